@@ -0,0 +1,55 @@
+//!      Circuit preprocessor: banded formulation benchmark
+//!      --------------------------------------------------
+//!
+//! Solves the catalunya centerline with the classic and the banded formulations for increasing mesh sizes,
+//! and reports the solve times and iterations of IPOPT
+//!
+//! Usage: circuit_preprocessor_banded_benchmark [database directory] [n_elements...]
+//!
+//!  - The database directory defaults to ./database
+//!  - The mesh sizes default to 500, 1000, 2000, 5000, 10000, 20000
+#include <iostream>
+#include <string>
+#include <vector>
+#include "src/core/applications/circuit_preprocessor.h"
+
+int main(int argc, char* argv[])
+{
+    const std::string database = (argc > 1 ? argv[1] : "./database");
+
+    std::vector<size_t> mesh_sizes = {500, 1000, 2000, 5000, 10000, 20000};
+
+    if ( argc > 2 )
+    {
+        mesh_sizes.clear();
+        for (int i = 2; i < argc; ++i)
+            mesh_sizes.push_back(std::stoul(argv[i]));
+    }
+
+    try
+    {
+        Xml_document coord_left_kml(database + "/tracks/catalunya/Catalunya_left.kml", true);
+        Xml_document coord_right_kml(database + "/tracks/catalunya/Catalunya_right.kml", true);
+
+        Circuit_preprocessor::Options opts_banded;
+        opts_banded.banded_formulation = true;
+
+        std::cout << "n_elements, classic time [s], classic iterations, banded time [s], banded iterations" << std::endl;
+
+        for (const size_t n_elements : mesh_sizes)
+        {
+            Circuit_preprocessor classic(coord_left_kml, coord_right_kml, false, {}, n_elements);
+            Circuit_preprocessor banded(coord_left_kml, coord_right_kml, false, opts_banded, n_elements);
+
+            std::cout << n_elements << ", " << classic.levels.back().elapsed_time << ", " << classic.levels.back().iter_count
+                      << ", " << banded.levels.back().elapsed_time << ", " << banded.levels.back().iter_count << std::endl;
+        }
+    }
+    catch (std::exception& ex)
+    {
+        std::cerr << "[ERROR] circuit_preprocessor_banded_benchmark -> " << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
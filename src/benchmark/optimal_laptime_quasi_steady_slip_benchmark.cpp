@@ -0,0 +1,131 @@
+//!      Optimal laptime: quasi-steady slip benchmark
+//!      --------------------------------------------
+//!
+//! Solves the Catalunya chicane (adapted mesh from i=533 to i=677) with the dynamic and the quasi-steady tire
+//! longitudinal slips, for several mesh strides, and reports the laptimes, iterations, and solve times of IPOPT
+//!
+//! Usage: optimal_laptime_quasi_steady_slip_benchmark [database directory] [starting lap] [strides...]
+//!
+//!  - The database directory defaults to ./database
+//!  - The starting lap is an optimal laptime of the full circuit in the adapted mesh, it provides the initial
+//!    condition of the chicane. Defaults to ./src/test/applications/data/f1_optimal_laptime_catalunya_adapted.xml
+//!  - The strides default to 1, 2, 4
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "src/core/vehicles/limebeer2014f1.h"
+#include "src/core/vehicles/track_by_polynomial.h"
+#include "src/core/applications/steady_state.h"
+#include "src/core/applications/optimal_laptime.h"
+#include "src/core/applications/circuit_preprocessor.h"
+
+using Car_t = limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p;
+
+//! Solve the chicane, one every stride points of the adapted mesh
+static Optimal_laptime<Car_t> solve_chicane(Car_t& car, limebeer2014f1<CppAD::AD<scalar>>::cartesian& car_cartesian,
+    const Circuit_preprocessor& catalunya_pproc, const Optimal_laptime<Car_t>& full_lap, const Optimal_laptime<Car_t>::Options& opts,
+    const size_t stride)
+{
+    // (1) Arclength: s(i0:stride:i1)
+    const size_t i0 = 533;
+    const size_t i1 = 677;
+    std::vector<scalar> s;
+    for (size_t i = i0; i <= i1; i += stride)
+        s.push_back(catalunya_pproc.s[i]);
+
+    const size_t n = s.size();
+
+    // (2) Initial guess: steady state at 70km/h
+    const auto ss = Steady_state(car_cartesian).solve(70.0*KMH, 0.0, 0.0);
+
+    std::vector<std::array<scalar,Car_t::NSTATE>>     q0(n, ss.q);
+    std::vector<std::array<scalar,Car_t::NALGEBRAIC>> qa0(n, ss.qa);
+
+    auto control_variables = Optimal_laptime<Car_t>::Control_variables<>{};
+
+    control_variables[Car_t::Chassis_type::front_axle_type::ISTEERING]
+        = Optimal_laptime<Car_t>::create_full_mesh(std::vector<scalar>(n, ss.u[Car_t::Chassis_type::front_axle_type::ISTEERING]), 50.0e0);
+
+    control_variables[Car_t::Chassis_type::ITHROTTLE]
+        = Optimal_laptime<Car_t>::create_full_mesh(std::vector<scalar>(n, ss.u[Car_t::Chassis_type::ITHROTTLE]), 20.0*8.0e-4);
+
+    control_variables[Car_t::Chassis_type::IBRAKE_BIAS]
+        = Optimal_laptime<Car_t>::create_dont_optimize();
+
+    // (3) Initial condition: the full lap at i0
+    q0.front()  = full_lap.q[i0];
+    qa0.front() = full_lap.qa[i0];
+
+    const auto u_start = full_lap.control_variables.control_array_at_s(car, i0, s.front());
+
+    for (size_t i = 0; i < Car_t::NCONTROL; ++i)
+    {
+        if ( control_variables[i].optimal_control_type != Optimal_laptime<Car_t>::DONT_OPTIMIZE )
+            control_variables[i].u.front() = u_start[i];
+    }
+
+    return Optimal_laptime<Car_t>(s, false, true, car, q0, qa0, control_variables, opts);
+}
+
+
+int main(int argc, char* argv[])
+{
+    const std::string database = (argc > 1 ? argv[1] : "./database");
+    const std::string starting_lap = (argc > 2 ? argv[2] : "./src/test/applications/data/f1_optimal_laptime_catalunya_adapted.xml");
+
+    std::vector<size_t> strides = {1, 2, 4};
+
+    if ( argc > 3 )
+    {
+        strides.clear();
+        for (int i = 3; i < argc; ++i)
+            strides.push_back(std::stoul(argv[i]));
+    }
+
+    try
+    {
+        Xml_document vehicle_xml(database + "/vehicles/f1/limebeer-2014-f1.xml", true);
+        limebeer2014f1<CppAD::AD<scalar>>::cartesian car_cartesian(vehicle_xml);
+
+        Xml_document catalunya_xml(database + "/tracks/catalunya/catalunya_adapted.xml", true);
+        Circuit_preprocessor catalunya_pproc(catalunya_xml);
+        Track_by_polynomial catalunya(catalunya_pproc);
+        Car_t::Road_t road(catalunya);
+        Car_t car(vehicle_xml, road);
+
+        Xml_document full_lap_xml(starting_lap, true);
+        Optimal_laptime<Car_t> full_lap(full_lap_xml);
+
+        Optimal_laptime<Car_t>::Options opts_dynamic;
+        Optimal_laptime<Car_t>::Options opts_quasi_steady;
+        opts_quasi_steady.quasi_steady_slip = true;
+
+        std::cout << "stride, dynamic laptime [s], dynamic iterations, dynamic time [s], "
+                  << "quasi-steady laptime [s], quasi-steady iterations, quasi-steady time [s]" << std::endl;
+
+        for (const size_t stride : strides)
+        {
+            std::cout << stride;
+
+            for (const auto& opts : {opts_dynamic, opts_quasi_steady})
+            {
+                const auto start = std::chrono::steady_clock::now();
+                const auto opt_laptime = solve_chicane(car, car_cartesian, catalunya_pproc, full_lap, opts, stride);
+                const std::chrono::duration<scalar> elapsed_time = std::chrono::steady_clock::now() - start;
+
+                std::cout << ", " << (opt_laptime.success ? std::to_string(opt_laptime.laptime) : "failed") << ", "
+                          << opt_laptime.iter_count << ", " << elapsed_time.count();
+            }
+
+            std::cout << std::endl;
+        }
+    }
+    catch (std::exception& ex)
+    {
+        std::cerr << "[ERROR] optimal_laptime_quasi_steady_slip_benchmark -> " << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+//!      Path tracking NMPC: real-time benchmark
+//!      ---------------------------------------
+//!
+//! Tracks the optimal lap of Catalunya (adapted mesh) in closed loop, starting 0.5m off the reference, with the
+//! Riccati and condensed QP solvers and several horizon lengths. For every run, reports the mean and maximum
+//! controller time per step against the minimum simulated time per step: the controller runs in real time if the
+//! maximum computation time is below the minimum simulated time
+//!
+//! Usage: path_tracking_nmpc_benchmark [database directory] [reference lap] [horizons...]
+//!
+//!  - The database directory defaults to ./database
+//!  - The reference lap defaults to ./src/test/applications/data/f1_optimal_laptime_catalunya_adapted.xml
+//!  - The horizons default to 10, 20, 40
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "src/core/vehicles/limebeer2014f1.h"
+#include "src/core/vehicles/track_by_polynomial.h"
+#include "src/core/applications/optimal_laptime.h"
+#include "src/core/applications/path_tracking_nmpc.h"
+#include "src/core/applications/circuit_preprocessor.h"
+
+using Car_t = limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p;
+
+int main(int argc, char* argv[])
+{
+    const std::string database = (argc > 1 ? argv[1] : "./database");
+    const std::string reference_lap = (argc > 2 ? argv[2] : "./src/test/applications/data/f1_optimal_laptime_catalunya_adapted.xml");
+
+    std::vector<size_t> horizons = {10, 20, 40};
+
+    if ( argc > 3 )
+    {
+        horizons.clear();
+        for (int i = 3; i < argc; ++i)
+            horizons.push_back(std::stoul(argv[i]));
+    }
+
+    try
+    {
+        Xml_document vehicle_xml(database + "/vehicles/f1/limebeer-2014-f1.xml", true);
+        Xml_document catalunya_xml(database + "/tracks/catalunya/catalunya_adapted.xml", true);
+        Circuit_preprocessor catalunya_pproc(catalunya_xml);
+        Track_by_polynomial catalunya(catalunya_pproc);
+        Car_t::Road_t road(catalunya);
+        Car_t car(vehicle_xml, road);
+
+        Xml_document reference_xml(reference_lap, true);
+        Optimal_laptime<Car_t> reference(reference_xml);
+
+        const size_t n_steps = reference.s.size() - 1;
+
+        auto q0 = reference.q.front();
+        q0[Car_t::Road_type::IN] += 0.5;
+
+        const auto u0 = reference.control_variables.control_array_at_s(car, 0, reference.s.front());
+
+        std::cout << "horizon, qp solver, mean step time [s], max step time [s], min simulated step [s], "
+                  << "total computation time [s], simulated time [s]" << std::endl;
+
+        for (const size_t horizon : horizons)
+        {
+            for (const auto qp_solver : {Path_tracking_nmpc<Car_t>::RICCATI, Path_tracking_nmpc<Car_t>::CONDENSED})
+            {
+                Path_tracking_nmpc<Car_t>::Options opts;
+                opts.horizon = horizon;
+                opts.qp_solver = qp_solver;
+                opts.keep_tapes = false;
+
+                Path_tracking_nmpc<Car_t> nmpc(car, reference, opts);
+                const auto solution = nmpc.simulate(q0, reference.qa.front(), u0, 0, n_steps);
+
+                std::cout << horizon << ", " << (qp_solver == Path_tracking_nmpc<Car_t>::RICCATI ? "riccati" : "condensed");
+
+                if ( !solution.success || solution.computation_time.size() == 0 )
+                {
+                    std::cout << ", failed" << std::endl;
+                    continue;
+                }
+
+                scalar min_simulated_step = solution.simulated_time;
+                for (size_t i = 1; i < solution.q.size(); ++i)
+                    min_simulated_step = std::min(min_simulated_step,
+                        solution.q[i][Car_t::Road_type::ITIME] - solution.q[i-1][Car_t::Road_type::ITIME]);
+
+                std::cout << ", " << solution.total_computation_time/solution.computation_time.size()
+                          << ", " << *std::max_element(solution.computation_time.cbegin(), solution.computation_time.cend())
+                          << ", " << min_simulated_step << ", " << solution.total_computation_time
+                          << ", " << solution.simulated_time << std::endl;
+            }
+        }
+    }
+    catch (std::exception& ex)
+    {
+        std::cerr << "[ERROR] path_tracking_nmpc_benchmark -> " << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -2,6 +2,7 @@
 #define __ENGINE_HPP__
 
 #include "lion/math/matrix_extensions.h"
+#include "src/core/foundation/tape_profiler.h"
 
 template<typename Timeseries_t>
 inline Engine<Timeseries_t>::Engine(Xml_document& database, const std::string& path, const bool only_max_power)
@@ -29,6 +30,8 @@ inline Engine<Timeseries_t>::Engine(Xml_document& database, const std::string& p
 template<typename Timeseries_t>
 inline Timeseries_t Engine<Timeseries_t>::operator()(const Timeseries_t throttle_percentage, const Timeseries_t angular_speed)
 {
+    FASTEST_LAP_TAPE_SCOPE("engine");
+
     if ( _direct_torque )
         return throttle_percentage;
 
@@ -3,6 +3,10 @@
 
 #include <vector>
 #include <array>
+#include <chrono>
+#include <tuple>
+#include <random>
+#include <limits>
 #include "lion/math/vector3d.h"
 #include "lion/io/Xml_document.h"
 #include <memory>
@@ -37,6 +41,50 @@ class Circuit_preprocessor
         scalar adaption_aspect_ratio_max = 1.2;
 
         int print_level = 0;
+
+        std::vector<size_t> multilevel_coarsening = {};  // Coarsening factors of the meshes solved before the requested one, from 
+                                                         // coarse to fine (e.g. {8} or {8,2}). Each solution warm starts the next
+
+        // Automatic remeshing: starting from the requested mesh, split the elements whose boundary error at the midpoint, or
+        // whose curvature change, exceeds the targets, and solve again warm started
+        scalar remeshing_target_error         = 0.0;     // Maximum boundary error [m]. Remeshing is disabled if zero
+        scalar remeshing_maximum_kappa_change = 2.0e-3;  // Maximum change of curvature within one element [1/m]
+        scalar remeshing_minimum_ds           = 1.0;     // Elements are not split below this size [m]
+        size_t remeshing_maximum_iterations   = 5;       // Maximum number of refinement passes
+
+        // Banded formulation: instead of a single arclength factor shared by all the elements (which gives a dense 
+        // Jacobian column), each point carries its own copy, tied to the previous one by a local consistency constraint.
+        // Same optimum, but the KKT matrix stays banded, which reduces the fill-in for large meshes
+        bool banded_formulation = false;
+    };
+
+    //! Summary of the solution of one mesh level
+    struct Level
+    {
+        size_t n_points;        //! Number of points of the mesh
+        size_t iter_count;      //! Number of iterations spent in IPOPT
+        scalar elapsed_time;    //! Wall time spent in IPOPT [s]
+    };
+
+    //! Options of the tuning driver: the score of a candidate is
+    //!     rms(L2 errors) + weight_max_error.max(max errors) + weight_smoothness.rms(dkappa)
+    struct Tuning_options
+    {
+        size_t n_threads         = 0;       // Number of threads (0: hardware concurrency)
+        scalar weight_max_error  = 0.1;     // Weight of the maximum boundary error
+        scalar weight_smoothness = 1.0e3;   // Weight of the rms of dkappa/ds
+    };
+
+    //! Results of the tuning driver, one entry per candidate
+    struct Tuning_result
+    {
+        std::vector<Options> candidates;        //! The option sets evaluated
+        std::vector<bool>    success;           //! False if the optimization of the candidate failed
+        std::vector<scalar>  L2_error;          //! rms of the left and right L2 boundary errors [m]
+        std::vector<scalar>  max_error;         //! maximum of the left and right maximum boundary errors [m]
+        std::vector<scalar>  smoothness;        //! rms of dkappa/ds [1/m2]
+        std::vector<scalar>  score;             //! Score (lower is better)
+        size_t               best;              //! Position of the best candidate
     };
 
     //! Default constructor
@@ -189,16 +237,68 @@ class Circuit_preprocessor
     scalar left_boundary_L2_error;
     scalar right_boundary_L2_error;
 
+    std::vector<Level> levels;  //! One per solved mesh: the coarse levels first, the requested mesh last
+
     std::unique_ptr<Xml_document> xml() const;
 
+    //! Solve again the same circuit with several option sets, in parallel. The measured boundaries, the mesh, and the
+    //! averaged centerline are shared by all candidates. On exit, *this contains the track of the best candidate
+    //! @param[in] candidates: option sets to be evaluated
+    //! @param[in] tuning_options: number of threads and weights of the score
+    Tuning_result tune(const std::vector<Options>& candidates, const Tuning_options& tuning_options = {});
+
+    //! Construct the option sets of a grid: all combinations of the given values
+    //! @param[in] base: values of the options not included in the grid
+    //! @param[in] values: pairs (option name, values). Names: eps_d, eps_k, eps_n, eps_c, maximum_kappa, maximum_dkappa, maximum_dn
+    static std::vector<Options> tuning_grid(const Options& base, const std::vector<std::pair<std::string,std::vector<scalar>>>& values);
+
+    //! Construct option sets by log-uniform random sampling
+    //! @param[in] base: values of the options not sampled
+    //! @param[in] ranges: tuples (option name, lower value, upper value). Values must be positive
+    //! @param[in] n_samples: number of option sets
+    //! @param[in] seed: seed of the random generator
+    static std::vector<Options> tuning_sample(const Options& base, const std::vector<std::tuple<std::string,scalar,scalar>>& ranges,
+                                              const size_t n_samples, const size_t seed = 0);
+
  private:
 
+    //! Averaged centerline used as initial point, stored to solve again with other options
+    std::vector<scalar>    _s_center;
+    std::vector<sVector3d> _r_center;
+    scalar                 _track_length_estimate;
+
+    //! Construct an uncomputed circuit with the measured boundaries and the reference frame of this one, and the given options
+    Circuit_preprocessor candidate_from_inputs(const Options& opts) const;
+
+    //! Set one of the tunable options by name
+    static void set_option(Options& opts, const std::string& name, const scalar value);
+
     template<bool closed>
     void transform_coordinates(const std::vector<Coordinates>& coord_left, const std::vector<Coordinates>& coord_right);
 
     template<bool closed>
     void compute(const std::vector<scalar>& s_center, const std::vector<sVector3d>& r_center, const scalar track_length_estimate);
 
+    //! Solve the optimization problem on the mesh given by s_center
+    //! @param[in] s_center: arclength of the averaged centerline
+    //! @param[in] r_center: points of the averaged centerline
+    //! @param[in] track_length_estimate: length of the averaged centerline
+    //! @param[in] x_start: initial point. If empty, computed from the averaged centerline
+    //! @return the optimal variables
+    template<bool closed>
+    std::vector<scalar> solve(const std::vector<scalar>& s_center, const std::vector<sVector3d>& r_center, const scalar track_length_estimate,
+                              const std::vector<scalar>& x_start);
+
+    //! Mark the elements to be split by the automatic remeshing. The flag of the i-th element is stored in the i-th position
+    template<bool closed>
+    std::vector<bool> elements_to_refine(const std::vector<scalar>& s_mesh, const std::vector<scalar>& x_solution, 
+                                         const scalar track_length_estimate) const;
+
+    //! Interpolate the variables of a coarse solution onto a finer mesh
+    template<bool closed>
+    std::vector<scalar> interpolate_solution(const std::vector<scalar>& s_coarse, const std::vector<scalar>& x_coarse, 
+                                             const std::vector<scalar>& s_fine, const scalar track_length_estimate) const;
+
     template<bool closed>
     class FG
     {
@@ -216,9 +316,11 @@ class Circuit_preprocessor
            const std::vector<sVector3d>& r_center, 
            int direction, 
            const Options opts) 
-            : _n_elements(n_elements), _n_points(n_points), _n_variables(1+(NSTATE+NCONTROLS)*_n_points), 
-              _n_constraints(1+NSTATE*n_elements + (closed ? 0 : 1)), _direction(direction), options(opts), _ds(element_ds), _r_left(r_left), _r_right(r_right), _r_center(r_center), _q(_n_points), _u(_n_points), _dqds(_n_points),
-              _dist2_left(_n_points), _dist2_right(_n_points), _dist2_center(_n_points) {}
+            : _n_elements(n_elements), _n_points(n_points), 
+              _n_variables(opts.banded_formulation ? (NSTATE+NCONTROLS+1)*_n_points : 1+(NSTATE+NCONTROLS)*_n_points), 
+              _n_constraints(1+NSTATE*n_elements + (closed ? 0 : 1) + (opts.banded_formulation ? _n_points-1 : 0)), 
+              _direction(direction), options(opts), _ds(element_ds), _r_left(r_left), _r_right(r_right), _r_center(r_center), _q(_n_points), _u(_n_points), _dqds(_n_points),
+              _ds_factor(_n_points), _dist2_left(_n_points), _dist2_right(_n_points), _dist2_center(_n_points) {}
 
         void operator()(ADvector& fg, const ADvector& x);
 
@@ -231,6 +333,13 @@ class Circuit_preprocessor
         constexpr const size_t& get_n_variables() const { return _n_variables; }
         constexpr const size_t& get_n_constraints() const { return _n_constraints; }
 
+        //! Transform a variables vector from the classic layout [ds_factor, (q,u)_0, ..., (q,u)_{n-1}] to the layout 
+        //! of this problem. For the banded formulation: [(q,u,ds_factor)_0, ..., (q,u,ds_factor)_{n-1}]
+        std::vector<scalar> variables_from_classic(const std::vector<scalar>& x_classic) const;
+
+        //! Transform a variables vector from the layout of this problem to the classic layout
+        std::vector<scalar> variables_to_classic(const std::vector<scalar>& x) const;
+
      private:
         size_t _n_elements;
         size_t _n_points;
@@ -250,6 +359,8 @@ class Circuit_preprocessor
         std::vector<std::array<CppAD::AD<scalar>,NCONTROLS>> _u;
         std::vector<std::array<CppAD::AD<scalar>,NSTATE>> _dqds;
 
+        std::vector<CppAD::AD<scalar>> _ds_factor;   //! Arclength factor of the element that starts at each point
+
         std::vector<CppAD::AD<scalar>> _dist2_left;
         std::vector<CppAD::AD<scalar>> _dist2_right;
         std::vector<CppAD::AD<scalar>> _dist2_center;
@@ -286,10 +397,15 @@ class Circuit_preprocessor
                                                                                           const std::vector<Coordinates>& coord_right,
                                                                                           Coordinates start, Coordinates finish);
 
+    //! Project the ds breakpoints into the arclength of the curve r_curve (with arclength s_curve). Done once per curve
     template<bool closed>
-    static scalar compute_ds_for_coordinates(const sVector3d point, const std::vector<sVector3d>& r_curve, const std::vector<std::pair<sVector3d,scalar>>& ds_breakpoints);
+    static std::vector<scalar> compute_breakpoints_arclength(const std::vector<sVector3d>& r_curve, const std::vector<scalar>& s_curve, 
+                                                             const std::vector<std::pair<sVector3d,scalar>>& ds_breakpoints);
 
-    static size_t who_is_ahead(std::array<size_t,2>& i_p1, std::array<size_t,2>& i_p2, const sVector3d& p1, const sVector3d& p2, const sVector3d& p_ref);
+    //! Get the ds for a given arclength from the projected breakpoints. Calls must come with non-decreasing s,
+    //! and i_break is the cursor (initialized to 1) that keeps the position of the walk between calls
+    static scalar compute_ds_for_arclength(const scalar s, const std::vector<scalar>& s_breakpoints, 
+                                           const std::vector<std::pair<sVector3d,scalar>>& ds_breakpoints, size_t& i_break);
 };
 
 #include "circuit_preprocessor.hpp"
@@ -6,6 +6,9 @@
 #include "lion/math/matrix_extensions.h"
 #include "lion/math/ipopt_cppad_handler.hpp"
 #include "src/core/foundation/fastest_lap_exception.h"
+#include "src/core/foundation/synchronized_output.h"
+#include "src/core/foundation/parallel.h"
+#include "src/core/foundation/trace.h"
 
 inline std::pair<std::vector<Circuit_preprocessor::Coordinates>,std::vector<Circuit_preprocessor::Coordinates>>
     Circuit_preprocessor::read_kml(Xml_document& coord_left_kml, Xml_document& coord_right_kml, bool clockwise)
@@ -180,8 +183,12 @@ inline void Circuit_preprocessor::transform_coordinates(const std::vector<Coordi
 
 
 template<bool closed>
-inline void Circuit_preprocessor::compute(const std::vector<scalar>& s_center, const std::vector<sVector3d>& r_center, const scalar track_length_estimate)
+inline std::vector<scalar> Circuit_preprocessor::solve(const std::vector<scalar>& s_center, const std::vector<sVector3d>& r_center, 
+    const scalar track_length_estimate, const std::vector<scalar>& x_start)
 {
+    const size_t n_points   = s_center.size();
+    const size_t n_elements = (closed ? n_points : n_points - 1);
+
     // (1) Compute the initial condition via finite differences
     std::vector<scalar> x_init(n_points,0.0);
     std::vector<scalar> y_init(n_points,0.0);
@@ -316,6 +323,24 @@ inline void Circuit_preprocessor::compute(const std::vector<scalar>& s_center, c
     assert(k_lb == fg.get_n_variables());
     assert(k_ub == fg.get_n_variables());
 
+    // Warm start from the provided point, which must lie within the bounds
+    if ( x_start.size() > 0 )
+    {
+        if ( x_start.size() != fg.get_n_variables() )
+            throw fastest_lap_exception("[ERROR] Circuit_preprocessor::solve -> x_start has incorrect size");
+
+        for (size_t i = 0; i < x.size(); ++i)
+            x[i] = std::max(x_lb[i], std::min(x_ub[i], x_start[i]));
+    }
+
+    // The vectors above are built in the classic layout, transform them to the layout of the problem
+    if ( options.banded_formulation )
+    {
+        x    = fg.variables_from_classic(x);
+        x_lb = fg.variables_from_classic(x_lb);
+        x_ub = fg.variables_from_classic(x_ub);
+    }
+
     // (7) Run the optimization
     std::string ipoptoptions;
     ipoptoptions += "Integer print_level  ";
@@ -332,13 +357,138 @@ inline void Circuit_preprocessor::compute(const std::vector<scalar>& s_center, c
     CppAD::ipopt_cppad_result<std::vector<scalar>> result;
 
     // solve the problem
-    CppAD::ipopt_cppad_solve(ipoptoptions, x, x_lb, x_ub, std::vector<scalar>(fg.get_n_constraints(),0.0), std::vector<scalar>(fg.get_n_constraints(),0.0), fg, result);
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    {
+        FASTEST_LAP_TRACE_SCOPE("Circuit_preprocessor::ipopt");
+        CppAD::ipopt_cppad_solve(ipoptoptions, x, x_lb, x_ub, std::vector<scalar>(fg.get_n_constraints(),0.0), std::vector<scalar>(fg.get_n_constraints(),0.0), fg, result);
+    }
 
     if ( result.status != CppAD::ipopt_cppad_result<std::vector<scalar>>::success )
     {
         throw fastest_lap_exception("Optimization did not succeed");
     }
 
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    levels.push_back({n_points, result.iter_count, std::chrono::duration<scalar>(end - start).count()});
+
+    if ( options.print_level > 0 )
+        synchronized_out(2) << "[INFO] Circuit_preprocessor -> level with " << n_points << " points solved in " << levels.back().elapsed_time 
+               << "s, " << result.iter_count << " iterations" << std::endl;
+
+    return fg.variables_to_classic(result.x);
+}
+
+
+template<bool closed>
+inline void Circuit_preprocessor::compute(const std::vector<scalar>& s_center, const std::vector<sVector3d>& r_center, const scalar track_length_estimate)
+{
+    // Keep the averaged centerline, to be able to solve again with other options
+    _s_center              = s_center;
+    _r_center              = r_center;
+    _track_length_estimate = track_length_estimate;
+
+    FASTEST_LAP_TRACE_SCOPE("Circuit_preprocessor::compute");
+
+    n_points   = s_center.size();
+    n_elements = (closed ? n_points : n_points - 1);
+
+    levels.clear();
+
+    // (1) Solve the coarse levels: each one is warm started from the previous
+    std::vector<scalar> s_previous;
+    std::vector<scalar> x_previous;
+
+    for (const size_t coarsening : options.multilevel_coarsening)
+    {
+        if ( coarsening < 2 )
+            throw fastest_lap_exception("[ERROR] Circuit_preprocessor::compute -> multilevel_coarsening factors must be larger than 1");
+
+        // (1.1) Keep one every "coarsening" points. Open circuits keep also the last point
+        std::vector<scalar> s_level;
+        std::vector<sVector3d> r_level;
+
+        for (size_t i = 0; i < n_points; i += coarsening)
+        {
+            s_level.push_back(s_center[i]);
+            r_level.push_back(r_center[i]);
+        }
+
+        if ( !closed && (s_level.back() != s_center.back()) )
+        {
+            s_level.push_back(s_center.back());
+            r_level.push_back(r_center.back());
+        }
+
+        if ( s_level.size() < 4 )
+            throw fastest_lap_exception("[ERROR] Circuit_preprocessor::compute -> multilevel_coarsening factor " + std::to_string(coarsening) 
+                + " leaves less than 4 points");
+
+        // (1.2) Solve
+        const auto x_start = ( x_previous.size() > 0 ? interpolate_solution<closed>(s_previous, x_previous, s_level, track_length_estimate) 
+                                                     : std::vector<scalar>{} );
+
+        x_previous = solve<closed>(s_level, r_level, track_length_estimate, x_start);
+        s_previous = s_level;
+    }
+
+    // (2) Solve the requested mesh
+    const auto x_start = ( x_previous.size() > 0 ? interpolate_solution<closed>(s_previous, x_previous, s_center, track_length_estimate) 
+                                                 : std::vector<scalar>{} );
+
+    std::vector<scalar> s_mesh(s_center);
+    std::vector<sVector3d> r_mesh(r_center);
+    auto x_solution = solve<closed>(s_mesh, r_mesh, track_length_estimate, x_start);
+
+    // (3) Automatic remeshing: split the elements with large boundary errors or curvature changes, and solve again warm started
+    if ( options.remeshing_target_error > 0.0 )
+    {
+        for (size_t iter = 0; iter < options.remeshing_maximum_iterations; ++iter)
+        {
+            const auto refine = elements_to_refine<closed>(s_mesh, x_solution, track_length_estimate);
+
+            if ( std::none_of(refine.cbegin(), refine.cend(), [](const auto& r) -> auto { return r; }) )
+                break;
+
+            // (3.1) Insert the midpoint of the marked elements
+            std::vector<scalar> s_new;
+            std::vector<sVector3d> r_new;
+
+            for (size_t i = 0; i < s_mesh.size(); ++i)
+            {
+                s_new.push_back(s_mesh[i]);
+                r_new.push_back(r_mesh[i]);
+
+                if ( refine[i] )
+                {
+                    const bool is_last = (i == s_mesh.size() - 1);
+                    s_new.push_back(0.5*(s_mesh[i] + (is_last ? track_length_estimate : s_mesh[i+1])));
+                    r_new.push_back(0.5*(r_mesh[i] + (is_last ? r_mesh.front() : r_mesh[i+1])));
+                }
+            }
+
+            // (3.2) Solve warm started from the current solution
+            const auto x_refined = interpolate_solution<closed>(s_mesh, x_solution, s_new, track_length_estimate);
+
+            s_mesh     = std::move(s_new);
+            r_mesh     = std::move(r_new);
+            x_solution = solve<closed>(s_mesh, r_mesh, track_length_estimate, x_refined);
+        }
+
+        n_points   = s_mesh.size();
+        n_elements = (closed ? n_points : n_points - 1);
+    }
+
+    // (4) Compute the element sizes of the final mesh
+    std::vector<scalar> element_ds(n_elements);
+
+    for (size_t i = 1; i < n_points; ++i)
+        element_ds[i-1] = s_mesh[i] - s_mesh[i-1];
+
+    if (closed)
+        element_ds[n_elements-1] = track_length_estimate - s_mesh.back();
+
     // Load the solution
     s            = std::vector<scalar>(n_points,0.0);
     r_left       = std::vector<sVector3d>(n_points);
@@ -365,9 +515,9 @@ inline void Circuit_preprocessor::compute(const std::vector<scalar>& s_center, c
     const auto& NCONTROLS = FG<closed>::NCONTROLS;
     
     for (size_t i = 1; i < n_points; ++i)
-        s[i] = s[i-1] + element_ds[i-1]*result.x[0];
+        s[i] = s[i-1] + element_ds[i-1]*x_solution[0];
 
-    track_length = s.back() + (closed ? element_ds.back()*result.x[0] : 0.0);
+    track_length = s.back() + (closed ? element_ds.back()*x_solution[0] : 0.0);
     
     for (size_t i = 0; i < n_points; ++i)
     {
@@ -382,21 +532,21 @@ inline void Circuit_preprocessor::compute(const std::vector<scalar>& s_center, c
         const size_t idnl    = 1  + (NSTATE + NCONTROLS)*i + NSTATE + IDNL;
         const size_t idnr    = 1  + (NSTATE + NCONTROLS)*i + NSTATE + IDNR;
 
-        r_left[i] = sVector3d(result.x[ix] - sin(result.x[itheta])*result.x[inl],
-                              result.x[iy] + cos(result.x[itheta])*result.x[inl],
+        r_left[i] = sVector3d(x_solution[ix] - sin(x_solution[itheta])*x_solution[inl],
+                              x_solution[iy] + cos(x_solution[itheta])*x_solution[inl],
                               0.0);
-        r_right[i] = sVector3d(result.x[ix] + sin(result.x[itheta])*result.x[inr],
-                               result.x[iy] - cos(result.x[itheta])*result.x[inr],
+        r_right[i] = sVector3d(x_solution[ix] + sin(x_solution[itheta])*x_solution[inr],
+                               x_solution[iy] - cos(x_solution[itheta])*x_solution[inr],
                                0.0); 
-        r_centerline[i] = sVector3d(result.x[ix], result.x[iy], 0.0);
-
-        theta[i]  = result.x[itheta];
-        kappa[i]  = result.x[ikappa];
-        nl[i]     = result.x[inl];
-        nr[i]     = result.x[inr];
-        dkappa[i] = result.x[idkappa];
-        dnl[i]    = result.x[idnl];
-        dnr[i]    = result.x[idnr];
+        r_centerline[i] = sVector3d(x_solution[ix], x_solution[iy], 0.0);
+
+        theta[i]  = x_solution[itheta];
+        kappa[i]  = x_solution[ikappa];
+        nl[i]     = x_solution[inl];
+        nr[i]     = x_solution[inr];
+        dkappa[i] = x_solution[idkappa];
+        dnl[i]    = x_solution[idnl];
+        dnr[i]    = x_solution[idnr];
     }
 
 
@@ -443,6 +593,286 @@ inline void Circuit_preprocessor::compute(const std::vector<scalar>& s_center, c
     right_boundary_L2_error = sqrt(right_boundary_L2_error/track_length);
 }
 
+template<bool closed>
+inline std::vector<bool> Circuit_preprocessor::elements_to_refine(const std::vector<scalar>& s_mesh, const std::vector<scalar>& x_solution,
+    const scalar track_length_estimate) const
+{
+    constexpr const size_t N = FG<closed>::NSTATE + FG<closed>::NCONTROLS;
+    const size_t n_mesh_points   = s_mesh.size();
+    const size_t n_mesh_elements = (closed ? n_mesh_points : n_mesh_points - 1);
+
+    auto variable = [&](const size_t i, const size_t k) -> scalar { return x_solution[1 + N*i + k]; };
+
+    auto boundaries = [&](const size_t i) -> std::pair<sVector3d,sVector3d>
+    {
+        const scalar x_i     = variable(i, FG<closed>::IX);
+        const scalar y_i     = variable(i, FG<closed>::IY);
+        const scalar theta_i = variable(i, FG<closed>::ITHETA);
+
+        return { sVector3d(x_i - sin(theta_i)*variable(i, FG<closed>::INL), y_i + cos(theta_i)*variable(i, FG<closed>::INL), 0.0),
+                 sVector3d(x_i + sin(theta_i)*variable(i, FG<closed>::INR), y_i - cos(theta_i)*variable(i, FG<closed>::INR), 0.0) };
+    };
+
+    std::vector<bool> refine(n_mesh_points, false);
+
+    // Elements are visited in order along the track: the search of the closest measured point starts from the previous one
+    std::array<size_t,2> i_l = {0,0};
+    std::array<size_t,2> i_r = {0,0};
+    scalar dist2_left, dist2_right;
+
+    for (size_t i = 0; i < n_mesh_elements; ++i)
+    {
+        const size_t i_next = (i + 1) % n_mesh_points;
+        const scalar ds = x_solution[0]*((i_next == 0 ? track_length_estimate : s_mesh[i_next]) - s_mesh[i]);
+
+        // (1) Boundary error at the midpoint of the element. The search runs for every element, so that the running index
+        //     follows the track also through the elements that are not split
+        const auto [r_left_i, r_right_i]           = boundaries(i);
+        const auto [r_left_next, r_right_next]     = boundaries(i_next);
+
+        std::tie(std::ignore,dist2_left,i_l)  = find_closest_point<scalar>(r_left_measured, 0.5*(r_left_i + r_left_next), closed, 
+                                                                            min(i_l[0],i_l[1]), options.maximum_distance_find);
+        std::tie(std::ignore,dist2_right,i_r) = find_closest_point<scalar>(r_right_measured, 0.5*(r_right_i + r_right_next), closed, 
+                                                                            min(i_r[0],i_r[1]), options.maximum_distance_find);
+
+        // (2) Do not split elements below the minimum size
+        if ( 0.5*ds < options.remeshing_minimum_ds )
+            continue;
+
+        const scalar left_error  = sqrt(dist2_left);
+        const scalar right_error = sqrt(dist2_right);
+
+        // (3) Curvature change across the element
+        const scalar kappa_change = std::abs(variable(i_next, FG<closed>::IKAPPA) - variable(i, FG<closed>::IKAPPA));
+
+        refine[i] = (std::max(left_error, right_error) > options.remeshing_target_error) || (kappa_change > options.remeshing_maximum_kappa_change);
+    }
+
+    return refine;
+}
+
+
+template<bool closed>
+inline std::vector<scalar> Circuit_preprocessor::interpolate_solution(const std::vector<scalar>& s_coarse, const std::vector<scalar>& x_coarse,
+    const std::vector<scalar>& s_fine, const scalar track_length_estimate) const
+{
+    constexpr const size_t N = FG<closed>::NSTATE + FG<closed>::NCONTROLS;
+    const size_t n_coarse = s_coarse.size();
+
+    std::vector<scalar> x_fine(1 + N*s_fine.size());
+
+    // (1) The ds factor is kept
+    x_fine[0] = x_coarse[0];
+
+    // (2) Linear interpolation of states and controls in the arclength of the averaged centerline
+    size_t j = 0;
+    for (size_t i = 0; i < s_fine.size(); ++i)
+    {
+        while ( (j + 2 < n_coarse) && (s_coarse[j+1] <= s_fine[i]) )
+            ++j;
+
+        size_t j_next = j + 1;
+        scalar s_next = s_coarse[j+1];
+        scalar theta_shift = 0.0;
+
+        if ( s_fine[i] >= s_coarse.back() )
+        {
+            if ( closed )
+            {
+                // Last element of a closed circuit: interpolate towards the first point, one lap ahead
+                j           = n_coarse - 1;
+                j_next      = 0;
+                s_next      = track_length_estimate;
+                theta_shift = 2.0*pi*direction;
+            }
+            else
+            {
+                j      = n_coarse - 2;
+                s_next = s_coarse.back();
+            }
+        }
+
+        const scalar t = (s_fine[i] - s_coarse[j])/(s_next - s_coarse[j]);
+
+        for (size_t k = 0; k < N; ++k)
+        {
+            const scalar x_j      = x_coarse[1 + N*j + k];
+            const scalar x_j_next = x_coarse[1 + N*j_next + k] + (k == FG<closed>::ITHETA ? theta_shift : 0.0);
+
+            x_fine[1 + N*i + k] = (1.0 - t)*x_j + t*x_j_next;
+        }
+    }
+
+    return x_fine;
+}
+
+
+inline Circuit_preprocessor::Tuning_result Circuit_preprocessor::tune(const std::vector<Options>& candidates, const Tuning_options& tuning_options)
+{
+    if ( candidates.size() == 0 )
+        throw fastest_lap_exception("[ERROR] Circuit_preprocessor::tune -> no candidates were provided");
+
+    if ( _s_center.size() == 0 )
+        throw fastest_lap_exception("[ERROR] Circuit_preprocessor::tune -> the circuit has not been computed");
+
+    const size_t n = candidates.size();
+
+    // (1) Solve all candidates. Each task builds its circuit from the inputs of this one, and writes only its own score
+    struct Candidate_score
+    {
+        bool   success    = false;
+        scalar L2_error   = std::numeric_limits<scalar>::infinity();
+        scalar max_error  = std::numeric_limits<scalar>::infinity();
+        scalar smoothness = std::numeric_limits<scalar>::infinity();
+        scalar score      = std::numeric_limits<scalar>::infinity();
+    };
+
+    std::vector<Circuit_preprocessor> solutions(n);
+    std::vector<Candidate_score> scores(n);
+
+    Parallel::for_each(n, tuning_options.n_threads, [&](const size_t i)
+    {
+        FASTEST_LAP_TRACE_SCOPE("Circuit_preprocessor::tune::candidate");
+
+        auto solution = candidate_from_inputs(candidates[i]);
+
+        try
+        {
+            if ( is_closed )
+                solution.compute<true>(_s_center, _r_center, _track_length_estimate);
+            else
+                solution.compute<false>(_s_center, _r_center, _track_length_estimate);
+        }
+        catch (const fastest_lap_exception&)
+        {
+            return;
+        }
+
+        // (1.1) rms of dkappa/ds
+        scalar dkappa2 = 0.0;
+        for (size_t j = 0; j < solution.n_points; ++j)
+        {
+            const scalar ds = ( j + 1 < solution.n_points ? solution.s[j+1] - solution.s[j] : solution.track_length - solution.s[j] );
+            dkappa2 += solution.dkappa[j]*solution.dkappa[j]*ds;
+        }
+
+        auto& score = scores[i];
+        score.success    = true;
+        score.L2_error   = sqrt(0.5*(solution.left_boundary_L2_error*solution.left_boundary_L2_error 
+                                   + solution.right_boundary_L2_error*solution.right_boundary_L2_error));
+        score.max_error  = std::max(solution.left_boundary_max_error, solution.right_boundary_max_error);
+        score.smoothness = sqrt(dkappa2/solution.track_length);
+        score.score      = score.L2_error + tuning_options.weight_max_error*score.max_error 
+                         + tuning_options.weight_smoothness*score.smoothness;
+
+        solutions[i] = std::move(solution);
+    });
+
+    // (2) Gather the scores
+    Tuning_result result;
+    result.candidates = candidates;
+
+    for (const auto& score : scores)
+    {
+        result.success.push_back(score.success);
+        result.L2_error.push_back(score.L2_error);
+        result.max_error.push_back(score.max_error);
+        result.smoothness.push_back(score.smoothness);
+        result.score.push_back(score.score);
+    }
+
+    // (3) Keep the best candidate
+    result.best = std::distance(result.score.cbegin(), std::min_element(result.score.cbegin(), result.score.cend()));
+
+    if ( !result.success[result.best] )
+        throw fastest_lap_exception("[ERROR] Circuit_preprocessor::tune -> none of the candidates succeeded");
+
+    *this = std::move(solutions[result.best]);
+
+    return result;
+}
+
+
+inline Circuit_preprocessor Circuit_preprocessor::candidate_from_inputs(const Options& opts) const
+{
+    Circuit_preprocessor candidate;
+
+    candidate.options          = opts;
+    candidate.is_closed        = is_closed;
+    candidate.direction        = direction;
+    candidate.x0               = x0;
+    candidate.y0               = y0;
+    candidate.phi0             = phi0;
+    candidate.theta0           = theta0;
+    candidate.phi_ref          = phi_ref;
+    candidate.R_earth          = R_earth;
+    candidate.r_left_measured  = r_left_measured;
+    candidate.r_right_measured = r_right_measured;
+
+    return candidate;
+}
+
+
+inline void Circuit_preprocessor::set_option(Options& opts, const std::string& name, const scalar value)
+{
+    if      ( name == "eps_d"          ) opts.eps_d          = value;
+    else if ( name == "eps_k"          ) opts.eps_k          = value;
+    else if ( name == "eps_n"          ) opts.eps_n          = value;
+    else if ( name == "eps_c"          ) opts.eps_c          = value;
+    else if ( name == "maximum_kappa"  ) opts.maximum_kappa  = value;
+    else if ( name == "maximum_dkappa" ) opts.maximum_dkappa = value;
+    else if ( name == "maximum_dn"     ) opts.maximum_dn     = value;
+    else
+        throw fastest_lap_exception("[ERROR] Circuit_preprocessor::set_option -> option \"" + name + "\" cannot be tuned. "
+            "Available options are: eps_d, eps_k, eps_n, eps_c, maximum_kappa, maximum_dkappa, maximum_dn");
+}
+
+
+inline std::vector<Circuit_preprocessor::Options> Circuit_preprocessor::tuning_grid(const Options& base, 
+    const std::vector<std::pair<std::string,std::vector<scalar>>>& values)
+{
+    std::vector<Options> candidates = {base};
+
+    // Every option multiplies the candidates by its number of values
+    for (const auto& [name, option_values] : values)
+    {
+        std::vector<Options> new_candidates;
+
+        for (const auto& candidate : candidates)
+            for (const auto& value : option_values)
+            {
+                new_candidates.push_back(candidate);
+                set_option(new_candidates.back(), name, value);
+            }
+
+        candidates = std::move(new_candidates);
+    }
+
+    return candidates;
+}
+
+
+inline std::vector<Circuit_preprocessor::Options> Circuit_preprocessor::tuning_sample(const Options& base, 
+    const std::vector<std::tuple<std::string,scalar,scalar>>& ranges, const size_t n_samples, const size_t seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<scalar> distribution(0.0, 1.0);
+
+    std::vector<Options> candidates(n_samples, base);
+
+    for (auto& candidate : candidates)
+        for (const auto& [name, lower, upper] : ranges)
+        {
+            if ( (lower <= 0.0) || (upper < lower) )
+                throw fastest_lap_exception("[ERROR] Circuit_preprocessor::tuning_sample -> ranges must satisfy 0 < lower <= upper");
+
+            set_option(candidate, name, lower*std::pow(upper/lower, distribution(generator)));
+        }
+
+    return candidates;
+}
+
+
 inline std::unique_ptr<Xml_document> Circuit_preprocessor::xml() const
 {
     std::ostringstream s_out;
@@ -752,10 +1182,14 @@ std::tuple<std::vector<scalar>, std::vector<sVector3d>, scalar> Circuit_preproce
     std::vector<scalar> s_right_mesh = {0.0, ds_breakpoints.front().second};
     std::vector<sVector3d> r_right_mesh = { track_right(s_right_mesh[0]), track_right(s_right_mesh[1]) };
 
+    // (4.1) Project the breakpoints once into the right boundary arclength, the mesh is then walked monotonically
+    const std::vector<scalar> s_breakpoints_right = compute_breakpoints_arclength<closed>(r_right, s_right, ds_breakpoints);
+    size_t i_break = 1;
+
     scalar ds_prev = ds_breakpoints.front().second;
     while ( s_right_mesh.back() < s_right.back() )
     {
-        scalar ds = compute_ds_for_coordinates<closed>(r_right_mesh.back(), r_right, ds_breakpoints);
+        scalar ds = compute_ds_for_arclength(min(s_right_mesh.back(),s_right.back()), s_breakpoints_right, ds_breakpoints, i_break);
 
         // Restrict the maximum aspect ratio of adjacent cells
         if ( ds > options.adaption_aspect_ratio_max*ds_prev )
@@ -809,10 +1243,13 @@ std::tuple<std::vector<scalar>, std::vector<sVector3d>, scalar> Circuit_preproce
     std::vector<scalar> s_center_mesh = {0.0, ds_breakpoints.front().second};
     std::vector<sVector3d> r_center_mesh = { track_center(s_center_mesh[0]), track_center(s_center_mesh[1]) };
 
+    const std::vector<scalar> s_breakpoints_center = compute_breakpoints_arclength<closed>(r_center, s_center, ds_breakpoints);
+    i_break = 1;
+
     ds_prev = ds_breakpoints.front().second;
     while ( s_center_mesh.back() < s_center.back() )
     {
-        scalar ds = compute_ds_for_coordinates<closed>(r_center_mesh.back(), r_center, ds_breakpoints);
+        scalar ds = compute_ds_for_arclength(min(s_center_mesh.back(),s_center.back()), s_breakpoints_center, ds_breakpoints, i_break);
 
         // Restrict the maximum aspect ratio of adjacent cells
         if ( ds > options.adaption_aspect_ratio_max*ds_prev )
@@ -1041,8 +1478,9 @@ void Circuit_preprocessor::FG<closed>::operator()(ADvector& fg, const ADvector&
     // (1) Load the state and control vectors
     size_t k = 0;
 
-    // (1a) First variable is the arclength 
-    CppAD::AD<scalar> ds_factor = x[k++];
+    // (1a) Classic formulation: first variable is the arclength factor, shared by all the elements
+    if ( !options.banded_formulation )
+        std::fill(_ds_factor.begin(), _ds_factor.end(), x[k++]);
 
     // (2a) Load state and controls
     for (size_t i = 0; i < _n_points; ++i)
@@ -1054,6 +1492,10 @@ void Circuit_preprocessor::FG<closed>::operator()(ADvector& fg, const ADvector&
         // Load control
         for (size_t j = 0; j < NCONTROLS; ++j)
             _u[i][j] = x[k++];
+
+        // Banded formulation: each point carries the arclength factor of its element
+        if ( options.banded_formulation )
+            _ds_factor[i] = x[k++];
     }
 
     // Check that all variables in x were used
@@ -1086,7 +1528,7 @@ void Circuit_preprocessor::FG<closed>::operator()(ADvector& fg, const ADvector&
             true, min(i_center[0],i_center[1]), options.maximum_distance_find);
 
         // Fitness function: minimize the square of the distance to the boundaries and centerline, and control powers
-        const auto ds = ds_factor*_ds[i-1];
+        const auto ds = _ds_factor[i-1]*_ds[i-1];
         fg[0] += 0.5*ds*options.eps_d*(_dist2_left[i] + _dist2_left[i-1]);
         fg[0] += 0.5*ds*options.eps_d*(_dist2_right[i]  + _dist2_right[i-1]  );
         fg[0] += 0.5*ds*options.eps_c*(_dist2_center[i] + _dist2_center[i-1] );
@@ -1097,12 +1539,16 @@ void Circuit_preprocessor::FG<closed>::operator()(ADvector& fg, const ADvector&
         // Equality constraints:  q^{i} = q^{i-1} + 0.5.ds.[dqds^{i} + dqds^{i-1}]
         for (size_t j = 0; j < NSTATE; ++j)
             fg[k++] = _q[i][j] - _q[i-1][j] - 0.5*ds*(_dqds[i-1][j] + _dqds[i][j]);
+
+        // Banded formulation: the arclength factor is the same for all the elements, imposed locally
+        if ( options.banded_formulation )
+            fg[k++] = _ds_factor[i] - _ds_factor[i-1];
     }
 
     // (6) Append the scheme equations of the periodic element if the circuit is closed
     if constexpr (closed)
     {
-        const auto ds = ds_factor*_ds.back();
+        const auto ds = _ds_factor.back()*_ds.back();
         // Add the periodic element
         // Fitness function: minimize the square of the distance to the boundaries and centerline, and control powers
         fg[0] += 0.5*ds*options.eps_d*(_dist2_left[0]    + _dist2_left[_n_elements-1] );
@@ -1135,47 +1581,94 @@ void Circuit_preprocessor::FG<closed>::operator()(ADvector& fg, const ADvector&
 
 
 template<bool closed>
-inline scalar Circuit_preprocessor::compute_ds_for_coordinates(const sVector3d point, const std::vector<sVector3d>& r_curve,
-    const std::vector<std::pair<sVector3d,scalar>>& ds_breakpoints)
+inline std::vector<scalar> Circuit_preprocessor::FG<closed>::variables_from_classic(const std::vector<scalar>& x_classic) const
 {
-    // (1) Find the closest point to the requested point in the curve
-    std::array<size_t,2> i_point; 
-    sVector3d v_closest_point;
-    std::tie(v_closest_point,std::ignore,i_point) = find_closest_point<scalar>(r_curve, point, closed, 0, 1.0e18);
-
-    // (2) Loop on the ds breakpoints until we find a point ahead of the requested
-    size_t i_closest_break = ds_breakpoints.size()-1;
-    for (size_t i = 1; i < ds_breakpoints.size(); ++i)
+    if ( !options.banded_formulation )
+        return x_classic;
+
+    assert(x_classic.size() == 1 + (NSTATE+NCONTROLS)*_n_points);
+
+    std::vector<scalar> x(_n_variables);
+    size_t k = 0;
+    size_t k_classic = 1;
+
+    for (size_t i = 0; i < _n_points; ++i)
     {
-        std::array<size_t,2> i_break; 
-        sVector3d v_closest_break;
-        std::tie(v_closest_break,std::ignore,i_break) = find_closest_point<scalar>(r_curve, ds_breakpoints[i].first, closed, 0, 1.0e18);
+        for (size_t j = 0; j < NSTATE + NCONTROLS; ++j)
+            x[k++] = x_classic[k_classic++];
 
-        if ( who_is_ahead(i_break, i_point, v_closest_break, v_closest_point, ds_breakpoints[i].first) == 1 )
-        {
-            i_closest_break = i - 1;
-            break;
-        }
+        x[k++] = x_classic[0];
+    }
+
+    assert(k == _n_variables);
+
+    return x;
+}
+
+
+template<bool closed>
+inline std::vector<scalar> Circuit_preprocessor::FG<closed>::variables_to_classic(const std::vector<scalar>& x) const
+{
+    if ( !options.banded_formulation )
+        return x;
+
+    assert(x.size() == _n_variables);
+
+    std::vector<scalar> x_classic(1 + (NSTATE+NCONTROLS)*_n_points);
+    size_t k = 0;
+    size_t k_classic = 1;
+
+    // The consistency constraints make all the copies equal, take the first one
+    x_classic[0] = x[NSTATE+NCONTROLS];
+
+    for (size_t i = 0; i < _n_points; ++i)
+    {
+        for (size_t j = 0; j < NSTATE + NCONTROLS; ++j)
+            x_classic[k_classic++] = x[k++];
+
+        ++k;
     }
 
-    return ds_breakpoints[i_closest_break].second;
+    assert(k == _n_variables);
+
+    return x_classic;
 }
 
-inline size_t Circuit_preprocessor::who_is_ahead(std::array<size_t,2>& i_p1, std::array<size_t,2>& i_p2, const sVector3d& p1, 
-    const sVector3d& p2, const sVector3d& p_ref)
+
+template<bool closed>
+inline std::vector<scalar> Circuit_preprocessor::compute_breakpoints_arclength(const std::vector<sVector3d>& r_curve, 
+    const std::vector<scalar>& s_curve, const std::vector<std::pair<sVector3d,scalar>>& ds_breakpoints)
 {
-    if ((i_p1.front() == i_p2.front()) && (i_p1.back() == i_p2.back()) )
+    std::vector<scalar> s_breakpoints(ds_breakpoints.size());
+
+    for (size_t i = 0; i < ds_breakpoints.size(); ++i)
     {
-        if ( i_p1.front() == i_p1.back() )
-            // Impossible to know with this information, we just arbitrarily say number 1
-            return 1;
+        // (1) Find the closest point to the breakpoint in the curve
+        std::array<size_t,2> i_break; 
+        sVector3d v_closest_break;
+        std::tie(v_closest_break,std::ignore,i_break) = find_closest_point<scalar>(r_curve, ds_breakpoints[i].first, closed, 0, 1.0e18);
 
-        else
-            // Choose the one farthest to the reference point
-            return (norm(p1-p_ref) > norm(p2-p_ref) ? 1 : 2);
+        // (2) Its arclength is the one of the segment start plus the distance travelled within the segment
+        s_breakpoints[i] = s_curve[i_break.front()] + norm(v_closest_break - r_curve[i_break.front()]);
     }
-    else 
-        return ((i_p1.front() < i_p2.front()) ? 2 : 1); 
+
+    return s_breakpoints;
+}
+
+
+inline scalar Circuit_preprocessor::compute_ds_for_arclength(const scalar s, const std::vector<scalar>& s_breakpoints, 
+    const std::vector<std::pair<sVector3d,scalar>>& ds_breakpoints, size_t& i_break)
+{
+    // (1) Advance the cursor until the first breakpoint ahead of s. Since s is non-decreasing between calls,
+    //     every breakpoint skipped in previous calls is still behind, and the cursor never goes back
+    while ( (i_break < s_breakpoints.size()) && (s_breakpoints[i_break] <= s) )
+        ++i_break;
+
+    // (2) Return the size of the breakpoint behind it, or the last one if none is ahead
+    if ( i_break < s_breakpoints.size() )
+        return ds_breakpoints[i_break-1].second;
+    else
+        return ds_breakpoints.back().second;
 }
 
 #endif
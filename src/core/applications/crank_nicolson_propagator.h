@@ -0,0 +1,119 @@
+#ifndef __CRANK_NICOLSON_PROPAGATOR_H__
+#define __CRANK_NICOLSON_PROPAGATOR_H__
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <algorithm>
+#include <type_traits>
+#include "lion/foundation/types.h"
+#include "lion/thirdparty/include/cppad/cppad.hpp"
+#include "src/core/foundation/fastest_lap_exception.h"
+
+//!      Crank-Nicolson propagator
+//!      -------------------------
+//!
+//! Takes steps of the scheme used by Optimal_laptime, q(k+1) - q(k) = ds.((1-sigma).f(k) + sigma.f(k+1)), g(k+1) = 0,
+//! solving for y = [q(k+1), qa(k+1)] with Newton-like iterations. Unlike lion's Crank_nicolson, the propagator is an object
+//! that keeps the Jacobian of the last step, so that long propagations do not need to recompute it at every iteration.
+//!
+//!     - The Jacobian is computed with AD, and factorized (LU with partial pivoting) once per evaluation
+//!     - With stale Jacobians, an iteration that does not reduce the residual by contraction_factor triggers a new Jacobian
+//!       at the current iterate. The Jacobian is also discarded when a step fails
+//!
+//! The Dynamic_model_t must be an AD vehicle (as in propagate_vehicle)
+template<typename Dynamic_model_t>
+class Crank_nicolson_propagator
+{
+ public:
+    constexpr static size_t NSTATE     = Dynamic_model_t::NSTATE;
+    constexpr static size_t NALGEBRAIC = Dynamic_model_t::NALGEBRAIC;
+    constexpr static size_t NCONTROL   = Dynamic_model_t::NCONTROL;
+    constexpr static size_t NY         = NSTATE + NALGEBRAIC;
+
+    static_assert(std::is_same_v<typename Dynamic_model_t::Timeseries_type,CppAD::AD<scalar>>, "Crank_nicolson_propagator requires an AD vehicle");
+
+    //! How the Jacobian of the iterations is obtained:
+    //!     (1) Newton: recomputed at every iteration
+    //!     (2) Frozen: computed at the first iteration of every step, and kept for the rest of the step (chord method)
+    //!     (3) Reuse: kept across steps, recomputed when the iterations stall, or after maximum_jacobian_age steps
+    //!     (4) Broyden: as reuse, but every iteration applies a rank-one (good Broyden) update to the inverse Jacobian
+    enum Jacobian_mode { NEWTON, FROZEN, REUSE, BROYDEN };
+
+    struct Options
+    {
+        scalar sigma                = 0.5;       // 0: explicit euler, 0.5: crank-nicolson, 1.0: implicit euler
+        size_t max_iter             = 10;        // Maximum number of iterations per step
+        scalar error_tolerance      = 1.0e-10;   // Tolerance on the infinity norm of the residual
+        scalar relaxation_factor    = 1.0;       // Fraction of the Newton step taken at each iteration
+        Jacobian_mode jacobian_mode = NEWTON;
+        size_t maximum_jacobian_age = 100;       // Reuse/Broyden: steps after which the Jacobian is recomputed
+        scalar contraction_factor   = 0.5;       // Stale Jacobians are recomputed if the residual decreases less than this factor
+    };
+
+    struct Statistics
+    {
+        size_t n_steps                = 0;
+        size_t n_iterations           = 0;
+        size_t n_jacobian_evaluations = 0;
+    };
+
+    //! Constructor
+    //! @param[in] options: options of the propagator
+    Crank_nicolson_propagator(const Options& options = Options{}) : _options(options) {}
+
+    //! Take one step from s to s+ds. The Jacobian of the previous steps is used if the options allow it
+    //! @param[in] car: vehicle
+    //! @param[in] u: controls at s
+    //! @param[in] u_next: controls at s+ds
+    //! @param[in,out] q: states at s on input, states at s+ds on output
+    //! @param[in,out] qa: algebraic variables at s on input, at s+ds on output
+    //! @param[in] s: current value of the independent variable (time or arclength)
+    //! @param[in] ds: step size
+    void take_step(Dynamic_model_t& car, const std::array<scalar,NCONTROL>& u, const std::array<scalar,NCONTROL>& u_next,
+                   std::array<scalar,NSTATE>& q, std::array<scalar,NALGEBRAIC>& qa, const scalar s, const scalar ds);
+
+    //! Change the options. The stored Jacobian is kept unless the Jacobian mode changes
+    void set_options(const Options& options);
+
+    const Options& get_options() const { return _options; }
+
+    const Statistics& get_statistics() const { return _statistics; }
+
+    //! Discard the stored Jacobian
+    void reset() { _has_jacobian = false; }
+
+ private:
+    Options _options;
+    Statistics _statistics;
+
+    bool _has_jacobian   = false;
+    size_t _jacobian_age = 0;               //! Number of steps since the Jacobian was computed
+    std::vector<scalar> _lu;                //! LU factors of the Jacobian of the residual (NY x NY, row major)
+    std::vector<size_t> _pivots;            //! Row permutation of the LU factors
+    std::vector<scalar> _inverse;           //! Broyden: approximation of the inverse of the Jacobian of the residual
+
+    //! Evaluate [f, g] at a point
+    static std::vector<scalar> evaluate(Dynamic_model_t& car, const std::vector<scalar>& y, const std::array<scalar,NCONTROL>& u, const scalar s);
+
+    //! Evaluate the Jacobian of [f, g] w.r.t. [q, qa] at a point (NY x NY, row major)
+    static std::vector<scalar> evaluate_jacobian(Dynamic_model_t& car, const std::vector<scalar>& y, const std::array<scalar,NCONTROL>& u, const scalar s);
+
+    //! Compute and factorize the Jacobian of the residual at y
+    void update_jacobian(Dynamic_model_t& car, const std::vector<scalar>& y, const std::array<scalar,NCONTROL>& u, const scalar s, const scalar ds);
+
+    //! Solve J.dy = residual with the stored Jacobian (or its Broyden inverse)
+    std::vector<scalar> solve(const std::vector<scalar>& residual) const;
+
+    //! LU factorization with partial pivoting, in place
+    static void lu_factorize(std::vector<scalar>& A, std::vector<size_t>& pivots, const size_t n);
+
+    //! Solve A.x = b from the LU factors of A
+    static std::vector<scalar> lu_solve(const std::vector<scalar>& LU, const std::vector<size_t>& pivots, std::vector<scalar> b, const size_t n);
+};
+
+#include "crank_nicolson_propagator.hpp"
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef __CRANK_NICOLSON_PROPAGATOR_HPP__
+#define __CRANK_NICOLSON_PROPAGATOR_HPP__
+
+template<typename Dynamic_model_t>
+inline void Crank_nicolson_propagator<Dynamic_model_t>::take_step(Dynamic_model_t& car, const std::array<scalar,NCONTROL>& u,
+    const std::array<scalar,NCONTROL>& u_next, std::array<scalar,NSTATE>& q, std::array<scalar,NALGEBRAIC>& qa, const scalar s, const scalar ds)
+{
+    const scalar sigma       = _options.sigma;
+    const Jacobian_mode mode = _options.jacobian_mode;
+
+    // (1) Derivatives at the beginning of the step
+    std::vector<scalar> y(NY);
+    std::copy(q.cbegin(), q.cend(), y.begin());
+    std::copy(qa.cbegin(), qa.cend(), y.begin() + NSTATE);
+
+    const auto f = evaluate(car, y, u, s);
+
+    // (2) Discard the stored Jacobian if it cannot be used in this step
+    if ( (mode == NEWTON) || (mode == FROZEN) || (_jacobian_age >= _options.maximum_jacobian_age) )
+        _has_jacobian = false;
+
+    // (3) Iterations on y_next = [q(k+1), qa(k+1)], starting from [q(k), qa(k)]
+    auto compute_residual = [&](const std::vector<scalar>& y_next) -> std::vector<scalar>
+    {
+        const auto f_next = evaluate(car, y_next, u_next, s + ds);
+        std::vector<scalar> residual(NY);
+
+        for (size_t i = 0; i < NSTATE; ++i)
+            residual[i] = y_next[i] - y[i] - ds*((1.0-sigma)*f[i] + sigma*f_next[i]);
+
+        for (size_t i = NSTATE; i < NY; ++i)
+            residual[i] = f_next[i];
+
+        return residual;
+    };
+
+    auto norm = [](const std::vector<scalar>& v) -> scalar
+    {
+        scalar result = 0.0;
+        for (const auto& v_i : v)
+        {
+            if ( !std::isfinite(v_i) )
+                return std::numeric_limits<scalar>::infinity();
+
+            result = std::max(result, std::abs(v_i));
+        }
+
+        return result;
+    };
+
+    std::vector<scalar> y_next(y);
+    auto residual = compute_residual(y_next);
+    scalar residual_norm = norm(residual);
+
+    for (size_t iter = 0; residual_norm >= _options.error_tolerance; ++iter)
+    {
+        if ( iter == _options.max_iter )
+        {
+            _has_jacobian = false;
+            throw fastest_lap_exception("[ERROR] Crank_nicolson_propagator::take_step -> the iterations did not converge at s = "
+                + std::to_string(s) + ". Residual: " + std::to_string(residual_norm));
+        }
+
+        ++_statistics.n_iterations;
+
+        // (3.1) Jacobian
+        const bool is_fresh = ( !_has_jacobian || (mode == NEWTON) );
+
+        if ( is_fresh )
+            update_jacobian(car, y_next, u_next, s + ds, ds);
+
+        // (3.2) Update
+        const auto dy = solve(residual);
+
+        std::vector<scalar> y_new(NY);
+        for (size_t i = 0; i < NY; ++i)
+            y_new[i] = y_next[i] - _options.relaxation_factor*dy[i];
+
+        const auto residual_new = compute_residual(y_new);
+        const scalar residual_new_norm = norm(residual_new);
+
+        // (3.3) A stale Jacobian that does not contract is computed again. If the residual grew, the update is rejected
+        if ( !is_fresh && (residual_new_norm > _options.contraction_factor*residual_norm) )
+        {
+            _has_jacobian = false;
+
+            if ( residual_new_norm > residual_norm )
+                continue;
+        }
+
+        // (3.4) Broyden: rank-one update of the inverse Jacobian, H += (dy - H.dr).(dy'.H)/(dy'.H.dr)
+        if ( (mode == BROYDEN) && _has_jacobian )
+        {
+            std::vector<scalar> delta_y(NY), delta_r(NY);
+            for (size_t i = 0; i < NY; ++i)
+            {
+                delta_y[i] = y_new[i] - y_next[i];
+                delta_r[i] = residual_new[i] - residual[i];
+            }
+
+            std::vector<scalar> H_delta_r(NY, 0.0), delta_y_H(NY, 0.0);
+            for (size_t i = 0; i < NY; ++i)
+                for (size_t j = 0; j < NY; ++j)
+                {
+                    H_delta_r[i] += _inverse[i*NY + j]*delta_r[j];
+                    delta_y_H[j] += delta_y[i]*_inverse[i*NY + j];
+                }
+
+            scalar denominator = 0.0;
+            for (size_t i = 0; i < NY; ++i)
+                denominator += delta_y[i]*H_delta_r[i];
+
+            if ( std::abs(denominator) > std::numeric_limits<scalar>::epsilon()*norm(delta_y)*norm(H_delta_r) )
+            {
+                for (size_t i = 0; i < NY; ++i)
+                    for (size_t j = 0; j < NY; ++j)
+                        _inverse[i*NY + j] += (delta_y[i] - H_delta_r[i])*delta_y_H[j]/denominator;
+            }
+        }
+
+        y_next        = y_new;
+        residual      = residual_new;
+        residual_norm = residual_new_norm;
+    }
+
+    // (4) Return the solution
+    std::copy_n(y_next.cbegin(), NSTATE, q.begin());
+    std::copy_n(y_next.cbegin() + NSTATE, NALGEBRAIC, qa.begin());
+
+    ++_jacobian_age;
+    ++_statistics.n_steps;
+}
+
+
+template<typename Dynamic_model_t>
+inline void Crank_nicolson_propagator<Dynamic_model_t>::set_options(const Options& options)
+{
+    if ( (options.jacobian_mode != _options.jacobian_mode) || (options.sigma != _options.sigma) )
+        _has_jacobian = false;
+
+    _options = options;
+}
+
+
+template<typename Dynamic_model_t>
+inline std::vector<scalar> Crank_nicolson_propagator<Dynamic_model_t>::evaluate(Dynamic_model_t& car, const std::vector<scalar>& y,
+    const std::array<scalar,NCONTROL>& u, const scalar s)
+{
+    std::array<CppAD::AD<scalar>,NSTATE>     q;
+    std::array<CppAD::AD<scalar>,NALGEBRAIC> qa;
+    std::array<CppAD::AD<scalar>,NCONTROL>   u_ad;
+
+    std::copy_n(y.cbegin(), NSTATE, q.begin());
+    std::copy_n(y.cbegin() + NSTATE, NALGEBRAIC, qa.begin());
+    std::copy(u.cbegin(), u.cend(), u_ad.begin());
+
+    const auto [dqds, dqa] = car(q, qa, u_ad, s);
+
+    std::vector<scalar> values(NY);
+
+    for (size_t i = 0; i < NSTATE; ++i)
+        values[i] = CppAD::Value(dqds[i]);
+
+    for (size_t i = 0; i < NALGEBRAIC; ++i)
+        values[NSTATE + i] = CppAD::Value(dqa[i]);
+
+    return values;
+}
+
+
+template<typename Dynamic_model_t>
+inline std::vector<scalar> Crank_nicolson_propagator<Dynamic_model_t>::evaluate_jacobian(Dynamic_model_t& car, const std::vector<scalar>& y,
+    const std::array<scalar,NCONTROL>& u, const scalar s)
+{
+    // (1) Record the vehicle with independent variables x = [q,qa]
+    std::vector<CppAD::AD<scalar>> x(y.cbegin(), y.cend());
+
+    CppAD::Independent(x);
+
+    std::array<CppAD::AD<scalar>,NSTATE>     q;
+    std::array<CppAD::AD<scalar>,NALGEBRAIC> qa;
+    std::array<CppAD::AD<scalar>,NCONTROL>   u_ad;
+
+    std::copy_n(x.cbegin(), NSTATE, q.begin());
+    std::copy_n(x.cbegin() + NSTATE, NALGEBRAIC, qa.begin());
+    std::copy(u.cbegin(), u.cend(), u_ad.begin());
+
+    auto [dqds, dqa] = car(q, qa, u_ad, s);
+
+    std::vector<CppAD::AD<scalar>> values(dqds.cbegin(), dqds.cend());
+    values.insert(values.end(), dqa.cbegin(), dqa.cend());
+
+    CppAD::ADFun<scalar> tape(x, values);
+
+    // (2) Jacobian, row major
+    return tape.Jacobian(y);
+}
+
+
+template<typename Dynamic_model_t>
+inline void Crank_nicolson_propagator<Dynamic_model_t>::update_jacobian(Dynamic_model_t& car, const std::vector<scalar>& y,
+    const std::array<scalar,NCONTROL>& u, const scalar s, const scalar ds)
+{
+    const auto jacobian = evaluate_jacobian(car, y, u, s);
+
+    // (1) Jacobian of the residual: [I - ds.sigma.df/dy ; dg/dy]
+    _lu.resize(NY*NY);
+
+    for (size_t i = 0; i < NSTATE; ++i)
+        for (size_t j = 0; j < NY; ++j)
+            _lu[i*NY + j] = (i == j ? 1.0 : 0.0) - ds*_options.sigma*jacobian[i*NY + j];
+
+    for (size_t i = NSTATE; i < NY; ++i)
+        for (size_t j = 0; j < NY; ++j)
+            _lu[i*NY + j] = jacobian[i*NY + j];
+
+    // (2) Factorize, and invert for Broyden
+    lu_factorize(_lu, _pivots, NY);
+
+    if ( _options.jacobian_mode == BROYDEN )
+    {
+        _inverse.resize(NY*NY);
+
+        for (size_t j = 0; j < NY; ++j)
+        {
+            std::vector<scalar> e_j(NY, 0.0);
+            e_j[j] = 1.0;
+
+            const auto column = lu_solve(_lu, _pivots, e_j, NY);
+
+            for (size_t i = 0; i < NY; ++i)
+                _inverse[i*NY + j] = column[i];
+        }
+    }
+
+    _has_jacobian = true;
+    _jacobian_age = 0;
+    ++_statistics.n_jacobian_evaluations;
+}
+
+
+template<typename Dynamic_model_t>
+inline std::vector<scalar> Crank_nicolson_propagator<Dynamic_model_t>::solve(const std::vector<scalar>& residual) const
+{
+    if ( _options.jacobian_mode != BROYDEN )
+        return lu_solve(_lu, _pivots, residual, NY);
+
+    std::vector<scalar> dy(NY, 0.0);
+
+    for (size_t i = 0; i < NY; ++i)
+        for (size_t j = 0; j < NY; ++j)
+            dy[i] += _inverse[i*NY + j]*residual[j];
+
+    return dy;
+}
+
+
+template<typename Dynamic_model_t>
+inline void Crank_nicolson_propagator<Dynamic_model_t>::lu_factorize(std::vector<scalar>& A, std::vector<size_t>& pivots, const size_t n)
+{
+    pivots.resize(n);
+
+    for (size_t col = 0; col < n; ++col)
+    {
+        // (1) Partial pivoting
+        size_t pivot = col;
+        for (size_t r = col + 1; r < n; ++r)
+            if ( std::abs(A[r*n + col]) > std::abs(A[pivot*n + col]) )
+                pivot = r;
+
+        if ( std::abs(A[pivot*n + col]) < std::numeric_limits<scalar>::min() )
+            throw fastest_lap_exception("[ERROR] Crank_nicolson_propagator::lu_factorize -> singular matrix");
+
+        pivots[col] = pivot;
+
+        if ( pivot != col )
+            std::swap_ranges(A.begin() + pivot*n, A.begin() + (pivot+1)*n, A.begin() + col*n);
+
+        // (2) Elimination: store the multipliers below the diagonal
+        for (size_t r = col + 1; r < n; ++r)
+        {
+            const scalar factor = A[r*n + col]/A[col*n + col];
+            A[r*n + col] = factor;
+
+            if ( factor == 0.0 )
+                continue;
+
+            for (size_t c = col + 1; c < n; ++c)
+                A[r*n + c] -= factor*A[col*n + c];
+        }
+    }
+}
+
+
+template<typename Dynamic_model_t>
+inline std::vector<scalar> Crank_nicolson_propagator<Dynamic_model_t>::lu_solve(const std::vector<scalar>& LU, const std::vector<size_t>& pivots,
+    std::vector<scalar> b, const size_t n)
+{
+    // (1) Forward substitution, applying the row permutation
+    for (size_t r = 0; r < n; ++r)
+    {
+        std::swap(b[r], b[pivots[r]]);
+
+        for (size_t c = 0; c < r; ++c)
+            b[r] -= LU[r*n + c]*b[c];
+    }
+
+    // (2) Back substitution
+    for (size_t r = n; r-- > 0; )
+    {
+        for (size_t c = r + 1; c < n; ++c)
+            b[r] -= LU[r*n + c]*b[c];
+
+        b[r] /= LU[r*n + r];
+    }
+
+    return b;
+}
+
+#endif
@@ -1,11 +1,20 @@
 #ifndef __OPTIMAL_LAPTIME_H__
 #define __OPTIMAL_LAPTIME_H__
 
+#include <random>
+#include <chrono>
+#include <numeric>
+#include <functional>
+#include <map>
 #include "lion/thirdparty/include/cppad/cppad.hpp"
+#include "lion/math/ipopt_cppad_handler.hpp"
 #include "lion/foundation/types.h"
 #include "src/core/vehicles/track_by_arcs.h"
 #include "src/core/vehicles/road_curvilinear.h"
 #include "src/core/foundation/fastest_lap_exception.h"
+#include "src/core/foundation/trace.h"
+#include "src/core/foundation/tape_profiler.h"
+#include "src/core/foundation/synchronized_output.h"
 
 template<typename Dynamic_model_t>
 class Optimal_laptime
@@ -16,6 +25,15 @@ class Optimal_laptime
     using Timeseries_t = typename Dynamic_model_t::Timeseries_type;
     static_assert(std::is_same<Timeseries_t,CppAD::AD<scalar>>::value == true);
 
+    //! Strategies to recover from a failed optimization, tried in the given order:
+    //!     (1) Restart from the last iterate, without multipliers, and with the adaptive barrier parameter update
+    //!     (2) Solve with the other control formulation (direct/derivative), and use it as initial guess
+    //!     (3) Construct the initial guess from coarser meshes (see Options::multilevel_coarsening)
+    //!     (4) Relax the optimization tolerances by a factor 100
+    enum Recovery_strategy { RESTART_ADAPTIVE_MU, SWITCH_FORMULATION, COARSE_MESH, RELAX_TOLERANCES };
+
+    struct Parameter_sensitivity;
+
     struct Options
     {
         struct Integral_quantity_conf
@@ -25,6 +43,16 @@ class Optimal_laptime
             scalar upper_bound;
         };
 
+        //! Selects which outputs are kept once the optimization finishes. Discarded buffers are released
+        struct Output_specification
+        {
+            bool solution                   = true;    // q, qa, and the control variables values
+            bool coordinates                = true;    // x_coord, y_coord, and psi
+            bool optimization_data          = true;    // x, bounds, multipliers, and scaling (needed for warm start/reoptimize_window)
+            std::vector<std::string> channels = {};    // State, algebraic state, or control names (and "x", "y", "psi") 
+                                                       // copied to Optimal_laptime::channels
+        };
+
         size_t print_level                = 0;
         scalar sigma                      = 0.5;     // 0: explicit euler, 0.5: crank-nicolson, 1.0: implicit euler
         size_t maximum_iterations         = 3000;
@@ -35,6 +63,23 @@ class Optimal_laptime
         scalar constraints_viol_tolerance = 1.0e-10;
         scalar acceptable_tolerance       = 1.0e-8;
         std::vector<Integral_quantity_conf> integral_quantities = {};
+        bool   automatic_scaling          = false;   // Scale variables from their bounds, and constraints from the initial Jacobian
+        size_t scaling_directions         = 4;       // Number of random directions used to estimate the Jacobian rows magnitude
+        scalar scaling_minimum            = 1.0e-6;  // Magnitudes below scaling_minimum are not meaningful (e.g. zero bounds, or 
+                                                     // empty Jacobian rows): their scale factor is 1
+        scalar scaling_maximum            = 1.0e6;   // Scale factors are capped at scaling_maximum
+        std::string ipopt_extra_options   = "";      // Appended as is to the IPOPT options, one option per line
+        std::vector<Recovery_strategy> recovery_strategies = {}; // If the optimization fails, try these in order
+        std::vector<size_t> multilevel_coarsening = {};  // e.g. {8,2}: solve first with one every 8 points, then one every 2 points, 
+                                                         // each level provides the initial guess of the next one
+        bool   fix_final_point            = false;   // Open simulations: fix the variables of the last point to the initial guess
+        bool   quasi_steady_slip          = false;   // Replace the tire longitudinal slip dynamics by the wheel torque balance at 
+                                                     // every point (the slips become algebraic). Removes the stiff wheel modes
+        size_t sensitivity_chunk_size     = 0;       // check_optimality: parameters per sensitivity analysis (0: all at once)
+        std::function<void(const size_t, const Parameter_sensitivity&)> sensitivity_callback = {};
+                                                     // check_optimality: if set, the sensitivities w.r.t. each parameter are streamed
+                                                     // here, and dqdp, dqadp, dcontrol_variablesdp, and dxdp are not stored
+        Output_specification output       = {};      // Outputs retained after the optimization (default: all)
     };
 
     //! Helper classes to encapsulate control variables ---------------------------------------------:-
@@ -130,8 +175,24 @@ class Optimal_laptime
             return *this;
         }
 
+        //! Resolve the layout of the controls on a mesh: the default values of the controls not optimized, the controls
+        //! of each type, and the hypermesh position of every mesh point. control_array_at_s and control_array_and_derivative_at_s
+        //! use it for the points of that mesh, so that no per point lookups are needed. Build it again if the types change
+        //! @param[in] car: the vehicle, provides the default values of the controls
+        //! @param[in] s: the full mesh
+        void build_gather_plan(const Dynamic_model_t& car, const std::vector<scalar>& s);
+
         std::array<T,Dynamic_model_t::NCONTROL> control_array_at_s(const Dynamic_model_t& car, const size_t i_fullmesh, const scalar s) const
         {
+            // (1) Use the gather plan if it was built for this mesh
+            if ( _gather_plan.is_built_for(i_fullmesh, s) )
+            {
+                std::array<T,Dynamic_model_t::NCONTROL> u;
+                gather_controls(i_fullmesh, u);
+                return u;
+            }
+
+            // (2) Otherwise, resolve the layout here
             std::array<scalar,Dynamic_model_t::NCONTROL> u_scalar = car.get_state_and_control_upper_lower_and_default_values().u_def;
             std::array<T,Dynamic_model_t::NCONTROL> u;
 
@@ -165,6 +226,20 @@ class Optimal_laptime
         std::pair<std::array<T,Dynamic_model_t::NCONTROL>,std::array<T,Dynamic_model_t::NCONTROL>>
             control_array_and_derivative_at_s(const Dynamic_model_t& car, const size_t i_fullmesh, const scalar s) const
         {
+            // (1) Use the gather plan if it was built for this mesh
+            if ( _gather_plan.is_built_for(i_fullmesh, s) )
+            {
+                std::array<T,Dynamic_model_t::NCONTROL> u;
+                std::array<T,Dynamic_model_t::NCONTROL> dudt{0.0};
+                gather_controls(i_fullmesh, u);
+
+                for (const size_t j : _gather_plan.full_mesh_controls)
+                    dudt[j] = (*this)[j].dudt[i_fullmesh];
+
+                return {u,dudt};
+            }
+
+            // (2) Otherwise, resolve the layout here
             std::array<T,Dynamic_model_t::NCONTROL> u = car.get_state_and_control_upper_lower_and_default_values().u_def;
             std::array<T,Dynamic_model_t::NCONTROL> dudt{0.0};
 
@@ -211,6 +286,39 @@ class Optimal_laptime
 
      private:
     
+        //! Layout of the controls on a mesh (see build_gather_plan)
+        struct Gather_plan
+        {
+            std::vector<scalar> s;                                  //! Mesh the plan was built for (empty if not built)
+            std::array<scalar,Dynamic_model_t::NCONTROL> u_def;     //! Default values of the controls
+            std::vector<size_t> constant_controls;                  //! Indexes of the controls of each type
+            std::vector<size_t> hypermesh_controls;
+            std::vector<size_t> full_mesh_controls;
+            std::vector<std::vector<size_t>> hypermesh_positions;   //! [k][i]: position of s[i] in the hypermesh of hypermesh_controls[k]
+
+            bool is_built_for(const size_t i, const scalar s_i) const { return (i < s.size()) && (s[i] == s_i); }
+        };
+
+        Gather_plan _gather_plan;
+
+        //! Fill the controls at a point of the mesh of the gather plan
+        void gather_controls(const size_t i_fullmesh, std::array<T,Dynamic_model_t::NCONTROL>& u) const
+        {
+            std::copy(_gather_plan.u_def.cbegin(), _gather_plan.u_def.cend(), u.begin());
+
+            for (const size_t j : _gather_plan.constant_controls)
+                u[j] = (*this)[j].u.front();
+
+            for (size_t k = 0; k < _gather_plan.hypermesh_controls.size(); ++k)
+            {
+                const size_t j = _gather_plan.hypermesh_controls[k];
+                u[j] = (*this)[j].u[_gather_plan.hypermesh_positions[k][i_fullmesh]];
+            }
+
+            for (const size_t j : _gather_plan.full_mesh_controls)
+                u[j] = (*this)[j].u[i_fullmesh];
+        }
+
         //! Checks the consistency of the sizes of the input vectors depending on the optimization case
         void check_inputs();
     
@@ -283,6 +391,7 @@ class Optimal_laptime
 
     Optimal_laptime(Xml_document& doc);
 
+    //! Solve the problem. If the optimization fails, the strategies in options.recovery_strategies are tried in order
     void compute(const Dynamic_model_t& car);
 
     template<bool isClosed>
@@ -294,6 +403,50 @@ class Optimal_laptime
     //! Export to XML
     std::unique_ptr<Xml_document> xml() const;
 
+    //! Profile the AD tape of the vehicle equations at every mesh point, split by component (road, chassis, 
+    //! axle, tire, engine, integral quantities). The current states and controls are used as recording point
+    //! @param[in] car: the vehicle
+    //! @param[in] points: mesh points to be profiled (empty: all)
+    //! @param[in] n_sweeps: number of sweeps averaged for the timings
+    //! @return one report per profiled point
+    std::vector<Tape_profiler::Report> profile_tape(const Dynamic_model_t& car, std::vector<size_t> points = {}, const size_t n_sweeps = 10) const;
+
+    //! Sensitivities of the solution with respect to one vehicle parameter (see Options::sensitivity_callback)
+    struct Parameter_sensitivity
+    {
+        std::vector<std::array<scalar,Dynamic_model_t::NSTATE>>     dqdp;
+        std::vector<std::array<scalar,Dynamic_model_t::NALGEBRAIC>> dqadp;
+        Control_variables<>                                         dcontrol_variablesdp;
+        scalar                                                      dlaptimedp;
+    };
+
+    //! Sensitivities of the laptime with respect to the track geometry at every mesh point
+    struct Track_sensitivities
+    {
+        std::vector<scalar> dlaptimedwl;        //! Derivative w.r.t. the distance to the left track limit [s/m]
+        std::vector<scalar> dlaptimedwr;        //! Derivative w.r.t. the distance to the right track limit [s/m]
+        std::vector<scalar> dlaptimedkappa;     //! Derivative w.r.t. the track curvature [s.m]
+    };
+
+    //! Compute the sensitivities of the laptime with respect to the track limits and curvature at the mesh points.
+    //! From the envelope theorem, at the optimum they are the partial derivatives of the Lagrangian, evaluated with the
+    //! multipliers of the solution: no new optimization is needed, and the whole profile costs one reverse AD sweep.
+    //! They are the derivatives of the cost function, i.e. the laptime plus the penalisation of the controls
+    //! @param[in] car: the vehicle used to compute the solution
+    Track_sensitivities compute_track_sensitivities(const Dynamic_model_t& car) const;
+
+    //! Re-optimize the window [i_start, i_end] of this solution, and splice the result back, e.g. after a local change of the
+    //! track or the vehicle. The window is solved as an open simulation warm started from this solution, with its first and last
+    //! points fixed, so the rest of the lap is kept and only its time is shifted. Constant and hypermesh controls, and restricted
+    //! integral quantities, are not supported, since they couple the window with the rest of the lap. The values of the integral
+    //! quantities are updated with the difference between the new and the old contributions of the window
+    //! @param[in] car: the vehicle used in the window
+    //! @param[in] i_start: first point of the window
+    //! @param[in] i_end: last point of the window
+    //! @return the solution of the window. If its optimization fails, the lap is not modified: the function throws if 
+    //!         options.throw_if_fail, otherwise the returned window has success = false
+    Optimal_laptime reoptimize_window(const Dynamic_model_t& car, const size_t i_start, const size_t i_end);
+
     Options options;
     
     struct Integral_quantity
@@ -325,6 +478,13 @@ class Optimal_laptime
         }
     } integral_quantities;
 
+    //! Integrate the integral quantities of the current solution over the elements between the points i_start and i_end,
+    //! with the quadrature used in the optimization
+    //! @param[in] car: the vehicle
+    //! @param[in] i_start: first point
+    //! @param[in] i_end: last point
+    std::array<scalar,Integral_quantities::N> integrate_quantities(const Dynamic_model_t& car, const size_t i_start, const size_t i_end) const;
+
     // Outputs
     bool success;
     bool is_closed;
@@ -339,9 +499,20 @@ class Optimal_laptime
     std::vector<scalar> x_coord;
     std::vector<scalar> y_coord;
     std::vector<scalar> psi;
+    std::map<std::string,std::vector<scalar>> channels;  //! Channels requested in options.output.channels
 
     size_t iter_count;  //! Number of iterations spent in IPOPT
 
+    struct Recovery_attempt
+    {
+        std::string strategy;
+        bool        success;
+        size_t      iter_count;
+        scalar      elapsed_time;   //! [s]
+    };
+
+    std::vector<Recovery_attempt> recovery_attempts;  //! Log of the attempts performed (only if options.recovery_strategies is not empty)
+
     std::vector<std::vector<std::array<scalar,Dynamic_model_t::NSTATE>>>     dqdp;
     std::vector<std::vector<std::array<scalar,Dynamic_model_t::NALGEBRAIC>>> dqadp;
     std::vector<Control_variables<>>                                         dcontrol_variablesdp;
@@ -361,6 +532,8 @@ class Optimal_laptime
         std::vector<scalar> s;
         std::vector<scalar> vl;
         std::vector<scalar> vu;
+        std::vector<scalar> x_scaling;  //! Variable scale factors used by the optimizer (only if options.automatic_scaling)
+        std::vector<scalar> c_scaling;  //! Constraint scale factors used by the optimizer (only if options.automatic_scaling)
     } optimization_data;            //! Auxiliary class to store the optimization data
 
     scalar laptime;
@@ -369,6 +542,33 @@ class Optimal_laptime
     
     void check_inputs(const Dynamic_model_t& car);
 
+    //! Solve the problem with the current formulation (direct/derivative) and initial guess
+    void compute_formulation(const Dynamic_model_t& car);
+
+    //! Solve the problem, and try the recovery strategies in order if the optimization fails
+    void compute_with_recovery(const Dynamic_model_t& car);
+
+    //! Check that the channels requested in options.output exist, before any optimization is run
+    void check_output_specification() const;
+
+    //! Fill the channels requested in options.output, and release the outputs that are not retained
+    void apply_output_specification(const Dynamic_model_t& car);
+
+    //! Change between direct and derivative formulations, adapting the full mesh control variables
+    void switch_formulation();
+
+    //! Solve the problem on the sequence of coarser meshes given by options.multilevel_coarsening, and use
+    //! the results as initial guess for this mesh. The final problem solved is not modified
+    //! The levels differ in mesh resolution only: every level solves the full vehicle model. Reduced models 
+    //! (point-mass, single-track) would need their own Dynamic_model_car classes, which are not available
+    //! @param[in] car: vehicle
+    void compute_multilevel_initial_guess(const Dynamic_model_t& car);
+
+    //! Linearly interpolate states, algebraic states and controls from a solution on a coarser mesh
+    //! @param[in] coarse: solution computed on a mesh whose points are a subset of this mesh
+    //! @param[in] track_length: length of the track, used to close the last element of closed simulations
+    void interpolate_from_coarse_solution(const Optimal_laptime& coarse, const scalar track_length);
+
     struct Export_solution
     {
         std::vector<std::array<scalar,Dynamic_model_t::NSTATE>> q;
@@ -379,6 +579,64 @@ class Optimal_laptime
 
     template<typename FG_t>
     Export_solution export_solution(FG_t& fg, const std::vector<scalar>& x) const;
+
+    //! Run IPOPT on the problem given by the fitness function, bounds and initial point. Applies the automatic scaling if
+    //! requested, the returned result is always given in physical units
+    template<typename FG_t>
+    CppAD::ipopt_cppad_result<std::vector<scalar>> solve_nlp(FG_t& fg, const std::vector<scalar>& x0, 
+        const std::vector<scalar>& x_lb, const std::vector<scalar>& x_ub, 
+        const std::vector<scalar>& c_lb, const std::vector<scalar>& c_ub);
+
+    //! Compute the variables and constraints scale factors, stored in optimization_data.x_scaling and c_scaling
+    //! The constraints estimate needs a tape of the NLP at x0: it is recorded here, since ipopt_cppad_solve records
+    //! its own tape internally and does not expose it. This costs one extra recording plus scaling_directions forward sweeps
+    template<typename FG_t>
+    void compute_nlp_scaling(FG_t& fg, const std::vector<scalar>& x0, const std::vector<scalar>& x_lb, const std::vector<scalar>& x_ub);
+
+    //! Gradient of the Lagrangian of the NLP with respect to curvature perturbations at the mesh points, at the solution
+    template<typename FG_t>
+    std::vector<scalar> curvature_lagrangian_gradient(FG_t& fg) const;
+
+    //! Compute the sensitivities w.r.t. the vehicle parameters, in chunks of options.sensitivity_chunk_size parameters. They are
+    //! stored in dqdp, dqadp, dcontrol_variablesdp, and dxdp, or streamed to options.sensitivity_callback if given. The solution 
+    //! (q, s) must be already exported
+    template<typename FG_t>
+    void compute_parameter_sensitivities(FG_t& fg, const Dynamic_model_t& car, const CppAD::ipopt_cppad_result<std::vector<scalar>>& result,
+        const std::vector<scalar>& x_lb, const std::vector<scalar>& x_ub, const std::vector<scalar>& c_lb, const std::vector<scalar>& c_ub);
+
+    //! Transform the derivative of the optimization variables w.r.t. one parameter into states, controls and laptime derivatives
+    template<typename FG_t>
+    Parameter_sensitivity export_parameter_sensitivity(FG_t& fg, const std::vector<scalar>& dxdp_i, const scalar track_length) const;
+
+    //! Fitness function restricted to a contiguous range of the vehicle parameters: the rest are kept constant. Used to
+    //! run the sensitivity analysis by chunks
+    template<typename FG_t>
+    class FG_parameter_chunk
+    {
+     public:
+        using ADvector = typename FG_t::ADvector;
+
+        FG_parameter_chunk(FG_t& fg, const std::vector<scalar>& p, const size_t i_start) : _fg(fg), _p(p), _i_start(i_start) {}
+
+        const size_t& get_n_variables() const { return _fg.get_n_variables(); }
+
+        const size_t& get_n_constraints() const { return _fg.get_n_constraints(); }
+
+        void operator()(ADvector& fg, const ADvector& x) { _fg(fg, x); }
+
+        void operator()(ADvector& fg, const ADvector& x, const ADvector& p_chunk)
+        {
+            ADvector p(_p.cbegin(), _p.cend());
+            std::copy(p_chunk.cbegin(), p_chunk.cend(), p.begin() + _i_start);
+
+            _fg(fg, x, p);
+        }
+
+     private:
+        FG_t& _fg;
+        const std::vector<scalar>& _p;
+        size_t _i_start;
+    };
     
 
     //! Auxiliary class to hold data structures to compute the fitness function and constraints
@@ -404,7 +662,11 @@ class Optimal_laptime
               _qa0(qa0), _u0(u0), _integral_quantities(integral_quantities), _sigma(sigma), _n_variables(n_variables),
               _n_constraints(n_constraints), _q(n_points,{0.0}), _qa(n_points), _control_variables(control_variables_0.to_CppAD().clear()), 
               _dqdt(n_points,{0.0}), _dqa(n_points), _integral_quantities_integrands(n_points), 
-              _integral_quantities_values() {}
+              _integral_quantities_values() 
+        {
+            // The layout of the controls is fixed during the optimization: resolve it once for all the evaluations
+            _control_variables.build_gather_plan(_car, _s);
+        }
 
      public:
         const size_t& get_n_variables() const { return _n_variables; }
@@ -427,7 +689,59 @@ class Optimal_laptime
 
         Dynamic_model_t& get_car() { return _car; }
 
+        //! Treat the tire longitudinal slips of the vehicle as quasi-steady (see Options::quasi_steady_slip)
+        void set_quasi_steady_slip(const bool quasi_steady_slip)
+        {
+            if ( quasi_steady_slip )
+            {
+                _quasi_steady_states = Dynamic_model_t::get_slip_states();
+
+                if ( std::none_of(_quasi_steady_states.cbegin(), _quasi_steady_states.cend(), [](const bool is_slip) { return is_slip; }) )
+                    throw fastest_lap_exception("[ERROR] Optimal_laptime::FG::set_quasi_steady_slip -> the vehicle has no tire slip states");
+            }
+            else
+                std::fill(_quasi_steady_states.begin(), _quasi_steady_states.end(), false);
+        }
+
+        //! Set the NLP scaling: the optimizer works with x/x_scaling and g/c_scaling. Empty vectors remove the scaling
+        void set_scaling(const std::vector<scalar>& x_scaling, const std::vector<scalar>& c_scaling) 
+        { 
+            _x_scaling = x_scaling; 
+            _c_scaling = c_scaling; 
+        }
+
      protected:
+
+        bool is_scaled() const { return _x_scaling.size() > 0; }
+
+        //! Equation of the j-th state in the element [i_prev,i] of length ds:
+        //!     (1) Dynamic states: q^{i} = q^{i-1} + ds.[(1-sigma).dqdt^{i-1} + sigma.dqdt^{i}]
+        //!     (2) Quasi-steady states: dqdt^{i} = 0, i.e. the equilibrium at the point i
+        Timeseries_t state_equation(const size_t i_prev, const size_t i, const scalar ds, const size_t j) const
+        {
+            if ( _quasi_steady_states[j] )
+                return _dqdt[i][j];
+            else
+                return _q[i][j] - _q[i_prev][j] - ds*((1.0-_sigma)*_dqdt[i_prev][j] + _sigma*_dqdt[i][j]);
+        }
+
+        //! Transform the scaled optimization variables into physical variables
+        ADvector unscale_variables(const ADvector& x) const
+        {
+            ADvector x_unscaled(x.size());
+            for (size_t i = 0; i < x.size(); ++i)
+                x_unscaled[i] = x[i]*_x_scaling[i];
+
+            return x_unscaled;
+        }
+
+        //! Scale the constraints. The fitness function (fg[0]) is not scaled
+        void scale_constraints(ADvector& fg) const
+        {
+            for (size_t i = 0; i < _c_scaling.size(); ++i)
+                fg[i+1] /= _c_scaling[i];
+        }
+
         size_t _n_elements;                 //! [c] Number of discretization elements
         size_t _n_points;                   //! [c] Number of discretization points
         Dynamic_model_t _car;               //! Vehicle
@@ -451,6 +765,11 @@ class Optimal_laptime
 
         std::vector<std::array<Timeseries_t,Integral_quantities::N>> _integral_quantities_integrands;
         std::array<Timeseries_t,Integral_quantities::N>              _integral_quantities_values;
+
+        std::vector<scalar> _x_scaling;     //! Variable scale factors (empty: no scaling)
+        std::vector<scalar> _c_scaling;     //! Constraint scale factors (empty: no scaling)
+
+        std::array<bool,Dynamic_model_t::NSTATE> _quasi_steady_states{};   //! States replaced by their equilibrium equation
     };
 
 
@@ -490,14 +809,31 @@ class Optimal_laptime
     
         void operator()(ADvector& fg, const ADvector& x)
         {
-            if ( base_type::_integral_quantities.get_n_restricted() > 0 )
-                compute<true>(fg, x);
+            FASTEST_LAP_TRACE_SCOPE("Optimal_laptime::FG_direct::evaluate");
+
+            if ( base_type::is_scaled() )
+            {
+                evaluate(fg, base_type::unscale_variables(x));
+                base_type::scale_constraints(fg);
+            }
             else
-                compute<false>(fg, x);
+            {
+                evaluate(fg, x);
+            }
         }
 
         template<bool compute_integrated_quantities>
         void compute(ADvector& fg, const ADvector& x);
+
+     private:
+
+        void evaluate(ADvector& fg, const ADvector& x)
+        {
+            if ( base_type::_integral_quantities.get_n_restricted() > 0 )
+                compute<true>(fg, x);
+            else
+                compute<false>(fg, x);
+        }
     };
 
 
@@ -538,16 +874,32 @@ class Optimal_laptime
 
         void operator()(ADvector& fg, const ADvector& x)
         {
-            if ( base_type::_integral_quantities.get_n_restricted() > 0 )
-                compute<true>(fg, x);
+            FASTEST_LAP_TRACE_SCOPE("Optimal_laptime::FG_derivative::evaluate");
+
+            if ( base_type::is_scaled() )
+            {
+                evaluate(fg, base_type::unscale_variables(x));
+                base_type::scale_constraints(fg);
+            }
             else
-                compute<false>(fg, x);
+            {
+                evaluate(fg, x);
+            }
         }
 
         template<bool compute_integrated_quantities>
         void compute(ADvector& fg, const ADvector& x);
 
      private:
+
+        void evaluate(ADvector& fg, const ADvector& x)
+        {
+            if ( base_type::_integral_quantities.get_n_restricted() > 0 )
+                compute<true>(fg, x);
+            else
+                compute<false>(fg, x);
+        }
+
         const std::array<scalar,Dynamic_model_t::NCONTROL> _dudt0;
     };
 
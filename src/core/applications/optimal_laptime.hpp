@@ -15,6 +15,10 @@ inline Optimal_laptime<Dynamic_model_t>::Optimal_laptime(const std::vector<scala
     // (1) Check inputs
     check_inputs(car);
 
+    // (2) Multilevel: improve the initial guess from solutions on coarser meshes
+    if ( options.multilevel_coarsening.size() > 0 )
+        compute_multilevel_initial_guess(car);
+
     // (4) Compute
     compute(car);
 }
@@ -107,6 +111,9 @@ inline void Optimal_laptime<Dynamic_model_t>::check_inputs(const Dynamic_model_t
             }
         }
     }
+
+    // (3.4) Output channels: checked before the multilevel initial guess is computed
+    check_output_specification();
         
     // (4) Set integral constraints
 
@@ -144,6 +151,152 @@ inline void Optimal_laptime<Dynamic_model_t>::check_inputs(const Dynamic_model_t
 }
 
 
+template<typename Dynamic_model_t>
+inline void Optimal_laptime<Dynamic_model_t>::compute_multilevel_initial_guess(const Dynamic_model_t& car)
+{
+    // (1) Options for the coarse levels: failures are not fatal, the previous guess is kept instead
+    Options coarse_options = options;
+    coarse_options.multilevel_coarsening = {};
+    coarse_options.throw_if_fail         = false;
+    coarse_options.check_optimality      = false;
+    coarse_options.recovery_strategies   = {};
+    coarse_options.output                = {};
+
+    for (const size_t coarsening : options.multilevel_coarsening)
+    {
+        if ( coarsening < 2 )
+            throw fastest_lap_exception("[ERROR] Optimal_laptime::compute_multilevel_initial_guess -> coarsening factors must be >= 2");
+
+        // (2) Construct the coarse mesh: one every "coarsening" points. Open simulations keep the last point
+        std::vector<size_t> indexes;
+        for (size_t i = 0; i < n_points; i += coarsening)
+            indexes.push_back(i);
+
+        if ( !is_closed && (indexes.back() != n_points - 1) )
+            indexes.push_back(n_points - 1);
+
+        if ( indexes.size() < 3 )
+        {
+            synchronized_out(2) << "[WARNING] Optimal_laptime -> multilevel coarsening " << coarsening << " leaves less than 3 points. Level skipped" << std::endl;
+            continue;
+        }
+
+        // (3) Restrict the current guess to the coarse mesh
+        const size_t n_coarse = indexes.size();
+        std::vector<scalar> s_coarse(n_coarse);
+        std::vector<std::array<scalar,Dynamic_model_t::NSTATE>> q_coarse(n_coarse);
+        std::vector<std::array<scalar,Dynamic_model_t::NALGEBRAIC>> qa_coarse(n_coarse);
+        auto control_variables_coarse = control_variables;
+
+        for (auto& control_variable : control_variables_coarse)
+        {
+            if ( control_variable.optimal_control_type == FULL_MESH )
+            {
+                control_variable.u = std::vector<scalar>(n_coarse);
+
+                if ( !is_direct )
+                    control_variable.dudt = std::vector<scalar>(n_coarse);
+            }
+        }
+
+        for (size_t i = 0; i < n_coarse; ++i)
+        {
+            s_coarse[i]  = s[indexes[i]];
+            q_coarse[i]  = q[indexes[i]];
+            qa_coarse[i] = qa[indexes[i]];
+
+            for (size_t j = 0; j < Dynamic_model_t::NCONTROL; ++j)
+            {
+                if ( control_variables[j].optimal_control_type == FULL_MESH )
+                {
+                    control_variables_coarse[j].u[i] = control_variables[j].u[indexes[i]];
+
+                    if ( !is_direct )
+                        control_variables_coarse[j].dudt[i] = control_variables[j].dudt[indexes[i]];
+                }
+            }
+        }
+
+        // (4) Solve the coarse problem
+        Optimal_laptime coarse(s_coarse, is_closed, is_direct, car, q_coarse, qa_coarse, control_variables_coarse, coarse_options);
+
+        synchronized_out(2) << "[INFO] Optimal_laptime -> multilevel level with " << n_coarse << " points: success = " << coarse.success 
+               << ", iterations = " << coarse.iter_count << ", laptime = " << coarse.laptime << std::endl;
+
+        if ( !coarse.success )
+            continue;
+
+        // (5) Bring the solution back to this mesh
+        interpolate_from_coarse_solution(coarse, car.get_road().track_length());
+    }
+}
+
+
+template<typename Dynamic_model_t>
+inline void Optimal_laptime<Dynamic_model_t>::interpolate_from_coarse_solution(const Optimal_laptime& coarse, const scalar track_length)
+{
+    for (size_t i = 0; i < n_points; ++i)
+    {
+        // (1) Get the coarse element [i_left,i_right] that contains s[i]
+        const size_t i_left = std::distance(coarse.s.cbegin(), std::upper_bound(coarse.s.cbegin(), coarse.s.cend(), s[i])) - 1;
+        size_t i_right      = i_left + 1;
+        scalar s_right      = 0.0;
+        scalar time_right   = 0.0;
+
+        if ( i_right < coarse.n_points )
+        {
+            s_right    = coarse.s[i_right];
+            time_right = coarse.q[i_right][Dynamic_model_t::Road_type::ITIME];
+        }
+        else if ( is_closed )
+        {
+            // (1.1) Closed simulations: the last element goes back to the first point, at s = L and time = laptime
+            i_right    = 0;
+            s_right    = track_length;
+            time_right = coarse.laptime;
+        }
+        else
+        {
+            // (1.2) Open simulations: the last point is shared by both meshes
+            i_right    = i_left;
+            s_right    = coarse.s[i_left];
+            time_right = coarse.q[i_left][Dynamic_model_t::Road_type::ITIME];
+        }
+
+        const scalar xi = ( i_right == i_left ? 0.0 : (s[i] - coarse.s[i_left])/(s_right - coarse.s[i_left]) );
+
+        // (2) States
+        for (size_t j = 0; j < Dynamic_model_t::NSTATE; ++j)
+            q[i][j] = (1.0-xi)*coarse.q[i_left][j] + xi*coarse.q[i_right][j];
+
+        q[i][Dynamic_model_t::Road_type::ITIME] = (1.0-xi)*coarse.q[i_left][Dynamic_model_t::Road_type::ITIME] + xi*time_right;
+
+        // (3) Algebraic states
+        for (size_t j = 0; j < Dynamic_model_t::NALGEBRAIC; ++j)
+            qa[i][j] = (1.0-xi)*coarse.qa[i_left][j] + xi*coarse.qa[i_right][j];
+
+        // (4) Full mesh controls
+        for (size_t j = 0; j < Dynamic_model_t::NCONTROL; ++j)
+        {
+            if ( control_variables[j].optimal_control_type == FULL_MESH )
+            {
+                control_variables[j].u[i] = (1.0-xi)*coarse.control_variables[j].u[i_left] + xi*coarse.control_variables[j].u[i_right];
+
+                if ( !is_direct )
+                    control_variables[j].dudt[i] = (1.0-xi)*coarse.control_variables[j].dudt[i_left] + xi*coarse.control_variables[j].dudt[i_right];
+            }
+        }
+    }
+
+    // (5) Constant and hypermesh controls do not depend on the mesh: copy them
+    for (size_t j = 0; j < Dynamic_model_t::NCONTROL; ++j)
+    {
+        if ( (control_variables[j].optimal_control_type == CONSTANT) || (control_variables[j].optimal_control_type == HYPERMESH) )
+            control_variables[j].u = coarse.control_variables[j].u;
+    }
+}
+
+
 template<typename Dynamic_model_t>
 inline Optimal_laptime<Dynamic_model_t>::Optimal_laptime(Xml_document& doc)
 {
@@ -211,116 +364,1129 @@ inline Optimal_laptime<Dynamic_model_t>::Optimal_laptime(Xml_document& doc)
         else
             throw fastest_lap_exception("optimal_control_type attribute not recognize. Options are: 'dont optimize', 'constant', 'hypermesh', 'full-mesh'");
 
-        // Get value
-        control_variables[i].u = root.get_child("control_variables/" + u_names[i] + "/values").get_value(std::vector<scalar>());
+        // Get value
+        control_variables[i].u = root.get_child("control_variables/" + u_names[i] + "/values").get_value(std::vector<scalar>());
+
+        // Get hypermesh
+        if ( control_variables[i].optimal_control_type == HYPERMESH )
+            control_variables[i].s_hypermesh = root.get_child("control_variables/" + u_names[i] + "/hypermesh").get_value(std::vector<scalar>());
+
+        // Get derivative value if present
+        if ( !is_direct && root.has_child("control_variables/" + u_names[i] + "/derivatives") )
+            control_variables[i].dudt = root.get_child("control_variables/" + u_names[i] + "/derivatives").get_value(std::vector<scalar>());
+
+        // Get hypermesh 
+        if ( control_variables[i].optimal_control_type == HYPERMESH )
+            control_variables[i].s_hypermesh = root.get_child("control_variables/" + u_names[i] + "/hypermesh").get_value(std::vector<scalar>());
+    }
+
+    // check them and compute its statistics
+    control_variables.check();
+
+    // Get x
+    x_coord = root.get_child("x").get_value(std::vector<scalar>());
+    y_coord = root.get_child("y").get_value(std::vector<scalar>());
+    psi     = root.get_child("psi").get_value(std::vector<scalar>());
+
+    // Get optimization data
+    optimization_data.zl     = root.get_child("optimization_data").get_child("zl").get_value(std::vector<scalar>());
+    optimization_data.zu     = root.get_child("optimization_data").get_child("zu").get_value(std::vector<scalar>());
+    optimization_data.lambda = root.get_child("optimization_data").get_child("lambda").get_value(std::vector<scalar>());
+}
+
+
+template<typename Dynamic_model_t>
+template<typename FG_t>
+inline typename Optimal_laptime<Dynamic_model_t>::Export_solution 
+    Optimal_laptime<Dynamic_model_t>::export_solution(FG_t& fg, const std::vector<scalar>& x) const
+{
+    // (1) Create output
+    Export_solution output;
+
+    // (1.1) Copy the structure of the control variables
+    output.control_variables = control_variables;
+    output.control_variables.clear();
+
+    // (1.2) Copy the structure of the integral quantities
+    output.integral_quantities = integral_quantities;
+
+    // (2) Transform x to CppAD
+    std::vector<CppAD::AD<scalar>> x_cppad(x.size(),0.0),fg_eval(fg.get_n_constraints()+1,0.0);
+    std::copy(x.cbegin(), x.cend(), x_cppad.begin());
+    fg.template compute<true>(fg_eval,x_cppad);
+  
+    assert(fg.get_states().size() == n_points);
+    assert(fg.get_algebraic_states().size() == n_points);
+
+    // (3) Export states
+    output.q = std::vector<std::array<scalar,Dynamic_model_t::NSTATE>>(n_points);
+    
+    for (size_t i = 0; i < n_points; ++i)
+        for (size_t j = 0; j < Dynamic_model_t::NSTATE; ++j)
+            output.q[i][j] = Value(fg.get_state(i)[j]);
+
+    // (4) Export algebraic states
+    output.qa = std::vector<std::array<scalar,Dynamic_model_t::NALGEBRAIC>>(n_points);
+    
+    for (size_t i = 0; i < n_points; ++i)
+        for (size_t j = 0; j < Dynamic_model_t::NALGEBRAIC; ++j)
+            output.qa[i][j] = Value(fg.get_algebraic_state(i)[j]);
+
+    // (5) Export control variables
+    for (size_t j = 0; j < Dynamic_model_t::NCONTROL; ++j)
+    {
+        switch (output.control_variables[j].optimal_control_type) 
+        {
+         case (CONSTANT):
+            std::transform(fg.get_control(j).u.cbegin(), fg.get_control(j).u.cend(), output.control_variables[j].u.begin(), 
+                [](const auto& u_cppad) -> auto { return Value(u_cppad); });
+            break;
+        
+         case (HYPERMESH):
+            std::transform(fg.get_control(j).u.cbegin(), fg.get_control(j).u.cend(), output.control_variables[j].u.begin(), 
+                [](const auto& u_cppad) -> auto { return Value(u_cppad); });
+            break;
+
+         case (FULL_MESH):
+            std::transform(fg.get_control(j).u.cbegin(), fg.get_control(j).u.cend(), output.control_variables[j].u.begin(), 
+                [](const auto& u_cppad) -> auto { return Value(u_cppad); });
+
+            std::transform(fg.get_control(j).dudt.cbegin(), fg.get_control(j).dudt.cend(), output.control_variables[j].dudt.begin(), 
+                [](const auto& u_cppad) -> auto { return Value(u_cppad); });
+            break;
+
+         default:
+            // do nothing
+            break;
+        }
+    }
+
+    // (6) Export integral quantities
+    for (size_t i = 0; i < Integral_quantities::N; ++i)
+        output.integral_quantities[i].value = Value(fg.get_integral_quantities_values()[i]);
+
+    return output;
+}
+
+
+
+
+
+template<typename Dynamic_model_t>
+template<typename FG_t>
+inline void Optimal_laptime<Dynamic_model_t>::compute_nlp_scaling(FG_t& fg, const std::vector<scalar>& x0, 
+    const std::vector<scalar>& x_lb, const std::vector<scalar>& x_ub)
+{
+    FASTEST_LAP_TRACE_SCOPE("Optimal_laptime::compute_nlp_scaling");
+
+    const size_t n_variables   = fg.get_n_variables();
+    const size_t n_constraints = fg.get_n_constraints();
+
+    // (1) Variables: use the largest finite bound. Unbounded variables use the magnitude of the initial point
+    std::vector<scalar> x_scaling(n_variables, 1.0);
+
+    for (size_t i = 0; i < n_variables; ++i)
+    {
+        const bool is_bounded = (x_lb[i] > std::numeric_limits<scalar>::lowest()) && (x_ub[i] < std::numeric_limits<scalar>::max());
+
+        const scalar magnitude = (is_bounded ? std::max(std::abs(x_lb[i]), std::abs(x_ub[i])) : std::abs(x0[i]));
+
+        if ( magnitude > options.scaling_minimum )
+            x_scaling[i] = std::min(magnitude, options.scaling_maximum);
+    }
+
+    // (2) Constraints: estimate the row magnitudes of the Jacobian w.r.t. the scaled variables at the initial point
+    //     with a few forward directional derivatives J.diag(x_scaling).r, with random r_j = +/- 1. The tape recorded
+    //     here is only used for this estimate (see the cost note in the declaration)
+    std::vector<CppAD::AD<scalar>> x_cppad(x0.cbegin(), x0.cend());
+    std::vector<CppAD::AD<scalar>> fg_cppad(n_constraints+1);
+
+    CppAD::Independent(x_cppad);
+    fg(fg_cppad, x_cppad);
+    CppAD::ADFun<scalar> fg_function(x_cppad, fg_cppad);
+
+    fg_function.Forward(0, x0);
+
+    std::vector<scalar> c_scaling(n_constraints, 0.0);
+    std::vector<scalar> dx(n_variables);
+    std::mt19937 generator(0);
+    std::bernoulli_distribution coin;
+
+    for (size_t direction = 0; direction < options.scaling_directions; ++direction)
+    {
+        for (size_t i = 0; i < n_variables; ++i)
+            dx[i] = (coin(generator) ? 1.0 : -1.0)*x_scaling[i];
+
+        const auto dfg = fg_function.Forward(1, dx);
+
+        for (size_t i = 0; i < n_constraints; ++i)
+            c_scaling[i] = std::max(c_scaling[i], std::abs(dfg[i+1]));
+    }
+
+    for (auto& c_scaling_i : c_scaling)
+        c_scaling_i = ( c_scaling_i > options.scaling_minimum ? std::min(c_scaling_i, options.scaling_maximum) : 1.0 );
+
+    // (3) Report
+    const auto [x_scaling_min, x_scaling_max] = std::minmax_element(x_scaling.cbegin(), x_scaling.cend());
+    const auto [c_scaling_min, c_scaling_max] = std::minmax_element(c_scaling.cbegin(), c_scaling.cend());
+
+    synchronized_out(2) << "[INFO] Optimal_laptime -> automatic scaling. Variables in [" << *x_scaling_min << ", " << *x_scaling_max 
+           << "], constraints in [" << *c_scaling_min << ", " << *c_scaling_max << "]" << std::endl;
+
+    optimization_data.x_scaling = x_scaling;
+    optimization_data.c_scaling = c_scaling;
+}
+
+
+template<typename Dynamic_model_t>
+template<typename FG_t>
+inline CppAD::ipopt_cppad_result<std::vector<scalar>> Optimal_laptime<Dynamic_model_t>::solve_nlp(FG_t& fg, 
+    const std::vector<scalar>& x0, const std::vector<scalar>& x_lb, const std::vector<scalar>& x_ub, 
+    const std::vector<scalar>& c_lb, const std::vector<scalar>& c_ub)
+{
+    FASTEST_LAP_TRACE_SCOPE("Optimal_laptime::solve_nlp");
+
+    // (1) Prepare options
+    std::ostringstream ipoptoptions; ipoptoptions << std::setprecision(17);
+    ipoptoptions << "Integer print_level " << options.print_level        << std::endl;
+    ipoptoptions << "Integer max_iter "    << options.maximum_iterations << std::endl;
+    ipoptoptions << "String  sb           yes\n";
+    ipoptoptions << "Sparse true forward\n";
+
+    if ( options.retape )
+    {
+        ipoptoptions << "Retape true\n";
+    }
+
+    ipoptoptions << "Numeric tol "             << options.nlp_tolerance              << std::endl;
+    ipoptoptions << "Numeric constr_viol_tol " << options.constraints_viol_tolerance << std::endl;
+    ipoptoptions << "Numeric acceptable_tol "  << options.acceptable_tolerance       << std::endl;
+    ipoptoptions << options.ipopt_extra_options;
+
+    // (2) Return object
+    CppAD::ipopt_cppad_result<std::vector<scalar>> result;
+
+    // (3) Unscaled problem: solve directly
+    if ( !options.automatic_scaling )
+    {
+        optimization_data.x_scaling.clear();
+        optimization_data.c_scaling.clear();
+
+        if ( !warm_start )
+            CppAD::ipopt_cppad_solve<std::vector<scalar>, FG_t>(ipoptoptions.str(), x0, x_lb, x_ub, c_lb, c_ub, fg, result);
+        else
+            CppAD::ipopt_cppad_solve<std::vector<scalar>, FG_t>(ipoptoptions.str(), x0, x_lb, x_ub, c_lb, c_ub, 
+                optimization_data.lambda, optimization_data.zl, optimization_data.zu, fg, result);
+
+        return result;
+    }
+
+    // (4) Scaled problem: the optimizer sees x/x_scaling and g/c_scaling
+    compute_nlp_scaling(fg, x0, x_lb, x_ub);
+    const auto& x_scaling = optimization_data.x_scaling;
+    const auto& c_scaling = optimization_data.c_scaling;
+
+    // (4.1) Scale a vector, keeping the infinite bounds untouched
+    auto scale = [](const std::vector<scalar>& v, const std::vector<scalar>& scaling) -> std::vector<scalar>
+    {
+        std::vector<scalar> v_scaled(v.size());
+        for (size_t i = 0; i < v.size(); ++i)
+        {
+            if ( (v[i] <= std::numeric_limits<scalar>::lowest()) || (v[i] >= std::numeric_limits<scalar>::max()) )
+                v_scaled[i] = v[i];
+            else
+                v_scaled[i] = v[i]/scaling[i];
+        }
+
+        return v_scaled;
+    };
+
+    auto multiply = [](std::vector<scalar> v, const std::vector<scalar>& scaling) -> std::vector<scalar>
+    {
+        std::transform(v.cbegin(), v.cend(), scaling.cbegin(), v.begin(), std::multiplies<scalar>());
+        return v;
+    };
+
+    fg.set_scaling(x_scaling, c_scaling);
+
+    // (4.2) Solve
+    if ( !warm_start )
+    {
+        CppAD::ipopt_cppad_solve<std::vector<scalar>, FG_t>(ipoptoptions.str(), scale(x0,x_scaling), scale(x_lb,x_scaling), scale(x_ub,x_scaling), 
+            scale(c_lb,c_scaling), scale(c_ub,c_scaling), fg, result);
+    }
+    else
+    {
+        CppAD::ipopt_cppad_solve<std::vector<scalar>, FG_t>(ipoptoptions.str(), scale(x0,x_scaling), scale(x_lb,x_scaling), scale(x_ub,x_scaling), 
+            scale(c_lb,c_scaling), scale(c_ub,c_scaling), multiply(optimization_data.lambda,c_scaling), 
+            multiply(optimization_data.zl,x_scaling), multiply(optimization_data.zu,x_scaling), fg, result);
+    }
+
+    // (4.3) Bring the results back to physical units, and remove the scaling from the fitness function
+    fg.set_scaling({}, {});
+
+    result.x      = multiply(result.x, x_scaling);
+    result.zl     = scale(result.zl, x_scaling);
+    result.zu     = scale(result.zu, x_scaling);
+    result.s      = multiply(result.s, c_scaling);
+    result.lambda = scale(result.lambda, c_scaling);
+    result.vl     = scale(result.vl, c_scaling);
+    result.vu     = scale(result.vu, c_scaling);
+
+    return result;
+}
+
+
+template<typename Dynamic_model_t>
+inline void Optimal_laptime<Dynamic_model_t>::compute(const Dynamic_model_t& car)
+{
+    FASTEST_LAP_TRACE_SCOPE("Optimal_laptime::compute");
+
+    if ( options.recovery_strategies.size() > 0 )
+        compute_with_recovery(car);
+    else
+        compute_formulation(car);
+
+    apply_output_specification(car);
+}
+
+
+template<typename Dynamic_model_t>
+inline void Optimal_laptime<Dynamic_model_t>::check_output_specification() const
+{
+    const auto [key_name, q_names, qa_names, u_names] = Dynamic_model_t::get_state_and_control_names();
+
+    for (const auto& name : options.output.channels)
+    {
+        const bool found = (name == "x") || (name == "y") || (name == "psi") 
+                        || (std::find(q_names.cbegin(), q_names.cend(), name) != q_names.cend())
+                        || (std::find(qa_names.cbegin(), qa_names.cend(), name) != qa_names.cend())
+                        || (std::find(u_names.cbegin(), u_names.cend(), name) != u_names.cend());
+
+        if ( !found )
+            throw fastest_lap_exception("[ERROR] Optimal_laptime::check_output_specification -> channel \"" + name + "\" was not found");
+    }
+}
+
+
+template<typename Dynamic_model_t>
+inline void Optimal_laptime<Dynamic_model_t>::apply_output_specification(const Dynamic_model_t& car)
+{
+    const auto& output = options.output;
+
+    // (1) Copy the requested channels
+    channels.clear();
+
+    if ( output.channels.size() > 0 )
+    {
+        const auto [key_name, q_names, qa_names, u_names] = Dynamic_model_t::get_state_and_control_names();
+
+        for (const auto& name : output.channels)
+        {
+            std::vector<scalar> values(n_points);
+
+            if ( name == "x" )
+                values = x_coord;
+            else if ( name == "y" )
+                values = y_coord;
+            else if ( name == "psi" )
+                values = psi;
+            else if ( auto it = std::find(q_names.cbegin(), q_names.cend(), name); it != q_names.cend() )
+            {
+                const size_t j = std::distance(q_names.cbegin(), it);
+                for (size_t i = 0; i < n_points; ++i)
+                    values[i] = q[i][j];
+            }
+            else if ( auto it = std::find(qa_names.cbegin(), qa_names.cend(), name); it != qa_names.cend() )
+            {
+                const size_t j = std::distance(qa_names.cbegin(), it);
+                for (size_t i = 0; i < n_points; ++i)
+                    values[i] = qa[i][j];
+            }
+            else if ( auto it = std::find(u_names.cbegin(), u_names.cend(), name); it != u_names.cend() )
+            {
+                const size_t j = std::distance(u_names.cbegin(), it);
+                for (size_t i = 0; i < n_points; ++i)
+                    values[i] = control_variables.control_array_at_s(car, i, s[i])[j];
+            }
+            else
+                throw fastest_lap_exception("[ERROR] Optimal_laptime::apply_output_specification -> channel \"" + name + "\" was not found");
+
+            channels[name] = std::move(values);
+        }
+    }
+
+    // (2) Release the buffers that are not retained. Swap with empty containers so that the memory is freed
+    if ( !output.solution )
+    {
+        std::vector<std::array<scalar,Dynamic_model_t::NSTATE>>().swap(q);
+        std::vector<std::array<scalar,Dynamic_model_t::NALGEBRAIC>>().swap(qa);
+
+        // Keep the control definitions: only the full mesh values scale with the mesh
+        for (auto& control_variable : control_variables)
+        {
+            if ( control_variable.optimal_control_type == FULL_MESH )
+            {
+                std::vector<scalar>().swap(control_variable.u);
+                std::vector<scalar>().swap(control_variable.dudt);
+            }
+        }
+    }
+
+    if ( !output.coordinates )
+    {
+        std::vector<scalar>().swap(x_coord);
+        std::vector<scalar>().swap(y_coord);
+        std::vector<scalar>().swap(psi);
+    }
+
+    if ( !output.optimization_data )
+        optimization_data = {};
+}
+
+
+template<typename Dynamic_model_t>
+inline std::vector<Tape_profiler::Report> Optimal_laptime<Dynamic_model_t>::profile_tape(const Dynamic_model_t& car, std::vector<size_t> points, const size_t n_sweeps) const
+{
+    constexpr const size_t NSTATE     = Dynamic_model_t::NSTATE;
+    constexpr const size_t NALGEBRAIC = Dynamic_model_t::NALGEBRAIC;
+    constexpr const size_t NCONTROL   = Dynamic_model_t::NCONTROL;
+
+    if ( (q.size() != n_points) || (qa.size() != n_points) )
+        throw fastest_lap_exception("[ERROR] Optimal_laptime::profile_tape -> the states have not been computed");
+
+    if ( points.size() == 0 )
+    {
+        points.resize(n_points);
+        std::iota(points.begin(), points.end(), 0);
+    }
+
+    std::vector<Tape_profiler::Report> reports;
+
+    for (const size_t i : points)
+    {
+        if ( i >= n_points )
+            throw fastest_lap_exception("[ERROR] Optimal_laptime::profile_tape -> point index is out of bounds");
+
+        // (1) Recording point: [q,qa,u]
+        const auto u_i = control_variables.control_array_at_s(car, i, s[i]);
+
+        std::vector<scalar> x0(q[i].cbegin(), q[i].cend());
+        x0.insert(x0.end(), qa[i].cbegin(), qa[i].cend());
+        x0.insert(x0.end(), u_i.cbegin(), u_i.cend());
+
+        // (2) Recorded function: the vehicle equations of FG_direct at one mesh point
+        Dynamic_model_t car_i = car;
+
+        auto f = [&](const std::vector<Timeseries_t>& x) -> std::vector<Timeseries_t>
+        {
+            std::array<Timeseries_t,NSTATE> q_i;
+            std::array<Timeseries_t,NALGEBRAIC> qa_i;
+            std::array<Timeseries_t,NCONTROL> u_ad;
+
+            std::copy_n(x.cbegin(), NSTATE, q_i.begin());
+            std::copy_n(x.cbegin() + NSTATE, NALGEBRAIC, qa_i.begin());
+            std::copy_n(x.cbegin() + NSTATE + NALGEBRAIC, NCONTROL, u_ad.begin());
+
+            const auto [dqdt, dqa] = car_i(q_i, qa_i, u_ad, s[i]);
+
+            std::vector<Timeseries_t> y(dqdt.cbegin(), dqdt.cend());
+            y.insert(y.end(), dqa.cbegin(), dqa.cend());
+
+            const auto c_extra = car_i.optimal_laptime_extra_constraints();
+            y.insert(y.end(), c_extra.cbegin(), c_extra.cend());
+
+            {
+                FASTEST_LAP_TAPE_SCOPE("integral quantities");
+
+                for (const auto& integrand : car_i.compute_integral_quantities())
+                    y.push_back(dqdt[Dynamic_model_t::Road_type::ITIME]*integrand);
+            }
+
+            return y;
+        };
+
+        reports.push_back(Tape_profiler::profile(f, x0, n_sweeps));
+    }
+
+    return reports;
+}
+
+
+template<typename Dynamic_model_t>
+inline typename Optimal_laptime<Dynamic_model_t>::Track_sensitivities Optimal_laptime<Dynamic_model_t>::compute_track_sensitivities(const Dynamic_model_t& car) const
+{
+    FASTEST_LAP_TRACE_SCOPE("Optimal_laptime::compute_track_sensitivities");
+
+    constexpr const size_t NSTATE     = Dynamic_model_t::NSTATE;
+    constexpr const size_t NALGEBRAIC = Dynamic_model_t::NALGEBRAIC;
+
+    if ( (optimization_data.x.size() == 0) || (optimization_data.lambda.size() == 0) )
+        throw fastest_lap_exception("[ERROR] Optimal_laptime::compute_track_sensitivities -> the optimization data is not available");
+
+    if ( !success )
+        throw fastest_lap_exception("[ERROR] Optimal_laptime::compute_track_sensitivities -> the optimization has not succeeded");
+
+    const auto& lambda = optimization_data.lambda;
+    const auto& zl     = optimization_data.zl;
+    const auto& zu     = optimization_data.zu;
+
+    Track_sensitivities sensitivities{std::vector<scalar>(n_points, 0.0), std::vector<scalar>(n_points, 0.0), std::vector<scalar>(n_points, 0.0)};
+
+    // At the optimum, the derivative of the cost function w.r.t. the bounds are: df/dx_lb = zl, df/dx_ub = -zu, and, for the
+    // constraints, df/dc_lb = -min(lambda,0), df/dc_ub = -max(lambda,0)
+
+    // (1) Track limits
+
+    // (1.1) Bounds of the lateral displacement: -wl < n < wr. The time is not an optimization variable, and n takes its position
+    const size_t offset = (is_closed ? 0 : 1);
+    const size_t variables_per_point = (is_direct ? n_variables_per_point<true>(control_variables)
+                                                  : n_variables_per_point<false>(control_variables));
+
+    for (size_t i = offset; i < n_points; ++i)
+    {
+        const size_t k = (i - offset)*variables_per_point + Dynamic_model_t::Road_type::ITIME;
+        sensitivities.dlaptimedwl[i] -= zl[k];
+        sensitivities.dlaptimedwr[i] -= zu[k];
+    }
+
+    // (1.2) Bounds of the extra constraints. They are affine in the track limits: differentiate them by a unit perturbation
+    Dynamic_model_t car_wl(car);
+    Dynamic_model_t car_wr(car);
+    car_wl.get_road().set_track_limits_perturbation(1.0, 0.0);
+    car_wr.get_road().set_track_limits_perturbation(0.0, 1.0);
+
+    const size_t constraints_per_element = (is_direct ? n_constraints_per_element<true>(control_variables)
+                                                      : n_constraints_per_element<false>(control_variables));
+
+    for (size_t element = 0; element < n_elements; ++element)
+    {
+        // The element i-1 -> i contains the extra constraints of the point i. For closed circuits, the last element is n-1 -> 0
+        const size_t i = (element + 1) % n_points;
+        const size_t k = element*constraints_per_element + NSTATE - 1 + NALGEBRAIC;
+
+        const auto [c_lb, c_ub]       = car.optimal_laptime_extra_constraints_bounds(s[i]);
+        const auto [c_lb_wl, c_ub_wl] = car_wl.optimal_laptime_extra_constraints_bounds(s[i]);
+        const auto [c_lb_wr, c_ub_wr] = car_wr.optimal_laptime_extra_constraints_bounds(s[i]);
+
+        for (size_t j = 0; j < Dynamic_model_t::N_OL_EXTRA_CONSTRAINTS; ++j)
+        {
+            const scalar dfdc_lb = -std::min(lambda[k+j], 0.0);
+            const scalar dfdc_ub = -std::max(lambda[k+j], 0.0);
+
+            sensitivities.dlaptimedwl[i] += dfdc_lb*(c_lb_wl[j] - c_lb[j]) + dfdc_ub*(c_ub_wl[j] - c_ub[j]);
+            sensitivities.dlaptimedwr[i] += dfdc_lb*(c_lb_wr[j] - c_lb[j]) + dfdc_ub*(c_ub_wr[j] - c_ub[j]);
+        }
+    }
+
+    // (2) Curvature: it enters the fitness function and the constraints, differentiate the Lagrangian
+    if ( is_direct )
+    {
+        const auto u0 = control_variables.control_array_at_s(car, 0, s.front());
+
+        if ( is_closed )
+        {
+            FG_direct<true> fg(n_elements,n_points,car,s,q.front(),qa.front(),u0,control_variables,integral_quantities,options.sigma);
+            fg.set_quasi_steady_slip(options.quasi_steady_slip);
+            sensitivities.dlaptimedkappa = curvature_lagrangian_gradient(fg);
+        }
+        else
+        {
+            FG_direct<false> fg(n_elements,n_points,car,s,q.front(),qa.front(),u0,control_variables,integral_quantities,options.sigma);
+            fg.set_quasi_steady_slip(options.quasi_steady_slip);
+            sensitivities.dlaptimedkappa = curvature_lagrangian_gradient(fg);
+        }
+    }
+    else
+    {
+        const auto [u0, dudt0] = control_variables.control_array_and_derivative_at_s(car, 0, s.front());
+
+        if ( is_closed )
+        {
+            FG_derivative<true> fg(n_elements,n_points,car,s,q.front(),qa.front(),u0,dudt0,control_variables,integral_quantities,options.sigma);
+            fg.set_quasi_steady_slip(options.quasi_steady_slip);
+            sensitivities.dlaptimedkappa = curvature_lagrangian_gradient(fg);
+        }
+        else
+        {
+            FG_derivative<false> fg(n_elements,n_points,car,s,q.front(),qa.front(),u0,dudt0,control_variables,integral_quantities,options.sigma);
+            fg.set_quasi_steady_slip(options.quasi_steady_slip);
+            sensitivities.dlaptimedkappa = curvature_lagrangian_gradient(fg);
+        }
+    }
+
+    return sensitivities;
+}
+
+
+template<typename Dynamic_model_t>
+template<typename FG_t>
+inline std::vector<scalar> Optimal_laptime<Dynamic_model_t>::curvature_lagrangian_gradient(FG_t& fg) const
+{
+    // (1) The curvature perturbations are the independent variables, the optimization variables are frozen at the solution
+    std::vector<Timeseries_t> dkappa(n_points, 0.0);
+    CppAD::Independent(dkappa);
+
+    fg.get_car().get_road().set_curvature_perturbation(s, dkappa);
+
+    // (2) Evaluate the Lagrangian: f + lambda'.g
+    const typename FG_t::ADvector x(optimization_data.x.cbegin(), optimization_data.x.cend());
+    typename FG_t::ADvector fg_values(fg.get_n_constraints() + 1);
+
+    fg(fg_values, x);
+
+    std::vector<Timeseries_t> lagrangian = {fg_values.front()};
+    for (size_t k = 0; k < fg.get_n_constraints(); ++k)
+        lagrangian.front() += optimization_data.lambda[k]*fg_values[k+1];
+
+    // (3) One reverse sweep gives the derivatives w.r.t. all the mesh points
+    CppAD::ADFun<scalar> tape(dkappa, lagrangian);
+
+    fg.get_car().get_road().set_curvature_perturbation({}, {});
+
+    return tape.Reverse(1, std::vector<scalar>{1.0});
+}
+
+
+template<typename Dynamic_model_t>
+template<typename FG_t>
+inline void Optimal_laptime<Dynamic_model_t>::compute_parameter_sensitivities(FG_t& fg, const Dynamic_model_t& car, 
+    const CppAD::ipopt_cppad_result<std::vector<scalar>>& result, const std::vector<scalar>& x_lb, const std::vector<scalar>& x_ub, 
+    const std::vector<scalar>& c_lb, const std::vector<scalar>& c_ub)
+{
+    FASTEST_LAP_TRACE_SCOPE("Optimal_laptime::compute_parameter_sensitivities");
+
+    const std::vector<scalar> p = car.get_parameters().get_all_parameters_as_scalar();
+    const size_t n_parameters = p.size();
+    const size_t chunk_size = ( options.sensitivity_chunk_size == 0 ? std::max(n_parameters, size_t(1)) : options.sensitivity_chunk_size );
+    const bool is_streamed = static_cast<bool>(options.sensitivity_callback);
+    const scalar& L = car.get_road().track_length();
+
+    // (1) The laptime derivatives are always stored, the rest only if they are not streamed
+    dlaptimedp.resize(n_parameters);
+
+    if ( !is_streamed )
+    {
+        dxdp.resize(n_parameters);
+        dqdp.resize(n_parameters);
+        dqadp.resize(n_parameters);
+        dcontrol_variablesdp.resize(n_parameters);
+    }
+
+    for (size_t i_start = 0; i_start < n_parameters; i_start += chunk_size)
+    {
+        const size_t i_end = std::min(i_start + chunk_size, n_parameters);
+
+        // (2) Run the sensitivity analysis w.r.t. the parameters of the chunk
+        FG_parameter_chunk<FG_t> fg_chunk(fg, p, i_start);
+        const std::vector<scalar> p_chunk(p.cbegin() + i_start, p.cbegin() + i_end);
+
+        auto sensitivity_opts = typename Sensitivity_analysis<FG_parameter_chunk<FG_t>>::Options{};
+        sensitivity_opts.ipopt_bound_relax_factor = 1.0e-8;
+        auto sensitivity_analysis = Sensitivity_analysis<FG_parameter_chunk<FG_t>>(fg_chunk, p_chunk, 
+                                                                                   result.x, result.s, result.lambda, result.zl, result.zu, 
+                                                                                   result.vl, result.vu, x_lb, x_ub, c_lb, c_ub, sensitivity_opts);
+        const auto& optimality_check = sensitivity_analysis.optimality_check;
+    
+        if ( !optimality_check.success ) 
+        {
+            std::ostringstream s_out;
+            s_out << "[ERROR] Requested optimality check for optimal laptime problem has failed" << std::endl;
+            s_out << "        Big components of the gradient vector are:" << std::endl;
+            for (size_t i = 0; i < optimality_check.id_not_ok.size(); ++i)
+                s_out << "            " << optimality_check.id_not_ok[i] << ": " << optimality_check.nlp_error[optimality_check.id_not_ok[i]] << std::endl;
+            throw fastest_lap_exception(s_out.str());
+        }
+
+        // (3) Export the derivatives of each parameter of the chunk
+        for (size_t i = i_start; i < i_end; ++i)
+        {
+            // dxdp contains the solution but also the slack variables and the lagrange multipliers, discard everything except the solution (goes first)
+            std::vector<scalar> dxdp_i = std::move(sensitivity_analysis.dxdp[i - i_start]);
+            dxdp_i.resize(fg.get_n_variables());
+
+            auto sensitivity = export_parameter_sensitivity(fg, dxdp_i, L);
+
+            dlaptimedp[i] = sensitivity.dlaptimedp;
+
+            if ( is_streamed )
+            {
+                options.sensitivity_callback(i, sensitivity);
+            }
+            else
+            {
+                dxdp[i]                 = std::move(dxdp_i);
+                dqdp[i]                 = std::move(sensitivity.dqdp);
+                dqadp[i]                = std::move(sensitivity.dqadp);
+                dcontrol_variablesdp[i] = std::move(sensitivity.dcontrol_variablesdp);
+            }
+        }
+    }
+}
+
+
+template<typename Dynamic_model_t>
+template<typename FG_t>
+inline typename Optimal_laptime<Dynamic_model_t>::Parameter_sensitivity Optimal_laptime<Dynamic_model_t>::export_parameter_sensitivity
+    (FG_t& fg, const std::vector<scalar>& dxdp_i, const scalar track_length) const
+{
+    const auto solution_exported = export_solution(fg, dxdp_i);
+    Parameter_sensitivity sensitivity{solution_exported.q, solution_exported.qa, solution_exported.control_variables, 0.0};
+
+    auto& dqdp_i = sensitivity.dqdp;
+    auto& dqadp_i = sensitivity.dqadp;
+    auto& dcontrol_variablesdp_i = sensitivity.dcontrol_variablesdp;
+
+    // (1) If open simulation, kill the first derivative
+    if ( !is_closed )
+    {
+        std::fill(dqdp_i.front().begin(), dqdp_i.front().end(), 0.0);
+        std::fill(dqadp_i.front().begin(), dqadp_i.front().end(), 0.0);
+        std::fill(dcontrol_variablesdp_i.front().u.begin(), dcontrol_variablesdp_i.front().u.end(), 0.0);
+        std::fill(dcontrol_variablesdp_i.front().dudt.begin(), dcontrol_variablesdp_i.front().dudt.end(), 0.0);
+    }
+
+    // (2) Compute the derivative of the time
+    auto d2timedsdp = [](const auto& kappa, const auto& n, const auto& dndp, 
+                         const auto& u, const auto& dudp, const auto& v, const auto& dvdp, 
+                         const auto& alpha, const auto& dalphadp) -> auto
+    { 
+        const auto u_n = u*cos(alpha) - v*sin(alpha);
+        const auto r   = 1.0 - kappa*n;
+        return -kappa*dndp/u_n - cos(alpha)*r/(u_n*u_n)*dudp + sin(alpha)*r/(u_n*u_n)*dvdp + r*(v*cos(alpha)+u*sin(alpha))/(u_n*u_n)*dalphadp;
+    };
+
+    auto d2timedsdp_at = [&](const size_t j) -> auto
+    {
+        fg.get_car().get_road().update_track(s[j]);
+        const auto& kappa_j = fg.get_car().get_road().get_curvature();
+
+        return d2timedsdp(kappa_j, q[j][Dynamic_model_t::Road_type::IN], dqdp_i[j][Dynamic_model_t::Road_type::IN], 
+                          q[j][Dynamic_model_t::Chassis_type::IU], dqdp_i[j][Dynamic_model_t::Chassis_type::IU], 
+                          q[j][Dynamic_model_t::Chassis_type::IV], dqdp_i[j][Dynamic_model_t::Chassis_type::IV], 
+                          q[j][Dynamic_model_t::Road_type::IALPHA], dqdp_i[j][Dynamic_model_t::Road_type::IALPHA]);
+    };
+
+    // (2.1) Compute the first point
+    auto d2timedsdp_first = d2timedsdp_at(0);
+    auto d2timedsdp_prev = d2timedsdp_first;
+
+    // (2.2) Compute the rest of the points
+    for (size_t j = 1; j < fg.get_states().size(); ++j)
+    {
+        auto d2timedsdp_j = d2timedsdp_at(j);
+        dqdp_i[j][Dynamic_model_t::Road_type::ITIME] = dqdp_i[j-1][Dynamic_model_t::Road_type::ITIME] 
+            + (s[j]-s[j-1])*(options.sigma*d2timedsdp_j + (1.0-options.sigma)*d2timedsdp_prev);
+        d2timedsdp_prev = d2timedsdp_j;
+    }
+
+    // (2.3) Compute the laptime
+    sensitivity.dlaptimedp = dqdp_i.back()[Dynamic_model_t::Road_type::ITIME];
+
+    if ( is_closed )
+        sensitivity.dlaptimedp += Value((track_length-s.back())*((1.0-options.sigma)*d2timedsdp_prev + options.sigma*d2timedsdp_first));
+
+    return sensitivity;
+}
+
+
+template<typename Dynamic_model_t>
+inline std::array<scalar,Optimal_laptime<Dynamic_model_t>::Integral_quantities::N> Optimal_laptime<Dynamic_model_t>::integrate_quantities(
+    const Dynamic_model_t& car, const size_t i_start, const size_t i_end) const
+{
+    constexpr const size_t NSTATE     = Dynamic_model_t::NSTATE;
+    constexpr const size_t NALGEBRAIC = Dynamic_model_t::NALGEBRAIC;
+    constexpr const size_t NCONTROL   = Dynamic_model_t::NCONTROL;
+    constexpr const size_t N          = Integral_quantities::N;
+
+    if ( (i_start > i_end) || (i_end >= n_points) )
+        throw fastest_lap_exception("[ERROR] Optimal_laptime::integrate_quantities -> the points must satisfy i_start <= i_end < n_points");
+
+    if ( (q.size() != n_points) || (qa.size() != n_points) )
+        throw fastest_lap_exception("[ERROR] Optimal_laptime::integrate_quantities -> the solution was not retained (see Options::output)");
+
+    Dynamic_model_t car_i = car;
+
+    // (1) Integrands at one point: dtime/ds times the quantities, as in FG
+    auto integrand = [&](const size_t i) -> std::array<scalar,N>
+    {
+        const auto u_i = control_variables.control_array_at_s(car, i, s[i]);
+
+        std::array<Timeseries_t,NSTATE> q_i;
+        std::array<Timeseries_t,NALGEBRAIC> qa_i;
+        std::array<Timeseries_t,NCONTROL> u_ad;
+
+        std::copy(q[i].cbegin(), q[i].cend(), q_i.begin());
+        std::copy(qa[i].cbegin(), qa[i].cend(), qa_i.begin());
+        std::copy(u_i.cbegin(), u_i.cend(), u_ad.begin());
+
+        const auto [dqdt, dqa] = car_i(q_i, qa_i, u_ad, s[i]);
+        const auto quantities = car_i.compute_integral_quantities();
+
+        std::array<scalar,N> result;
+        for (size_t k = 0; k < N; ++k)
+            result[k] = Value(dqdt[Dynamic_model_t::Road_type::ITIME]*quantities[k]);
+
+        return result;
+    };
+
+    // (2) Quadrature over the elements
+    std::array<scalar,N> values;
+    values.fill(0.0);
+
+    auto integrand_previous = integrand(i_start);
+
+    for (size_t i = i_start + 1; i <= i_end; ++i)
+    {
+        const auto integrand_i = integrand(i);
+
+        for (size_t k = 0; k < N; ++k)
+            values[k] += (s[i] - s[i-1])*((1.0 - options.sigma)*integrand_previous[k] + options.sigma*integrand_i[k]);
+
+        integrand_previous = integrand_i;
+    }
+
+    return values;
+}
+
+
+template<typename Dynamic_model_t>
+inline Optimal_laptime<Dynamic_model_t> Optimal_laptime<Dynamic_model_t>::reoptimize_window(const Dynamic_model_t& car, const size_t i_start, const size_t i_end)
+{
+    FASTEST_LAP_TRACE_SCOPE("Optimal_laptime::reoptimize_window");
+
+    // (1) Check inputs
+    if ( (i_start >= i_end) || (i_end >= n_points) )
+        throw fastest_lap_exception("[ERROR] Optimal_laptime::reoptimize_window -> the window must satisfy i_start < i_end < n_points");
+
+    if ( (optimization_data.x.size() == 0) || (optimization_data.lambda.size() == 0) )
+        throw fastest_lap_exception("[ERROR] Optimal_laptime::reoptimize_window -> the optimization data is not available");
+
+    if ( (q.size() != n_points) || (x_coord.size() != n_points) )
+        throw fastest_lap_exception("[ERROR] Optimal_laptime::reoptimize_window -> the solution was not retained (see Options::output)");
+
+    check_output_specification();
+
+    for (const auto& control_variable : control_variables)
+    {
+        if ( (control_variable.optimal_control_type == CONSTANT) || (control_variable.optimal_control_type == HYPERMESH) )
+            throw fastest_lap_exception("[ERROR] Optimal_laptime::reoptimize_window -> constant and hypermesh controls are not supported");
+    }
+
+    if ( integral_quantities.get_n_restricted() > 0 )
+        throw fastest_lap_exception("[ERROR] Optimal_laptime::reoptimize_window -> restricted integral quantities are not supported");
+
+    // (2) Extract the window from the current solution
+    const size_t n_points_window = i_end - i_start + 1;
+
+    const std::vector<scalar> s_window(s.cbegin() + i_start, s.cbegin() + i_end + 1);
+    const std::vector<std::array<scalar,Dynamic_model_t::NSTATE>> q_window(q.cbegin() + i_start, q.cbegin() + i_end + 1);
+    const std::vector<std::array<scalar,Dynamic_model_t::NALGEBRAIC>> qa_window(qa.cbegin() + i_start, qa.cbegin() + i_end + 1);
+
+    auto control_variables_window = control_variables;
+    for (auto& control_variable : control_variables_window)
+    {
+        if ( control_variable.optimal_control_type == FULL_MESH )
+        {
+            control_variable.u = std::vector<scalar>(control_variable.u.cbegin() + i_start, control_variable.u.cbegin() + i_end + 1);
+
+            if ( !is_direct )
+                control_variable.dudt = std::vector<scalar>(control_variable.dudt.cbegin() + i_start, control_variable.dudt.cbegin() + i_end + 1);
+        }
+    }
+
+    // (3) Extract the multipliers. The window is open: its variables start at i_start+1, and its element k is the element i_start+k of the lap
+    const size_t offset = (is_closed ? 0 : 1);
+    const size_t variables_per_point = (is_direct ? n_variables_per_point<true>(control_variables)
+                                                  : n_variables_per_point<false>(control_variables));
+    const size_t constraints_per_element = (is_direct ? n_constraints_per_element<true>(control_variables)
+                                                      : n_constraints_per_element<false>(control_variables));
+
+    const size_t k_start = (i_start + 1 - offset)*variables_per_point;
+    const size_t k_end   = (i_end + 1 - offset)*variables_per_point;
+    const size_t kc_start = i_start*constraints_per_element;
+    const size_t kc_end   = i_end*constraints_per_element;
+
+    const std::vector<scalar> zl_window(optimization_data.zl.cbegin() + k_start, optimization_data.zl.cbegin() + k_end);
+    const std::vector<scalar> zu_window(optimization_data.zu.cbegin() + k_start, optimization_data.zu.cbegin() + k_end);
+    const std::vector<scalar> lambda_window(optimization_data.lambda.cbegin() + kc_start, optimization_data.lambda.cbegin() + kc_end);
+
+    // (4) Solve the window with its last point fixed
+    Options window_options = options;
+    window_options.fix_final_point       = true;
+    window_options.multilevel_coarsening = {};
+    window_options.check_optimality      = false;
+    window_options.output                = {};
+    window_options.throw_if_fail         = false;
+
+    Optimal_laptime window(s_window, false, is_direct, car, q_window, qa_window, control_variables_window,
+                           zl_window, zu_window, lambda_window, window_options);
+
+    // (4.1) A failed window leaves the lap unchanged
+    if ( !window.success )
+    {
+        if ( options.throw_if_fail )
+            throw fastest_lap_exception("[ERROR] Optimal_laptime::reoptimize_window -> the optimization of the window [" 
+                + std::to_string(i_start) + ", " + std::to_string(i_end) + "] did not succeed");
+
+        return window;
+    }
 
-        // Get hypermesh
-        if ( control_variables[i].optimal_control_type == HYPERMESH )
-            control_variables[i].s_hypermesh = root.get_child("control_variables/" + u_names[i] + "/hypermesh").get_value(std::vector<scalar>());
+    // (5) Splice the window into the lap
 
-        // Get derivative value if present
-        if ( !is_direct && root.has_child("control_variables/" + u_names[i] + "/derivatives") )
-            control_variables[i].dudt = root.get_child("control_variables/" + u_names[i] + "/derivatives").get_value(std::vector<scalar>());
+    // (5.1) Integral quantities: replace the contribution of the window. The old one is evaluated with the vehicle of the
+    //       window, before the states are overwritten
+    const auto integral_quantities_window_old = integrate_quantities(car, i_start, i_end);
 
-        // Get hypermesh 
-        if ( control_variables[i].optimal_control_type == HYPERMESH )
-            control_variables[i].s_hypermesh = root.get_child("control_variables/" + u_names[i] + "/hypermesh").get_value(std::vector<scalar>());
+    for (size_t k = 0; k < Integral_quantities::N; ++k)
+        integral_quantities[k].value += window.integral_quantities[k].value - integral_quantities_window_old[k];
+
+    // (5.2) Shift the time of the points after the window
+    const scalar delta_time = window.q.back()[Dynamic_model_t::Road_type::ITIME] - q[i_end][Dynamic_model_t::Road_type::ITIME];
+
+    for (size_t i = i_end + 1; i < n_points; ++i)
+        q[i][Dynamic_model_t::Road_type::ITIME] += delta_time;
+
+    laptime += delta_time;
+
+    // (5.3) States, controls and coordinates
+    for (size_t i = 0; i < n_points_window; ++i)
+    {
+        q[i_start + i]       = window.q[i];
+        qa[i_start + i]      = window.qa[i];
+        x_coord[i_start + i] = window.x_coord[i];
+        y_coord[i_start + i] = window.y_coord[i];
+        psi[i_start + i]     = window.psi[i];
     }
 
-    // check them and compute its statistics
-    control_variables.check();
+    for (size_t j = 0; j < Dynamic_model_t::NCONTROL; ++j)
+    {
+        if ( control_variables[j].optimal_control_type == FULL_MESH )
+        {
+            std::copy(window.control_variables[j].u.cbegin(), window.control_variables[j].u.cend(), control_variables[j].u.begin() + i_start);
 
-    // Get x
-    x_coord = root.get_child("x").get_value(std::vector<scalar>());
-    y_coord = root.get_child("y").get_value(std::vector<scalar>());
-    psi     = root.get_child("psi").get_value(std::vector<scalar>());
+            if ( !is_direct )
+                std::copy(window.control_variables[j].dudt.cbegin(), window.control_variables[j].dudt.cend(), control_variables[j].dudt.begin() + i_start);
+        }
+    }
 
-    // Get optimization data
-    optimization_data.zl     = root.get_child("optimization_data").get_child("zl").get_value(std::vector<scalar>());
-    optimization_data.zu     = root.get_child("optimization_data").get_child("zu").get_value(std::vector<scalar>());
-    optimization_data.lambda = root.get_child("optimization_data").get_child("lambda").get_value(std::vector<scalar>());
+    // (5.4) Optimization data
+    std::copy(window.optimization_data.x.cbegin(), window.optimization_data.x.cend(), optimization_data.x.begin() + k_start);
+    std::copy(window.optimization_data.zl.cbegin(), window.optimization_data.zl.cend(), optimization_data.zl.begin() + k_start);
+    std::copy(window.optimization_data.zu.cbegin(), window.optimization_data.zu.cend(), optimization_data.zu.begin() + k_start);
+    std::copy(window.optimization_data.lambda.cbegin(), window.optimization_data.lambda.cend(), optimization_data.lambda.begin() + kc_start);
+
+    // (5.5) The parametric sensitivities are no longer valid
+    dqdp.clear();
+    dqadp.clear();
+    dcontrol_variablesdp.clear();
+    dxdp.clear();
+    dlaptimedp.clear();
+
+    // (5.6) Refresh the requested channels
+    apply_output_specification(car);
+
+    return window;
 }
 
 
 template<typename Dynamic_model_t>
-template<typename FG_t>
-inline typename Optimal_laptime<Dynamic_model_t>::Export_solution 
-    Optimal_laptime<Dynamic_model_t>::export_solution(FG_t& fg, const std::vector<scalar>& x) const
+inline void Optimal_laptime<Dynamic_model_t>::compute_with_recovery(const Dynamic_model_t& car)
 {
-    // (1) Create output
-    Export_solution output;
+    // (1) Save the user options and the initial guess: the strategies modify them
+    const Options user_options = options;
+    const auto q_initial = q;
+    const auto qa_initial = qa;
+    const auto control_variables_initial = control_variables;
+
+    // (1.1) Attempts never throw nor check optimality: this is done at the end, once
+    auto reset_options = [&]()
+    {
+        options = user_options;
+        options.throw_if_fail    = false;
+        options.check_optimality = false;
+        options.recovery_strategies = {};
+    };
 
-    // (1.1) Copy the structure of the control variables
-    output.control_variables = control_variables;
-    output.control_variables.clear();
+    auto restore_initial_guess = [&]()
+    {
+        q                 = q_initial;
+        qa                = qa_initial;
+        control_variables = control_variables_initial;
+        warm_start        = false;
+    };
 
-    // (1.2) Copy the structure of the integral quantities
-    output.integral_quantities = integral_quantities;
+    // (1.2) An attempt that throws (in its preparation or in the optimization) is logged as failed, and the guess it 
+    //       started from is restored
+    auto run_attempt = [&](const std::string& strategy, const std::function<void()>& prepare) -> bool
+    {
+        const auto q_attempt                 = q;
+        const auto qa_attempt                = qa;
+        const auto control_variables_attempt = control_variables;
+        const bool warm_start_attempt        = warm_start;
 
-    // (2) Transform x to CppAD
-    std::vector<CppAD::AD<scalar>> x_cppad(x.size(),0.0),fg_eval(fg.get_n_constraints()+1,0.0);
-    std::copy(x.cbegin(), x.cend(), x_cppad.begin());
-    fg.template compute<true>(fg_eval,x_cppad);
-  
-    assert(fg.get_states().size() == n_points);
-    assert(fg.get_algebraic_states().size() == n_points);
+        const auto start = std::chrono::steady_clock::now();
 
-    // (3) Export states
-    output.q = std::vector<std::array<scalar,Dynamic_model_t::NSTATE>>(n_points);
-    
-    for (size_t i = 0; i < n_points; ++i)
-        for (size_t j = 0; j < Dynamic_model_t::NSTATE; ++j)
-            output.q[i][j] = Value(fg.get_state(i)[j]);
+        try
+        {
+            if ( prepare )
+                prepare();
 
-    // (4) Export algebraic states
-    output.qa = std::vector<std::array<scalar,Dynamic_model_t::NALGEBRAIC>>(n_points);
-    
-    for (size_t i = 0; i < n_points; ++i)
-        for (size_t j = 0; j < Dynamic_model_t::NALGEBRAIC; ++j)
-            output.qa[i][j] = Value(fg.get_algebraic_state(i)[j]);
+            compute_formulation(car);
+        }
+        catch (const std::exception& error)
+        {
+            synchronized_out(2) << "[WARNING] Optimal_laptime -> attempt \"" << strategy << "\" threw: " << error.what() << std::endl;
 
-    // (5) Export control variables
-    for (size_t j = 0; j < Dynamic_model_t::NCONTROL; ++j)
+            q                 = q_attempt;
+            qa                = qa_attempt;
+            control_variables = control_variables_attempt;
+            warm_start        = warm_start_attempt;
+            success           = false;
+            iter_count        = 0;
+        }
+
+        const std::chrono::duration<scalar> elapsed_time = std::chrono::steady_clock::now() - start;
+
+        recovery_attempts.push_back({strategy, success, iter_count, elapsed_time.count()});
+
+        synchronized_out(2) << "[INFO] Optimal_laptime -> attempt \"" << strategy << "\": success = " << success << ", iterations = " 
+               << iter_count << ", elapsed time = " << elapsed_time.count() << "s" << std::endl;
+
+        return success;
+    };
+
+    bool solved = false;
+
+    try
     {
-        switch (output.control_variables[j].optimal_control_type) 
+        // (2) Solve the problem as given
+        recovery_attempts.clear();
+        reset_options();
+        solved = run_attempt("original", {});
+
+        // (3) Try the recovery strategies in order
+        for (auto it = user_options.recovery_strategies.cbegin(); (it != user_options.recovery_strategies.cend()) && (!solved); ++it)
         {
-         case (CONSTANT):
-            std::transform(fg.get_control(j).u.cbegin(), fg.get_control(j).u.cend(), output.control_variables[j].u.begin(), 
-                [](const auto& u_cppad) -> auto { return Value(u_cppad); });
-            break;
-        
-         case (HYPERMESH):
-            std::transform(fg.get_control(j).u.cbegin(), fg.get_control(j).u.cend(), output.control_variables[j].u.begin(), 
-                [](const auto& u_cppad) -> auto { return Value(u_cppad); });
-            break;
+            reset_options();
 
-         case (FULL_MESH):
-            std::transform(fg.get_control(j).u.cbegin(), fg.get_control(j).u.cend(), output.control_variables[j].u.begin(), 
-                [](const auto& u_cppad) -> auto { return Value(u_cppad); });
+            switch (*it)
+            {
+             case (RESTART_ADAPTIVE_MU):
+                // (3.1) q, qa and control_variables contain the last iterate. Multipliers are discarded
+                warm_start = false;
+                options.ipopt_extra_options += "String mu_strategy adaptive\nNumeric mu_init 1.0e-3\n";
+                solved = run_attempt("restart-adaptive-mu", {});
+                break;
+
+             case (SWITCH_FORMULATION):
+                // (3.2) Solve with the other formulation, and use it as initial guess for the original one
+                restore_initial_guess();
+                switch_formulation();
+                {
+                    const bool solved_switched = run_attempt(is_direct ? "switched-to-direct" : "switched-to-derivative", {});
+                    switch_formulation();
+
+                    if ( solved_switched )
+                        solved = run_attempt("switched-back", {});
+                }
+                break;
+
+             case (COARSE_MESH):
+                // (3.3) Construct the initial guess from coarser meshes
+                restore_initial_guess();
+                if ( options.multilevel_coarsening.size() == 0 )
+                    options.multilevel_coarsening = {4, 2};
+
+                solved = run_attempt("coarse-mesh", [&]() { compute_multilevel_initial_guess(car); });
+                break;
+
+             case (RELAX_TOLERANCES):
+                // (3.4) Relaxed tolerances, the solution satisfies the relaxed tolerances only
+                restore_initial_guess();
+                options.nlp_tolerance              *= 1.0e2;
+                options.constraints_viol_tolerance *= 1.0e2;
+                options.acceptable_tolerance       *= 1.0e2;
+                solved = run_attempt("relax-tolerances", {});
+                break;
+
+             default:
+                throw fastest_lap_exception("[ERROR] Optimal_laptime::compute_with_recovery -> recovery strategy not recognized");
+            }
+        }
+    }
+    catch (...)
+    {
+        // (3.5) Errors outside the attempts are not recovered, but the user options are always restored
+        options = user_options;
+        throw;
+    }
 
-            std::transform(fg.get_control(j).dudt.cbegin(), fg.get_control(j).dudt.cend(), output.control_variables[j].dudt.begin(), 
-                [](const auto& u_cppad) -> auto { return Value(u_cppad); });
-            break;
+    // (4) Restore the user options. Keep the options of the attempt that succeeded for the optimality check
+    const Options successful_options = options;
+    options = user_options;
 
-         default:
-            // do nothing
-            break;
-        }
+    if ( !solved )
+    {
+        if ( options.throw_if_fail )
+            throw fastest_lap_exception("[ERROR] Optimal_laptime::compute -> optimization did not succeed after " 
+                + std::to_string(recovery_attempts.size()) + " attempts");
+
+        return;
     }
 
-    // (6) Export integral quantities
-    for (size_t i = 0; i < Integral_quantities::N; ++i)
-        output.integral_quantities[i].value = Value(fg.get_integral_quantities_values()[i]);
+    // (5) Run the optimality check, warm started from the converged solution and with the settings of the attempt that
+    //     succeeded (e.g. relaxed tolerances). If it does not converge, the recovered solution is kept, without the check
+    if ( options.check_optimality )
+    {
+        const auto recovered = *this;
 
-    return output;
+        options                  = successful_options;
+        options.check_optimality = true;
+        warm_start               = true;
+
+        try
+        {
+            compute_formulation(car);
+        }
+        catch (const std::exception& error)
+        {
+            synchronized_out(2) << "[WARNING] Optimal_laptime -> the optimality check threw: " << error.what() << std::endl;
+            success = false;
+        }
+
+        if ( !success )
+        {
+            synchronized_out(2) << "[WARNING] Optimal_laptime -> the optimality check did not converge. The recovered solution is kept" << std::endl;
+            *this = recovered;
+        }
+
+        options = user_options;
+    }
 }
 
 
+template<typename Dynamic_model_t>
+inline void Optimal_laptime<Dynamic_model_t>::switch_formulation()
+{
+    is_direct = !is_direct;
 
+    // Direct formulations do not use the control derivatives. Derivative formulations start with zero derivatives
+    for (auto& control_variable : control_variables)
+    {
+        if ( control_variable.optimal_control_type == FULL_MESH )
+        {
+            if ( is_direct )
+                control_variable.dudt.clear();
+            else
+                control_variable.dudt = std::vector<scalar>(n_points, 0.0);
+        }
+    }
+}
 
 
 template<typename Dynamic_model_t>
-inline void Optimal_laptime<Dynamic_model_t>::compute(const Dynamic_model_t& car)
+inline void Optimal_laptime<Dynamic_model_t>::compute_formulation(const Dynamic_model_t& car)
 {
     if ( is_direct )
     {
@@ -367,6 +1533,7 @@ inline void Optimal_laptime<Dynamic_model_t>::compute_direct(const Dynamic_model
 
     // (2) Construct fitness function functor
     FG_direct<isClosed> fg(n_elements,n_points,car,s,q.front(),qa.front(),u0,control_variables, integral_quantities, options.sigma);
+    fg.set_quasi_steady_slip(options.quasi_steady_slip);
 
     // (3) Construct vectors of initial optimization point, and variable upper/lower bounds
     std::vector<scalar> x0(fg.get_n_variables(),0.0);
@@ -455,6 +1622,19 @@ inline void Optimal_laptime<Dynamic_model_t>::compute_direct(const Dynamic_model
         }
     }
 
+    // (3.7) Fix the variables of the last point to the initial guess, if requested
+    if ( !isClosed && options.fix_final_point )
+    {
+        const size_t n_variables_last_point = n_variables_per_point<true>(control_variables);
+        const size_t k_last_point = (n_points - 2)*n_variables_last_point;
+
+        for (size_t i = k_last_point; i < k_last_point + n_variables_last_point; ++i)
+        {
+            x_lb[i] = x0[i];
+            x_ub[i] = x0[i];
+        }
+    }
+
     // (4) Construct vector of upper/lower bounds for constraints
     std::vector<scalar> c_lb(fg.get_n_constraints(),0.0);
     std::vector<scalar> c_ub(fg.get_n_constraints(),0.0);
@@ -589,34 +1769,10 @@ inline void Optimal_laptime<Dynamic_model_t>::compute_direct(const Dynamic_model
 
     // (8) Run optimization
 
-    // (8.1) Prepare options
-    std::ostringstream ipoptoptions; ipoptoptions << std::setprecision(17);
-    ipoptoptions << "Integer print_level " << options.print_level << std::endl;
-    ipoptoptions << "Integer max_iter " << options.maximum_iterations << std::endl;
-    ipoptoptions << "String  sb           yes\n";
-    ipoptoptions << "Sparse true forward\n";
-
-    if ( options.retape )
-    {
-        ipoptoptions << "Retape true\n";
-    }
-
-    ipoptoptions << "Numeric tol "             << options.nlp_tolerance              << std::endl;
-    ipoptoptions << "Numeric constr_viol_tol " << options.constraints_viol_tolerance << std::endl;
-    ipoptoptions << "Numeric acceptable_tol "  << options.acceptable_tolerance       << std::endl;
-
-    // (8.2) Return object
-    CppAD::ipopt_cppad_result<std::vector<scalar>> result;
-
-    // (8.3) Solve the problem
-    if ( !warm_start )
-        CppAD::ipopt_cppad_solve<std::vector<scalar>, FG_direct<isClosed>>(ipoptoptions.str(), x0, x_lb, x_ub, c_lb, c_ub, fg, result);
-    else
-        CppAD::ipopt_cppad_solve<std::vector<scalar>, FG_direct<isClosed>>(ipoptoptions.str(), x0, x_lb, x_ub, c_lb, c_ub, 
-            optimization_data.lambda, optimization_data.zl, optimization_data.zu, fg, result);
-    
+    // (8.1) Solve the problem: scaling, if requested, is handled inside solve_nlp and the result is in physical units
+    const auto result = solve_nlp(fg, x0, x_lb, x_ub, c_lb, c_ub);
 
-    // (8.4) Check success flag
+    // (8.2) Check success flag
     success = result.status == CppAD::ipopt_cppad_result<std::vector<scalar>>::success; 
     iter_count = result.iter_count;
 
@@ -625,33 +1781,6 @@ inline void Optimal_laptime<Dynamic_model_t>::compute_direct(const Dynamic_model
         throw fastest_lap_exception("Optimization did not succeed");
     }
 
-    // (8.5) Check optimality (disabled by default)
-    if ( options.check_optimality )
-    {
-        auto sensitivity_opts = typename Sensitivity_analysis<FG_direct<isClosed>>::Options{};
-        sensitivity_opts.ipopt_bound_relax_factor = 1.0e-8;
-        auto sensitivity_analysis = Sensitivity_analysis<FG_direct<isClosed>>(fg, car.get_parameters().get_all_parameters_as_scalar(), 
-                                                                              result.x, result.s, result.lambda, result.zl, result.zu, 
-                                                                              result.vl, result.vu, x_lb, x_ub, c_lb, c_ub, sensitivity_opts);
-        const auto& optimality_check = sensitivity_analysis.optimality_check;
-    
-        if ( !optimality_check.success ) 
-        {
-            std::ostringstream s_out;
-            s_out << "[ERROR] Requested optimality check for optimal laptime problem has failed" << std::endl;
-            s_out << "        Big components of the gradient vector are:" << std::endl;
-            for (size_t i = 0; i < optimality_check.id_not_ok.size(); ++i)
-                s_out << "            " << optimality_check.id_not_ok[i] << ": " << optimality_check.nlp_error[optimality_check.id_not_ok[i]] << std::endl;
-            throw fastest_lap_exception(s_out.str());
-        }
-
-        dxdp = sensitivity_analysis.dxdp;
-
-        // dxdp contains the solution but also the slack variables and the lagrange multipliers, discard everything except the solution (goes first)
-        for (auto& dxdpi : dxdp)
-            dxdpi.resize(fg.get_n_variables());
-    }
-
     // (9) Export the solution
 
     // (9.1) Export states
@@ -710,91 +1839,9 @@ inline void Optimal_laptime<Dynamic_model_t>::compute_direct(const Dynamic_model
     optimization_data.vl     = result.vl;
     optimization_data.vu     = result.vu;
 
-    // (9.4) Save sensitivity analysis data
-
-    // (9.4.2) State and control vectors
+    // (9.4) Sensitivity analysis (disabled by default): checks optimality, and computes the derivatives w.r.t. the parameters
     if ( options.check_optimality )
-    {
-        const size_t n_parameters = car.get_parameters().get_all_parameters_as_scalar().size();
-        dqdp.resize(n_parameters);
-        dqadp.resize(n_parameters);
-        dcontrol_variablesdp.resize(n_parameters);
-        dlaptimedp.resize(n_parameters);
-
-        for (size_t i = 0; i < n_parameters; ++i)
-        {
-            const auto solution_exported = export_solution(fg, dxdp[i]);
-            dqdp[i]                 = solution_exported.q;
-            dqadp[i]                = solution_exported.qa;
-            dcontrol_variablesdp[i] = solution_exported.control_variables;
-
-            // If open simulation, kill the first derivative
-            if ( !isClosed )
-            {
-                std::fill(dqdp[i].front().begin(), dqdp[i].front().end(), 0.0);
-                std::fill(dqadp[i].front().begin(), dqadp[i].front().end(), 0.0);
-                std::fill(dcontrol_variablesdp[i].front().u.begin(), dcontrol_variablesdp[i].front().u.end(), 0.0);
-                std::fill(dcontrol_variablesdp[i].front().dudt.begin(), dcontrol_variablesdp[i].front().dudt.end(), 0.0);
-            }
-
-            // Compute the derivative of the time
-            fg.get_car().get_road().update_track(s[0]);
-            const auto& kappa_i = fg.get_car().get_road().get_curvature();
-            const auto& n_i = q[0][Dynamic_model_t::Road_type::IN];
-            const auto& dndp_i = dqdp[i][0][Dynamic_model_t::Road_type::IN];
-
-            const auto& u_i = q[0][Dynamic_model_t::Chassis_type::IU];
-            const auto& dudp_i = dqdp[i][0][Dynamic_model_t::Chassis_type::IU];
-
-            const auto& v_i = q[0][Dynamic_model_t::Chassis_type::IV];
-            const auto& dvdp_i = dqdp[i][0][Dynamic_model_t::Chassis_type::IV];
-
-            const auto& alpha_i = q[0][Dynamic_model_t::Road_type::IALPHA];
-            const auto& dalphadp_i = dqdp[i][0][Dynamic_model_t::Road_type::IALPHA];
-    
-            auto d2timedsdp = [](const auto& kappa, const auto& n, const auto& dndp, 
-                                 const auto& u, const auto& dudp, const auto& v, const auto& dvdp, 
-                                 const auto& alpha, const auto& dalphadp) -> auto
-            { 
-                const auto u_n = u*cos(alpha) - v*sin(alpha);
-                const auto r   = 1.0 - kappa*n;
-                return -kappa*dndp/u_n - cos(alpha)*r/(u_n*u_n)*dudp + sin(alpha)*r/(u_n*u_n)*dvdp + r*(v*cos(alpha)+u*sin(alpha))/(u_n*u_n)*dalphadp;
-            };
-
-            auto d2timedsdp_first = d2timedsdp(kappa_i, n_i, dndp_i, u_i, dudp_i, v_i, dvdp_i, alpha_i, dalphadp_i);
-            auto d2timedsdp_prev = d2timedsdp_first;
-
-            // (9.2.2) Compute the rest of the points
-            for (size_t j = 1; j < fg.get_states().size(); ++j)
-            {
-                fg.get_car().get_road().update_track(s[j]);
-                const auto& kappa_i = fg.get_car().get_road().get_curvature();
-                const auto& n_i = q[j][Dynamic_model_t::Road_type::IN];
-                const auto& dndp_i = dqdp[i][j][Dynamic_model_t::Road_type::IN];
-    
-                const auto& u_i = q[j][Dynamic_model_t::Chassis_type::IU];
-                const auto& dudp_i = dqdp[i][j][Dynamic_model_t::Chassis_type::IU];
-    
-                const auto& v_i = q[j][Dynamic_model_t::Chassis_type::IV];
-                const auto& dvdp_i = dqdp[i][j][Dynamic_model_t::Chassis_type::IV];
-    
-                const auto& alpha_i = q[j][Dynamic_model_t::Road_type::IALPHA];
-                const auto& dalphadp_i = dqdp[i][j][Dynamic_model_t::Road_type::IALPHA];
-
-                auto d2timedsdp_i = d2timedsdp(kappa_i, n_i, dndp_i, u_i, dudp_i, v_i, dvdp_i, alpha_i, dalphadp_i);
-                dqdp[i][j][Dynamic_model_t::Road_type::ITIME] = dqdp[i][j-1][Dynamic_model_t::Road_type::ITIME] 
-                    + (s[j]-s[j-1])*(options.sigma*d2timedsdp_i + (1.0-options.sigma)*d2timedsdp_prev);
-                d2timedsdp_prev = d2timedsdp_i;
-            }
-
-            // (9.2.4) Compute the laptime
-            dlaptimedp[i] = dqdp[i].back()[Dynamic_model_t::Road_type::ITIME];
-
-            if (isClosed)
-                dlaptimedp[i] += Value((L-s.back())*((1.0-options.sigma)*d2timedsdp_prev + options.sigma*d2timedsdp_first));
-
-        } 
-    }
+        compute_parameter_sensitivities(fg, car, result, x_lb, x_ub, c_lb, c_ub);
 }
 
 template<typename Dynamic_model_t>
@@ -827,6 +1874,7 @@ inline void Optimal_laptime<Dynamic_model_t>::compute_derivative(const Dynamic_m
 
     // (2) Construct fitness function functor
     FG_derivative<isClosed> fg(n_elements,n_points,car,s,q.front(),qa.front(),u0,dudt0,control_variables,integral_quantities,options.sigma);
+    fg.set_quasi_steady_slip(options.quasi_steady_slip);
 
     // (3) Construct vectors of initial optimization point, and variable upper/lower bounds
     std::vector<scalar> x0(fg.get_n_variables(),0.0);
@@ -925,6 +1973,19 @@ inline void Optimal_laptime<Dynamic_model_t>::compute_derivative(const Dynamic_m
         }
     }
 
+    // (3.8) Fix the variables of the last point to the initial guess, if requested
+    if ( !isClosed && options.fix_final_point )
+    {
+        const size_t n_variables_last_point = n_variables_per_point<false>(control_variables);
+        const size_t k_last_point = (n_points - 2)*n_variables_last_point;
+
+        for (size_t i = k_last_point; i < k_last_point + n_variables_last_point; ++i)
+        {
+            x_lb[i] = x0[i];
+            x_ub[i] = x0[i];
+        }
+    }
+
     // (4) Construct vector of upper/lower bounds for constraints
     std::vector<scalar> c_lb(fg.get_n_constraints(),0.0);
     std::vector<scalar> c_ub(fg.get_n_constraints(),0.0);
@@ -1082,33 +2143,10 @@ inline void Optimal_laptime<Dynamic_model_t>::compute_derivative(const Dynamic_m
 
     // (8) Run optimization
 
-    // (8.1) Prepare options
-    std::ostringstream ipoptoptions; ipoptoptions << std::setprecision(17);
-    ipoptoptions << "Integer print_level " << options.print_level        << std::endl;
-    ipoptoptions << "Integer max_iter "    << options.maximum_iterations << std::endl;
-    ipoptoptions << "String  sb           yes\n";
-    ipoptoptions << "Sparse true forward\n";
-
-    if ( options.retape )
-    {
-        ipoptoptions << "Retape true\n";
-    }
-
-    ipoptoptions << "Numeric tol "             << options.nlp_tolerance              << std::endl;
-    ipoptoptions << "Numeric constr_viol_tol " << options.constraints_viol_tolerance << std::endl;
-    ipoptoptions << "Numeric acceptable_tol "  << options.acceptable_tolerance       << std::endl;
-
-    // (8.2) Return object
-    CppAD::ipopt_cppad_result<std::vector<scalar>> result;
+    // (8.1) Solve the problem: scaling, if requested, is handled inside solve_nlp and the result is in physical units
+    const auto result = solve_nlp(fg, x0, x_lb, x_ub, c_lb, c_ub);
 
-    // (8.3) Solve the problem
-    if ( !warm_start )
-        CppAD::ipopt_cppad_solve<std::vector<scalar>, FG_derivative<isClosed>>(ipoptoptions.str(), x0, x_lb, x_ub, c_lb, c_ub, fg, result);
-    else
-        CppAD::ipopt_cppad_solve<std::vector<scalar>, FG_derivative<isClosed>>(ipoptoptions.str(), x0, x_lb, x_ub, c_lb, c_ub, 
-            optimization_data.lambda, optimization_data.zl, optimization_data.zu, fg, result);
- 
-    // (8.4) Check success flag
+    // (8.2) Check success flag
     success = result.status == CppAD::ipopt_cppad_result<std::vector<scalar>>::success; 
     iter_count = result.iter_count;
 
@@ -1117,7 +2155,7 @@ inline void Optimal_laptime<Dynamic_model_t>::compute_derivative(const Dynamic_m
         throw fastest_lap_exception("Optimization did not succeed");
     }
 
-    // (8.5) Check optimality (disabled by default)
+    // (8.3) Check optimality (disabled by default)
     if ( options.check_optimality )
     {
         auto sensitivity_analysis = Sensitivity_analysis<FG_derivative<isClosed>>(fg, result.x, result.s, result.lambda, result.zl, result.zu, result.vl, result.vu, x_lb, x_ub, c_lb, c_ub, {});
@@ -1133,7 +2171,7 @@ inline void Optimal_laptime<Dynamic_model_t>::compute_derivative(const Dynamic_m
             throw fastest_lap_exception(s_out.str());
         }
 
-        out(2) << "[INFO] Optimal laptime -> requested optimality check has passed" << std::endl;
+        synchronized_out(2) << "[INFO] Optimal laptime -> requested optimality check has passed" << std::endl;
     }
 
     // (9) Export the solution
@@ -1209,6 +2247,9 @@ inline void Optimal_laptime<Dynamic_model_t>::compute_derivative(const Dynamic_m
 template<typename Dynamic_model_t>
 std::unique_ptr<Xml_document> Optimal_laptime<Dynamic_model_t>::xml() const 
 {
+    if ( (q.size() != n_points) || (x_coord.size() != n_points) )
+        throw fastest_lap_exception("[ERROR] Optimal_laptime::xml -> the solution was not retained (see Options::output)");
+
     std::unique_ptr<Xml_document> doc_ptr(std::make_unique<Xml_document>());
 
     const auto [key_name, q_names, qa_names, u_names] = Dynamic_model_t::get_state_and_control_names();
@@ -1514,11 +2555,11 @@ inline void Optimal_laptime<Dynamic_model_t>::FG_direct<isClosed>::compute(FG_di
 
         // (5.2) q^{i} = q^{i-1} + 0.5.ds.[dqdt^{i} + dqdt^{i-1}] (before time)
         for (size_t j = 0; j < Dynamic_model_t::Road_type::ITIME; ++j)
-            fg[k++] = _q[i][j] - _q[i-1][j] - (_s[i]-_s[i-1])*((1.0-_sigma)*_dqdt[i-1][j] + _sigma*_dqdt[i][j]);
+            fg[k++] = FG::state_equation(i-1, i, _s[i]-_s[i-1], j);
 
         // (5.3) q^{i} = q^{i-1} + 0.5.ds.[dqdt^{i} + dqdt^{i-1}] (after time)
         for (size_t j = Dynamic_model_t::Road_type::ITIME+1; j < Dynamic_model_t::NSTATE; ++j)
-            fg[k++] = _q[i][j] - _q[i-1][j] - (_s[i]-_s[i-1])*((1.0-_sigma)*_dqdt[i-1][j] + _sigma*_dqdt[i][j]);
+            fg[k++] = FG::state_equation(i-1, i, _s[i]-_s[i-1], j);
 
         // (5.4) algebraic constraints: dqa^{i} = 0.0
         for (size_t j = 0; j < Dynamic_model_t::NALGEBRAIC; ++j)
@@ -1562,11 +2603,11 @@ inline void Optimal_laptime<Dynamic_model_t>::FG_direct<isClosed>::compute(FG_di
 
         // (5.7.2) q^{0} = q^{n-1} + 0.5.ds.[dqdt^{0} + dqdt^{n-1}] (before time)
         for (size_t j = 0; j < Dynamic_model_t::Road_type::ITIME; ++j)
-            fg[k++] = _q.front()[j] - _q.back()[j] - (L-_s.back())*((1.0-_sigma)*_dqdt.back()[j] + _sigma*_dqdt.front()[j]);
+            fg[k++] = FG::state_equation(_n_points-1, 0, L-_s.back(), j);
 
         // (5.7.3) q^{0} = q^{n-1} + 0.5.ds.[dqdt^{0} + dqdt^{n-1}] (after time)
         for (size_t j = Dynamic_model_t::Road_type::ITIME+1; j < Dynamic_model_t::NSTATE; ++j)
-            fg[k++] = _q.front()[j] - _q.back()[j] - (L-_s.back())*((1.0-_sigma)*_dqdt.back()[j] + _sigma*_dqdt.front()[j]);
+            fg[k++] = FG::state_equation(_n_points-1, 0, L-_s.back(), j);
 
         // (5.7.4) algebraic constraints: dqa^{0} = 0.0
         for (size_t j = 0; j < Dynamic_model_t::NALGEBRAIC; ++j)
@@ -1746,11 +2787,11 @@ inline void Optimal_laptime<Dynamic_model_t>::FG_derivative<isClosed>::compute(F
 
         // (5.2) q^{i} = q^{i-1} + 0.5.ds.[dqdt^{i} + dqdt^{i-1}] (before time)
         for (size_t j = 0; j < Dynamic_model_t::Road_type::ITIME; ++j)
-            fg[k++] = _q[i][j] - _q[i-1][j] - (_s[i]-_s[i-1])*((1.0-_sigma)*_dqdt[i-1][j] + _sigma*_dqdt[i][j]);
+            fg[k++] = FG::state_equation(i-1, i, _s[i]-_s[i-1], j);
 
         // (5.3) q^{i} = q^{i-1} + 0.5.ds.[dqdt^{i} + dqdt^{i-1}] (before time)
         for (size_t j = Dynamic_model_t::Road_type::ITIME+1; j < Dynamic_model_t::NSTATE; ++j)
-            fg[k++] = _q[i][j] - _q[i-1][j] - (_s[i]-_s[i-1])*((1.0-_sigma)*_dqdt[i-1][j] + _sigma*_dqdt[i][j]);
+            fg[k++] = FG::state_equation(i-1, i, _s[i]-_s[i-1], j);
 
         // (5.4) algebraic constraints: dqa^{i} = 0.0
         for (size_t j = 0; j < Dynamic_model_t::NALGEBRAIC; ++j)
@@ -1806,11 +2847,11 @@ inline void Optimal_laptime<Dynamic_model_t>::FG_derivative<isClosed>::compute(F
 
         // (5.7.2) q^{i} = q^{i-1} + 0.5.ds.[dqdt^{i} + dqdt^{i-1}] (before time)
         for (size_t j = 0; j < Dynamic_model_t::Road_type::ITIME; ++j)
-            fg[k++] = _q.front()[j] - _q.back()[j] - (L-_s.back())*((1.0-_sigma)*_dqdt.back()[j] + _sigma*_dqdt.front()[j]);
+            fg[k++] = FG::state_equation(_n_points-1, 0, L-_s.back(), j);
 
         // (5.7.3) q^{i} = q^{i-1} + 0.5.ds.[dqdt^{i} + dqdt^{i-1}] (before time)
         for (size_t j = Dynamic_model_t::Road_type::ITIME+1; j < Dynamic_model_t::NSTATE; ++j)
-            fg[k++] = _q.front()[j] - _q.back()[j] - (L-_s.back())*((1.0-_sigma)*_dqdt.back()[j] + _sigma*_dqdt.front()[j]);
+            fg[k++] = FG::state_equation(_n_points-1, 0, L-_s.back(), j);
 
         // (5.7.3) algebraic constraints: dqa^{0} = 0
         for (size_t j = 0; j < Dynamic_model_t::NALGEBRAIC; ++j)
@@ -1934,6 +2975,49 @@ void Optimal_laptime<Dynamic_model_t>::Control_variables<T>::check_inputs()
 }
 
 
+template<typename Dynamic_model_t>
+template<typename T>
+void Optimal_laptime<Dynamic_model_t>::Control_variables<T>::build_gather_plan(const Dynamic_model_t& car, const std::vector<scalar>& s)
+{
+    // (1) Default values
+    Gather_plan plan;
+    plan.s     = s;
+    plan.u_def = car.get_state_and_control_upper_lower_and_default_values().u_def;
+
+    // (2) Classify the controls, and locate the mesh points in the hypermeshes
+    for (size_t j = 0; j < Dynamic_model_t::NCONTROL; ++j)
+    {
+        switch((*this)[j].optimal_control_type)
+        {
+         case(DONT_OPTIMIZE):
+            // Keep the default value
+            break;
+         case(CONSTANT):
+            plan.constant_controls.push_back(j);
+            break;
+         case(HYPERMESH):
+            {
+                plan.hypermesh_controls.push_back(j);
+                std::vector<size_t> positions(s.size());
+
+                for (size_t i = 0; i < s.size(); ++i)
+                    positions[i] = Control_variable<T>::get_hypermesh_position_for_s((*this)[j].s_hypermesh, s[i]);
+
+                plan.hypermesh_positions.push_back(std::move(positions));
+                break;
+            }
+         case(FULL_MESH): 
+            plan.full_mesh_controls.push_back(j);
+            break;
+         default:
+            throw fastest_lap_exception("[ERROR] Control_variables::build_gather_plan() -> optimization mode not recognized");
+        }
+    }
+
+    _gather_plan = std::move(plan);
+}
+
+
 template<typename Dynamic_model_t>
 template<typename T>
 void Optimal_laptime<Dynamic_model_t>::Control_variables<T>::compute_statistics()
@@ -0,0 +1,75 @@
+#ifndef __PARETO_FRONT_H__
+#define __PARETO_FRONT_H__
+
+#include "src/core/applications/optimal_laptime.h"
+
+//! Pareto front between laptime and the budget of one integral quantity (e.g. engine energy, tire energy)
+//! Constructed by continuation on the upper bound of the integral quantity:
+//!     - Predictor: secant extrapolation of states and controls from the two previous points of the front
+//!     - Corrector: Optimal_laptime warm started with the predicted point and the multipliers of the previous point
+//! The step is adapted to the number of corrector iterations, and reduced where the slope of the front changes quickly
+template<typename Dynamic_model_t>
+class Pareto_front
+{
+ public:
+
+    using Optimal_laptime_type = Optimal_laptime<Dynamic_model_t>;
+
+    struct Options
+    {
+        std::string integral_quantity;                      // Name of the integral quantity whose upper bound is swept
+        scalar bound_start;                                 // First value of the upper bound
+        scalar bound_end;                                   // Last value of the upper bound
+        scalar initial_step;                                // Initial step size (absolute value)
+        scalar minimum_step;                                // The continuation stops if the step is reduced below this value
+        scalar maximum_step;                                // Maximum step size (absolute value)
+        size_t target_iterations        = 30;               // The step grows if the corrector needs less iterations than this
+        scalar step_growth              = 1.5;              // Step multiplier when the corrector converges fast
+        scalar step_reduction           = 0.5;              // Step multiplier when a point is rejected
+        scalar maximum_slope_change     = 0.25;             // Maximum relative change of dlaptime/dbound between consecutive points
+        scalar maximum_slope_change_absolute = 1.0e-8;      // Floor of the maximum change of dlaptime/dbound, used where the front is flat
+        bool   keep_solutions           = false;            // Store the full Optimal_laptime solution of every point
+        typename Optimal_laptime_type::Options optimal_laptime_options = {};
+    };
+
+    struct Point
+    {
+        scalar bound;                       //! Upper bound of the integral quantity
+        scalar laptime;                     //! Optimal laptime
+        scalar integral_quantity_value;     //! Value of the integral quantity in the optimal solution
+        size_t iter_count;                  //! Iterations spent by the corrector
+    };
+
+    //! Construct the front
+    //! @param[in] start: converged solution used to warm start the first point. It must restrict the swept integral quantity
+    //! @param[in] car: vehicle
+    //! @param[in] opts: options
+    Pareto_front(const Optimal_laptime_type& start, const Dynamic_model_t& car, const Options& opts);
+
+    Options options;
+
+    std::vector<Point> points;                              //! Accepted points, sorted from bound_start to bound_end
+    std::vector<Optimal_laptime_type> solutions;            //! Solutions of the accepted points (only if keep_solutions)
+    size_t number_of_rejected_points;                       //! Number of corrector steps rejected
+    bool   success;                                         //! True if bound_end was reached
+
+ private:
+
+    //! Position of the swept quantity in Dynamic_model_t::Integral_quantities::names
+    size_t _integral_quantity_index;
+
+    //! Check the options and the starting solution
+    void check_inputs(const Optimal_laptime_type& start);
+
+    //! Predict the solution at a new bound by secant extrapolation of the two previous solutions
+    static Optimal_laptime_type predict(const Optimal_laptime_type& previous, const Optimal_laptime_type& last,
+                                        const scalar bound_previous, const scalar bound_last, const scalar bound_new);
+
+    //! Solve the problem at the given bound warm started from the predicted solution and the multipliers of the last solution
+    Optimal_laptime_type correct(const Optimal_laptime_type& predicted, const Optimal_laptime_type& last,
+                                 const Dynamic_model_t& car, const scalar bound) const;
+};
+
+#include "pareto_front.hpp"
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef __PARETO_FRONT_HPP__
+#define __PARETO_FRONT_HPP__
+
+#include "src/core/foundation/fastest_lap_exception.h"
+#include "src/core/foundation/synchronized_output.h"
+
+template<typename Dynamic_model_t>
+inline Pareto_front<Dynamic_model_t>::Pareto_front(const Optimal_laptime_type& start, const Dynamic_model_t& car, const Options& opts)
+: options(opts), points(), solutions(), number_of_rejected_points(0), success(false), _integral_quantity_index(0)
+{
+    // (1) Check inputs
+    check_inputs(start);
+
+    const scalar direction = (options.bound_end > options.bound_start ? 1.0 : -1.0);
+    scalar step = options.initial_step;
+
+    auto add_point = [&](const Optimal_laptime_type& solution, const scalar bound)
+    {
+        points.push_back({bound, solution.laptime, solution.integral_quantities[_integral_quantity_index].value, solution.iter_count});
+
+        if ( options.keep_solutions )
+            solutions.push_back(solution);
+
+        synchronized_out(2) << "[INFO] Pareto_front -> point " << points.size() << ": bound = " << bound << ", laptime = " << solution.laptime
+               << ", iterations = " << solution.iter_count << std::endl;
+    };
+
+    // (2) First point: correct the starting solution at bound_start
+    Optimal_laptime_type last = correct(start, start, car, options.bound_start);
+
+    if ( !last.success )
+        throw fastest_lap_exception("[ERROR] Pareto_front -> the first point of the front (bound = " + std::to_string(options.bound_start)
+            + ") did not converge");
+
+    add_point(last, options.bound_start);
+
+    Optimal_laptime_type previous = last;
+    scalar bound_previous = options.bound_start;
+    scalar bound_last     = options.bound_start;
+
+    // (3) Continuation
+    while ( direction*(options.bound_end - bound_last) > 0.0 )
+    {
+        // (3.1) Next bound: do not go further than bound_end
+        const scalar bound_new = ( direction*(options.bound_end - bound_last) > step ? bound_last + direction*step : options.bound_end );
+
+        // (3.2) Predictor
+        const auto predicted = predict(previous, last, bound_previous, bound_last, bound_new);
+
+        // (3.3) Corrector
+        auto corrected = correct(predicted, last, car, bound_new);
+
+        // (3.4) Accept if converged and, unless the step cannot be reduced further, if the slope of the front changes slowly
+        bool accept = corrected.success;
+
+        const bool step_can_be_reduced = (step*options.step_reduction >= options.minimum_step);
+
+        if ( accept && (points.size() >= 2) && step_can_be_reduced )
+        {
+            const auto& point_last     = points.back();
+            const auto& point_previous = points[points.size()-2];
+            const scalar slope_last = (point_last.laptime - point_previous.laptime)/(point_last.bound - point_previous.bound);
+            const scalar slope_new  = (corrected.laptime - point_last.laptime)/(bound_new - point_last.bound);
+
+            const scalar maximum_slope_change = std::max(options.maximum_slope_change*std::abs(slope_last), 
+                                                         options.maximum_slope_change_absolute);
+
+            if ( std::abs(slope_new - slope_last) > maximum_slope_change )
+                accept = false;
+        }
+
+        if ( !accept )
+        {
+            ++number_of_rejected_points;
+
+            if ( !step_can_be_reduced )
+            {
+                synchronized_out(2) << "[WARNING] Pareto_front -> continuation stopped at bound = " << bound_last << ": minimum step reached" << std::endl;
+                return;
+            }
+
+            step *= options.step_reduction;
+            continue;
+        }
+
+        // (3.5) Store the point
+        add_point(corrected, bound_new);
+
+        // (3.6) Adapt the step to the effort spent by the corrector
+        if ( corrected.iter_count <= options.target_iterations )
+            step = std::min(step*options.step_growth, options.maximum_step);
+
+        previous       = std::move(last);
+        last           = std::move(corrected);
+        bound_previous = bound_last;
+        bound_last     = bound_new;
+    }
+
+    success = true;
+}
+
+
+template<typename Dynamic_model_t>
+inline void Pareto_front<Dynamic_model_t>::check_inputs(const Optimal_laptime_type& start)
+{
+    // (1) Find the integral quantity
+    const auto& names = Dynamic_model_t::Integral_quantities::names;
+    const auto it = std::find(names.cbegin(), names.cend(), options.integral_quantity);
+
+    if ( it == names.cend() )
+    {
+        std::ostringstream s_out;
+        s_out << "[ERROR] Pareto_front -> integral quantity \"" << options.integral_quantity << "\" was not found." << std::endl;
+        s_out << "[ERROR] Available options are: " << names;
+        throw fastest_lap_exception(s_out.str());
+    }
+
+    _integral_quantity_index = std::distance(names.cbegin(), it);
+
+    // (2) The starting solution must restrict the quantity, so that the multipliers have the correct size
+    if ( !start.integral_quantities[_integral_quantity_index].restrict )
+        throw fastest_lap_exception("[ERROR] Pareto_front -> the starting solution must restrict the integral quantity \""
+            + options.integral_quantity + "\"");
+
+    // (3) Check the steps
+    if ( options.minimum_step <= 0.0 )
+        throw fastest_lap_exception("[ERROR] Pareto_front -> minimum_step must be positive");
+
+    if ( (options.initial_step < options.minimum_step) || (options.initial_step > options.maximum_step) )
+        throw fastest_lap_exception("[ERROR] Pareto_front -> initial_step must be in [minimum_step, maximum_step]");
+
+    // (4) Check the slope tolerances
+    if ( (options.maximum_slope_change < 0.0) || (options.maximum_slope_change_absolute < 0.0) )
+        throw fastest_lap_exception("[ERROR] Pareto_front -> maximum_slope_change and maximum_slope_change_absolute must be non-negative");
+}
+
+
+template<typename Dynamic_model_t>
+inline typename Pareto_front<Dynamic_model_t>::Optimal_laptime_type Pareto_front<Dynamic_model_t>::predict(const Optimal_laptime_type& previous,
+    const Optimal_laptime_type& last, const scalar bound_previous, const scalar bound_last, const scalar bound_new)
+{
+    Optimal_laptime_type predicted = last;
+
+    // (1) With only one point, the prediction is the last solution
+    if ( std::abs(bound_last - bound_previous) < std::numeric_limits<scalar>::epsilon() )
+        return predicted;
+
+    // (2) Secant extrapolation: y_new = y_last + t.(y_last - y_previous)
+    const scalar t = (bound_new - bound_last)/(bound_last - bound_previous);
+
+    auto extrapolate = [t](std::vector<scalar>& y, const std::vector<scalar>& y_previous, const std::vector<scalar>& y_last)
+    {
+        for (size_t i = 0; i < y.size(); ++i)
+            y[i] = y_last[i] + t*(y_last[i] - y_previous[i]);
+    };
+
+    for (size_t i = 0; i < last.n_points; ++i)
+    {
+        for (size_t j = 0; j < Dynamic_model_t::NSTATE; ++j)
+            predicted.q[i][j] = last.q[i][j] + t*(last.q[i][j] - previous.q[i][j]);
+
+        for (size_t j = 0; j < Dynamic_model_t::NALGEBRAIC; ++j)
+            predicted.qa[i][j] = last.qa[i][j] + t*(last.qa[i][j] - previous.qa[i][j]);
+    }
+
+    for (size_t j = 0; j < Dynamic_model_t::NCONTROL; ++j)
+    {
+        extrapolate(predicted.control_variables[j].u, previous.control_variables[j].u, last.control_variables[j].u);
+        extrapolate(predicted.control_variables[j].dudt, previous.control_variables[j].dudt, last.control_variables[j].dudt);
+    }
+
+    return predicted;
+}
+
+
+template<typename Dynamic_model_t>
+inline typename Pareto_front<Dynamic_model_t>::Optimal_laptime_type Pareto_front<Dynamic_model_t>::correct(const Optimal_laptime_type& predicted,
+    const Optimal_laptime_type& last, const Dynamic_model_t& car, const scalar bound) const
+{
+    // (1) Set the bound of the swept quantity
+    auto opts = options.optimal_laptime_options;
+    opts.throw_if_fail = false;
+
+    auto it = std::find_if(opts.integral_quantities.begin(), opts.integral_quantities.end(),
+                           [this](const auto& quantity) -> auto { return quantity.name == options.integral_quantity; });
+
+    if ( it == opts.integral_quantities.end() )
+        opts.integral_quantities.push_back({options.integral_quantity, std::numeric_limits<scalar>::lowest(), bound});
+    else
+        it->upper_bound = bound;
+
+    // (2) Solve: primal from the prediction, dual from the last point of the front
+    return Optimal_laptime_type(predicted.s, predicted.is_closed, predicted.is_direct, car, predicted.q, predicted.qa, predicted.control_variables,
+        last.optimization_data.zl, last.optimization_data.zu, last.optimization_data.lambda, opts);
+}
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef __PATH_TRACKING_NMPC_H__
+#define __PATH_TRACKING_NMPC_H__
+
+#include <chrono>
+#include <memory>
+#include <functional>
+#include "lion/foundation/types.h"
+#include "lion/thirdparty/include/cppad/cppad.hpp"
+#include "src/core/applications/optimal_laptime.h"
+#include "src/core/foundation/fastest_lap_exception.h"
+#include "src/core/foundation/synchronized_output.h"
+
+//!      Nonlinear MPC path tracking
+//!      ---------------------------
+//!
+//! Tracks a reference lap (typically an Optimal_laptime solution) with a curvilinear Dynamic_model_car.
+//! The horizon spans the next N points of the reference mesh, and the problem is solved with the
+//! real-time iteration scheme: one Gauss-Newton SQP iteration (one QP) per control step.
+//!
+//!     - Dynamics: the same Crank-Nicolson scheme as Optimal_laptime, q(k+1) - q(k) = ds.((1-sigma).f(k) + sigma.f(k+1))
+//!       The controls are augmented to the state, z = [q,u], and the inputs are the control derivatives w = du/ds
+//!     - The algebraic variables are eliminated from the linearized equations at each node
+//!     - Cost: sum_k 1/2 (z(k)-z_ref(k))'.Q.(z(k)-z_ref(k)) + 1/2 w(k)'.R.w(k)
+//!     - The linearization trajectory is shifted by one node after every step (warm start)
+//!     - The vehicle functions are taped once per mesh node and reused by every step that contains it
+//!
+//! State bounds are not enforced, and the controls are projected onto their bounds after each QP
+template<typename Dynamic_model_t>
+class Path_tracking_nmpc
+{
+ public:
+    constexpr static size_t NSTATE     = Dynamic_model_t::NSTATE;
+    constexpr static size_t NALGEBRAIC = Dynamic_model_t::NALGEBRAIC;
+    constexpr static size_t NCONTROL   = Dynamic_model_t::NCONTROL;
+    constexpr static size_t NZ         = NSTATE + NCONTROL;
+
+    //! Solvers for the QP of each step
+    //!     (1) Riccati: structured solve, O(N) in the horizon length
+    //!     (2) Condensed: eliminate the states and solve the dense problem in the inputs, O(N^3)
+    enum Qp_solver { RICCATI, CONDENSED };
+
+    struct Options
+    {
+        size_t horizon                          = 20;          // Number of mesh elements in the horizon
+        Qp_solver qp_solver                     = RICCATI;
+        std::vector<scalar> state_weights       = {};          // Weights of (q-q_ref). If empty, 1/(1+max|q_ref|)^2, and 0 for the time
+        std::vector<scalar> control_weights     = {};          // Weights of (u-u_ref). If empty, 1/(1+max|u_ref|)^2
+        std::vector<scalar> control_rate_weights = {};         // Weights of du/ds. If empty, 1.0e-2 of the control weights
+        scalar terminal_weight_factor           = 10.0;        // Q(N) = terminal_weight_factor.Q
+        scalar sigma                            = 0.5;         // 0: explicit euler, 0.5: crank-nicolson, 1.0: implicit euler
+        bool   keep_tapes                       = true;        // If false, tapes behind the horizon are released
+        size_t plant_maximum_iterations         = 20;          // Newton iterations of the closed-loop simulator
+        scalar plant_tolerance                  = 1.0e-10;     // Tolerance of the closed-loop simulator
+    };
+
+    //! Constructor from a reference trajectory
+    //! @param[in] car: vehicle, with a curvilinear road
+    //! @param[in] s_ref: arclength of the reference mesh
+    //! @param[in] is_closed: if true, the horizon wraps around the track
+    //! @param[in] q_ref: reference states
+    //! @param[in] qa_ref: reference algebraic variables
+    //! @param[in] u_ref: reference controls
+    //! @param[in] opts: options
+    Path_tracking_nmpc(const Dynamic_model_t& car, const std::vector<scalar>& s_ref, const bool is_closed,
+                       const std::vector<std::array<scalar,NSTATE>>& q_ref,
+                       const std::vector<std::array<scalar,NALGEBRAIC>>& qa_ref,
+                       const std::vector<std::array<scalar,NCONTROL>>& u_ref,
+                       const Options& opts);
+
+    //! Constructor from an Optimal_laptime solution
+    //! @param[in] car: vehicle, with a curvilinear road
+    //! @param[in] reference: the optimal laptime used as reference
+    //! @param[in] opts: options
+    Path_tracking_nmpc(const Dynamic_model_t& car, const Optimal_laptime<Dynamic_model_t>& reference, const Options& opts);
+
+    //! Compute the controls for the next mesh point
+    //! @param[in] i: index of the current mesh point
+    //! @param[in] q: measured state
+    //! @param[in] qa: measured algebraic variables
+    //! @param[in] u: controls currently applied
+    //! @return the controls to be reached at i+1
+    std::array<scalar,NCONTROL> step(const size_t i, const std::array<scalar,NSTATE>& q, const std::array<scalar,NALGEBRAIC>& qa,
+                                     const std::array<scalar,NCONTROL>& u);
+
+    //! Propagate the vehicle from i to i+1 with the nonlinear model
+    //! @param[in] i: index of the current mesh point
+    //! @param[in/out] q: state
+    //! @param[in/out] qa: algebraic variables
+    //! @param[in] u: controls at i
+    //! @param[in] u_next: controls at i+1
+    //! @return true if the Newton iterations converged
+    bool propagate(const size_t i, std::array<scalar,NSTATE>& q, std::array<scalar,NALGEBRAIC>& qa,
+                   const std::array<scalar,NCONTROL>& u, const std::array<scalar,NCONTROL>& u_next);
+
+    struct Closed_loop_solution
+    {
+        bool success;                                           //! False if the simulator failed to converge
+        std::vector<scalar> s;                                  //! Arclength of every simulated point
+        std::vector<std::array<scalar,NSTATE>> q;               //! States
+        std::vector<std::array<scalar,NALGEBRAIC>> qa;          //! Algebraic variables
+        std::vector<std::array<scalar,NCONTROL>> u;             //! Controls
+        std::vector<scalar> computation_time;                   //! Wall time spent by the controller at every step [s]
+        scalar total_computation_time;                          //! Total wall time spent by the controller [s]
+        scalar simulated_time;                                  //! Elapsed time of the vehicle [s]
+    };
+
+    //! Simulate the closed loop: controller + nonlinear model
+    //! @param[in] q0: initial state
+    //! @param[in] qa0: initial algebraic variables
+    //! @param[in] u0: initial controls
+    //! @param[in] i_start: index of the initial mesh point
+    //! @param[in] n_steps: number of steps
+    //! @param[in] disturbance: called after every step as disturbance(i,q,qa), can modify the state
+    Closed_loop_solution simulate(const std::array<scalar,NSTATE>& q0, const std::array<scalar,NALGEBRAIC>& qa0,
+                                  const std::array<scalar,NCONTROL>& u0, const size_t i_start, const size_t n_steps,
+        std::function<void(const size_t, std::array<scalar,NSTATE>&, std::array<scalar,NALGEBRAIC>&)> disturbance = {});
+
+    //! Get the options
+    const Options& get_options() const { return _options; }
+
+    //! Number of tapes currently stored
+    size_t get_number_of_tapes() const { return std::count_if(_tapes.cbegin(), _tapes.cend(), [](const auto& t) -> auto { return t != nullptr; }); }
+
+ private:
+    Dynamic_model_t _car;
+    Options _options;
+
+    bool   _is_closed;
+    size_t _n_points;
+    std::vector<scalar> _s_ref;
+    std::vector<std::array<scalar,NSTATE>> _q_ref;
+    std::vector<std::array<scalar,NALGEBRAIC>> _qa_ref;
+    std::vector<std::array<scalar,NCONTROL>> _u_ref;
+
+    std::array<scalar,NZ> _z_weights;           //! Diagonal of Q
+    std::array<scalar,NCONTROL> _w_weights;     //! Diagonal of R
+    std::array<scalar,NCONTROL> _u_lb;          //! Lower bounds of the controls
+    std::array<scalar,NCONTROL> _u_ub;          //! Upper bounds of the controls
+
+    //! Tapes of [dqds,dqa] = f(q,qa,u), one per mesh point
+    std::vector<std::unique_ptr<CppAD::ADFun<scalar>>> _tapes;
+
+    //! Linearization trajectory, one entry per horizon node
+    bool _initialized;
+    size_t _i_current;
+    std::vector<std::array<scalar,NZ>> _z;
+    std::vector<std::array<scalar,NALGEBRAIC>> _qa;
+    std::vector<std::array<scalar,NCONTROL>> _w;
+
+    //! Linearization of the vehicle functions at one node, with the algebraic variables eliminated
+    struct Node_linearization
+    {
+        std::vector<scalar> f;      //! [NSTATE]: reduced dqds
+        std::vector<scalar> f_q;    //! [NSTATE x NSTATE]: reduced Jacobian w.r.t. q
+        std::vector<scalar> f_u;    //! [NSTATE x NCONTROL]: reduced Jacobian w.r.t. u
+        std::vector<scalar> qa_0;   //! [NALGEBRAIC]: qa correction, dqa = qa_0 + qa_q.dq + qa_u.du
+        std::vector<scalar> qa_q;   //! [NALGEBRAIC x NSTATE]
+        std::vector<scalar> qa_u;   //! [NALGEBRAIC x NCONTROL]
+    };
+
+    //! Discrete linear dynamics of one element, dz(k+1) = A.dz(k) + B.dw(k) + c
+    struct Stage
+    {
+        std::vector<scalar> A;      //! [NZ x NZ]
+        std::vector<scalar> B;      //! [NZ x NCONTROL]
+        std::vector<scalar> c;      //! [NZ]
+    };
+
+    //! Common setup to both constructors
+    void initialize();
+
+    //! Global index of the k-th node of a horizon that starts at i
+    size_t node_index(const size_t i, const size_t k) const { return (_is_closed ? (i+k) % _n_points : i+k); }
+
+    //! Length of the element [i,i+1]
+    scalar element_length(const size_t i) const;
+
+    //! Number of elements in a horizon that starts at i
+    size_t horizon_length(const size_t i) const;
+
+    //! Get the tape for the i-th point, record it if needed
+    CppAD::ADFun<scalar>& get_tape(const size_t i);
+
+    //! Evaluate the tape of the i-th point: returns values [dqds,dqa] and Jacobian (row major)
+    std::pair<std::vector<scalar>,std::vector<scalar>> evaluate(const size_t i, const std::array<scalar,NSTATE>& q,
+        const std::array<scalar,NALGEBRAIC>& qa, const std::array<scalar,NCONTROL>& u);
+
+    //! Linearize the reduced ODE at the i-th point
+    Node_linearization linearize(const size_t i, const std::array<scalar,NZ>& z, const std::array<scalar,NALGEBRAIC>& qa);
+
+    //! Set the k-th node of the linearization trajectory from the reference at the i-th point
+    void set_node_from_reference(const size_t k, const size_t i);
+
+    //! Set the linearization trajectory from the reference
+    void reset_trajectory(const size_t i);
+
+    //! Shift the linearization trajectory by one node
+    void shift_trajectory();
+
+    //! Solve the QP with the Riccati recursion. Returns [dz,dw]
+    std::pair<std::vector<std::array<scalar,NZ>>,std::vector<std::array<scalar,NCONTROL>>>
+        solve_riccati(const std::vector<Stage>& stages, const std::vector<std::array<scalar,NZ>>& residuals, const std::array<scalar,NZ>& dz0) const;
+
+    //! Solve the QP by condensing. Returns [dz,dw]
+    std::pair<std::vector<std::array<scalar,NZ>>,std::vector<std::array<scalar,NCONTROL>>>
+        solve_condensed(const std::vector<Stage>& stages, const std::vector<std::array<scalar,NZ>>& residuals, const std::array<scalar,NZ>& dz0) const;
+
+    //! Dense solve of A.X = B, with A [n x n] and B [n x m], row major (Gaussian elimination with partial pivoting)
+    static std::vector<scalar> solve_linear_system(std::vector<scalar> A, std::vector<scalar> B, const size_t n, const size_t m);
+
+    //! Dense product C = op(A).B, with op(A) [m x k], B [k x n], row major. If transpose_a, A is stored as [k x m]
+    static std::vector<scalar> multiply(const std::vector<scalar>& A, const std::vector<scalar>& B, const size_t m, const size_t k, const size_t n,
+                                        const bool transpose_a = false);
+};
+
+#include "path_tracking_nmpc.hpp"
+
+#endif
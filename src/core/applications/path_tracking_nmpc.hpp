@@ -0,0 +1,878 @@
+#ifndef __PATH_TRACKING_NMPC_HPP__
+#define __PATH_TRACKING_NMPC_HPP__
+
+template<typename Dynamic_model_t>
+inline Path_tracking_nmpc<Dynamic_model_t>::Path_tracking_nmpc(const Dynamic_model_t& car, const std::vector<scalar>& s_ref, const bool is_closed,
+    const std::vector<std::array<scalar,NSTATE>>& q_ref, const std::vector<std::array<scalar,NALGEBRAIC>>& qa_ref,
+    const std::vector<std::array<scalar,NCONTROL>>& u_ref, const Options& opts)
+: _car(car), _options(opts), _is_closed(is_closed), _n_points(s_ref.size()), _s_ref(s_ref), _q_ref(q_ref), _qa_ref(qa_ref), _u_ref(u_ref)
+{
+    initialize();
+}
+
+
+template<typename Dynamic_model_t>
+inline Path_tracking_nmpc<Dynamic_model_t>::Path_tracking_nmpc(const Dynamic_model_t& car, const Optimal_laptime<Dynamic_model_t>& reference,
+    const Options& opts)
+: _car(car), _options(opts), _is_closed(reference.is_closed), _n_points(reference.s.size()), _s_ref(reference.s), _q_ref(reference.q),
+  _qa_ref(reference.qa), _u_ref(reference.s.size())
+{
+    for (size_t i = 0; i < _n_points; ++i)
+        _u_ref[i] = reference.control_variables.control_array_at_s(car, i, reference.s[i]);
+
+    initialize();
+}
+
+
+template<typename Dynamic_model_t>
+inline void Path_tracking_nmpc<Dynamic_model_t>::initialize()
+{
+    // (1) Check inputs
+    if ( _n_points < 2 )
+        throw fastest_lap_exception("[ERROR] Path_tracking_nmpc -> the reference must contain at least two points");
+
+    if ( (_q_ref.size() != _n_points) || (_qa_ref.size() != _n_points) || (_u_ref.size() != _n_points) )
+        throw fastest_lap_exception("[ERROR] Path_tracking_nmpc -> q_ref, qa_ref, and u_ref must have the same size as s_ref");
+
+    if ( _options.horizon == 0 )
+        throw fastest_lap_exception("[ERROR] Path_tracking_nmpc -> horizon must be positive");
+
+    if ( _is_closed && (_options.horizon + 1 >= _n_points) )
+        throw fastest_lap_exception("[ERROR] Path_tracking_nmpc -> horizon must be smaller than the number of elements for closed circuits");
+
+    // (2) Control bounds
+    const auto values = _car.get_state_and_control_upper_lower_and_default_values();
+    _u_lb = values.u_lb;
+    _u_ub = values.u_ub;
+
+    // (3) Weights
+    auto default_weight = [](const auto& reference, const size_t j) -> scalar
+    {
+        scalar max_value = 0.0;
+        for (const auto& x : reference)
+            max_value = std::max(max_value, std::abs(x[j]));
+
+        return 1.0/((1.0 + max_value)*(1.0 + max_value));
+    };
+
+    if ( _options.state_weights.size() == 0 )
+    {
+        for (size_t j = 0; j < NSTATE; ++j)
+            _z_weights[j] = default_weight(_q_ref, j);
+
+        // The time restarts at every lap: do not track it
+        _z_weights[Dynamic_model_t::Road_type::ITIME] = 0.0;
+    }
+    else if ( _options.state_weights.size() == NSTATE )
+        std::copy(_options.state_weights.cbegin(), _options.state_weights.cend(), _z_weights.begin());
+    else
+        throw fastest_lap_exception("[ERROR] Path_tracking_nmpc -> state_weights must have size NSTATE");
+
+    if ( _options.control_weights.size() == 0 )
+    {
+        for (size_t j = 0; j < NCONTROL; ++j)
+            _z_weights[NSTATE+j] = default_weight(_u_ref, j);
+    }
+    else if ( _options.control_weights.size() == NCONTROL )
+        std::copy(_options.control_weights.cbegin(), _options.control_weights.cend(), _z_weights.begin() + NSTATE);
+    else
+        throw fastest_lap_exception("[ERROR] Path_tracking_nmpc -> control_weights must have size NCONTROL");
+
+    if ( _options.control_rate_weights.size() == 0 )
+    {
+        for (size_t j = 0; j < NCONTROL; ++j)
+            _w_weights[j] = 1.0e-2*_z_weights[NSTATE+j];
+    }
+    else if ( _options.control_rate_weights.size() == NCONTROL )
+        std::copy(_options.control_rate_weights.cbegin(), _options.control_rate_weights.cend(), _w_weights.begin());
+    else
+        throw fastest_lap_exception("[ERROR] Path_tracking_nmpc -> control_rate_weights must have size NCONTROL");
+
+    for (size_t j = 0; j < NCONTROL; ++j)
+        if ( _w_weights[j] <= 0.0 )
+            throw fastest_lap_exception("[ERROR] Path_tracking_nmpc -> control_rate_weights must be positive");
+
+    // (4) Allocate tapes and trajectories
+    _tapes.resize(_n_points);
+
+    _initialized = false;
+    _i_current   = 0;
+    _z  = std::vector<std::array<scalar,NZ>>(_options.horizon+1);
+    _qa = std::vector<std::array<scalar,NALGEBRAIC>>(_options.horizon+1);
+    _w  = std::vector<std::array<scalar,NCONTROL>>(_options.horizon);
+}
+
+
+template<typename Dynamic_model_t>
+inline scalar Path_tracking_nmpc<Dynamic_model_t>::element_length(const size_t i) const
+{
+    if ( i + 1 < _n_points )
+        return _s_ref[i+1] - _s_ref[i];
+    else if ( _is_closed )
+        return _car.get_road().track_length() - _s_ref.back() + _s_ref.front();
+    else
+        throw fastest_lap_exception("[ERROR] Path_tracking_nmpc::element_length -> the last point of an open reference has no element");
+}
+
+
+template<typename Dynamic_model_t>
+inline size_t Path_tracking_nmpc<Dynamic_model_t>::horizon_length(const size_t i) const
+{
+    if ( _is_closed )
+        return _options.horizon;
+    else
+        return std::min(_options.horizon, _n_points - 1 - i);
+}
+
+
+template<typename Dynamic_model_t>
+inline CppAD::ADFun<scalar>& Path_tracking_nmpc<Dynamic_model_t>::get_tape(const size_t i)
+{
+    if ( _tapes[i] == nullptr )
+    {
+        // (1) Declare the independent variables x = [q,qa,u], recorded at the reference values
+        std::vector<CppAD::AD<scalar>> x(NSTATE + NALGEBRAIC + NCONTROL);
+
+        std::copy(_q_ref[i].cbegin(), _q_ref[i].cend(), x.begin());
+        std::copy(_qa_ref[i].cbegin(), _qa_ref[i].cend(), x.begin() + NSTATE);
+        std::copy(_u_ref[i].cbegin(), _u_ref[i].cend(), x.begin() + NSTATE + NALGEBRAIC);
+
+        CppAD::Independent(x);
+
+        std::array<CppAD::AD<scalar>,NSTATE>     q;
+        std::array<CppAD::AD<scalar>,NALGEBRAIC> qa;
+        std::array<CppAD::AD<scalar>,NCONTROL>   u;
+
+        std::copy_n(x.cbegin(), NSTATE, q.begin());
+        std::copy_n(x.cbegin() + NSTATE, NALGEBRAIC, qa.begin());
+        std::copy_n(x.cbegin() + NSTATE + NALGEBRAIC, NCONTROL, u.begin());
+
+        // (2) Record the vehicle at the arclength of the point
+        auto [dqds, dqa] = _car(q, qa, u, _s_ref[i]);
+
+        std::vector<CppAD::AD<scalar>> y(dqds.cbegin(), dqds.cend());
+        y.insert(y.end(), dqa.cbegin(), dqa.cend());
+
+        _tapes[i] = std::make_unique<CppAD::ADFun<scalar>>(x, y);
+    }
+
+    return *_tapes[i];
+}
+
+
+template<typename Dynamic_model_t>
+inline std::pair<std::vector<scalar>,std::vector<scalar>> Path_tracking_nmpc<Dynamic_model_t>::evaluate(const size_t i,
+    const std::array<scalar,NSTATE>& q, const std::array<scalar,NALGEBRAIC>& qa, const std::array<scalar,NCONTROL>& u)
+{
+    std::vector<scalar> x(NSTATE + NALGEBRAIC + NCONTROL);
+
+    std::copy(q.cbegin(), q.cend(), x.begin());
+    std::copy(qa.cbegin(), qa.cend(), x.begin() + NSTATE);
+    std::copy(u.cbegin(), u.cend(), x.begin() + NSTATE + NALGEBRAIC);
+
+    auto& f = get_tape(i);
+
+    auto values = f.Forward(0, x);
+    auto jacobian = f.Jacobian(x);
+
+    return {values, jacobian};
+}
+
+
+template<typename Dynamic_model_t>
+inline typename Path_tracking_nmpc<Dynamic_model_t>::Node_linearization Path_tracking_nmpc<Dynamic_model_t>::linearize(const size_t i,
+    const std::array<scalar,NZ>& z, const std::array<scalar,NALGEBRAIC>& qa)
+{
+    constexpr const size_t n_total = NSTATE + NALGEBRAIC + NCONTROL;
+
+    std::array<scalar,NSTATE> q;
+    std::array<scalar,NCONTROL> u;
+    std::copy_n(z.cbegin(), NSTATE, q.begin());
+    std::copy_n(z.cbegin() + NSTATE, NCONTROL, u.begin());
+
+    const auto [values, jacobian] = evaluate(i, q, qa, u);
+
+    // (1) Eliminate the algebraic variables: dqa = -dg/dqa^{-1}.(g + dg/dq.dq + dg/du.du)
+    std::vector<scalar> g_qa(NALGEBRAIC*NALGEBRAIC);
+    std::vector<scalar> rhs(NALGEBRAIC*(NSTATE+NCONTROL+1));
+
+    for (size_t a = 0; a < NALGEBRAIC; ++a)
+    {
+        const size_t row = (NSTATE + a)*n_total;
+
+        for (size_t c = 0; c < NALGEBRAIC; ++c)
+            g_qa[a*NALGEBRAIC + c] = jacobian[row + NSTATE + c];
+
+        for (size_t c = 0; c < NSTATE; ++c)
+            rhs[a*(NSTATE+NCONTROL+1) + c] = -jacobian[row + c];
+
+        for (size_t c = 0; c < NCONTROL; ++c)
+            rhs[a*(NSTATE+NCONTROL+1) + NSTATE + c] = -jacobian[row + NSTATE + NALGEBRAIC + c];
+
+        rhs[a*(NSTATE+NCONTROL+1) + NSTATE + NCONTROL] = -values[NSTATE + a];
+    }
+
+    const auto dqa = solve_linear_system(g_qa, rhs, NALGEBRAIC, NSTATE+NCONTROL+1);
+
+    Node_linearization linearization;
+    linearization.qa_0 = std::vector<scalar>(NALGEBRAIC);
+    linearization.qa_q = std::vector<scalar>(NALGEBRAIC*NSTATE);
+    linearization.qa_u = std::vector<scalar>(NALGEBRAIC*NCONTROL);
+
+    for (size_t a = 0; a < NALGEBRAIC; ++a)
+    {
+        for (size_t c = 0; c < NSTATE; ++c)
+            linearization.qa_q[a*NSTATE + c] = dqa[a*(NSTATE+NCONTROL+1) + c];
+
+        for (size_t c = 0; c < NCONTROL; ++c)
+            linearization.qa_u[a*NCONTROL + c] = dqa[a*(NSTATE+NCONTROL+1) + NSTATE + c];
+
+        linearization.qa_0[a] = dqa[a*(NSTATE+NCONTROL+1) + NSTATE + NCONTROL];
+    }
+
+    // (2) Reduced ODE: f + df/dqa.dqa
+    linearization.f   = std::vector<scalar>(values.cbegin(), values.cbegin() + NSTATE);
+    linearization.f_q = std::vector<scalar>(NSTATE*NSTATE);
+    linearization.f_u = std::vector<scalar>(NSTATE*NCONTROL);
+
+    for (size_t r = 0; r < NSTATE; ++r)
+    {
+        const size_t row = r*n_total;
+
+        for (size_t c = 0; c < NSTATE; ++c)
+            linearization.f_q[r*NSTATE + c] = jacobian[row + c];
+
+        for (size_t c = 0; c < NCONTROL; ++c)
+            linearization.f_u[r*NCONTROL + c] = jacobian[row + NSTATE + NALGEBRAIC + c];
+
+        for (size_t a = 0; a < NALGEBRAIC; ++a)
+        {
+            const scalar f_qa = jacobian[row + NSTATE + a];
+
+            linearization.f[r] += f_qa*linearization.qa_0[a];
+
+            for (size_t c = 0; c < NSTATE; ++c)
+                linearization.f_q[r*NSTATE + c] += f_qa*linearization.qa_q[a*NSTATE + c];
+
+            for (size_t c = 0; c < NCONTROL; ++c)
+                linearization.f_u[r*NCONTROL + c] += f_qa*linearization.qa_u[a*NCONTROL + c];
+        }
+    }
+
+    return linearization;
+}
+
+
+template<typename Dynamic_model_t>
+inline void Path_tracking_nmpc<Dynamic_model_t>::set_node_from_reference(const size_t k, const size_t i)
+{
+    std::copy(_q_ref[i].cbegin(), _q_ref[i].cend(), _z[k].begin());
+    std::copy(_u_ref[i].cbegin(), _u_ref[i].cend(), _z[k].begin() + NSTATE);
+    _qa[k] = _qa_ref[i];
+
+    if ( k < _options.horizon )
+    {
+        if ( _is_closed || (i + 1 < _n_points) )
+        {
+            const size_t i_next = node_index(i,1);
+            const scalar ds = element_length(i);
+
+            for (size_t j = 0; j < NCONTROL; ++j)
+                _w[k][j] = (_u_ref[i_next][j] - _u_ref[i][j])/ds;
+        }
+        else
+            _w[k].fill(0.0);
+    }
+}
+
+
+template<typename Dynamic_model_t>
+inline void Path_tracking_nmpc<Dynamic_model_t>::reset_trajectory(const size_t i)
+{
+    for (size_t k = 0; k <= _options.horizon; ++k)
+        set_node_from_reference(k, std::min(node_index(i,k), _n_points-1));
+
+    _i_current   = i;
+    _initialized = true;
+}
+
+
+template<typename Dynamic_model_t>
+inline void Path_tracking_nmpc<Dynamic_model_t>::shift_trajectory()
+{
+    std::rotate(_z.begin(), _z.begin() + 1, _z.end());
+    std::rotate(_qa.begin(), _qa.begin() + 1, _qa.end());
+    std::rotate(_w.begin(), _w.begin() + 1, _w.end());
+
+    // The new nodes enter from the reference
+    const size_t i_last = std::min(node_index(_i_current,_options.horizon), _n_points-1);
+    set_node_from_reference(_options.horizon, i_last);
+
+    if ( _is_closed || (i_last > 0) )
+    {
+        const size_t i_previous = (i_last == 0 ? _n_points - 1 : i_last - 1);
+        const scalar ds = element_length(i_previous);
+
+        for (size_t j = 0; j < NCONTROL; ++j)
+            _w.back()[j] = (_u_ref[i_last][j] - _z[_options.horizon-1][NSTATE+j])/ds;
+    }
+}
+
+
+template<typename Dynamic_model_t>
+inline std::array<scalar,Path_tracking_nmpc<Dynamic_model_t>::NCONTROL> Path_tracking_nmpc<Dynamic_model_t>::step(const size_t i,
+    const std::array<scalar,NSTATE>& q, const std::array<scalar,NALGEBRAIC>& qa, const std::array<scalar,NCONTROL>& u)
+{
+    if ( i >= _n_points )
+        throw fastest_lap_exception("[ERROR] Path_tracking_nmpc::step -> point index out of bounds");
+
+    // (1) Warm start: the trajectory was shifted by the previous step. Otherwise, start from the reference
+    if ( !_initialized || (i != _i_current) )
+        reset_trajectory(i);
+
+    const size_t N = horizon_length(i);
+
+    if ( N == 0 )
+        return u;
+
+    // (2) Preparation phase: linearize the nodes and the elements of the horizon
+    std::vector<Node_linearization> nodes;
+    nodes.reserve(N+1);
+
+    for (size_t k = 0; k <= N; ++k)
+        nodes.push_back(linearize(node_index(i,k), _z[k], _qa[k]));
+
+    const scalar sigma = _options.sigma;
+    std::vector<Stage> stages(N);
+
+    for (size_t k = 0; k < N; ++k)
+    {
+        const scalar ds = element_length(node_index(i,k));
+        const auto& node_a = nodes[k];
+        const auto& node_b = nodes[k+1];
+
+        // (2.1) Defects of the linearization trajectory
+        std::array<scalar,NCONTROL> c_u;
+        for (size_t j = 0; j < NCONTROL; ++j)
+            c_u[j] = _z[k][NSTATE+j] + ds*_w[k][j] - _z[k+1][NSTATE+j];
+
+        // (2.2) Solve (I - ds.sigma.f_q(k+1)).dq(k+1) = [I + ds.(1-sigma).f_q(k) | ds.(1-sigma).f_u(k) + ds.sigma.f_u(k+1) | ds^2.sigma.f_u(k+1) | c_q]
+        constexpr const size_t n_rhs = NZ + NCONTROL + 1;
+        std::vector<scalar> M(NSTATE*NSTATE);
+        std::vector<scalar> rhs(NSTATE*n_rhs);
+
+        for (size_t r = 0; r < NSTATE; ++r)
+        {
+            for (size_t c = 0; c < NSTATE; ++c)
+            {
+                M[r*NSTATE + c] = (r == c ? 1.0 : 0.0) - ds*sigma*node_b.f_q[r*NSTATE + c];
+                rhs[r*n_rhs + c] = (r == c ? 1.0 : 0.0) + ds*(1.0-sigma)*node_a.f_q[r*NSTATE + c];
+            }
+
+            scalar c_q = _z[k][r] + ds*((1.0-sigma)*node_a.f[r] + sigma*node_b.f[r]) - _z[k+1][r];
+
+            for (size_t j = 0; j < NCONTROL; ++j)
+            {
+                rhs[r*n_rhs + NSTATE + j]   = ds*(1.0-sigma)*node_a.f_u[r*NCONTROL + j] + ds*sigma*node_b.f_u[r*NCONTROL + j];
+                rhs[r*n_rhs + NZ + j]       = ds*ds*sigma*node_b.f_u[r*NCONTROL + j];
+                c_q                        += ds*sigma*node_b.f_u[r*NCONTROL + j]*c_u[j];
+            }
+
+            rhs[r*n_rhs + NZ + NCONTROL] = c_q;
+        }
+
+        const auto X = solve_linear_system(M, rhs, NSTATE, n_rhs);
+
+        // (2.3) Construct dz(k+1) = A.dz(k) + B.dw(k) + c
+        auto& stage = stages[k];
+        stage.A = std::vector<scalar>(NZ*NZ, 0.0);
+        stage.B = std::vector<scalar>(NZ*NCONTROL, 0.0);
+        stage.c = std::vector<scalar>(NZ, 0.0);
+
+        for (size_t r = 0; r < NSTATE; ++r)
+        {
+            std::copy_n(X.cbegin() + r*n_rhs, NZ, stage.A.begin() + r*NZ);
+            std::copy_n(X.cbegin() + r*n_rhs + NZ, NCONTROL, stage.B.begin() + r*NCONTROL);
+            stage.c[r] = X[r*n_rhs + NZ + NCONTROL];
+        }
+
+        for (size_t j = 0; j < NCONTROL; ++j)
+        {
+            stage.A[(NSTATE+j)*NZ + NSTATE + j] = 1.0;
+            stage.B[(NSTATE+j)*NCONTROL + j]    = ds;
+            stage.c[NSTATE+j]                   = c_u[j];
+        }
+    }
+
+    std::vector<std::array<scalar,NZ>> residuals(N+1);
+
+    for (size_t k = 0; k <= N; ++k)
+    {
+        const size_t i_node = node_index(i,k);
+
+        for (size_t j = 0; j < NSTATE; ++j)
+            residuals[k][j] = _z[k][j] - _q_ref[i_node][j];
+
+        for (size_t j = 0; j < NCONTROL; ++j)
+            residuals[k][NSTATE+j] = _z[k][NSTATE+j] - _u_ref[i_node][j];
+    }
+
+    // (3) Feedback phase: embed the measured state and solve the QP
+    std::array<scalar,NZ> dz0;
+
+    for (size_t j = 0; j < NSTATE; ++j)
+        dz0[j] = q[j] - _z[0][j];
+
+    for (size_t j = 0; j < NCONTROL; ++j)
+        dz0[NSTATE+j] = u[j] - _z[0][NSTATE+j];
+
+    const auto [dz, dw] = ( _options.qp_solver == RICCATI ? solve_riccati(stages, residuals, dz0) : solve_condensed(stages, residuals, dz0) );
+
+    // (4) Update the trajectory
+    for (size_t k = 0; k <= N; ++k)
+    {
+        for (size_t a = 0; a < NALGEBRAIC; ++a)
+        {
+            _qa[k][a] += nodes[k].qa_0[a];
+
+            for (size_t c = 0; c < NSTATE; ++c)
+                _qa[k][a] += nodes[k].qa_q[a*NSTATE + c]*dz[k][c];
+
+            for (size_t c = 0; c < NCONTROL; ++c)
+                _qa[k][a] += nodes[k].qa_u[a*NCONTROL + c]*dz[k][NSTATE+c];
+        }
+
+        for (size_t j = 0; j < NZ; ++j)
+            _z[k][j] += dz[k][j];
+
+        for (size_t j = 0; j < NCONTROL; ++j)
+            _z[k][NSTATE+j] = std::max(_u_lb[j], std::min(_u_ub[j], _z[k][NSTATE+j]));
+    }
+
+    for (size_t k = 0; k < N; ++k)
+        for (size_t j = 0; j < NCONTROL; ++j)
+            _w[k][j] += dw[k][j];
+
+    _qa[0] = qa;
+
+    std::array<scalar,NCONTROL> u_next;
+    std::copy_n(_z[1].cbegin() + NSTATE, NCONTROL, u_next.begin());
+
+    // (5) Release the tape left behind the horizon, and shift the trajectory for the next step
+    if ( !_options.keep_tapes && (_is_closed || (i > 0)) )
+        _tapes[(i == 0 ? _n_points - 1 : i - 1)].reset();
+
+    _i_current = node_index(i,1);
+    shift_trajectory();
+
+    return u_next;
+}
+
+
+template<typename Dynamic_model_t>
+inline std::pair<std::vector<std::array<scalar,Path_tracking_nmpc<Dynamic_model_t>::NZ>>,
+                 std::vector<std::array<scalar,Path_tracking_nmpc<Dynamic_model_t>::NCONTROL>>>
+    Path_tracking_nmpc<Dynamic_model_t>::solve_riccati(const std::vector<Stage>& stages, const std::vector<std::array<scalar,NZ>>& residuals,
+    const std::array<scalar,NZ>& dz0) const
+{
+    const size_t N = stages.size();
+
+    // (1) Terminal cost-to-go: V(dz) = 1/2 dz'.P.dz + p'.dz
+    std::vector<scalar> P(NZ*NZ, 0.0);
+    std::vector<scalar> p(NZ);
+
+    for (size_t j = 0; j < NZ; ++j)
+    {
+        P[j*NZ + j] = _options.terminal_weight_factor*_z_weights[j];
+        p[j]        = _options.terminal_weight_factor*_z_weights[j]*residuals[N][j];
+    }
+
+    // (2) Backward recursion: dw(k) = K(k).dz(k) + k(k)
+    std::vector<std::vector<scalar>> K(N);
+    std::vector<std::vector<scalar>> k_ff(N);
+
+    for (size_t k = N; k-- > 0; )
+    {
+        const auto& stage = stages[k];
+
+        const auto PA = multiply(P, stage.A, NZ, NZ, NZ);
+        const auto PB = multiply(P, stage.B, NZ, NZ, NCONTROL);
+        auto Pc_p = multiply(P, stage.c, NZ, NZ, 1);
+
+        for (size_t j = 0; j < NZ; ++j)
+            Pc_p[j] += p[j];
+
+        // (2.1) H = R + B'.P.B, G = B'.P.A, g = R.w + B'.(P.c + p)
+        auto H = multiply(stage.B, PB, NCONTROL, NZ, NCONTROL, true);
+        const auto G = multiply(stage.B, PA, NCONTROL, NZ, NZ, true);
+        const auto g = multiply(stage.B, Pc_p, NCONTROL, NZ, 1, true);
+
+        std::vector<scalar> rhs(NCONTROL*(NZ+1));
+
+        for (size_t r = 0; r < NCONTROL; ++r)
+        {
+            H[r*NCONTROL + r] += _w_weights[r];
+
+            for (size_t c = 0; c < NZ; ++c)
+                rhs[r*(NZ+1) + c] = -G[r*NZ + c];
+
+            rhs[r*(NZ+1) + NZ] = -(g[r] + _w_weights[r]*_w[k][r]);
+        }
+
+        // (2.2) [K,k] = -H^{-1}.[G,g]
+        const auto X = solve_linear_system(H, rhs, NCONTROL, NZ+1);
+
+        K[k]    = std::vector<scalar>(NCONTROL*NZ);
+        k_ff[k] = std::vector<scalar>(NCONTROL);
+
+        for (size_t r = 0; r < NCONTROL; ++r)
+        {
+            std::copy_n(X.cbegin() + r*(NZ+1), NZ, K[k].begin() + r*NZ);
+            k_ff[k][r] = X[r*(NZ+1) + NZ];
+        }
+
+        // (2.3) P = Q + A'.P.A + G'.K, p = Q.r + A'.(P.c + p) + G'.k
+        auto P_new = multiply(stage.A, PA, NZ, NZ, NZ, true);
+        const auto GK = multiply(G, K[k], NZ, NCONTROL, NZ, true);
+        auto p_new = multiply(stage.A, Pc_p, NZ, NZ, 1, true);
+        const auto Gk = multiply(G, k_ff[k], NZ, NCONTROL, 1, true);
+
+        for (size_t r = 0; r < NZ; ++r)
+        {
+            for (size_t c = 0; c < NZ; ++c)
+                P_new[r*NZ + c] += GK[r*NZ + c];
+
+            P_new[r*NZ + r] += _z_weights[r];
+            p_new[r]        += _z_weights[r]*residuals[k][r] + Gk[r];
+        }
+
+        // (2.4) Keep P symmetric
+        for (size_t r = 0; r < NZ; ++r)
+            for (size_t c = r+1; c < NZ; ++c)
+                P_new[r*NZ + c] = P_new[c*NZ + r] = 0.5*(P_new[r*NZ + c] + P_new[c*NZ + r]);
+
+        P = std::move(P_new);
+        p = std::move(p_new);
+    }
+
+    // (3) Forward rollout
+    std::vector<std::array<scalar,NZ>> dz(N+1);
+    std::vector<std::array<scalar,NCONTROL>> dw(N);
+
+    dz[0] = dz0;
+
+    for (size_t k = 0; k < N; ++k)
+    {
+        const auto K_dz = multiply(K[k], std::vector<scalar>(dz[k].cbegin(), dz[k].cend()), NCONTROL, NZ, 1);
+
+        for (size_t j = 0; j < NCONTROL; ++j)
+            dw[k][j] = K_dz[j] + k_ff[k][j];
+
+        const auto A_dz = multiply(stages[k].A, std::vector<scalar>(dz[k].cbegin(), dz[k].cend()), NZ, NZ, 1);
+        const auto B_dw = multiply(stages[k].B, std::vector<scalar>(dw[k].cbegin(), dw[k].cend()), NZ, NCONTROL, 1);
+
+        for (size_t j = 0; j < NZ; ++j)
+            dz[k+1][j] = A_dz[j] + B_dw[j] + stages[k].c[j];
+    }
+
+    return {dz, dw};
+}
+
+
+template<typename Dynamic_model_t>
+inline std::pair<std::vector<std::array<scalar,Path_tracking_nmpc<Dynamic_model_t>::NZ>>,
+                 std::vector<std::array<scalar,Path_tracking_nmpc<Dynamic_model_t>::NCONTROL>>>
+    Path_tracking_nmpc<Dynamic_model_t>::solve_condensed(const std::vector<Stage>& stages, const std::vector<std::array<scalar,NZ>>& residuals,
+    const std::array<scalar,NZ>& dz0) const
+{
+    const size_t N = stages.size();
+    const size_t n_w = N*NCONTROL;
+
+    // (1) Hessian and gradient of the input terms
+    std::vector<scalar> H(n_w*n_w, 0.0);
+    std::vector<scalar> g(n_w);
+
+    for (size_t k = 0; k < N; ++k)
+        for (size_t j = 0; j < NCONTROL; ++j)
+        {
+            H[(k*NCONTROL + j)*n_w + k*NCONTROL + j] = _w_weights[j];
+            g[k*NCONTROL + j] = _w_weights[j]*_w[k][j];
+        }
+
+    // (2) Propagate dz(k) = d(k) + S(k).dW, and add the state terms
+    std::vector<scalar> d(dz0.cbegin(), dz0.cend());
+    std::vector<scalar> S(NZ*n_w, 0.0);
+
+    for (size_t k = 0; k < N; ++k)
+    {
+        // (2.1) d(k+1) = A.d(k) + c, S(k+1) = A.S(k) + [0,..,B,..,0]
+        auto d_next = multiply(stages[k].A, d, NZ, NZ, 1);
+        auto S_next = multiply(stages[k].A, S, NZ, NZ, n_w);
+
+        for (size_t r = 0; r < NZ; ++r)
+        {
+            d_next[r] += stages[k].c[r];
+
+            for (size_t j = 0; j < NCONTROL; ++j)
+                S_next[r*n_w + k*NCONTROL + j] += stages[k].B[r*NCONTROL + j];
+        }
+
+        d = std::move(d_next);
+        S = std::move(S_next);
+
+        // (2.2) H += S'.Q.S, g += S'.Q.(d + r)
+        const scalar factor = (k + 1 == N ? _options.terminal_weight_factor : 1.0);
+        std::vector<scalar> QS(NZ*n_w);
+        std::vector<scalar> Q_d(NZ);
+
+        for (size_t r = 0; r < NZ; ++r)
+        {
+            const scalar weight = factor*_z_weights[r];
+
+            for (size_t c = 0; c < n_w; ++c)
+                QS[r*n_w + c] = weight*S[r*n_w + c];
+
+            Q_d[r] = weight*(d[r] + residuals[k+1][r]);
+        }
+
+        const auto StQS = multiply(S, QS, n_w, NZ, n_w, true);
+        const auto StQd = multiply(S, Q_d, n_w, NZ, 1, true);
+
+        for (size_t r = 0; r < n_w; ++r)
+        {
+            for (size_t c = 0; c < n_w; ++c)
+                H[r*n_w + c] += StQS[r*n_w + c];
+
+            g[r] += StQd[r];
+        }
+    }
+
+    // (3) Solve H.dW = -g
+    for (auto& g_i : g)
+        g_i = -g_i;
+
+    const auto dW = solve_linear_system(H, g, n_w, 1);
+
+    // (4) Forward rollout
+    std::vector<std::array<scalar,NZ>> dz(N+1);
+    std::vector<std::array<scalar,NCONTROL>> dw(N);
+
+    dz[0] = dz0;
+
+    for (size_t k = 0; k < N; ++k)
+    {
+        std::copy_n(dW.cbegin() + k*NCONTROL, NCONTROL, dw[k].begin());
+
+        const auto A_dz = multiply(stages[k].A, std::vector<scalar>(dz[k].cbegin(), dz[k].cend()), NZ, NZ, 1);
+        const auto B_dw = multiply(stages[k].B, std::vector<scalar>(dw[k].cbegin(), dw[k].cend()), NZ, NCONTROL, 1);
+
+        for (size_t j = 0; j < NZ; ++j)
+            dz[k+1][j] = A_dz[j] + B_dw[j] + stages[k].c[j];
+    }
+
+    return {dz, dw};
+}
+
+
+template<typename Dynamic_model_t>
+inline bool Path_tracking_nmpc<Dynamic_model_t>::propagate(const size_t i, std::array<scalar,NSTATE>& q, std::array<scalar,NALGEBRAIC>& qa,
+    const std::array<scalar,NCONTROL>& u, const std::array<scalar,NCONTROL>& u_next)
+{
+    constexpr const size_t n_total = NSTATE + NALGEBRAIC + NCONTROL;
+    constexpr const size_t n_y     = NSTATE + NALGEBRAIC;
+
+    const scalar ds       = element_length(i);
+    const size_t i_next   = node_index(i,1);
+    const scalar sigma    = _options.sigma;
+    const auto [f, jac_f] = evaluate(i, q, qa, u);
+
+    // (1) Newton iterations on y = [q(i+1), qa(i+1)]
+    std::array<scalar,NSTATE> q_next(q);
+    std::array<scalar,NALGEBRAIC> qa_next(qa);
+
+    for (size_t iter = 0; iter <= _options.plant_maximum_iterations; ++iter)
+    {
+        const auto [values, jacobian] = evaluate(i_next, q_next, qa_next, u_next);
+
+        // (1.1) Residual: [q(i+1) - q(i) - ds.((1-sigma).f(i) + sigma.f(i+1)), g(i+1)]
+        std::vector<scalar> residual(n_y);
+        scalar residual_norm = 0.0;
+
+        for (size_t r = 0; r < NSTATE; ++r)
+            residual[r] = q_next[r] - q[r] - ds*((1.0-sigma)*f[r] + sigma*values[r]);
+
+        for (size_t a = 0; a < NALGEBRAIC; ++a)
+            residual[NSTATE + a] = values[NSTATE + a];
+
+        for (const auto& r : residual)
+            residual_norm = std::max(residual_norm, std::abs(r));
+
+        if ( residual_norm < _options.plant_tolerance )
+        {
+            q  = q_next;
+            qa = qa_next;
+            return true;
+        }
+
+        if ( iter == _options.plant_maximum_iterations )
+            break;
+
+        // (1.2) Jacobian
+        std::vector<scalar> J(n_y*n_y);
+
+        for (size_t r = 0; r < NSTATE; ++r)
+            for (size_t c = 0; c < n_y; ++c)
+                J[r*n_y + c] = (r == c ? 1.0 : 0.0) - ds*sigma*jacobian[r*n_total + c];
+
+        for (size_t a = 0; a < NALGEBRAIC; ++a)
+            for (size_t c = 0; c < n_y; ++c)
+                J[(NSTATE + a)*n_y + c] = jacobian[(NSTATE + a)*n_total + c];
+
+        // (1.3) Update
+        const auto dy = solve_linear_system(J, residual, n_y, 1);
+
+        for (size_t r = 0; r < NSTATE; ++r)
+            q_next[r] -= dy[r];
+
+        for (size_t a = 0; a < NALGEBRAIC; ++a)
+            qa_next[a] -= dy[NSTATE + a];
+    }
+
+    return false;
+}
+
+
+template<typename Dynamic_model_t>
+inline typename Path_tracking_nmpc<Dynamic_model_t>::Closed_loop_solution Path_tracking_nmpc<Dynamic_model_t>::simulate(
+    const std::array<scalar,NSTATE>& q0, const std::array<scalar,NALGEBRAIC>& qa0, const std::array<scalar,NCONTROL>& u0,
+    const size_t i_start, const size_t n_steps,
+    std::function<void(const size_t, std::array<scalar,NSTATE>&, std::array<scalar,NALGEBRAIC>&)> disturbance)
+{
+    Closed_loop_solution solution = {true, {_s_ref[i_start]}, {q0}, {qa0}, {u0}, {}, 0.0, 0.0};
+
+    auto q  = q0;
+    auto qa = qa0;
+    auto u  = u0;
+    size_t i = i_start;
+
+    _initialized = false;
+
+    for (size_t n = 0; n < n_steps; ++n)
+    {
+        if ( !_is_closed && (i + 1 >= _n_points) )
+            break;
+
+        // (1) Controller
+        const auto start = std::chrono::high_resolution_clock::now();
+        const auto u_next = step(i, q, qa, u);
+        const auto end = std::chrono::high_resolution_clock::now();
+        const scalar elapsed = std::chrono::duration<scalar>(end - start).count();
+
+        // (2) Vehicle
+        if ( !propagate(i, q, qa, u, u_next) )
+        {
+            synchronized_out(2) << "[WARNING] Path_tracking_nmpc::simulate -> the vehicle simulation did not converge at s = " << _s_ref[i] << std::endl;
+            solution.success = false;
+            break;
+        }
+
+        u = u_next;
+        i = node_index(i,1);
+
+        // (3) Disturbances
+        if ( disturbance )
+            disturbance(i, q, qa);
+
+        solution.s.push_back(_s_ref[i]);
+        solution.q.push_back(q);
+        solution.qa.push_back(qa);
+        solution.u.push_back(u);
+        solution.computation_time.push_back(elapsed);
+        solution.total_computation_time += elapsed;
+    }
+
+    solution.simulated_time = solution.q.back()[Dynamic_model_t::Road_type::ITIME] - q0[Dynamic_model_t::Road_type::ITIME];
+
+    synchronized_out(2) << "[INFO] Path_tracking_nmpc::simulate -> simulated time: " << solution.simulated_time << "s, computation time: "
+           << solution.total_computation_time << "s" << std::endl;
+
+    return solution;
+}
+
+
+template<typename Dynamic_model_t>
+inline std::vector<scalar> Path_tracking_nmpc<Dynamic_model_t>::solve_linear_system(std::vector<scalar> A, std::vector<scalar> B,
+    const size_t n, const size_t m)
+{
+    // (1) Forward elimination with partial pivoting
+    for (size_t col = 0; col < n; ++col)
+    {
+        size_t pivot = col;
+        for (size_t r = col + 1; r < n; ++r)
+            if ( std::abs(A[r*n + col]) > std::abs(A[pivot*n + col]) )
+                pivot = r;
+
+        if ( std::abs(A[pivot*n + col]) < std::numeric_limits<scalar>::min() )
+            throw fastest_lap_exception("[ERROR] Path_tracking_nmpc::solve_linear_system -> singular matrix");
+
+        if ( pivot != col )
+        {
+            std::swap_ranges(A.begin() + pivot*n, A.begin() + (pivot+1)*n, A.begin() + col*n);
+            std::swap_ranges(B.begin() + pivot*m, B.begin() + (pivot+1)*m, B.begin() + col*m);
+        }
+
+        for (size_t r = col + 1; r < n; ++r)
+        {
+            const scalar factor = A[r*n + col]/A[col*n + col];
+
+            if ( factor == 0.0 )
+                continue;
+
+            for (size_t c = col; c < n; ++c)
+                A[r*n + c] -= factor*A[col*n + c];
+
+            for (size_t c = 0; c < m; ++c)
+                B[r*m + c] -= factor*B[col*m + c];
+        }
+    }
+
+    // (2) Back substitution
+    for (size_t r = n; r-- > 0; )
+    {
+        for (size_t c = 0; c < m; ++c)
+        {
+            scalar value = B[r*m + c];
+
+            for (size_t l = r + 1; l < n; ++l)
+                value -= A[r*n + l]*B[l*m + c];
+
+            B[r*m + c] = value/A[r*n + r];
+        }
+    }
+
+    return B;
+}
+
+
+template<typename Dynamic_model_t>
+inline std::vector<scalar> Path_tracking_nmpc<Dynamic_model_t>::multiply(const std::vector<scalar>& A, const std::vector<scalar>& B,
+    const size_t m, const size_t k, const size_t n, const bool transpose_a)
+{
+    std::vector<scalar> C(m*n, 0.0);
+
+    for (size_t i = 0; i < m; ++i)
+        for (size_t l = 0; l < k; ++l)
+        {
+            const scalar a_il = (transpose_a ? A[l*m + i] : A[i*k + l]);
+
+            if ( a_il == 0.0 )
+                continue;
+
+            for (size_t j = 0; j < n; ++j)
+                C[i*n + j] += a_il*B[l*n + j];
+        }
+
+    return C;
+}
+
+#endif
@@ -7,12 +7,16 @@
 #include "lion/thirdparty/include/logger.hpp"
 #include "lion/thirdparty/include/cppad/ipopt/solve.hpp"
 #include "src/core/foundation/fastest_lap_exception.h"
+#include "src/core/foundation/synchronized_output.h"
+#include "src/core/foundation/trace.h"
 
 template<typename Dynamic_model_t>
 template<typename T>
 std::enable_if_t<std::is_same<T,scalar>::value,typename Steady_state<Dynamic_model_t>::Solution> 
     Steady_state<Dynamic_model_t>::solve(scalar v, scalar ax, scalar ay, const size_t n_steps, const bool provide_x0, const std::vector<scalar>& x0_provided, bool throw_if_fail)
 {
+    FASTEST_LAP_TRACE_SCOPE("Steady_state::solve");
+
     std::vector<scalar> x0 = Dynamic_model_t::steady_state_initial_guess();
 
     if ( provide_x0 )
@@ -57,6 +61,8 @@ template<typename T>
 std::enable_if_t<std::is_same<T,CppAD::AD<scalar>>::value,typename Steady_state<Dynamic_model_t>::Solution> 
     Steady_state<Dynamic_model_t>::solve(scalar v, scalar ax, scalar ay, const size_t, const bool provide_x0, const std::vector<scalar>& x0_provided, bool throw_if_fail)
 {
+    FASTEST_LAP_TRACE_SCOPE("Steady_state::solve");
+
     std::vector<scalar> x0 = Dynamic_model_t::steady_state_initial_guess();
 
     if ( provide_x0 )
@@ -621,7 +627,7 @@ std::enable_if_t<std::is_same<T,scalar>::value,
 
     for (size_t i = 0; i < n_points; ++i)
     {
-        out(2).progress_bar("g-g diagram computation: ", i, n_points);
+        synchronized_out(2).progress_bar("g-g diagram computation: ", i, n_points);
         auto result_ss_ay_candidate = solve(v,result_max_lat_acc.ax*ay_gg[i]/result_max_lat_acc.ay, ay_gg[i], 1, true, x0_ss_ay, false);
 
         if ( result_ss_ay_candidate.solved )
@@ -678,7 +684,7 @@ std::enable_if_t<std::is_same<T,scalar>::value,
         std::vector<scalar> x0_ss_ay = Dynamic_model_t::get_x(result_ss_ay.q, result_ss_ay.qa, result_ss_ay.u, v);
     }
 
-    out(2).stop_progress_bar();
+    synchronized_out(2).stop_progress_bar();
 
     return {solution_max, solution_min};
 } 
@@ -719,7 +725,7 @@ std::enable_if_t<std::is_same<T,CppAD::AD<scalar>>::value,
 
     for (size_t i = 0; i < n_points; ++i)
     {
-        out(2).progress_bar("g-g diagram computation: ", i, n_points);
+        synchronized_out(2).progress_bar("g-g diagram computation: ", i, n_points);
         auto result_ss_ay_candidate = solve(v,result_max_lat_acc.ax*ay_gg[i]/result_max_lat_acc.ay, ay_gg[i], 1, true, x0_ss_ay, false);
 
         if ( result_ss_ay_candidate.solved )
@@ -873,7 +879,7 @@ std::enable_if_t<std::is_same<T,CppAD::AD<scalar>>::value,
         std::vector<scalar> x0_ss_ay = Dynamic_model_t::get_x(result_ss_ay.q, result_ss_ay.qa, result_ss_ay.u, v);
     }
 
-    out(2).stop_progress_bar();
+    synchronized_out(2).stop_progress_bar();
 
     return {solution_max, solution_min};
 } 
@@ -93,6 +93,11 @@ class Axle
     static void set_state_and_control_names(std::array<std::string,NSTATE>& q, 
                                      std::array<std::string,NCONTROL>& u);
 
+    //! Mark the state variables of this class that are tire longitudinal slips: none
+    //! @param[out] is_slip: true for the tire longitudinal slip states
+    template<size_t NSTATE>
+    static void set_slip_states(std::array<bool,NSTATE>&) {}
+
     static std::string type() { return "axle"; }
     
     void fill_xml(Xml_document& doc) const;
@@ -211,6 +211,11 @@ class Axle_car_3dof : public Axle<Timeseries_t,std::tuple<Tire_left_t,Tire_right
     static void set_state_and_control_names(std::array<std::string,NSTATE>& q, 
                                      std::array<std::string,NCONTROL>& u);
 
+    //! Mark the state variables of this class that are tire longitudinal slips: kappa left and right
+    //! @param[out] is_slip: true for the tire longitudinal slip states
+    template<size_t NSTATE>
+    static void set_slip_states(std::array<bool,NSTATE>& is_slip);
+
     static std::string type() { return "axle_car_3dof"; }
 
     void fill_xml(Xml_document& doc) const;
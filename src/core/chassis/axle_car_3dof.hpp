@@ -2,6 +2,7 @@
 #define __AXLE_CAR_3DOF_HPP__
 
 #include "src/core/foundation/fastest_lap_exception.h"
+#include "src/core/foundation/tape_profiler.h"
 
 template<typename Timeseries_t, typename Tire_left_t, typename Tire_right_t, template<size_t,size_t> typename Axle_mode, size_t STATE0, size_t CONTROL0>
 Axle_car_3dof<Timeseries_t,Tire_left_t,Tire_right_t,Axle_mode,STATE0,CONTROL0>::Axle_car_3dof(const std::string& name,
@@ -184,6 +185,8 @@ template<typename Timeseries_t, typename Tire_left_t, typename Tire_right_t, tem
 void Axle_car_3dof<Timeseries_t,Tire_left_t,Tire_right_t,Axle_mode,STATE0,CONTROL0>::update
     (Timeseries_t Fz_left, Timeseries_t Fz_right, Timeseries_t throttle, Timeseries_t brake_bias)
 {
+    FASTEST_LAP_TAPE_SCOPE("axle");
+
     // Create aliases
     Tire_left_t& tire_l  = std::get<LEFT>(base_type::_tires);
     Tire_right_t& tire_r = std::get<RIGHT>(base_type::_tires);
@@ -283,6 +286,17 @@ void Axle_car_3dof<Timeseries_t,Tire_left_t,Tire_right_t,Axle_mode,STATE0,CONTRO
 }
 
 
+template<typename Timeseries_t, typename Tire_left_t, typename Tire_right_t, template<size_t,size_t> typename Axle_mode, size_t STATE0, size_t CONTROL0>
+template<size_t NSTATE>
+void Axle_car_3dof<Timeseries_t,Tire_left_t,Tire_right_t,Axle_mode,STATE0,CONTROL0>::set_slip_states(std::array<bool,NSTATE>& is_slip)
+{
+    base_type::set_slip_states(is_slip);
+
+    is_slip[Axle_type::IKAPPA_LEFT]  = true;
+    is_slip[Axle_type::IKAPPA_RIGHT] = true;
+}
+
+
 template<typename Timeseries_t, typename Tire_left_t, typename Tire_right_t, template<size_t,size_t> typename Axle_mode, size_t STATE0, size_t CONTROL0>
 template<size_t NSTATE, size_t NCONTROL>
 void Axle_car_3dof<Timeseries_t,Tire_left_t,Tire_right_t,Axle_mode,STATE0,CONTROL0>::set_state_and_controls(const std::array<Timeseries_t,NSTATE>& q, const std::array<Timeseries_t,NCONTROL>& u)
@@ -2,6 +2,7 @@
 #define __AXLE_CAR_6DOF_HPP__
 
 #include "src/core/foundation/fastest_lap_exception.h"
+#include "src/core/foundation/tape_profiler.h"
 
 template<typename Timeseries_t, typename Tire_left_t, typename Tire_right_t, template<size_t,size_t> typename Axle_mode, size_t STATE0, size_t CONTROL0>
 Axle_car_6dof<Timeseries_t,Tire_left_t,Tire_right_t,Axle_mode,STATE0,CONTROL0>::Axle_car_6dof(const std::string& name,
@@ -65,6 +66,8 @@ void Axle_car_6dof<Timeseries_t,Tire_left_t,Tire_right_t,Axle_mode,STATE0,CONTRO
 template<typename Timeseries_t, typename Tire_left_t, typename Tire_right_t, template<size_t,size_t> typename Axle_mode, size_t STATE0, size_t CONTROL0>
 void Axle_car_6dof<Timeseries_t,Tire_left_t,Tire_right_t,Axle_mode,STATE0,CONTROL0>::update(Timeseries_t phi, Timeseries_t dphi)
 {
+    FASTEST_LAP_TAPE_SCOPE("axle");
+
     // Create aliases
     Tire_left_t& tire_l  = std::get<LEFT>(base_type::_tires);
     Tire_right_t& tire_r = std::get<RIGHT>(base_type::_tires);
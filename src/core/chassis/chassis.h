@@ -189,6 +189,15 @@ class Chassis
     static void set_state_and_control_names(std::array<std::string,NSTATE>& q, 
                                      std::array<std::string,NCONTROL>& u);
 
+    //! Mark the state variables that are tire longitudinal slips
+    //! @param[out] is_slip: true for the tire longitudinal slip states
+    template<size_t NSTATE>
+    static void set_slip_states(std::array<bool,NSTATE>& is_slip)
+    {
+        FrontAxle_t::set_slip_states(is_slip);
+        RearAxle_t::set_slip_states(is_slip);
+    }
+
     static std::string type() { return "chassis"; }
 
 
@@ -0,0 +1,152 @@
+#ifndef __DEPENDENCY_TRACKER_H__
+#define __DEPENDENCY_TRACKER_H__
+
+#include <map>
+#include <atomic>
+#include <string>
+#include <functional>
+
+//!      Dependency tracker
+//!      ------------------
+//!
+//! Records which parameters of a vehicle were changed, and when, so that the artefacts derived from it (steady-state
+//! solutions, performance maps...) can tell whether they are still up to date. Every artefact declares its dependencies
+//! as a predicate on the parameter path (e.g. "vehicle/chassis/aerodynamics/cl"): a change only invalidates the artefacts
+//! that depend on it.
+//!
+//!     - Every change increases the epoch of the tracker. An artefact computed at epoch e is up to date if none of the
+//!       parameters it depends on changed after e
+//!     - Every tracker has a unique id, and copies get a new one with an empty history: the artefacts of a vehicle are
+//!       never taken as up to date for another vehicle
+class Dependency_tracker
+{
+ public:
+
+    //! Returns true if an artefact depends on the parameter given by its path. An empty predicate depends on everything
+    using Predicate = std::function<bool(const std::string&)>;
+
+    Dependency_tracker() : _id(new_id()) {}
+
+    Dependency_tracker(const Dependency_tracker&) : _id(new_id()) {}
+
+    Dependency_tracker& operator=(const Dependency_tracker&)
+    {
+        _id = new_id();
+        _epoch = 0;
+        _last_global_change = 0;
+        _changes.clear();
+        return *this;
+    }
+
+    //! Register the change of a parameter
+    //! @param[in] path: full path of the parameter
+    void parameter_changed(const std::string& path) { _changes[path] = ++_epoch; }
+
+    //! Register a change that affects all the artefacts
+    void everything_changed() { _last_global_change = ++_epoch; }
+
+    //! Unique identifier of the tracker
+    size_t get_id() const { return _id; }
+
+    //! Number of changes registered
+    size_t get_epoch() const { return _epoch; }
+
+    //! Check if an artefact is up to date
+    //! @param[in] id: id of the tracker when the artefact was computed
+    //! @param[in] epoch: epoch of the tracker when the artefact was computed
+    //! @param[in] depends_on: dependencies of the artefact
+    bool is_up_to_date(const size_t id, const size_t epoch, const Predicate& depends_on) const
+    {
+        if ( (id != _id) || (_last_global_change > epoch) )
+            return false;
+
+        for (const auto& [path, change_epoch] : _changes)
+        {
+            if ( (change_epoch > epoch) && (!depends_on || depends_on(path)) )
+                return false;
+        }
+
+        return true;
+    }
+
+ private:
+    size_t _id;
+    size_t _epoch              = 0;
+    size_t _last_global_change = 0;         //! Epoch of the last call to everything_changed()
+    std::map<std::string,size_t> _changes;  //! Epoch of the last change of every parameter changed
+
+    static size_t new_id()
+    {
+        static std::atomic<size_t> last_id{0};
+        return ++last_id;
+    }
+};
+
+
+//! Stores artefacts derived from a vehicle by key (e.g. the steady state by speed), and drops them when one of
+//! the parameters they depend on changes. Not thread safe
+template<typename Key, typename Value>
+class Artefact_cache
+{
+ public:
+
+    //! Constructor
+    //! @param[in] depends_on: dependencies of the artefacts, all the parameters if empty
+    explicit Artefact_cache(const Dependency_tracker::Predicate& depends_on = {}) : _depends_on(depends_on) {}
+
+    //! Get the artefact for a key. It is computed with compute() if it is not stored or not up to date
+    //! @param[in] tracker: dependency tracker of the vehicle
+    //! @param[in] key: key of the artefact
+    //! @param[in] compute: function that computes the artefact, with signature Value()
+    template<typename Compute_t>
+    const Value& get(const Dependency_tracker& tracker, const Key& key, Compute_t&& compute)
+    {
+        validate(tracker);
+
+        auto it = _values.find(key);
+
+        if ( it == _values.end() )
+        {
+            it = _values.emplace(key, compute()).first;
+            ++_n_computations;
+        }
+        else
+        {
+            ++_n_hits;
+        }
+
+        return it->second;
+    }
+
+    //! Remove the artefacts that are not up to date
+    void validate(const Dependency_tracker& tracker)
+    {
+        if ( !tracker.is_up_to_date(_tracker_id, _epoch, _depends_on) )
+            _values.clear();
+
+        _tracker_id = tracker.get_id();
+        _epoch      = tracker.get_epoch();
+    }
+
+    //! Remove all the artefacts
+    void clear() { _values.clear(); }
+
+    //! Number of artefacts stored
+    size_t size() const { return _values.size(); }
+
+    //! Number of artefacts computed
+    size_t get_n_computations() const { return _n_computations; }
+
+    //! Number of artefacts reused
+    size_t get_n_hits() const { return _n_hits; }
+
+ private:
+    Dependency_tracker::Predicate _depends_on;
+    std::map<Key,Value> _values;
+    size_t _tracker_id     = 0;     //! Tracker and epoch the stored artefacts are up to date with
+    size_t _epoch          = 0;
+    size_t _n_computations = 0;
+    size_t _n_hits         = 0;
+};
+
+#endif
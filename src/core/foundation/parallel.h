@@ -0,0 +1,129 @@
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <mutex>
+#include "lion/foundation/types.h"
+#include "lion/thirdparty/include/cppad/cppad.hpp"
+#include "src/core/foundation/fastest_lap_exception.h"
+
+//!      Parallel loops
+//!      --------------
+//!
+//! Run independent tasks in a pool of threads. CppAD is configured for multithreading
+//! the first time a parallel loop is executed: every thread records its own tapes
+//!
+//! Thread safety of the library:
+//!     - Optimal_laptime, Steady_state, Circuit_preprocessor and the vehicles can be used concurrently
+//!       as long as every thread works on its own objects (copy the vehicle/track into each task)
+//!     - Concurrent AD recording must happen inside Parallel::for_each, since CppAD needs the thread numbers
+//!     - Parallel loops started from inside a task run sequentially in that task
+//!     - The library writes to the lion logger through synchronized_out(), which serializes the messages. Code that
+//!       writes directly to out() from a task must hold Synchronized_output::mutex()
+//!     - The C API tables are global: the C API entry points must not be called concurrently
+class Parallel
+{
+ public:
+
+    //! Number of threads used when zero is requested
+    static size_t default_number_of_threads() { return std::max<size_t>(1, std::thread::hardware_concurrency()); }
+
+    //! Run f(i) for i = 0,...,n-1. The indexes are distributed dynamically among the threads
+    //! The first exception thrown by any task is rethrown once all threads have finished
+    //! @param[in] n: number of tasks
+    //! @param[in] n_threads: number of threads (0: hardware concurrency). The calling thread is one of them
+    //! @param[in] f: task, f(i)
+    template<typename F>
+    static void for_each(const size_t n, size_t n_threads, F&& f)
+    {
+        if ( n_threads == 0 )
+            n_threads = default_number_of_threads();
+
+        n_threads = std::min({n_threads, n, static_cast<size_t>(CPPAD_MAX_NUM_THREADS)});
+
+        // (1) Sequential execution, also for loops nested in a parallel task
+        if ( (n_threads <= 1) || in_parallel() )
+        {
+            for (size_t i = 0; i < n; ++i)
+                f(i);
+
+            return;
+        }
+
+        // (2) Parallel execution
+        initialize();
+
+        std::atomic<size_t> next_task{0};
+        std::vector<std::exception_ptr> errors(n_threads);
+
+        auto worker = [&](const size_t thread_number)
+        {
+            _thread_number = thread_number;
+
+            try
+            {
+                for (size_t i = next_task++; i < n; i = next_task++)
+                    f(i);
+            }
+            catch (...)
+            {
+                errors[thread_number] = std::current_exception();
+                next_task = n;
+            }
+        };
+
+        _in_parallel = true;
+
+        std::vector<std::thread> threads;
+        for (size_t thread_number = 1; thread_number < n_threads; ++thread_number)
+            threads.emplace_back(worker, thread_number);
+
+        worker(0);
+
+        for (auto& thread : threads)
+            thread.join();
+
+        _in_parallel = false;
+
+        // (3) Return the memory held by the worker threads to the system
+        for (size_t thread_number = 1; thread_number < n_threads; ++thread_number)
+            CppAD::thread_alloc::free_available(thread_number);
+
+        for (const auto& error : errors)
+            if ( error )
+                std::rethrow_exception(error);
+    }
+
+    //! Configure CppAD for multithreading. Called by the first parallel loop, it can also be called
+    //! beforehand. Must be called in sequential mode (outside of any parallel loop)
+    static void initialize()
+    {
+        if ( in_parallel() )
+            throw fastest_lap_exception("[ERROR] Parallel::initialize -> cannot be called from a parallel task");
+
+        static std::once_flag is_initialized;
+
+        std::call_once(is_initialized, []()
+        {
+            CppAD::thread_alloc::parallel_setup(CPPAD_MAX_NUM_THREADS, in_parallel, thread_number);
+            CppAD::parallel_ad<scalar>();
+        });
+    }
+
+    //! Index of the current thread within the running loop (0 for the calling thread)
+    static size_t thread_number() { return _thread_number; }
+
+    //! True while a parallel loop is running
+    static bool in_parallel() { return _in_parallel; }
+
+ private:
+
+    inline static thread_local size_t _thread_number = 0;
+    inline static std::atomic<bool> _in_parallel{false};
+};
+
+#endif
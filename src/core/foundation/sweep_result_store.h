@@ -0,0 +1,548 @@
+#ifndef __SWEEP_RESULT_STORE_H__
+#define __SWEEP_RESULT_STORE_H__
+
+#include <map>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include "lion/foundation/types.h"
+#include "src/core/foundation/fastest_lap_exception.h"
+
+//!      Sweep result store
+//!      ------------------
+//!
+//! Stores the results of a sweep (e.g. one Optimal_laptime per set of parameters) in a single binary file, organized
+//! by columns: every run has its metadata and a set of named channels (e.g. Optimal_laptime::channels).
+//!
+//!     - Channels are split in chunks of chunk_size values, and every chunk is compressed independently (lossless)
+//!     - Runs are appended to the file as they are added. Writer::add_run can be called from several threads: the
+//!       compression runs outside of the lock
+//!     - The index (metadata, and position of the chunks of every channel) is written at the end by Writer::close().
+//!       The Reader loads the index only, and reads the chunks of one channel of one run on request
+//!
+//! File layout (native byte order, little-endian on all supported platforms):
+//!
+//!     header: "FLSWEEP1", uint32 version, uint32 chunk_size
+//!     chunks: compressed chunks, in the order they were written
+//!     index:  uint64 n_runs, and per run: metadata, uint64 n_channels, and per channel: name, uint64 n_values,
+//!             uint64 n_chunks, and {uint64 offset, uint64 n_bytes, uint64 n_values} per chunk
+//!     footer: uint64 index offset, "FLSWEEPI"
+//!
+//! Compression: every value is XOR'ed with the previous value of the chunk, and only the non-zero low bytes of the
+//! result are stored, together with a 4-bit byte count per value. The sign, exponent and leading mantissa bits of
+//! smooth channels repeat from one point to the next, which saves one or two bytes per value (about 20%). Constant
+//! channels cost half a byte per value, and noisy channels do not compress
+class Sweep_result_store
+{
+ public:
+
+    //! Metadata of one run
+    struct Run_metadata
+    {
+        std::string name;
+        std::map<std::string,scalar> parameters;    //! Values of the parameters swept
+        bool   success      = false;
+        size_t iter_count   = 0;                    //! Number of iterations of the optimizer
+        scalar elapsed_time = 0.0;                  //! [s]
+        scalar laptime      = 0.0;                  //! [s]
+    };
+
+ private:
+
+    static constexpr const char HEADER_MAGIC[] = "FLSWEEP1";
+    static constexpr const char FOOTER_MAGIC[] = "FLSWEEPI";
+    static constexpr const uint32_t VERSION = 1;
+
+    //! Position of a compressed chunk in the file
+    struct Chunk
+    {
+        uint64_t offset;
+        uint64_t n_bytes;
+        uint64_t n_values;
+    };
+
+    struct Channel_entry
+    {
+        std::string name;
+        uint64_t n_values;
+        std::vector<Chunk> chunks;
+    };
+
+    struct Run_entry
+    {
+        Run_metadata metadata;
+        std::vector<Channel_entry> channels;
+    };
+
+ public:
+
+    //! Writes a store incrementally
+    class Writer
+    {
+     public:
+
+        //! Constructor: create the file and write the header
+        //! @param[in] file_name: name of the output file
+        //! @param[in] chunk_size: number of values per compressed chunk
+        Writer(const std::string& file_name, const size_t chunk_size = 4096) : _chunk_size(chunk_size)
+        {
+            if ( chunk_size == 0 )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Writer -> chunk_size must be positive");
+
+            if ( chunk_size > std::numeric_limits<uint32_t>::max() )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Writer -> chunk_size must be smaller than 2^32");
+
+            _file.open(file_name, std::ios::binary | std::ios::trunc);
+
+            if ( !_file.is_open() )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Writer -> could not open file \"" + file_name + "\"");
+
+            std::vector<uint8_t> header;
+            header.insert(header.end(), HEADER_MAGIC, HEADER_MAGIC + 8);
+            write_pod(header, VERSION);
+            write_pod(header, static_cast<uint32_t>(chunk_size));
+
+            write_bytes(header);
+        }
+
+        //! Destructor: closes the store if close() was not called. Errors are lost: call close() to catch them
+        ~Writer()
+        {
+            try { close(); }
+            catch (...) {}
+        }
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        //! Append one run. Thread safe
+        //! @param[in] metadata: metadata of the run
+        //! @param[in] channels: channels of the run, name -> values
+        void add_run(const Run_metadata& metadata, const std::map<std::string,std::vector<scalar>>& channels)
+        {
+            // (1) Compress the chunks, outside the lock
+            std::vector<std::vector<std::vector<uint8_t>>> compressed;
+            compressed.reserve(channels.size());
+
+            for (const auto& [name, values] : channels)
+            {
+                compressed.emplace_back();
+                for (size_t i = 0; i < values.size(); i += _chunk_size)
+                    compressed.back().push_back(compress(values.data() + i, std::min(_chunk_size, values.size() - i)));
+            }
+
+            // (2) Write them, and register the run in the index
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if ( _closed )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Writer::add_run -> the store is closed");
+
+            Run_entry run{metadata, {}};
+            auto it_compressed = compressed.cbegin();
+
+            for (const auto& [name, values] : channels)
+            {
+                Channel_entry channel{name, values.size(), {}};
+
+                for (size_t k = 0; k < it_compressed->size(); ++k)
+                {
+                    const auto& chunk = (*it_compressed)[k];
+                    channel.chunks.push_back({_offset, chunk.size(), std::min<uint64_t>(_chunk_size, values.size() - k*_chunk_size)});
+                    write_bytes(chunk);
+                }
+
+                run.channels.push_back(std::move(channel));
+                ++it_compressed;
+            }
+
+            // (3) Flush, so that the data of the finished runs is on disk
+            _file.flush();
+            _runs.push_back(std::move(run));
+        }
+
+        //! Write the index and the footer, and close the file. Further calls have no effect
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if ( _closed )
+                return;
+
+            _closed = true;
+
+            const uint64_t index_offset = _offset;
+            std::vector<uint8_t> index;
+
+            write_pod(index, static_cast<uint64_t>(_runs.size()));
+
+            for (const auto& run : _runs)
+            {
+                write_metadata(index, run.metadata);
+                write_pod(index, static_cast<uint64_t>(run.channels.size()));
+
+                for (const auto& channel : run.channels)
+                {
+                    write_string(index, channel.name);
+                    write_pod(index, channel.n_values);
+                    write_pod(index, static_cast<uint64_t>(channel.chunks.size()));
+
+                    for (const auto& chunk : channel.chunks)
+                    {
+                        write_pod(index, chunk.offset);
+                        write_pod(index, chunk.n_bytes);
+                        write_pod(index, chunk.n_values);
+                    }
+                }
+            }
+
+            write_pod(index, index_offset);
+            index.insert(index.end(), FOOTER_MAGIC, FOOTER_MAGIC + 8);
+
+            write_bytes(index);
+            _file.close();
+
+            if ( _file.fail() )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Writer::close -> error while writing the file");
+        }
+
+        //! Number of runs added
+        size_t get_n_runs() const { std::lock_guard<std::mutex> lock(_mutex); return _runs.size(); }
+
+     private:
+        std::ofstream _file;
+        size_t _chunk_size;
+        uint64_t _offset = 0;           //! Current size of the file
+        std::vector<Run_entry> _runs;   //! Index of the runs written
+        bool _closed = false;
+        mutable std::mutex _mutex;
+
+        void write_bytes(const std::vector<uint8_t>& bytes)
+        {
+            _file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+            if ( _file.fail() )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Writer -> error while writing the file");
+
+            _offset += bytes.size();
+        }
+    };
+
+    //! Reads a store written by Writer. Only the index is loaded in memory
+    class Reader
+    {
+     public:
+
+        //! Constructor: open the file and load the index
+        //! @param[in] file_name: name of the store
+        explicit Reader(const std::string& file_name) : _file(file_name, std::ios::binary)
+        {
+            if ( !_file.is_open() )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader -> could not open file \"" + file_name + "\"");
+
+            // (1) Header
+            const auto header = read_bytes(0, 16);
+
+            if ( std::memcmp(header.data(), HEADER_MAGIC, 8) != 0 )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader -> \"" + file_name + "\" is not a sweep result store");
+
+            size_t position = 8;
+            if ( read_pod<uint32_t>(header, position) != VERSION )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader -> unsupported version");
+
+            _chunk_size = read_pod<uint32_t>(header, position);
+
+            // (2) Footer: the store is not valid until the Writer is closed
+            _file.seekg(0, std::ios::end);
+            const uint64_t file_size = _file.tellg();
+
+            if ( file_size < 32 )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader -> the store was not closed");
+
+            const auto footer = read_bytes(file_size - 16, 16);
+
+            if ( std::memcmp(footer.data() + 8, FOOTER_MAGIC, 8) != 0 )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader -> the store was not closed");
+
+            position = 0;
+            const uint64_t index_offset = read_pod<uint64_t>(footer, position);
+
+            if ( (index_offset < 16) || (index_offset > file_size - 16) )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader -> corrupted index offset");
+
+            // (3) Index
+            const auto index = read_bytes(index_offset, file_size - 16 - index_offset);
+            position = 0;
+
+            const uint64_t n_runs = read_pod<uint64_t>(index, position);
+
+            for (uint64_t i = 0; i < n_runs; ++i)
+            {
+                Run_entry run;
+                run.metadata = read_metadata(index, position);
+
+                const uint64_t n_channels = read_pod<uint64_t>(index, position);
+
+                for (uint64_t j = 0; j < n_channels; ++j)
+                {
+                    Channel_entry channel;
+                    channel.name = read_string(index, position);
+                    channel.n_values = read_pod<uint64_t>(index, position);
+
+                    const uint64_t n_chunks = read_pod<uint64_t>(index, position);
+
+                    for (uint64_t k = 0; k < n_chunks; ++k)
+                    {
+                        Chunk chunk;
+                        chunk.offset   = read_pod<uint64_t>(index, position);
+                        chunk.n_bytes  = read_pod<uint64_t>(index, position);
+                        chunk.n_values = read_pod<uint64_t>(index, position);
+
+                        if ( chunk.offset + chunk.n_bytes > index_offset )
+                            throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader -> corrupted chunk offset");
+
+                        channel.chunks.push_back(chunk);
+                    }
+
+                    run.channels.push_back(std::move(channel));
+                }
+
+                _runs.push_back(std::move(run));
+            }
+        }
+
+        //! Number of runs stored
+        size_t get_n_runs() const { return _runs.size(); }
+
+        //! Number of values per compressed chunk
+        size_t get_chunk_size() const { return _chunk_size; }
+
+        //! Metadata of a run
+        const Run_metadata& get_metadata(const size_t i_run) const { return get_run(i_run).metadata; }
+
+        //! Names of the channels of a run
+        std::vector<std::string> get_channel_names(const size_t i_run) const
+        {
+            std::vector<std::string> names;
+            for (const auto& channel : get_run(i_run).channels)
+                names.push_back(channel.name);
+
+            return names;
+        }
+
+        //! True if the run has a given channel
+        bool has_channel(const size_t i_run, const std::string& name) const
+        {
+            const auto& channels = get_run(i_run).channels;
+            return std::any_of(channels.cbegin(), channels.cend(), [&](const auto& channel) { return channel.name == name; });
+        }
+
+        //! Read one channel of one run. Only its chunks are read from the file. Thread safe
+        //! @param[in] i_run: index of the run
+        //! @param[in] name: name of the channel
+        std::vector<scalar> get_channel(const size_t i_run, const std::string& name) const
+        {
+            const auto& channels = get_run(i_run).channels;
+            auto it = std::find_if(channels.cbegin(), channels.cend(), [&](const auto& channel) { return channel.name == name; });
+
+            if ( it == channels.cend() )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader::get_channel -> run " + std::to_string(i_run)
+                    + " has no channel \"" + name + "\"");
+
+            std::vector<scalar> values(it->n_values);
+            size_t i_value = 0;
+
+            for (const auto& chunk : it->chunks)
+            {
+                if ( i_value + chunk.n_values > values.size() )
+                    throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader::get_channel -> corrupted channel \"" + name + "\"");
+
+                const auto bytes = read_bytes(chunk.offset, chunk.n_bytes);
+                decompress(bytes.data(), bytes.size(), values.data() + i_value, chunk.n_values);
+                i_value += chunk.n_values;
+            }
+
+            if ( i_value != values.size() )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader::get_channel -> corrupted channel \"" + name + "\"");
+
+            return values;
+        }
+
+     private:
+        mutable std::ifstream _file;
+        mutable std::mutex _mutex;      //! Serializes the seek+read of the chunks
+        size_t _chunk_size;
+        std::vector<Run_entry> _runs;
+
+        const Run_entry& get_run(const size_t i_run) const
+        {
+            if ( i_run >= _runs.size() )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader -> run index " + std::to_string(i_run) + " is out of bounds");
+
+            return _runs[i_run];
+        }
+
+        std::vector<uint8_t> read_bytes(const uint64_t offset, const uint64_t n_bytes) const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::vector<uint8_t> bytes(n_bytes);
+
+            _file.clear();
+            _file.seekg(offset);
+            _file.read(reinterpret_cast<char*>(bytes.data()), n_bytes);
+
+            if ( _file.fail() )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader -> error while reading the file");
+
+            return bytes;
+        }
+    };
+
+    //! Compress a chunk of values
+    //! @param[in] values: pointer to the first value
+    //! @param[in] n: number of values
+    static std::vector<uint8_t> compress(const scalar* values, const size_t n)
+    {
+        // (1) Byte counts, two per byte, followed by the significant bytes of every value, lowest first
+        std::vector<uint8_t> result((n+1)/2, 0);
+        result.reserve((n+1)/2 + 8*n);
+
+        uint64_t previous = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, values + i, sizeof(bits));
+
+            uint64_t x = bits ^ previous;
+            previous = bits;
+
+            uint8_t n_bytes = 0;
+            for (uint64_t y = x; y != 0; y >>= 8)
+                ++n_bytes;
+
+            result[i/2] |= (n_bytes << (4*(i%2)));
+
+            for (uint8_t k = 0; k < n_bytes; ++k, x >>= 8)
+                result.push_back(static_cast<uint8_t>(x & 0xFF));
+        }
+
+        return result;
+    }
+
+    //! Decompress a chunk of values
+    //! @param[in] data: compressed data
+    //! @param[in] n_bytes: size of the compressed data
+    //! @param[out] values: pointer to the first output value
+    //! @param[in] n: number of values
+    static void decompress(const uint8_t* data, const size_t n_bytes, scalar* values, const size_t n)
+    {
+        size_t position = (n+1)/2;
+
+        if ( position > n_bytes )
+            throw fastest_lap_exception("[ERROR] Sweep_result_store::decompress -> corrupted chunk");
+
+        uint64_t previous = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const uint8_t n_value_bytes = (data[i/2] >> (4*(i%2))) & 0x0F;
+
+            if ( (n_value_bytes > 8) || (position + n_value_bytes > n_bytes) )
+                throw fastest_lap_exception("[ERROR] Sweep_result_store::decompress -> corrupted chunk");
+
+            uint64_t x = 0;
+            for (uint8_t k = 0; k < n_value_bytes; ++k)
+                x |= (static_cast<uint64_t>(data[position++]) << (8*k));
+
+            previous ^= x;
+            std::memcpy(values + i, &previous, sizeof(previous));
+        }
+
+        if ( position != n_bytes )
+            throw fastest_lap_exception("[ERROR] Sweep_result_store::decompress -> corrupted chunk");
+    }
+
+ private:
+
+    template<typename T>
+    static void write_pod(std::vector<uint8_t>& buffer, const T& value)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    static void write_string(std::vector<uint8_t>& buffer, const std::string& str)
+    {
+        write_pod(buffer, static_cast<uint64_t>(str.size()));
+        buffer.insert(buffer.end(), str.cbegin(), str.cend());
+    }
+
+    static void write_metadata(std::vector<uint8_t>& buffer, const Run_metadata& metadata)
+    {
+        write_string(buffer, metadata.name);
+        write_pod(buffer, static_cast<uint64_t>(metadata.parameters.size()));
+
+        for (const auto& [name, value] : metadata.parameters)
+        {
+            write_string(buffer, name);
+            write_pod(buffer, value);
+        }
+
+        write_pod(buffer, static_cast<uint8_t>(metadata.success));
+        write_pod(buffer, static_cast<uint64_t>(metadata.iter_count));
+        write_pod(buffer, metadata.elapsed_time);
+        write_pod(buffer, metadata.laptime);
+    }
+
+    template<typename T>
+    static T read_pod(const std::vector<uint8_t>& buffer, size_t& position)
+    {
+        if ( position + sizeof(T) > buffer.size() )
+            throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader -> corrupted index");
+
+        T value;
+        std::memcpy(&value, buffer.data() + position, sizeof(T));
+        position += sizeof(T);
+
+        return value;
+    }
+
+    static std::string read_string(const std::vector<uint8_t>& buffer, size_t& position)
+    {
+        const uint64_t size = read_pod<uint64_t>(buffer, position);
+
+        if ( size > buffer.size() - position )
+            throw fastest_lap_exception("[ERROR] Sweep_result_store::Reader -> corrupted index");
+
+        std::string str(buffer.cbegin() + position, buffer.cbegin() + position + size);
+        position += size;
+
+        return str;
+    }
+
+    static Run_metadata read_metadata(const std::vector<uint8_t>& buffer, size_t& position)
+    {
+        Run_metadata metadata;
+        metadata.name = read_string(buffer, position);
+
+        const uint64_t n_parameters = read_pod<uint64_t>(buffer, position);
+
+        for (uint64_t i = 0; i < n_parameters; ++i)
+        {
+            const std::string name = read_string(buffer, position);
+            metadata.parameters[name] = read_pod<scalar>(buffer, position);
+        }
+
+        metadata.success      = (read_pod<uint8_t>(buffer, position) != 0);
+        metadata.iter_count   = read_pod<uint64_t>(buffer, position);
+        metadata.elapsed_time = read_pod<scalar>(buffer, position);
+        metadata.laptime      = read_pod<scalar>(buffer, position);
+
+        return metadata;
+    }
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef __SYNCHRONIZED_OUTPUT_H__
+#define __SYNCHRONIZED_OUTPUT_H__
+
+#include <mutex>
+#include <sstream>
+#include <utility>
+#include "lion/thirdparty/include/logger.hpp"
+
+//!      Synchronized output
+//!      -------------------
+//!
+//! Thread safe front end of the lion logger. A statement such as
+//!
+//!     synchronized_out(2) << "[INFO] message " << value << std::endl;
+//!
+//! is assembled in a buffer owned by the calling thread, and written to out(2) in one piece, under a lock,
+//! when the statement ends. Messages of concurrent tasks never interleave, and the logger is never
+//! written by two threads at the same time
+class Synchronized_output
+{
+ public:
+
+    explicit Synchronized_output(const int level) : _level(level) {}
+
+    Synchronized_output(const Synchronized_output&) = delete;
+    Synchronized_output& operator=(const Synchronized_output&) = delete;
+
+    ~Synchronized_output()
+    {
+        if ( _buffer.tellp() > 0 )
+        {
+            std::lock_guard<std::mutex> lock(mutex());
+            out(_level) << _buffer.str() << std::flush;
+        }
+    }
+
+    template<typename T>
+    Synchronized_output& operator<<(const T& value)
+    {
+        _buffer << value;
+        return *this;
+    }
+
+    //! Manipulators (std::endl, std::flush...)
+    Synchronized_output& operator<<(std::ostream& (*manipulator)(std::ostream&))
+    {
+        _buffer << manipulator;
+        return *this;
+    }
+
+    template<typename ... Args>
+    void progress_bar(Args&& ... args)
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        out(_level).progress_bar(std::forward<Args>(args)...);
+    }
+
+    void stop_progress_bar()
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        out(_level).stop_progress_bar();
+    }
+
+    //! Lock held while writing to the lion logger
+    static std::mutex& mutex()
+    {
+        static std::mutex logger_mutex;
+        return logger_mutex;
+    }
+
+ private:
+    int _level;
+    std::ostringstream _buffer;
+};
+
+
+//! Write to the lion logger with the given print level, see Synchronized_output
+inline Synchronized_output synchronized_out(const int level) { return Synchronized_output(level); }
+
+#endif
@@ -0,0 +1,293 @@
+#ifndef __TAPE_PROFILER_H__
+#define __TAPE_PROFILER_H__
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include "lion/foundation/types.h"
+#include "lion/thirdparty/include/cppad/cppad.hpp"
+#include "src/core/foundation/fastest_lap_exception.h"
+
+//!      AD tape profiler
+//!      ----------------
+//!
+//! Attributes the operations recorded in a CppAD tape to the model components (road, chassis, axle, tire, engine...)
+//! Components are tagged in the source with FASTEST_LAP_TAPE_SCOPE("name"). Nested scopes are attributed to the
+//! innermost component (self cost), and everything outside any scope to "other".
+//!
+//! CppAD does not expose the length of a tape during the recording. The profiler records the function once to
+//! find the sequence of scope events, and then once more per event, closing the tape at that event. The costs of
+//! a component are the differences between the tapes closed before and after it: this is a diagnostic tool,
+//! O(number of events) recordings per call.
+//!
+//! While no profile is running, a scope costs one check of a thread local flag. Define FASTEST_LAP_DISABLE_TAPE_PROFILER
+//! to remove the FASTEST_LAP_TAPE_SCOPE macros from the build entirely
+class Tape_profiler
+{
+ public:
+
+    //! Costs of one component
+    struct Component
+    {
+        std::string name;
+        size_t n_operations = 0;        //! Number of operations recorded
+        size_t n_variables  = 0;        //! Number of variables recorded
+        scalar forward_time = 0.0;      //! Wall time of a zero order forward sweep [s]
+        scalar reverse_time = 0.0;      //! Wall time of a first order reverse sweep [s]
+    };
+
+    //! Costs of one tape, split by component
+    struct Report
+    {
+        std::vector<Component> components;  //! Components, in order of first appearance
+        size_t n_operations = 0;            //! Total number of operations
+        size_t n_variables  = 0;            //! Total number of variables
+        scalar forward_time = 0.0;          //! Total time of a zero order forward sweep [s]
+        scalar reverse_time = 0.0;          //! Total time of a first order reverse sweep [s]
+
+        //! Get a component by name
+        const Component& operator[](const std::string& name) const
+        {
+            const auto it = std::find_if(components.cbegin(), components.cend(), [&](const auto& c) -> auto { return c.name == name; });
+
+            if ( it == components.cend() )
+                throw fastest_lap_exception("[ERROR] Tape_profiler::Report::operator[] -> component \"" + name + "\" was not found");
+
+            return *it;
+        }
+
+        //! True if the component was recorded
+        bool has_component(const std::string& name) const
+        {
+            return std::any_of(components.cbegin(), components.cend(), [&](const auto& c) -> auto { return c.name == name; });
+        }
+
+        //! Accumulate the costs of another report
+        Report& operator+=(const Report& other)
+        {
+            for (const auto& other_component : other.components)
+                add(other_component);
+
+            n_operations += other.n_operations;
+            n_variables  += other.n_variables;
+            forward_time += other.forward_time;
+            reverse_time += other.reverse_time;
+
+            return *this;
+        }
+
+        //! Accumulate the costs of a component
+        void add(const Component& component)
+        {
+            auto it = std::find_if(components.begin(), components.end(), [&](const auto& c) -> auto { return c.name == component.name; });
+
+            if ( it == components.end() )
+            {
+                components.push_back({component.name});
+                it = components.end() - 1;
+            }
+
+            it->n_operations += component.n_operations;
+            it->n_variables  += component.n_variables;
+            it->forward_time += component.forward_time;
+            it->reverse_time += component.reverse_time;
+        }
+    };
+
+    //! Profile the tape of y = f(x)
+    //! @param[in] f: function, std::vector<CppAD::AD<scalar>> f(const std::vector<CppAD::AD<scalar>>& x)
+    //! @param[in] x0: point where the tape is recorded and the sweeps are timed
+    //! @param[in] n_sweeps: number of sweeps averaged for the timings
+    template<typename F>
+    static Report profile(F&& f, const std::vector<scalar>& x0, const size_t n_sweeps = 10)
+    {
+        if ( x0.size() == 0 )
+            throw fastest_lap_exception("[ERROR] Tape_profiler::profile -> x0 must not be empty");
+
+        auto& st = state();
+
+        if ( st.active )
+            throw fastest_lap_exception("[ERROR] Tape_profiler::profile -> profiles cannot be nested");
+
+        // (1) Record the complete tape, and the sequence of scope events
+        st = State{};
+
+        std::vector<CppAD::AD<scalar>> x(x0.cbegin(), x0.cend());
+        CppAD::Independent(x);
+        st.x      = &x;
+        st.active = true;
+
+        std::vector<CppAD::AD<scalar>> y;
+        try
+        {
+            y = f(x);
+        }
+        catch (...)
+        {
+            st.active = false;
+            CppAD::AD<scalar>::abort_recording();
+            throw;
+        }
+
+        st.active = false;
+        CppAD::ADFun<scalar> tape(x, y);
+
+        const auto events = st.events;
+
+        // (2) Measure the tapes closed at every event. The last one is the complete tape
+        std::vector<Component> cumulative(events.size() + 1);
+
+        for (size_t k = 0; k < events.size(); ++k)
+        {
+            std::vector<CppAD::AD<scalar>> x_k(x0.cbegin(), x0.cend());
+            CppAD::Independent(x_k);
+
+            st = State{};
+            st.x      = &x_k;
+            st.target = k;
+            st.active = true;
+
+            try
+            {
+                f(x_k);
+            }
+            catch (...)
+            {
+                st.active = false;
+                if ( st.tape == nullptr ) CppAD::AD<scalar>::abort_recording();
+                throw;
+            }
+
+            st.active = false;
+
+            if ( st.tape == nullptr )
+                throw fastest_lap_exception("[ERROR] Tape_profiler::profile -> the sequence of events changed between recordings");
+
+            cumulative[k] = measure(*st.tape, x0, n_sweeps);
+        }
+
+        cumulative.back() = measure(tape, x0, n_sweeps);
+        st = State{};
+
+        // (3) Attribute the differences to the innermost open scope
+        Report report;
+        std::vector<std::string> stack;
+        Component previous;
+
+        for (size_t k = 0; k <= events.size(); ++k)
+        {
+            Component component{(stack.empty() ? "other" : stack.back())};
+            component.n_operations = cumulative[k].n_operations - std::min(previous.n_operations, cumulative[k].n_operations);
+            component.n_variables  = cumulative[k].n_variables - std::min(previous.n_variables, cumulative[k].n_variables);
+            component.forward_time = std::max(cumulative[k].forward_time - previous.forward_time, 0.0);
+            component.reverse_time = std::max(cumulative[k].reverse_time - previous.reverse_time, 0.0);
+            report.add(component);
+
+            previous = cumulative[k];
+
+            if ( k < events.size() )
+            {
+                if ( events[k].second )
+                    stack.push_back(events[k].first);
+                else if ( !stack.empty() )
+                    stack.pop_back();
+            }
+        }
+
+        report.n_operations = cumulative.back().n_operations;
+        report.n_variables  = cumulative.back().n_variables;
+        report.forward_time = cumulative.back().forward_time;
+        report.reverse_time = cumulative.back().reverse_time;
+
+        return report;
+    }
+
+    //! Tags the operations recorded during its lifetime with a component name
+    class Scope
+    {
+     public:
+        explicit Scope(const char* name) : _name(state().active ? name : nullptr) { if ( _name ) event(_name, true); }
+
+        ~Scope() { if ( _name && state().active ) event(_name, false); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+     private:
+        const char* _name;      //! nullptr if no profile was running at construction
+    };
+
+ private:
+
+    //! Profiling state of the current thread
+    struct State
+    {
+        bool active = false;                                        //! True while a profiled function is recorded
+        size_t n_events = 0;                                        //! Events seen in the current recording
+        size_t target = std::numeric_limits<size_t>::max();         //! Event where the tape is closed (max: none)
+        std::vector<CppAD::AD<scalar>>* x = nullptr;                //! Independent variables of the current recording
+        std::unique_ptr<CppAD::ADFun<scalar>> tape;                 //! Tape closed at the target event
+        std::vector<std::pair<std::string,bool>> events;            //! Events of the first recording: (name, is_begin)
+    };
+
+    static State& state()
+    {
+        thread_local State st;
+        return st;
+    }
+
+    static void event(const char* name, const bool is_begin)
+    {
+        auto& st = state();
+
+        if ( st.target == std::numeric_limits<size_t>::max() )
+        {
+            st.events.push_back({name, is_begin});
+        }
+        else if ( st.n_events == st.target )
+        {
+            // Close the tape here: the rest of the function is evaluated but not recorded
+            st.tape = std::make_unique<CppAD::ADFun<scalar>>();
+            st.tape->Dependent(*st.x, std::vector<CppAD::AD<scalar>>{st.x->front()});
+            st.active = false;
+        }
+
+        ++st.n_events;
+    }
+
+    //! Size and sweep times of a tape
+    static Component measure(CppAD::ADFun<scalar>& tape, const std::vector<scalar>& x0, const size_t n_sweeps)
+    {
+        Component result;
+        result.n_operations = tape.size_op();
+        result.n_variables  = tape.size_var();
+
+        const size_t n = std::max<size_t>(n_sweeps, 1);
+        const std::vector<scalar> w(tape.Range(), 1.0);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i)
+            tape.Forward(0, x0);
+        result.forward_time = std::chrono::duration<scalar>(std::chrono::steady_clock::now() - start).count()/n;
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i)
+            tape.Reverse(1, w);
+        result.reverse_time = std::chrono::duration<scalar>(std::chrono::steady_clock::now() - start).count()/n;
+
+        return result;
+    }
+};
+
+#ifdef FASTEST_LAP_DISABLE_TAPE_PROFILER
+#define FASTEST_LAP_TAPE_SCOPE(name)
+#else
+#define FASTEST_LAP_TAPE_CONCATENATE_(a,b) a ## b
+#define FASTEST_LAP_TAPE_CONCATENATE(a,b) FASTEST_LAP_TAPE_CONCATENATE_(a,b)
+#define FASTEST_LAP_TAPE_SCOPE(name) Tape_profiler::Scope FASTEST_LAP_TAPE_CONCATENATE(_tape_scope_,__LINE__)(name)
+#endif
+
+#endif
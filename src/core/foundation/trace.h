@@ -0,0 +1,254 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include "src/core/foundation/fastest_lap_exception.h"
+
+//!      Timeline tracing
+//!      ----------------
+//!
+//! Records begin/end events of the solver phases, with the thread that executed them, and writes
+//! them in the Chrome trace event format (chrome://tracing, https://ui.perfetto.dev)
+//!
+//!     - Every thread writes into its own ring buffer: when it is full, the oldest events are overwritten
+//!     - The buffer of a thread that finishes is kept, and given to the next thread that starts recording
+//!     - While disabled, an event costs one relaxed atomic load. Define FASTEST_LAP_DISABLE_TRACE to remove
+//!       the FASTEST_LAP_TRACE_SCOPE macros from the build entirely
+//!
+//! Event names must be string literals (or outlive the trace): only the pointer is stored
+class Trace
+{
+ public:
+
+    //! Start recording
+    //! @param[in] events_per_thread: capacity of the ring buffer of each thread. Takes effect on empty buffers (see clear())
+    static void enable(const size_t events_per_thread = 65536)
+    {
+        if ( events_per_thread == 0 )
+            throw fastest_lap_exception("[ERROR] Trace::enable -> events_per_thread must be positive");
+
+        _capacity = events_per_thread;
+        _enabled  = true;
+    }
+
+    //! Stop recording. The recorded events are kept
+    static void disable() { _enabled = false; }
+
+    //! True if events are being recorded
+    static bool is_enabled() { return _enabled.load(std::memory_order_relaxed); }
+
+    //! Remove all the recorded events
+    static void clear()
+    {
+        std::lock_guard<std::mutex> lock(_registry_mutex);
+
+        for (auto& buffer : _registry)
+        {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            buffer->events.clear();
+            buffer->head = 0;
+        }
+    }
+
+    //! Record the beginning of a phase
+    static void begin(const char* name) { if ( is_enabled() ) record(name, 'B'); }
+
+    //! Record the end of a phase
+    static void end(const char* name) { if ( is_enabled() ) record(name, 'E'); }
+
+    //! Records begin at construction and end at destruction
+    class Scope
+    {
+     public:
+        explicit Scope(const char* name) : _name(is_enabled() ? name : nullptr) { if ( _name ) record(_name, 'B'); }
+
+        ~Scope() { if ( _name ) record(_name, 'E'); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+     private:
+        const char* _name;      //! nullptr if tracing was disabled at construction
+    };
+
+    //! Number of events currently stored
+    static size_t size()
+    {
+        std::lock_guard<std::mutex> lock(_registry_mutex);
+
+        size_t n = 0;
+        for (auto& buffer : _registry)
+        {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            n += buffer->events.size();
+        }
+
+        return n;
+    }
+
+    //! Get the recorded events in the Chrome trace event format (JSON)
+    static std::string json()
+    {
+        std::ostringstream s_out;
+        s_out << std::fixed << std::setprecision(3);
+        s_out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        bool first = true;
+        auto separator = [&]() -> const char* { const char* sep = (first ? "\n" : ",\n"); first = false; return sep; };
+
+        std::lock_guard<std::mutex> lock(_registry_mutex);
+
+        for (auto& buffer : _registry)
+        {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+
+            // (1) Name the thread
+            s_out << separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->thread_id
+                  << ",\"args\":{\"name\":\"" << (buffer->thread_id == 0 ? "main" : "worker " + std::to_string(buffer->thread_id)) << "\"}}";
+
+            // (2) Events, from the oldest to the newest
+            const size_t n_events = buffer->events.size();
+            for (size_t i = 0; i < n_events; ++i)
+            {
+                const auto& event = buffer->events[(buffer->head + i) % n_events];
+
+                s_out << separator() << "{\"name\":\"" << escape(event.name) << "\",\"cat\":\"fastest-lap\",\"ph\":\"" << event.phase
+                      << "\",\"ts\":" << event.timestamp << ",\"pid\":0,\"tid\":" << buffer->thread_id << "}";
+            }
+        }
+
+        s_out << "\n]}\n";
+
+        return s_out.str();
+    }
+
+    //! Write the recorded events to a file in the Chrome trace event format
+    //! @param[in] file_name: name of the output file (typically .json)
+    static void save(const std::string& file_name)
+    {
+        std::ofstream file(file_name);
+
+        if ( !file.is_open() )
+            throw fastest_lap_exception("[ERROR] Trace::save -> could not open file \"" + file_name + "\"");
+
+        file << json();
+    }
+
+ private:
+
+    struct Event
+    {
+        const char* name;
+        char phase;             //! 'B': begin, 'E': end
+        double timestamp;       //! [us] since the first use of the trace
+    };
+
+    //! Ring buffer of one thread
+    struct Buffer
+    {
+        size_t thread_id;
+        std::vector<Event> events;
+        size_t head = 0;        //! Position of the oldest event once the buffer is full
+        std::mutex mutex;       //! Only contended while the trace is being written
+    };
+
+    //! Holds the buffer of a thread, and releases it when the thread finishes
+    struct Thread_buffer
+    {
+        Buffer* buffer = nullptr;
+
+        ~Thread_buffer()
+        {
+            if ( buffer != nullptr )
+            {
+                std::lock_guard<std::mutex> lock(_registry_mutex);
+                _free_buffers.push_back(buffer);
+            }
+        }
+    };
+
+    inline static std::atomic<bool> _enabled{false};
+    inline static std::atomic<size_t> _capacity{65536};
+    inline static const std::chrono::steady_clock::time_point _origin = std::chrono::steady_clock::now();
+
+    inline static std::mutex _registry_mutex;
+    inline static std::vector<std::unique_ptr<Buffer>> _registry;
+    inline static std::vector<Buffer*> _free_buffers;
+
+    //! Get the buffer of the current thread: reuse one from a finished thread, or construct a new one
+    static Buffer& get_buffer()
+    {
+        thread_local Thread_buffer thread_buffer;
+
+        if ( thread_buffer.buffer == nullptr )
+        {
+            std::lock_guard<std::mutex> lock(_registry_mutex);
+
+            if ( _free_buffers.size() > 0 )
+            {
+                thread_buffer.buffer = _free_buffers.back();
+                _free_buffers.pop_back();
+            }
+            else
+            {
+                _registry.push_back(std::make_unique<Buffer>());
+                _registry.back()->thread_id = _registry.size() - 1;
+                thread_buffer.buffer = _registry.back().get();
+            }
+        }
+
+        return *thread_buffer.buffer;
+    }
+
+    static void record(const char* name, const char phase)
+    {
+        const double timestamp = std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now() - _origin).count();
+        const size_t capacity = _capacity.load(std::memory_order_relaxed);
+
+        Buffer& buffer = get_buffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+
+        if ( (buffer.events.size() < capacity) && (buffer.head == 0) )
+        {
+            buffer.events.push_back({name, phase, timestamp});
+        }
+        else
+        {
+            // Full: overwrite the oldest event
+            buffer.events[buffer.head] = {name, phase, timestamp};
+            buffer.head = (buffer.head + 1) % buffer.events.size();
+        }
+    }
+
+    static std::string escape(const char* name)
+    {
+        std::string result;
+        for (const char* c = name; *c != '\0'; ++c)
+        {
+            if ( (*c == '"') || (*c == '\\') )
+                result.push_back('\\');
+
+            result.push_back(*c);
+        }
+
+        return result;
+    }
+};
+
+#ifdef FASTEST_LAP_DISABLE_TRACE
+#define FASTEST_LAP_TRACE_SCOPE(name)
+#else
+#define FASTEST_LAP_TRACE_CONCATENATE_(a,b) a ## b
+#define FASTEST_LAP_TRACE_CONCATENATE(a,b) FASTEST_LAP_TRACE_CONCATENATE_(a,b)
+#define FASTEST_LAP_TRACE_SCOPE(name) Trace::Scope FASTEST_LAP_TRACE_CONCATENATE(_trace_scope_,__LINE__)(name)
+#endif
+
+#endif
@@ -4,6 +4,7 @@
 #include <iomanip>
 #include "lion/thirdparty/include/logger.hpp"
 #include "src/core/foundation/fastest_lap_exception.h"
+#include "src/core/foundation/synchronized_output.h"
 
 template<typename Timeseries_t, size_t STATE0, size_t CONTROL0>
 inline Tire<Timeseries_t,STATE0,CONTROL0>::Tire(const std::string& name, Xml_document& database, 
@@ -105,7 +106,7 @@ inline std::ostream& Tire<Timeseries_t,STATE0,CONTROL0>::print(std::ostream& os)
     os << "Tire \"" << _name << "\"" << std::endl;    
     os << "======" << std::string(_name.length()+1, '=') << std::endl;
 
-    out(2) << std::left << std::setw(16) << "   * R0: " << std::right << std::setw(5) << _R0  << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * R0: " << std::right << std::setw(5) << _R0  << std::endl;
 
     return os;
 }
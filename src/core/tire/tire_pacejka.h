@@ -1,6 +1,8 @@
 #ifndef __TIRE_PACEJKA_H__
 #define __TIRE_PACEJKA_H__
 
+#include <utility>
+#include <tuple>
 #include "tire.h"
 
 //! Implementation of the complete Pacejka tire model
@@ -59,6 +61,15 @@ struct Pacejka_standard_model
     template<typename Timeseries_t>
     Timeseries_t force_combined_lateral_magic(Timeseries_t kappa, Timeseries_t lambda, Timeseries_t Fz) const;
 
+    //! Applies the magic formula for the case of combined slip, for both forces at once.
+    //! The results are identical to force_combined_longitudinal_magic and force_combined_lateral_magic
+    //! @param[in] kappa: instantaneous longitudinal slip
+    //! @param[in] kappa: instantaneous lateral slip     
+    //! @param[in] Fz: Vertical load [N]
+    //! @return (Fx, Fy)
+    template<typename Timeseries_t>
+    std::pair<Timeseries_t,Timeseries_t> force_combined_magic(Timeseries_t kappa, Timeseries_t lambda, Timeseries_t Fz) const;
+
     DECLARE_PARAMS(
         { "nominal-vertical-load", _Fz0 },
         { "lambdaFz0", _lambdaFz0 },
@@ -130,6 +141,27 @@ struct Pacejka_simple_model
     //! Compute the combined lateral force
     Timeseries_t force_combined_lateral_magic(Timeseries_t kappa, Timeseries_t lambda, Timeseries_t Fz) const;
 
+    //! Compute the combined longitudinal and lateral forces. The load interpolated peaks and the
+    //! normalized slips are evaluated (and taped) only once
+    //! @return (Fx, Fy)
+    std::pair<Timeseries_t,Timeseries_t> force_combined_magic(Timeseries_t kappa, Timeseries_t lambda, Timeseries_t Fz) const;
+
+    //! Terms shared by the longitudinal and lateral forces
+    struct Normalized_slips
+    {
+        Timeseries_t kappa_n;   //! kappa/kappa_max(Fz)
+        Timeseries_t lambda_n;  //! lambda/lambda_max(Fz)
+        Timeseries_t rho;       //! Combined normalized slip
+    };
+
+    //! Normalize the slips with the load interpolated slips of the friction peak
+    Normalized_slips normalized_slips(Timeseries_t kappa, Timeseries_t lambda, Timeseries_t Fz) const;
+
+    //! Load interpolated peak friction coefficient
+    //! @param[in] mu_max1: peak friction coefficient at load 1
+    //! @param[in] mu_max2: peak friction coefficient at load 2
+    Timeseries_t peak_friction(const Timeseries_t& mu_max1, const Timeseries_t& mu_max2, Timeseries_t Fz) const;
+
     // Constants
     scalar _Fz1 = 0.0;            //! [c] Reference load 1
     scalar _Fz2 = 0.0;            //! [c] Reference load 2
@@ -4,6 +4,8 @@
 #include "lion/math/optimise.h"
 #include "lion/thirdparty/include/logger.hpp"
 #include "src/core/foundation/fastest_lap_exception.h"
+#include "src/core/foundation/synchronized_output.h"
+#include "src/core/foundation/tape_profiler.h"
 
 template<typename Timeseries_t, typename Pacejka_model, size_t STATE0, size_t CONTROL0>
 inline Tire_pacejka<Timeseries_t,Pacejka_model,STATE0,CONTROL0>::Tire_pacejka(const std::string& name, Xml_document& database, 
@@ -66,6 +68,8 @@ void Tire_pacejka<Timeseries_t,Pacejka_model,STATE0,CONTROL0>::fill_xml(Xml_docu
 template<typename Timeseries_t, typename Pacejka_model, size_t STATE0, size_t CONTROL0>
 inline void Tire_pacejka<Timeseries_t,Pacejka_model,STATE0,CONTROL0>::update(Timeseries_t Fz, Timeseries_t kappa)
 {
+    FASTEST_LAP_TAPE_SCOPE("tire");
+
     // Compute omega
     base_type::update_from_kappa(kappa);
 
@@ -76,6 +80,8 @@ inline void Tire_pacejka<Timeseries_t,Pacejka_model,STATE0,CONTROL0>::update(Tim
 template<typename Timeseries_t, typename Pacejka_model, size_t STATE0, size_t CONTROL0>
 inline void Tire_pacejka<Timeseries_t,Pacejka_model,STATE0,CONTROL0>::update(const Vector3d<Timeseries_t>& x0, const Vector3d<Timeseries_t>& v0, Timeseries_t omega)
 {
+    FASTEST_LAP_TAPE_SCOPE("tire");
+
     base_type::update(x0, v0, omega);
 
     update_self();
@@ -85,6 +91,8 @@ inline void Tire_pacejka<Timeseries_t,Pacejka_model,STATE0,CONTROL0>::update(con
 template<typename Timeseries_t, typename Pacejka_model, size_t STATE0, size_t CONTROL0>
 inline void Tire_pacejka<Timeseries_t,Pacejka_model,STATE0,CONTROL0>::update(Timeseries_t omega)
 {
+    FASTEST_LAP_TAPE_SCOPE("tire");
+
     base_type::update(omega);
 
     update_self();
@@ -108,8 +116,7 @@ inline void Tire_pacejka<Timeseries_t,Pacejka_model,STATE0,CONTROL0>::update_sel
 {
     // Compute the magic formula forces
     // For now, lets use a steady-state version
-    _Smagic = _model.force_combined_longitudinal_magic(base_type::_kappa,base_type::_lambda,Fz);
-    _Fmagic = _model.force_combined_lateral_magic(base_type::_kappa, base_type::_lambda, Fz);
+    std::tie(_Smagic, _Fmagic) = _model.force_combined_magic(base_type::_kappa, base_type::_lambda, Fz);
 
     base_type::_F[X] = _Smagic; 
     base_type::_F[Y] = _Fmagic;
@@ -179,6 +186,14 @@ inline Timeseries_t Pacejka_standard_model::force_combined_lateral_magic(Timeser
 }
 
 
+template<typename Timeseries_t>
+inline std::pair<Timeseries_t,Timeseries_t> Pacejka_standard_model::force_combined_magic(Timeseries_t kappa, Timeseries_t lambda, Timeseries_t Fz) const
+{
+    // The two forces only share the inputs: evaluate them one after the other
+    return { force_combined_longitudinal_magic(kappa, lambda, Fz), force_combined_lateral_magic(kappa, lambda, Fz) };
+}
+
+
 template<typename Timeseries_t>
 inline void Pacejka_simple_model<Timeseries_t>::initialise()
 {
@@ -193,9 +208,9 @@ inline void Pacejka_simple_model<Timeseries_t>::initialise()
 
 
 template<typename Timeseries_t>
-Timeseries_t Pacejka_simple_model<Timeseries_t>::force_combined_longitudinal_magic(Timeseries_t kappa, Timeseries_t lambda, Timeseries_t Fz) const
+inline typename Pacejka_simple_model<Timeseries_t>::Normalized_slips Pacejka_simple_model<Timeseries_t>::normalized_slips(Timeseries_t kappa, 
+    Timeseries_t lambda, Timeseries_t Fz) const
 {
-    const Timeseries_t mu_x_max  = smooth_pos((Fz - _Fz1)*(_mu_x_max2  - _mu_x_max1 )/(_Fz2 - _Fz1) + _mu_x_max1-_mu_min,1.0e-5)+_mu_min;
     const Timeseries_t kappa_max = (Fz - _Fz1)*(_kappa_max2 - _kappa_max1)/(_Fz2 - _Fz1) + _kappa_max1;
     const Timeseries_t lambda_max = (Fz - _Fz1)*(_lambda_max2 - _lambda_max1)/(_Fz2 - _Fz1) + _lambda_max1;
 
@@ -203,7 +218,24 @@ Timeseries_t Pacejka_simple_model<Timeseries_t>::force_combined_longitudinal_mag
     const Timeseries_t lambda_n = lambda/lambda_max;
     const Timeseries_t rho = sqrt(kappa_n*kappa_n + lambda_n*lambda_n + 1.0e-12);
 
-    const Timeseries_t mu_x = mu_x_max*sin(_Qx*atan(_Sx*rho));
+    return {kappa_n, lambda_n, rho};
+}
+
+
+template<typename Timeseries_t>
+inline Timeseries_t Pacejka_simple_model<Timeseries_t>::peak_friction(const Timeseries_t& mu_max1, const Timeseries_t& mu_max2, Timeseries_t Fz) const
+{
+    return smooth_pos((Fz - _Fz1)*(mu_max2 - mu_max1)/(_Fz2 - _Fz1) + mu_max1 - _mu_min,1.0e-5) + _mu_min;
+}
+
+
+template<typename Timeseries_t>
+Timeseries_t Pacejka_simple_model<Timeseries_t>::force_combined_longitudinal_magic(Timeseries_t kappa, Timeseries_t lambda, Timeseries_t Fz) const
+{
+    const auto [kappa_n, lambda_n, rho] = normalized_slips(kappa, lambda, Fz);
+    (void) lambda_n;
+
+    const Timeseries_t mu_x = peak_friction(_mu_x_max1, _mu_x_max2, Fz)*sin(_Qx*atan(_Sx*rho));
     
     return mu_x*Fz*kappa_n/(rho);
 }
@@ -212,26 +244,35 @@ Timeseries_t Pacejka_simple_model<Timeseries_t>::force_combined_longitudinal_mag
 template<typename Timeseries_t>
 Timeseries_t Pacejka_simple_model<Timeseries_t>::force_combined_lateral_magic(Timeseries_t kappa, Timeseries_t lambda, Timeseries_t Fz) const
 {
-    const Timeseries_t mu_y_max  = smooth_pos((Fz - _Fz1)*(_mu_y_max2  - _mu_y_max1 )/(_Fz2 - _Fz1) + _mu_y_max1-_mu_min,1.0e-5)+_mu_min;
-    const Timeseries_t kappa_max = (Fz - _Fz1)*(_kappa_max2 - _kappa_max1)/(_Fz2 - _Fz1) + _kappa_max1;
-    const Timeseries_t lambda_max = (Fz - _Fz1)*(_lambda_max2 - _lambda_max1)/(_Fz2 - _Fz1) + _lambda_max1;
+    const auto [kappa_n, lambda_n, rho] = normalized_slips(kappa, lambda, Fz);
+    (void) kappa_n;
 
-    const Timeseries_t kappa_n = kappa/kappa_max;
-    const Timeseries_t lambda_n = lambda/lambda_max;
-    const Timeseries_t rho = sqrt(kappa_n*kappa_n + lambda_n*lambda_n + 1.0e-12);
-
-    const Timeseries_t mu_y = mu_y_max*sin(_Qy*atan(_Sy*rho));
+    const Timeseries_t mu_y = peak_friction(_mu_y_max1, _mu_y_max2, Fz)*sin(_Qy*atan(_Sy*rho));
     
     return mu_y*Fz*lambda_n/(rho);
 }
 
 
+template<typename Timeseries_t>
+std::pair<Timeseries_t,Timeseries_t> Pacejka_simple_model<Timeseries_t>::force_combined_magic(Timeseries_t kappa, Timeseries_t lambda, Timeseries_t Fz) const
+{
+    // (1) Common terms: load interpolated slips of the peak and normalized slips
+    const auto [kappa_n, lambda_n, rho] = normalized_slips(kappa, lambda, Fz);
+
+    // (2) Longitudinal and lateral friction coefficients
+    const Timeseries_t mu_x = peak_friction(_mu_x_max1, _mu_x_max2, Fz)*sin(_Qx*atan(_Sx*rho));
+    const Timeseries_t mu_y = peak_friction(_mu_y_max1, _mu_y_max2, Fz)*sin(_Qy*atan(_Sy*rho));
+
+    return { mu_x*Fz*kappa_n/(rho), mu_y*Fz*lambda_n/(rho) };
+}
+
+
 template<typename Timeseries_t, typename Pacejka_model, size_t STATE0, size_t CONTROL0>
 inline std::ostream& Tire_pacejka<Timeseries_t,Pacejka_model,STATE0,CONTROL0>::print(std::ostream& os) const
 {
     base_type::print(os);
-    out(2) << std::left << std::setw(16) << "   * kt: "  << std::right << std::setw(5) << _kt << std::endl;
-    out(2) << std::left << std::setw(16) << "   * ct: "  << std::right << std::setw(5) << _ct << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * kt: "  << std::right << std::setw(5) << _kt << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * ct: "  << std::right << std::setw(5) << _ct << std::endl;
     _model.print(os);
 
     return os;
@@ -240,24 +281,24 @@ inline std::ostream& Tire_pacejka<Timeseries_t,Pacejka_model,STATE0,CONTROL0>::p
 
 inline std::ostream& Pacejka_standard_model::print(std::ostream& os) const
 {
-    out(2) << std::left << std::setw(16) << "   * Fz0: "  << std::right << std::setw(5) << _Fz0 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pCx1: "  << std::right << std::setw(5) << _pCx1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pDx1: "  << std::right << std::setw(5) << _pDx1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pEx1: "  << std::right << std::setw(5) << _pEx1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pKx1: "  << std::right << std::setw(5) << _pKx1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pKx2: "  << std::right << std::setw(5) << _pKx2 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pKx3: "  << std::right << std::setw(5) << _pKx3 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pCy1: "  << std::right << std::setw(5) << _pCy1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pDy1: "  << std::right << std::setw(5) << _pDy1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pEy1: "  << std::right << std::setw(5) << _pEy1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pKy1: "  << std::right << std::setw(5) << _pKy1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pKy2: "  << std::right << std::setw(5) << _pKy2 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * pKy4: "  << std::right << std::setw(5) << _pKy4 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * rBx1: "  << std::right << std::setw(5) << _rBx1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * rCx1: "  << std::right << std::setw(5) << _rCx1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * rBy1: "  << std::right << std::setw(5) << _rBy1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * rCy1: "  << std::right << std::setw(5) << _rCy1 << std::endl;
-    out(2) << std::left << std::setw(16) << "   * lambdaFz0: " <<  std::right << std::setw(5) << _lambdaFz0 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * Fz0: "  << std::right << std::setw(5) << _Fz0 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pCx1: "  << std::right << std::setw(5) << _pCx1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pDx1: "  << std::right << std::setw(5) << _pDx1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pEx1: "  << std::right << std::setw(5) << _pEx1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pKx1: "  << std::right << std::setw(5) << _pKx1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pKx2: "  << std::right << std::setw(5) << _pKx2 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pKx3: "  << std::right << std::setw(5) << _pKx3 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pCy1: "  << std::right << std::setw(5) << _pCy1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pDy1: "  << std::right << std::setw(5) << _pDy1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pEy1: "  << std::right << std::setw(5) << _pEy1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pKy1: "  << std::right << std::setw(5) << _pKy1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pKy2: "  << std::right << std::setw(5) << _pKy2 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * pKy4: "  << std::right << std::setw(5) << _pKy4 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * rBx1: "  << std::right << std::setw(5) << _rBx1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * rCx1: "  << std::right << std::setw(5) << _rCx1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * rBy1: "  << std::right << std::setw(5) << _rBy1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * rCy1: "  << std::right << std::setw(5) << _rCy1 << std::endl;
+    synchronized_out(2) << std::left << std::setw(16) << "   * lambdaFz0: " <<  std::right << std::setw(5) << _lambdaFz0 << std::endl;
 
     return os;
 }
@@ -106,6 +106,15 @@ class Dynamic_model_car : public Dynamic_model<Timeseries_t>
     static std::tuple<std::string,std::array<std::string,_NSTATE>,std::array<std::string,Chassis_t::NALGEBRAIC>,std::array<std::string,_NCONTROL>> 
         get_state_and_control_names();
 
+    //! Get which state variables are tire longitudinal slips. They can be replaced by the quasi-steady 
+    //! torque balance in optimal laptime simulations (see Optimal_laptime::Options::quasi_steady_slip)
+    static std::array<bool,_NSTATE> get_slip_states() 
+    { 
+        std::array<bool,_NSTATE> is_slip{};
+        Chassis_t::set_slip_states(is_slip);
+        return is_slip;
+    }
+
     //! Get state and control upper and lower values
     struct State_and_control_upper_lower_and_default_values
     {
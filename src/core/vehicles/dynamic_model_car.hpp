@@ -2,6 +2,7 @@
 #define __CAR_HPP__
 
 #include "lion/math/matrix_extensions.h"
+#include "src/core/foundation/tape_profiler.h"
 
 template<typename Timeseries_t, typename Chassis_t, typename RoadModel_t, size_t _NSTATE, size_t _NCONTROL>
 template<size_t NALG>
@@ -46,8 +47,15 @@ std::pair<std::array<Timeseries_t,_NSTATE>,std::array<Timeseries_t,Chassis_t::NA
     _road.set_state_and_controls(t,q,u);
 
     // (3) Update
-    _road.update(_chassis.get_u(), _chassis.get_v(), _chassis.get_omega());
-    _chassis.update(_road.get_x(), _road.get_y(), _road.get_psi());
+    {
+        FASTEST_LAP_TAPE_SCOPE("road");
+        _road.update(_chassis.get_u(), _chassis.get_v(), _chassis.get_omega());
+    }
+
+    {
+        FASTEST_LAP_TAPE_SCOPE("chassis");
+        _chassis.update(_road.get_x(), _road.get_y(), _road.get_psi());
+    }
 
     // (4) Get time derivative
     _chassis.get_state_derivative(dqdt);
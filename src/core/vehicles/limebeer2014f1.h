@@ -9,6 +9,7 @@
 #include "src/core/vehicles/road_cartesian.h"
 #include "src/core/vehicles/road_curvilinear.h"
 #include "src/core/vehicles/dynamic_model_car.h"
+#include "src/core/foundation/dependency_tracker.h"
 #include "lion/thirdparty/include/cppad/cppad.hpp"
 
 template<typename Timeseries_t>
@@ -281,6 +282,8 @@ struct limebeer2014f1_all
 
         cartesian_ad.set_parameter(parameter, value);
         curvilinear_ad.set_parameter(parameter, value);
+
+        dependencies.parameter_changed(parameter);
     }
 
     template<typename ... Args> 
@@ -291,6 +294,8 @@ struct limebeer2014f1_all
 
         cartesian_ad.add_parameter(parameter_name, std::forward<Args>(args)...);
         curvilinear_ad.add_parameter(parameter_name, std::forward<Args>(args)...);
+
+        dependencies.parameter_changed(parameter_name);
     }
 
 
@@ -298,6 +303,8 @@ struct limebeer2014f1_all
     limebeer2014f1<scalar>::curvilinear_p             curvilinear_scalar;
     limebeer2014f1<CppAD::AD<scalar>>::cartesian      cartesian_ad;
     limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p  curvilinear_ad;
+
+    Dependency_tracker dependencies;    //! Parameter changes, used to reuse the artefacts derived from the vehicle
 };
 
 #endif
@@ -9,6 +9,7 @@
 #include "src/core/vehicles/road_cartesian.h"
 #include "src/core/vehicles/road_curvilinear.h"
 #include "src/core/vehicles/dynamic_model_car.h"
+#include "src/core/foundation/dependency_tracker.h"
 #include "lion/thirdparty/include/cppad/cppad.hpp"
 
 template<typename Timeseries_t>
@@ -239,12 +240,16 @@ struct lot2016kart_all
 
         cartesian_ad.add_parameter(parameter_name, std::forward<Args>(args)...);
         curvilinear_ad.add_parameter(parameter_name, std::forward<Args>(args)...);
+
+        dependencies.parameter_changed(parameter_name);
     }
 
     lot2016kart<scalar>::cartesian                 cartesian_scalar;
     lot2016kart<scalar>::curvilinear_p             curvilinear_scalar;
     lot2016kart<CppAD::AD<scalar>>::cartesian      cartesian_ad;
     lot2016kart<CppAD::AD<scalar>>::curvilinear_p  curvilinear_ad;
+
+    Dependency_tracker dependencies;    //! Parameter changes, used to reuse the artefacts derived from the vehicle
 };
 
 #endif
@@ -1,9 +1,12 @@
 #ifndef __ROAD_CURVILINEAR_H__
 #define __ROAD_CURVILINEAR_H__
 
+#include <vector>
+#include <algorithm>
 #include "road.h"
 #include "lion/math/polynomial.h"
 #include "lion/math/matrix_extensions.h"
+#include "src/core/foundation/fastest_lap_exception.h"
 
 template<typename Timeseries_t,typename Track_t,size_t STATE0, size_t CONTROL0>
 class Road_curvilinear : public Road<Timeseries_t,STATE0,CONTROL0>
@@ -26,9 +29,9 @@ class Road_curvilinear : public Road<Timeseries_t,STATE0,CONTROL0>
 
     constexpr const scalar& track_length() const { return _track.get_total_length(); } 
 
-    constexpr const scalar get_left_track_limit(scalar s) const { return _track.get_left_track_limit(s); }
+    constexpr const scalar get_left_track_limit(scalar s) const { return _track.get_left_track_limit(s) + _dwl; }
 
-    constexpr const scalar get_right_track_limit(scalar s) const { return _track.get_right_track_limit(s); }
+    constexpr const scalar get_right_track_limit(scalar s) const { return _track.get_right_track_limit(s) + _dwr; }
 
     constexpr scalar curvature(const sVector3d& dr, const sVector3d& d2r, const scalar drnorm) const
                                                         { return cross(dr,d2r)[Z]/(drnorm*drnorm*drnorm); } 
@@ -70,6 +73,17 @@ class Road_curvilinear : public Road<Timeseries_t,STATE0,CONTROL0>
 
     void update_track(const scalar t);
 
+    //! Perturb the track limits, used to compute sensitivities with respect to the track geometry
+    //! @param[in] dwl: offset added to the distance to the left track limit
+    //! @param[in] dwr: offset added to the distance to the right track limit
+    void set_track_limits_perturbation(const scalar dwl, const scalar dwr) { _dwl = dwl; _dwr = dwr; }
+
+    //! Perturb the curvature at a set of arclengths, used to compute sensitivities with respect to the track geometry.
+    //! The perturbation is only applied at the exact arclengths given (the mesh points), and it is removed with empty vectors
+    //! @param[in] s: arclengths, sorted
+    //! @param[in] dkappa: curvature perturbation at each arclength
+    void set_curvature_perturbation(const std::vector<scalar>& s, const std::vector<Timeseries_t>& dkappa);
+
  private:
     Track_t _track;     //! [in] Vectorial polynomial with track coordinates
 
@@ -87,6 +101,12 @@ class Road_curvilinear : public Road<Timeseries_t,STATE0,CONTROL0>
     scalar _k;
     scalar _theta;
 
+    scalar _dwl = 0.0;                      //! Perturbation of the left track limit
+    scalar _dwr = 0.0;                      //! Perturbation of the right track limit
+    std::vector<scalar> _s_dkappa;          //! Arclengths where the curvature is perturbed
+    std::vector<Timeseries_t> _dkappa;      //! Curvature perturbations at _s_dkappa
+    Timeseries_t _dk = 0.0;                 //! Curvature perturbation at the current arclength
+
 
     Timeseries_t _time;  //! The simulation time
     Timeseries_t _n;     //! The normal distance to the road centerline
@@ -11,7 +11,8 @@ inline Road_curvilinear<Timeseries_t,Track_t,STATE0,CONTROL0>::Road_curvilinear(
 template<typename Timeseries_t,typename Track_t,size_t STATE0, size_t CONTROL0>
 void Road_curvilinear<Timeseries_t,Track_t,STATE0,CONTROL0>::update(const Timeseries_t u, const Timeseries_t v, const Timeseries_t omega)
 {
-    const Timeseries_t dtimeds = (1.0 - _n*_k)/(u*cos(_alpha) - v*sin(_alpha));
+    const Timeseries_t k = _k + _dk;
+    const Timeseries_t dtimeds = (1.0 - _n*k)/(u*cos(_alpha) - v*sin(_alpha));
 
     base_type::_dtimedt = dtimeds*_drnorm;
 
@@ -22,7 +23,7 @@ void Road_curvilinear<Timeseries_t,Track_t,STATE0,CONTROL0>::update(const Timese
     _dn = u*sin(_alpha) + v*cos(_alpha);
 
     // dalphadtime
-    _dalpha = omega - _k/dtimeds;
+    _dalpha = omega - k/dtimeds;
 }
 
 
@@ -124,5 +125,31 @@ inline void Road_curvilinear<Timeseries_t,Track_t,STATE0,CONTROL0>::update_track
 
     // Curvature
     _k = curvature(_dr,_d2r,_drnorm);
+
+    // Curvature perturbation
+    if ( _s_dkappa.size() > 0 )
+    {
+        const auto it = std::lower_bound(_s_dkappa.cbegin(), _s_dkappa.cend(), t);
+        
+        if ( (it != _s_dkappa.cend()) && (*it == t) )
+            _dk = _dkappa[std::distance(_s_dkappa.cbegin(), it)];
+        else
+            _dk = 0.0;
+    }
+}
+
+
+template<typename Timeseries_t,typename Track_t,size_t STATE0, size_t CONTROL0>
+inline void Road_curvilinear<Timeseries_t,Track_t,STATE0,CONTROL0>::set_curvature_perturbation(const std::vector<scalar>& s, const std::vector<Timeseries_t>& dkappa)
+{
+    if ( s.size() != dkappa.size() )
+        throw fastest_lap_exception("[ERROR] Road_curvilinear::set_curvature_perturbation -> s and dkappa must have the same size");
+
+    if ( !std::is_sorted(s.cbegin(), s.cend()) )
+        throw fastest_lap_exception("[ERROR] Road_curvilinear::set_curvature_perturbation -> s must be sorted");
+
+    _s_dkappa = s;
+    _dkappa   = dkappa;
+    _dk       = 0.0;
 }
 #endif
@@ -2,6 +2,7 @@
 #define __TRACK_RUN_H__
 
 #include <fstream>
+#include <mutex>
 #include "lion/math/polynomial.h"
 #include "lion/propagators/ode45.h"
 
@@ -58,6 +59,9 @@ class Track_run
 
     std::vector<scalar> _max_u;
     std::vector<scalar> _min_u;
+
+    //! The ODE45 options are static: integrations from several threads are serialized
+    inline static std::mutex _ode45_mutex;
 };
 
 #include "track_run.hpp"
@@ -30,6 +30,8 @@ inline std::pair<std::vector<typename DynamicModel_t::Timeseries_type>,std::vect
     set_control_points(_x);
     construct_controls(t_start, t_final);
 
+    std::lock_guard<std::mutex> lock(_ode45_mutex);
+
     ODE45<DynamicModel_t,Polynomial_array<scalar,DynamicModel_t::NCONTROL>,DynamicModel_t::NSTATE>::set("max h",0.02);
     ODE45<DynamicModel_t,Polynomial_array<scalar,DynamicModel_t::NCONTROL>,DynamicModel_t::NSTATE>::set("relative error",1.0e-8);
     ODE45<DynamicModel_t,Polynomial_array<scalar,DynamicModel_t::NCONTROL>,DynamicModel_t::NSTATE>::set("absolute error",1.0e-6);
@@ -69,6 +71,8 @@ inline typename DynamicModel_t::Timeseries_type Track_run<DynamicModel_t>::opera
 template<class DynamicModel_t>
 inline typename DynamicModel_t::Timeseries_type Track_run<DynamicModel_t>::simulate(const double t_start, const double t_final, const double dt, bool write)
 {
+    std::lock_guard<std::mutex> lock(_ode45_mutex);
+
     ODE45<DynamicModel_t,Polynomial_array<scalar,DynamicModel_t::NCONTROL>,DynamicModel_t::NSTATE>::set("max h",0.01);
     ODE45<DynamicModel_t,Polynomial_array<scalar,DynamicModel_t::NCONTROL>,DynamicModel_t::NSTATE>::set("relative error",1.0e-8);
     ODE45<DynamicModel_t,Polynomial_array<scalar,DynamicModel_t::NCONTROL>,DynamicModel_t::NSTATE>::set("absolute error",1.0e-6);
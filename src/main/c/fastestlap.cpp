@@ -0,0 +1,401 @@
+//!      fastestlap: batch command line driver
+//!      -------------------------------------
+//!
+//! Runs a job file without Python: the operations are executed in order through libfastestlapc, and
+//! the results are written to CSV (.csv) or binary (any other extension) files
+//!
+//! Usage: fastestlap job.xml
+//!
+//! Job file example:
+//!      <fastest_lap_job>
+//!          <print_level> 0 </print_level>
+//!          <trace_file> trace.json </trace_file>
+//!          <vehicle>
+//!              <name> car </name>
+//!              <database> ./database/vehicles/f1/ferrari-2022-australia.xml </database>
+//!          </vehicle>
+//!          <track>
+//!              <name> catalunya </name>
+//!              <file> ./database/tracks/catalunya/catalunya_adapted.xml </file>
+//!          </track>
+//!          <circuit_preprocessor>
+//!              <options_file> preprocessor_options.xml </options_file>
+//!          </circuit_preprocessor>
+//!          <vehicle_set_parameter>
+//!              <vehicle> car </vehicle>
+//!              <parameter> vehicle/chassis/mass </parameter>
+//!              <value> 795.0 </value>
+//!          </vehicle_set_parameter>
+//!          <gg_diagram>
+//!              <vehicle> car </vehicle>
+//!              <speeds> 50.0, 70.0 </speeds>
+//!              <n_points> 30 </n_points>
+//!              <output> gg.csv </output>
+//!          </gg_diagram>
+//!          <steady_state_sweep>
+//!              <vehicle> car </vehicle>
+//!              <v> 50.0, 60.0, 70.0 </v>
+//!              <ax> 0.0 </ax>
+//!              <ay> 0.0 </ay>
+//!              <n_threads> 0 </n_threads>
+//!              <output> steady_state.bin </output>
+//!          </steady_state_sweep>
+//!          <optimal_laptime>
+//!              <vehicle> car </vehicle>
+//!              <track> catalunya </track>
+//!              <n_points> 500 </n_points>
+//!              <options_file> optimal_laptime_options.xml </options_file>
+//!              <output> run.csv </output>
+//!          </optimal_laptime>
+//!      </fastest_lap_job>
+//!
+//!  - The options files are given as is to libfastestlapc (see fastestlapc.cpp). For optimal_laptime, the
+//!    variables in options/output_variables are written to the output file. The scalar variables (laptime and
+//!    integral_quantities.*) are written as columns with a constant value
+//!  - steady_state_sweep: v, ax and ay have the same size, or size 1. The points are solved in parallel
+//!  - optimal_laptime: without n_points, the mesh of the track is used
+//!  - Binary outputs are sweep result stores (see src/core/foundation/sweep_result_store.h) with one run, named after
+//!    the operation, whose channels are the columns
+#include "fastestlapc.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include "lion/io/Xml_document.h"
+#include "src/core/foundation/fastest_lap_exception.h"
+#include "src/core/foundation/sweep_result_store.h"
+
+//! A set of named columns with the same number of rows
+struct Output_table
+{
+    std::vector<std::string> names;
+    std::vector<std::vector<double>> columns;
+
+    void add(const std::string& name, const std::vector<double>& column)
+    {
+        if ( (columns.size() > 0) && (column.size() != columns.front().size()) )
+            throw fastest_lap_exception("[ERROR] fastestlap -> column \"" + name + "\" has a different number of rows");
+
+        names.push_back(name);
+        columns.push_back(column);
+    }
+
+    void save(const std::string& file_name, const std::string& run_name) const
+    {
+        const bool is_csv = (file_name.size() >= 4) && (file_name.substr(file_name.size()-4) == ".csv");
+
+        if ( is_csv )
+        {
+            // (1) CSV: header and one line per row
+            std::ofstream file(file_name);
+
+            if ( !file.is_open() )
+                throw fastest_lap_exception("[ERROR] fastestlap -> could not open file \"" + file_name + "\"");
+
+            const size_t n_rows = (columns.size() > 0 ? columns.front().size() : 0);
+
+            for (size_t j = 0; j < names.size(); ++j)
+                file << (j > 0 ? "," : "") << names[j];
+
+            file << std::endl << std::setprecision(17);
+
+            for (size_t i = 0; i < n_rows; ++i)
+            {
+                for (size_t j = 0; j < columns.size(); ++j)
+                    file << (j > 0 ? "," : "") << columns[j][i];
+
+                file << "\n";
+            }
+        }
+        else
+        {
+            // (2) Binary: a sweep result store with one run, one channel per column
+            std::map<std::string,std::vector<scalar>> channels;
+
+            for (size_t j = 0; j < names.size(); ++j)
+            {
+                if ( !channels.insert({names[j], columns[j]}).second )
+                    throw fastest_lap_exception("[ERROR] fastestlap -> column \"" + names[j] + "\" is repeated");
+            }
+
+            Sweep_result_store::Writer store(file_name);
+            store.add_run({run_name, {}, true}, channels);
+            store.close();
+        }
+    }
+};
+
+
+static std::string trim(const std::string& str)
+{
+    const auto first = str.find_first_not_of(" \t\n\r");
+
+    if ( first == std::string::npos )
+        return "";
+
+    return str.substr(first, str.find_last_not_of(" \t\n\r") - first + 1);
+}
+
+
+static std::string read_file(const std::string& file_name)
+{
+    std::ifstream file(file_name);
+
+    if ( !file.is_open() )
+        throw fastest_lap_exception("[ERROR] fastestlap -> could not open file \"" + file_name + "\"");
+
+    std::stringstream s_in;
+    s_in << file.rdbuf();
+    return s_in.str();
+}
+
+
+static std::string get_string(Xml_element& operation, const std::string& name)
+{
+    if ( !operation.has_child(name) )
+        throw fastest_lap_exception("[ERROR] fastestlap -> operation \"" + operation.get_name() + "\" requires \"" + name + "\"");
+
+    return trim(operation.get_child(name).get_value());
+}
+
+
+//! Expand the vectors of size 1 to n
+static std::vector<double> broadcast(const std::vector<double>& v, const size_t n, const std::string& name)
+{
+    if ( v.size() == n )
+        return v;
+    else if ( v.size() == 1 )
+        return std::vector<double>(n, v.front());
+    else
+        throw fastest_lap_exception("[ERROR] fastestlap -> \"" + name + "\" must have size 1 or " + std::to_string(n));
+}
+
+
+//! The optimal_laptime outputs that libfastestlapc stores in the scalar table, the rest are vectors
+static bool is_scalar_output(const std::string& variable_name)
+{
+    return (variable_name == "laptime") || (variable_name.find("integral_quantities.") == 0);
+}
+
+
+static void run_gg_diagram(Xml_element& operation)
+{
+    const std::string vehicle = get_string(operation, "vehicle");
+    const auto speeds = operation.get_child("speeds").get_value(std::vector<double>());
+    const int n_points = operation.get_child("n_points").get_value(int());
+
+    std::vector<double> v, ay, ax_max, ax_min;
+    std::vector<double> ay_i(n_points), ax_max_i(n_points), ax_min_i(n_points);
+
+    for (const double speed : speeds)
+    {
+        gg_diagram(ay_i.data(), ax_max_i.data(), ax_min_i.data(), vehicle.c_str(), speed, n_points);
+
+        v.insert(v.end(), n_points, speed);
+        ay.insert(ay.end(), ay_i.cbegin(), ay_i.cend());
+        ax_max.insert(ax_max.end(), ax_max_i.cbegin(), ax_max_i.cend());
+        ax_min.insert(ax_min.end(), ax_min_i.cbegin(), ax_min_i.cend());
+    }
+
+    Output_table table;
+    table.add("v", v);
+    table.add("ay", ay);
+    table.add("ax_max", ax_max);
+    table.add("ax_min", ax_min);
+    table.save(get_string(operation, "output"), "gg_diagram");
+}
+
+
+static void run_steady_state_sweep(Xml_element& operation)
+{
+    const std::string vehicle = get_string(operation, "vehicle");
+    const auto v_in  = operation.get_child("v").get_value(std::vector<double>());
+    const auto ax_in = operation.get_child("ax").get_value(std::vector<double>());
+    const auto ay_in = operation.get_child("ay").get_value(std::vector<double>());
+    const int n_threads = (operation.has_child("n_threads") ? operation.get_child("n_threads").get_value(int()) : 0);
+
+    // (1) Construct the points
+    const size_t n_points = std::max({v_in.size(), ax_in.size(), ay_in.size()});
+    const auto v  = broadcast(v_in, n_points, "v");
+    const auto ax = broadcast(ax_in, n_points, "ax");
+    const auto ay = broadcast(ay_in, n_points, "ay");
+
+    // (2) Solve
+    int n_state, n_algebraic, n_control;
+    vehicle_get_number_of_variables(&n_state, &n_algebraic, &n_control, vehicle.c_str());
+
+    std::vector<double> q(n_points*n_state), qa(n_points*n_algebraic), u(n_points*n_control);
+    std::unique_ptr<bool[]> success(new bool[n_points]);
+
+    steady_state_batch(q.data(), qa.data(), u.data(), success.get(), vehicle.c_str(), n_points, v.data(), ax.data(), ay.data(), n_threads);
+
+    // (3) Write: one row per point
+    Output_table table;
+    table.add("v", v);
+    table.add("ax", ax);
+    table.add("ay", ay);
+    table.add("success", std::vector<double>(success.get(), success.get() + n_points));
+
+    auto add_columns = [&](const std::string& name, const std::vector<double>& data, const int n)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            std::vector<double> column(n_points);
+            for (size_t i = 0; i < n_points; ++i)
+                column[i] = data[i*n + j];
+
+            table.add(name + std::to_string(j), column);
+        }
+    };
+
+    add_columns("q", q, n_state);
+    add_columns("qa", qa, n_algebraic);
+    add_columns("u", u, n_control);
+
+    table.save(get_string(operation, "output"), "steady_state_sweep");
+}
+
+
+static void run_optimal_laptime(Xml_element& operation)
+{
+    const std::string vehicle = get_string(operation, "vehicle");
+    const std::string track   = get_string(operation, "track");
+    const std::string options = read_file(get_string(operation, "options_file"));
+
+    // (1) Construct the mesh: equally spaced, or the mesh of the track
+    std::vector<double> s;
+
+    if ( operation.has_child("n_points") )
+    {
+        const int n_points = operation.get_child("n_points").get_value(int());
+        const double track_length = track_download_length(track.c_str());
+
+        s.resize(n_points);
+        for (int i = 0; i < n_points; ++i)
+            s[i] = track_length*i/n_points;
+    }
+    else
+    {
+        s.resize(track_download_number_of_points(track.c_str()));
+        track_download_data(s.data(), track.c_str(), s.size(), "arclength");
+    }
+
+    // (2) Solve
+    optimal_laptime(vehicle.c_str(), track.c_str(), s.size(), s.data(), options.c_str());
+
+    // (3) Write the output variables requested in the options, and remove them from the tables
+    if ( !operation.has_child("output") )
+        return;
+
+    Xml_document options_doc;
+    options_doc.parse(options);
+
+    if ( !options_doc.has_element("options/output_variables") )
+        throw fastest_lap_exception("[ERROR] fastestlap -> optimal_laptime with output requires options/output_variables");
+
+    const std::string prefix = trim(options_doc.get_element("options/output_variables/prefix").get_value());
+
+    Output_table table;
+    table.add("arclength", s);
+
+    for (auto& variable : options_doc.get_element("options/output_variables/variables").get_children())
+    {
+        const std::string name = prefix + variable.get_name();
+
+        if ( is_scalar_output(variable.get_name()) )
+        {
+            table.add(variable.get_name(), std::vector<double>(s.size(), download_scalar(name.c_str())));
+        }
+        else
+        {
+            std::vector<double> data(download_vector_size(name.c_str()));
+            download_vector(data.data(), data.size(), name.c_str());
+            table.add(variable.get_name(), data);
+        }
+    }
+
+    table.save(get_string(operation, "output"), "optimal_laptime");
+
+    delete_variables_by_prefix(prefix.c_str());
+}
+
+
+static void run_job(const std::string& job_file_name)
+{
+    Xml_document job(job_file_name, true);
+
+    auto root = job.get_root_element();
+
+    // (1) Global settings
+    if ( root.has_child("print_level") )
+        set_print_level(root.get_child("print_level").get_value(int()));
+
+    const bool trace = root.has_child("trace_file");
+
+    if ( trace )
+        start_tracing(65536);
+
+    // (2) Run the operations in order
+    for (auto& operation : root.get_children())
+    {
+        const std::string name = operation.get_name();
+        const auto start = std::chrono::steady_clock::now();
+
+        if ( (name == "print_level") || (name == "trace_file") )
+            continue;
+        else if ( name == "vehicle" )
+            create_vehicle_from_xml(get_string(operation, "name").c_str(), get_string(operation, "database").c_str());
+        else if ( name == "track" )
+            create_track_from_xml(get_string(operation, "name").c_str(), get_string(operation, "file").c_str());
+        else if ( name == "circuit_preprocessor" )
+            circuit_preprocessor(read_file(get_string(operation, "options_file")).c_str());
+        else if ( name == "vehicle_set_parameter" )
+            vehicle_set_parameter(get_string(operation, "vehicle").c_str(), get_string(operation, "parameter").c_str(),
+                                  operation.get_child("value").get_value(double()));
+        else if ( name == "gg_diagram" )
+            run_gg_diagram(operation);
+        else if ( name == "steady_state_sweep" )
+            run_steady_state_sweep(operation);
+        else if ( name == "optimal_laptime" )
+            run_optimal_laptime(operation);
+        else
+            throw fastest_lap_exception("[ERROR] fastestlap -> unknown operation \"" + name + "\"");
+
+        const std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start;
+        std::cout << "[fastestlap] " << name << ": " << elapsed_time.count() << "s" << std::endl;
+    }
+
+    // (3) Write the timeline
+    if ( trace )
+    {
+        stop_tracing();
+        save_tracing(get_string(root, "trace_file").c_str());
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    if ( (argc != 2) || (std::string(argv[1]) == "--help") || (std::string(argv[1]) == "-h") )
+    {
+        std::cout << "Usage: fastestlap job.xml" << std::endl;
+        std::cout << "       runs the operations of the job file (vehicle, track, circuit_preprocessor, vehicle_set_parameter," << std::endl;
+        std::cout << "       gg_diagram, steady_state_sweep, optimal_laptime) in order. See src/main/c/fastestlap.cpp" << std::endl;
+        return (argc == 2 ? 0 : 1);
+    }
+
+    try
+    {
+        run_job(argv[1]);
+    }
+    catch (std::exception& ex)
+    {
+        std::cerr << "[ERROR] fastestlap -> " << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -2,14 +2,24 @@
 #include <iostream>
 #include <unordered_map>
 #include <algorithm>
+#include <iterator>
 #include <regex>
+#include <limits>
+#include <fstream>
+#include <memory>
+#include <chrono>
 
 #include "src/core/vehicles/lot2016kart.h"
 #include "src/core/vehicles/limebeer2014f1.h"
 #include "src/core/applications/steady_state.h"
 #include "src/core/applications/optimal_laptime.h"
 #include "lion/propagators/crank_nicolson.h"
+#include "src/core/applications/crank_nicolson_propagator.h"
 #include "src/core/foundation/fastest_lap_exception.h"
+#include "src/core/foundation/trace.h"
+#include "src/core/foundation/parallel.h"
+#include "src/core/foundation/dependency_tracker.h"
+#include "src/core/foundation/sweep_result_store.h"
 
 #define CATCH()  catch(fastest_lap_exception& ex) \
  { \
@@ -33,6 +43,7 @@ std::unordered_map<std::string,limebeer2014f1_all>  table_f1_3dof;
 std::unordered_map<std::string,Track_by_polynomial> table_track;
 std::unordered_map<std::string,scalar>              table_scalar;
 std::unordered_map<std::string,std::vector<scalar>> table_vector;
+std::unordered_map<std::string,std::unique_ptr<Sweep_result_store::Writer>> table_sweep_result_store;
 
 
 #ifdef __cplusplus
@@ -58,6 +69,94 @@ Optimal_laptime<typename vehicle_t::vehicle_ad_curvilinear>& get_warm_start()
         throw fastest_lap_exception("[ERROR] get_warm_start() -> vehicle_t is not supported");
 }
 
+// Artefacts derived from a vehicle, reused until one of the parameters they depend on changes (see Dependency_tracker).
+// The steady states of the 3DOF model do not depend on the inertias: all the angular accelerations vanish. The 6DOF 
+// chassis has products of inertia in its cornering equilibrium, so all its parameters are taken as dependencies
+template<typename vehicle_t>
+struct Vehicle_artefacts
+{
+    using Steady_state_solution = typename Steady_state<decltype(vehicle_t::cartesian_ad)>::Solution;
+
+    static bool steady_state_depends_on(const std::string& path)
+    {
+        if constexpr (std::is_same_v<vehicle_t,limebeer2014f1_all>)
+            return (path.find("/inertia") == std::string::npos);
+        else
+            return true;
+    }
+
+    Artefact_cache<scalar,Steady_state_solution> steady_state{steady_state_depends_on};   //! Steady state at 0g, by speed
+    Artefact_cache<std::pair<scalar,int>,std::array<std::vector<scalar>,3>> gg_diagram{steady_state_depends_on};   //! {ay, ax_max, ax_min}, by speed and n_points
+
+    // Propagators that keep their Jacobian between calls to propagate_vehicle, by track name (empty for cartesian)
+    Artefact_cache<std::string,std::shared_ptr<Crank_nicolson_propagator<decltype(vehicle_t::cartesian_ad)>>> propagator_cartesian;
+    Artefact_cache<std::string,std::shared_ptr<Crank_nicolson_propagator<decltype(vehicle_t::curvilinear_ad)>>> propagator_curvilinear;
+};
+
+
+// Artefacts of all the vehicles of a type, by the id of their dependency tracker
+template<typename vehicle_t>
+std::unordered_map<size_t,Vehicle_artefacts<vehicle_t>>& get_artefacts_table()
+{
+    static std::unordered_map<size_t,Vehicle_artefacts<vehicle_t>> table_artefacts;
+    return table_artefacts;
+}
+
+
+template<typename vehicle_t>
+Vehicle_artefacts<vehicle_t>& get_artefacts(const vehicle_t& vehicle)
+{
+    return get_artefacts_table<vehicle_t>()[vehicle.dependencies.get_id()];
+}
+
+
+#ifdef __cplusplus
+// Number of artefacts computed and reused by the cache of a vehicle ("steady_state", "gg_diagram", "propagator_cartesian"
+// or "propagator_curvilinear")
+fastestlapc_API std::pair<size_t,size_t> get_artefacts_statistics(const std::string& vehicle_name, const std::string& artefact)
+{
+    auto statistics = [&](auto& artefacts) -> std::pair<size_t,size_t>
+    {
+        if ( artefact == "steady_state" )
+            return {artefacts.steady_state.get_n_computations(), artefacts.steady_state.get_n_hits()};
+        else if ( artefact == "gg_diagram" )
+            return {artefacts.gg_diagram.get_n_computations(), artefacts.gg_diagram.get_n_hits()};
+        else if ( artefact == "propagator_cartesian" )
+            return {artefacts.propagator_cartesian.get_n_computations(), artefacts.propagator_cartesian.get_n_hits()};
+        else if ( artefact == "propagator_curvilinear" )
+            return {artefacts.propagator_curvilinear.get_n_computations(), artefacts.propagator_curvilinear.get_n_hits()};
+        else
+            throw fastest_lap_exception("[ERROR] get_artefacts_statistics -> artefact \"" + artefact + "\" is not recognized");
+    };
+
+    if ( table_f1_3dof.count(vehicle_name) != 0 )
+        return statistics(get_artefacts(table_f1_3dof.at(vehicle_name)));
+    else if ( table_kart_6dof.count(vehicle_name) != 0 )
+        return statistics(get_artefacts(table_kart_6dof.at(vehicle_name)));
+    else
+        throw fastest_lap_exception("[ERROR] get_artefacts_statistics -> vehicle \"" + vehicle_name + "\" does not exist");
+}
+#endif
+
+
+// Release the artefacts of the vehicles that have been deleted
+void release_unused_artefacts()
+{
+    auto release = [](auto& table_artefacts, const auto& table_vehicles)
+    {
+        for (auto it = table_artefacts.begin(); it != table_artefacts.end(); )
+        {
+            const bool exists = std::any_of(table_vehicles.cbegin(), table_vehicles.cend(), 
+                [&](const auto& vehicle) { return vehicle.second.dependencies.get_id() == it->first; });
+
+            it = (exists ? std::next(it) : table_artefacts.erase(it));
+        }
+    };
+
+    release(get_artefacts_table<limebeer2014f1_all>(), table_f1_3dof);
+    release(get_artefacts_table<lot2016kart_all>(), table_kart_6dof);
+}
+
 
 void check_variable_exists_in_tables(const std::string& name)
 {
@@ -88,10 +187,92 @@ void set_print_level(int print_level)
 }
 
 
+void start_tracing(const int events_per_thread)
+{
+ try
+ {
+    if ( events_per_thread <= 0 )
+        throw fastest_lap_exception("[ERROR] start_tracing -> events_per_thread must be positive");
+
+    Trace::enable(events_per_thread);
+ }
+ CATCH()
+}
+
+
+void stop_tracing()
+{
+ try
+ {
+    Trace::disable();
+ }
+ CATCH()
+}
+
+
+void clear_tracing()
+{
+ try
+ {
+    Trace::clear();
+ }
+ CATCH()
+}
+
+
+void save_tracing(const char* file_name)
+{
+ try
+ {
+    Trace::save(file_name);
+ }
+ CATCH()
+}
+
+
+void sweep_result_store_open(const char* c_store_name, const char* file_name, const int chunk_size)
+{
+ try
+ {
+    const std::string store_name(c_store_name);
+
+    if ( table_sweep_result_store.count(store_name) != 0 )
+        throw fastest_lap_exception("[ERROR] sweep_result_store_open -> store \"" + store_name + "\" is already open");
+
+    if ( chunk_size <= 0 )
+        throw fastest_lap_exception("[ERROR] sweep_result_store_open -> chunk_size must be positive");
+
+    table_sweep_result_store.insert({store_name, std::make_unique<Sweep_result_store::Writer>(file_name, chunk_size)});
+ }
+ CATCH()
+}
+
+
+void sweep_result_store_close(const char* c_store_name)
+{
+ try
+ {
+    const std::string store_name(c_store_name);
+
+    if ( table_sweep_result_store.count(store_name) == 0 )
+        throw fastest_lap_exception("[ERROR] sweep_result_store_close -> store \"" + store_name + "\" is not open");
+
+    // Remove the store from the table first: it is released even if writing the index fails
+    auto store = std::move(table_sweep_result_store.at(store_name));
+    table_sweep_result_store.erase(store_name);
+
+    store->close();
+ }
+ CATCH()
+}
+
+
 void create_vehicle_from_xml(const char* vehicle_name, const char* database_file)
 {
  try
  {
+    FASTEST_LAP_TRACE_SCOPE("create_vehicle_from_xml");
+
     const std::string s_database = database_file;
     const std::string s_name = vehicle_name;
 
@@ -165,6 +346,8 @@ void create_track_from_xml(const char* name, const char* track_file)
 {
  try
  {
+    FASTEST_LAP_TRACE_SCOPE("create_track_from_xml");
+
     out(2) << "[INFO] Fastest-lap API -> [start] create track" << std::endl;
 
     // (1) Check that the track does not exists in the map
@@ -270,6 +453,8 @@ void move_variable(const char* c_old_name, const char* c_new_name)
     {
         throw fastest_lap_exception("[ERROR] copy_variable -> variable \"" + old_name + "\" does not exist");
     }
+
+    release_unused_artefacts();
  }
  CATCH()
 }
@@ -667,6 +852,31 @@ void vehicle_save_as_xml(const char* c_vehicle_name, const char* file_name)
 }
 
 
+void vehicle_get_number_of_variables(int* n_state, int* n_algebraic, int* n_control, const char* c_vehicle_name)
+{
+ try
+ {
+    const std::string vehicle_name(c_vehicle_name);
+
+    auto get_sizes = [&](const auto& car)
+    {
+        using vehicle_t = std::decay_t<decltype(car)>;
+        *n_state     = vehicle_t::NSTATE;
+        *n_algebraic = vehicle_t::NALGEBRAIC;
+        *n_control   = vehicle_t::NCONTROL;
+    };
+
+    if ( table_kart_6dof.count(vehicle_name) != 0 )
+        get_sizes(table_kart_6dof.at(vehicle_name).cartesian_ad);
+    else if ( table_f1_3dof.count(vehicle_name) != 0 )
+        get_sizes(table_f1_3dof.at(vehicle_name).cartesian_ad);
+    else
+        throw fastest_lap_exception("[ERROR] vehicle_get_number_of_variables -> vehicle \"" + vehicle_name + "\" does not exist");
+ }
+ CATCH()
+}
+
+
 int track_download_number_of_points(const char* track_name_c)
 {
  try
@@ -912,6 +1122,8 @@ void delete_variables()
     table_track.clear();
     table_scalar.clear();
     table_vector.clear();
+
+    release_unused_artefacts();
  }
  CATCH()
 }
@@ -956,6 +1168,8 @@ void delete_variable(const char* c_variable_name)
     {
         throw fastest_lap_exception("[ERROR] delete_variable -> variable \"" + variable_name + "\" has not been defined");
     }
+
+    release_unused_artefacts();
  }
  CATCH()
 }
@@ -988,6 +1202,8 @@ void delete_variables_by_prefix(const char* prefix_c)
     delete_variable_by_prefix_generic(table_kart_6dof, prefix);
     delete_variable_by_prefix_generic(table_f1_3dof, prefix);
     delete_variable_by_prefix_generic(table_track, prefix);
+
+    release_unused_artefacts();
  }
  CATCH()
 }
@@ -1079,8 +1295,9 @@ void vehicle_equations(double* dqdt, double* dqa, double** jac_dqdt, double** ja
 }
 
 
-template<typename Vehicle_t>
-void compute_propagation(Vehicle_t car, double* c_q, double* c_qa, double* c_u, double s, double ds, double* c_u_next, const char* c_options)
+template<typename Vehicle_t, typename Propagator_cache_t>
+void compute_propagation(Vehicle_t car, const Dependency_tracker& dependencies, Propagator_cache_t& propagators, const std::string& track_name, 
+    double* c_q, double* c_qa, double* c_u, double s, double ds, double* c_u_next, const char* c_options)
 {
     // (1) Construct Cpp version of the C inputs
     std::array<scalar,Vehicle_t::NSTATE> q;
@@ -1105,6 +1322,48 @@ void compute_propagation(Vehicle_t car, double* c_q, double* c_qa, double* c_u,
         if ( doc.has_element("options/max_iter") )          opts.max_iter = doc.get_element("options/max_iter").get_value(scalar());
         if ( doc.has_element("options/error_tolerance") )   opts.error_tolerance = doc.get_element("options/error_tolerance").get_value(scalar());
         if ( doc.has_element("options/relaxation_factor") ) opts.relaxation_factor = doc.get_element("options/relaxation_factor").get_value(scalar());
+
+        // (2.1) Jacobian mode: "newton", "frozen", "reuse" or "broyden". If given, the step is taken by a Crank_nicolson_propagator
+        //       stored with the vehicle, so that the Jacobian can be kept from one call to the next
+        if ( doc.has_element("options/jacobian_mode") )
+        {
+            using Propagator_t = Crank_nicolson_propagator<Vehicle_t>;
+
+            const std::string mode = doc.get_element("options/jacobian_mode").get_value();
+            typename Propagator_t::Options propagator_options;
+
+            if ( mode == "newton" )       propagator_options.jacobian_mode = Propagator_t::NEWTON;
+            else if ( mode == "frozen" )  propagator_options.jacobian_mode = Propagator_t::FROZEN;
+            else if ( mode == "reuse" )   propagator_options.jacobian_mode = Propagator_t::REUSE;
+            else if ( mode == "broyden" ) propagator_options.jacobian_mode = Propagator_t::BROYDEN;
+            else
+                throw fastest_lap_exception("[ERROR] propagate_vehicle -> jacobian_mode \"" + mode + "\" is not recognized. Options are: newton, frozen, reuse, broyden");
+
+            propagator_options.sigma             = opts.sigma;
+            propagator_options.max_iter          = opts.max_iter;
+            propagator_options.error_tolerance   = opts.error_tolerance;
+            propagator_options.relaxation_factor = opts.relaxation_factor;
+
+            if ( doc.has_element("options/maximum_jacobian_age") ) 
+            {
+                const int maximum_jacobian_age = doc.get_element("options/maximum_jacobian_age").get_value(int());
+
+                if ( maximum_jacobian_age < 0 )
+                    throw fastest_lap_exception("[ERROR] propagate_vehicle -> maximum_jacobian_age must be non-negative");
+
+                propagator_options.maximum_jacobian_age = maximum_jacobian_age;
+            }
+
+            // (2.2) Take the step with the stored propagator. It is discarded if any parameter of the vehicle changes
+            auto& propagator = *propagators.get(dependencies, track_name, []() { return std::make_shared<Propagator_t>(); });
+
+            propagator.set_options(propagator_options);
+            propagator.take_step(car, u, u_next, q, qa, s, ds);
+
+            std::copy_n(q.begin(), Vehicle_t::NSTATE, c_q);
+            std::copy_n(qa.begin(), Vehicle_t::NALGEBRAIC, c_qa);
+            return;
+        }
     }
 
     // (3) Take step
@@ -1120,32 +1379,38 @@ void propagate_vehicle(double* q, double* qa, double* u, const char* c_vehicle_n
 {
  try
  {
+    FASTEST_LAP_TRACE_SCOPE("propagate_vehicle");
+
     const std::string vehicle_name(c_vehicle_name);
     const std::string track_name(c_track_name);
     if ( table_kart_6dof.count(vehicle_name) != 0 )
     {
+        auto& vehicle = table_kart_6dof.at(vehicle_name);
+
         if ( use_circuit )
         {
-            table_kart_6dof.at(vehicle_name).curvilinear_ad.get_road().change_track(table_track.at(track_name));
-            table_kart_6dof.at(vehicle_name).curvilinear_scalar.get_road().change_track(table_track.at(track_name));
-            compute_propagation(table_kart_6dof.at(vehicle_name).curvilinear_ad, q, qa, u, s, ds, u_next, options);
+            vehicle.curvilinear_ad.get_road().change_track(table_track.at(track_name));
+            vehicle.curvilinear_scalar.get_road().change_track(table_track.at(track_name));
+            compute_propagation(vehicle.curvilinear_ad, vehicle.dependencies, get_artefacts(vehicle).propagator_curvilinear, track_name, q, qa, u, s, ds, u_next, options);
         }
         else
         {
-            compute_propagation(table_kart_6dof.at(vehicle_name).cartesian_ad, q, qa, u, s, ds, u_next, options);
+            compute_propagation(vehicle.cartesian_ad, vehicle.dependencies, get_artefacts(vehicle).propagator_cartesian, "", q, qa, u, s, ds, u_next, options);
         }
     }
     else if ( table_f1_3dof.count(vehicle_name) != 0 )
     {
+        auto& vehicle = table_f1_3dof.at(vehicle_name);
+
         if ( use_circuit )
         {
-            table_f1_3dof.at(vehicle_name).curvilinear_ad.get_road().change_track(table_track.at(track_name));
-            table_f1_3dof.at(vehicle_name).curvilinear_scalar.get_road().change_track(table_track.at(track_name));
-            compute_propagation(table_f1_3dof.at(vehicle_name).curvilinear_ad, q, qa, u, s, ds, u_next, options);
+            vehicle.curvilinear_ad.get_road().change_track(table_track.at(track_name));
+            vehicle.curvilinear_scalar.get_road().change_track(table_track.at(track_name));
+            compute_propagation(vehicle.curvilinear_ad, vehicle.dependencies, get_artefacts(vehicle).propagator_curvilinear, track_name, q, qa, u, s, ds, u_next, options);
         }
         else
         {
-            compute_propagation(table_f1_3dof.at(vehicle_name).cartesian_ad, q, qa, u, s, ds, u_next, options);
+            compute_propagation(vehicle.cartesian_ad, vehicle.dependencies, get_artefacts(vehicle).propagator_cartesian, "", q, qa, u, s, ds, u_next, options);
         }
     }
  }
@@ -1154,17 +1419,117 @@ void propagate_vehicle(double* q, double* qa, double* u, const char* c_vehicle_n
 
 
 template<typename vehicle_t>
-void compute_gg_diagram(vehicle_t& car, double* ay, double* ax_max, double* ax_min, double v, const int n_points)
+void compute_steady_state_batch(vehicle_t& car, double* q, double* qa, double* u, bool* success, const int n_points, 
+                                const double* v, const double* ax, const double* ay, const int n_threads)
+{
+    const size_t n = n_points;
+
+    // (1) Split the points in contiguous chunks, one per thread. Inside a chunk, every point is warm started from the previous one,
+    //     so neighbouring points should be given close to each other
+    const size_t n_chunks = std::min(n, (n_threads > 0 ? static_cast<size_t>(n_threads) : Parallel::default_number_of_threads()));
+
+    Parallel::for_each(n_chunks, n_chunks, [&](const size_t chunk)
+    {
+        // (1.1) Each thread works with its own copy of the vehicle
+        vehicle_t car_chunk = car;
+        Steady_state ss(car_chunk);
+
+        std::vector<scalar> x0;
+
+        for (size_t i = (chunk*n)/n_chunks; i < ((chunk+1)*n)/n_chunks; ++i)
+        {
+            typename Steady_state<vehicle_t>::Solution solution;
+            solution.solved = false;
+
+            // (1.2) Warm start from the previous point
+            if ( x0.size() > 0 )
+            {
+                try { solution = ss.solve(v[i], ax[i], ay[i], 1, true, x0, false); }
+                catch (const std::exception&) { solution.solved = false; }
+            }
+
+            // (1.3) If there was no previous point, or the warm start failed, start from the default initial point
+            if ( !solution.solved )
+            {
+                try { solution = ss.solve(v[i], ax[i], ay[i], 20, false, {}, false); }
+                catch (const std::exception&) { solution.solved = false; }
+            }
+
+            success[i] = solution.solved;
+
+            if ( solution.solved )
+            {
+                std::copy(solution.q.cbegin(), solution.q.cend(), q + i*vehicle_t::NSTATE);
+                std::copy(solution.qa.cbegin(), solution.qa.cend(), qa + i*vehicle_t::NALGEBRAIC);
+                std::copy(solution.u.cbegin(), solution.u.cend(), u + i*vehicle_t::NCONTROL);
+
+                x0 = vehicle_t::get_x(solution.q, solution.qa, solution.u, v[i]);
+            }
+            else
+            {
+                std::fill_n(q + i*vehicle_t::NSTATE, vehicle_t::NSTATE, std::numeric_limits<double>::quiet_NaN());
+                std::fill_n(qa + i*vehicle_t::NALGEBRAIC, vehicle_t::NALGEBRAIC, std::numeric_limits<double>::quiet_NaN());
+                std::fill_n(u + i*vehicle_t::NCONTROL, vehicle_t::NCONTROL, std::numeric_limits<double>::quiet_NaN());
+
+                x0.clear();
+            }
+        }
+    });
+}
+
+
+void steady_state_batch(double* q, double* qa, double* u, bool* success, const char* c_vehicle_name, const int n_points, 
+                        const double* v, const double* ax, const double* ay, const int n_threads)
 {
-    Steady_state ss(car);
-    auto [sol_max, sol_min] = ss.gg_diagram(v,n_points);
+ try
+ {
+    FASTEST_LAP_TRACE_SCOPE("steady_state_batch");
+
+    if ( n_points <= 0 )
+        throw fastest_lap_exception("[ERROR] steady_state_batch -> n_points must be positive");
 
-    for (int i = 0; i < n_points; ++i)
+    const std::string vehicle_name(c_vehicle_name);
+    if ( table_kart_6dof.count(vehicle_name) != 0 )
+    {
+        compute_steady_state_batch(table_kart_6dof.at(vehicle_name).cartesian_ad, q, qa, u, success, n_points, v, ax, ay, n_threads);
+    }
+    else if ( table_f1_3dof.count(vehicle_name) != 0 )
+    {
+        compute_steady_state_batch(table_f1_3dof.at(vehicle_name).cartesian_ad, q, qa, u, success, n_points, v, ax, ay, n_threads);
+    }
+    else
     {
-        ay[i] = sol_max[i].ay;
-        ax_max[i] = sol_max[i].ax;
-        ax_min[i] = sol_min[i].ax;
+        throw fastest_lap_exception("[ERROR] steady_state_batch -> vehicle \"" + vehicle_name + "\" does not exist");
     }
+ }
+ CATCH()
+}
+
+
+template<typename vehicle_t>
+void compute_gg_diagram(vehicle_t& vehicle, double* ay, double* ax_max, double* ax_min, double v, const int n_points)
+{
+    // (1) Compute the diagram, or reuse it if none of the parameters it depends on changed
+    const auto& diagram = get_artefacts(vehicle).gg_diagram.get(vehicle.dependencies, {v, n_points}, [&]()
+    {
+        Steady_state ss(vehicle.cartesian_ad);
+        auto [sol_max, sol_min] = ss.gg_diagram(v,n_points);
+
+        std::array<std::vector<scalar>,3> result;
+        for (int i = 0; i < n_points; ++i)
+        {
+            result[0].push_back(sol_max[i].ay);
+            result[1].push_back(sol_max[i].ax);
+            result[2].push_back(sol_min[i].ax);
+        }
+
+        return result;
+    });
+
+    // (2) Copy to the outputs
+    std::copy(diagram[0].cbegin(), diagram[0].cend(), ay);
+    std::copy(diagram[1].cbegin(), diagram[1].cend(), ax_max);
+    std::copy(diagram[2].cbegin(), diagram[2].cend(), ax_min);
 }
 
 
@@ -1172,14 +1537,16 @@ void gg_diagram(double* ay, double* ax_max, double* ax_min, const char* c_vehicl
 {
  try
  {
+    FASTEST_LAP_TRACE_SCOPE("gg_diagram");
+
     const std::string vehicle_name(c_vehicle_name);
     if ( table_kart_6dof.count(vehicle_name) != 0 )
     {
-        compute_gg_diagram(table_kart_6dof.at(vehicle_name).cartesian_ad, ay, ax_max, ax_min, v, n_points);
+        compute_gg_diagram(table_kart_6dof.at(vehicle_name), ay, ax_max, ax_min, v, n_points);
     }
     else if ( table_f1_3dof.count(vehicle_name) != 0 )
     {
-        compute_gg_diagram(table_f1_3dof.at(vehicle_name).cartesian_ad, ay, ax_max, ax_min, v, n_points);
+        compute_gg_diagram(table_f1_3dof.at(vehicle_name), ay, ax_max, ax_min, v, n_points);
     }
  }
  CATCH()
@@ -1199,6 +1566,23 @@ struct Optimal_laptime_configuration
     //          <print_level> 5 </print_level>
     //          <initial_speed> 50.0 </initial_speed>
     //          <sigma> 0.5 </sigma>
+    //          <automatic_scaling> false </automatic_scaling>
+    //          <quasi_steady_slip> false </quasi_steady_slip>
+    //          <compute_sensitivity> true </compute_sensitivity>
+    //          <sensitivity_chunk_size> 50 </sensitivity_chunk_size>
+    //          <sensitivity_file> sensitivities.flsweep </sensitivity_file>
+    //          <sweep_result_store>
+    //              <name> sweep </name>
+    //              <run_name> mass-795 </run_name>
+    //              <parameters>
+    //                  <mass> 795.0 </mass>
+    //              </parameters>
+    //          </sweep_result_store>
+    //          <multilevel_coarsening> 8, 2 </multilevel_coarsening>
+    //          <recovery_strategies>
+    //              <restart-adaptive-mu/>
+    //              <coarse-mesh/>
+    //          </recovery_strategies>
     //          <integral_constraints>
     //              <variable_name>
     //                  <lower_bound/>
@@ -1289,6 +1673,58 @@ struct Optimal_laptime_configuration
 
         if ( doc.has_element("options/compute_sensitivity") ) compute_sensitivity = doc.get_element("options/compute_sensitivity").get_value(bool());
 
+        // Sensitivities are computed by chunks of parameters, and streamed to a file instead of stored in the tables
+        if ( doc.has_element("options/sensitivity_chunk_size") ) 
+            sensitivity_chunk_size = doc.get_element("options/sensitivity_chunk_size").get_value(int());
+
+        if ( doc.has_element("options/sensitivity_file") ) sensitivity_file = doc.get_element("options/sensitivity_file").get_value();
+
+        // Append the output variables as a run of an open sweep result store (see sweep_result_store_open)
+        if ( doc.has_element("options/sweep_result_store") )
+        {
+            sweep_result_store = doc.get_element("options/sweep_result_store/name").get_value();
+            sweep_run_name     = doc.get_element("options/sweep_result_store/run_name").get_value();
+
+            if ( doc.has_element("options/sweep_result_store/parameters") )
+            {
+                for (auto& parameter : doc.get_element("options/sweep_result_store/parameters").get_children())
+                    sweep_parameters[parameter.get_name()] = parameter.get_value(scalar());
+            }
+        }
+
+        if ( doc.has_element("options/automatic_scaling") ) automatic_scaling = doc.get_element("options/automatic_scaling").get_value(bool());
+
+        if ( doc.has_element("options/quasi_steady_slip") ) quasi_steady_slip = doc.get_element("options/quasi_steady_slip").get_value(bool());
+
+        // Recovery strategies, tried in the given order if the optimization fails
+        if ( doc.has_element("options/recovery_strategies") )
+        {
+            using Optimal_laptime_t = Optimal_laptime<typename vehicle_t::vehicle_ad_curvilinear>;
+
+            for (auto& strategy : doc.get_element("options/recovery_strategies").get_children())
+            {
+                if ( strategy.get_name() == "restart-adaptive-mu" )
+                    recovery_strategies.push_back(Optimal_laptime_t::RESTART_ADAPTIVE_MU);
+                else if ( strategy.get_name() == "switch-formulation" )
+                    recovery_strategies.push_back(Optimal_laptime_t::SWITCH_FORMULATION);
+                else if ( strategy.get_name() == "coarse-mesh" )
+                    recovery_strategies.push_back(Optimal_laptime_t::COARSE_MESH);
+                else if ( strategy.get_name() == "relax-tolerances" )
+                    recovery_strategies.push_back(Optimal_laptime_t::RELAX_TOLERANCES);
+                else
+                    throw fastest_lap_exception("[ERROR] Recovery strategy \"" + strategy.get_name() + "\" not recognized. Options are: "
+                        "restart-adaptive-mu, switch-formulation, coarse-mesh, relax-tolerances");
+            }
+        }
+
+        // Multilevel: coarsening factors of the meshes solved first to construct the initial guess
+        if ( doc.has_element("options/multilevel_coarsening") ) 
+        {
+            const auto coarsening = doc.get_element("options/multilevel_coarsening").get_value(std::vector<scalar>());
+            std::transform(coarsening.cbegin(), coarsening.cend(), std::back_inserter(multilevel_coarsening), 
+                [](const auto& c) -> auto { return static_cast<size_t>(c); });
+        }
+
         // Prepare control variables
         if ( doc.has_element("options/control_variables") )
         {
@@ -1358,10 +1794,19 @@ struct Optimal_laptime_configuration
     bool is_closed                    = true;                   // Compute closed simulation
     bool set_initial_condition        = false;                  // If an initial condition has to be set
     bool compute_sensitivity          = false;                  // To compute sensitivity w.r.t. parameters
+    size_t sensitivity_chunk_size     = 0;                      // Parameters per sensitivity analysis (0: all at once)
+    std::string sensitivity_file      = "";                     // If given, stream the sensitivities to this sweep result store
+    std::string sweep_result_store    = "";                     // If given, append the output variables to this store
+    std::string sweep_run_name        = "";                     // Name of the run in the sweep result store
+    std::map<std::string,scalar> sweep_parameters{};            // Values of the swept parameters, stored with the run
     scalar sigma                      = 0.5;                    // Scheme used (0.5:Crank Nicolson, 1.0:Implicit Euler)
     std::string output_variables_prefix = "run/";                 // Prefix used to save the variables in the table
     std::vector<std::string> variables_to_save{};               // Variables chosen to be saved
     std::vector<std::tuple<std::string,scalar,scalar>> integral_constraints;
+    bool automatic_scaling            = false;                  // Use the automatic scaling of the NLP
+    bool quasi_steady_slip            = false;                  // Solve the tire longitudinal slips from the wheel torque balance
+    std::vector<size_t> multilevel_coarsening{};                // Coarsening factors of the multilevel initial guess
+    std::vector<typename Optimal_laptime<typename vehicle_t::vehicle_ad_curvilinear>::Recovery_strategy> recovery_strategies{};
 
     // Control variables definition
     std::array<std::string,vehicle_t::vehicle_ad_curvilinear::NCONTROL> control_type = get_default_control_types();
@@ -1455,6 +1900,73 @@ typename Optimal_laptime<typename vehicle_t::vehicle_ad_curvilinear>::template C
 } 
 
 
+//! Stream the sensitivities of an optimal laptime to a sweep result store (see sweep_result_store.h): one run per parameter,
+//! named after its alias and written as soon as the parameter is computed, with one channel per state, algebraic state,
+//! and full mesh control, and the channel "laptime" with one value (e.g. the derivative of "u" w.r.t. "mass" is the channel
+//! "u" of the run "mass")
+template<typename Dynamic_model_t>
+class Sensitivity_file_writer
+{
+ public:
+    using Parameter_sensitivity = typename Optimal_laptime<Dynamic_model_t>::Parameter_sensitivity;
+
+    Sensitivity_file_writer(const std::string& file_name, const std::vector<std::string>& parameter_aliases)
+    : _store(std::make_shared<Sweep_result_store::Writer>(file_name)), _parameter_aliases(parameter_aliases)
+    {}
+
+    void operator()(const size_t i_parameter, const Parameter_sensitivity& sensitivity)
+    {
+        const auto names = Dynamic_model_t::get_state_and_control_names();
+        const auto& q_names  = std::get<1>(names);
+        const auto& qa_names = std::get<2>(names);
+        const auto& u_names  = std::get<3>(names);
+
+        // (1) Construct the channels of this parameter
+        const size_t n_rows = sensitivity.dqdp.size();
+        std::map<std::string,std::vector<scalar>> channels;
+
+        for (size_t j = 0; j < Dynamic_model_t::NSTATE; ++j)
+        {
+            auto& channel = channels[q_names[j]];
+            channel.resize(n_rows);
+
+            for (size_t i = 0; i < n_rows; ++i)
+                channel[i] = sensitivity.dqdp[i][j];
+        }
+
+        for (size_t j = 0; j < Dynamic_model_t::NALGEBRAIC; ++j)
+        {
+            auto& channel = channels[qa_names[j]];
+            channel.resize(n_rows);
+
+            for (size_t i = 0; i < n_rows; ++i)
+                channel[i] = sensitivity.dqadp[i][j];
+        }
+
+        for (size_t j = 0; j < Dynamic_model_t::NCONTROL; ++j)
+            if ( sensitivity.dcontrol_variablesdp[j].optimal_control_type == Optimal_laptime<Dynamic_model_t>::FULL_MESH )
+                channels[u_names[j]] = sensitivity.dcontrol_variablesdp[j].u;
+
+        channels["laptime"] = {sensitivity.dlaptimedp};
+
+        // (2) Append the run
+        Sweep_result_store::Run_metadata metadata;
+        metadata.name    = _parameter_aliases.at(i_parameter);
+        metadata.success = true;
+
+        _store->add_run(metadata, channels);
+
+        // (3) Close the store after the last parameter
+        if ( i_parameter + 1 == _parameter_aliases.size() )
+            _store->close();
+    }
+
+ private:
+    std::shared_ptr<Sweep_result_store::Writer> _store;   //! Shared: the writer is copied into the Optimal_laptime options
+    std::vector<std::string> _parameter_aliases;
+};
+
+
 template<typename vehicle_t>
 void compute_optimal_laptime(vehicle_t& vehicle, Track_by_polynomial& track, const int n_points, const double* s, const char* options)
 {
@@ -1466,16 +1978,18 @@ void compute_optimal_laptime(vehicle_t& vehicle, Track_by_polynomial& track, con
 
     // (2) Process options
     auto conf = Optimal_laptime_configuration<vehicle_t>(options);
+
+    if ( (conf.sweep_result_store.size() > 0) && (table_sweep_result_store.count(conf.sweep_result_store) == 0) )
+        throw fastest_lap_exception("[ERROR] optimal_laptime -> sweep result store \"" + conf.sweep_result_store + "\" is not open");
    
     // (3) Set the track into the curvilinear car dynamic model
     car_curv.get_road().change_track(track);
     car_curv_sc.get_road().change_track(track);
 
-    // (4) Start from the steady-state values at 0g    
+    // (4) Start from the steady-state values at 0g. They are reused while the parameters they depend on do not change
     scalar v = conf.steady_state_speed*KMH;
 
-    Steady_state ss_ = Steady_state(car_cart);
-    auto ss = ss_.solve(v,0.0,0.0); 
+    auto ss = get_artefacts(vehicle).steady_state.get(vehicle.dependencies, v, [&]() { return Steady_state(car_cart).solve(v,0.0,0.0); });
 
     if constexpr (std::is_same_v<vehicle_t,lot2016kart_all>)
         ss.u[1] = 0.0;
@@ -1491,6 +2005,28 @@ void compute_optimal_laptime(vehicle_t& vehicle, Track_by_polynomial& track, con
     opts.print_level      = conf.print_level;
     opts.sigma            = conf.sigma;
     opts.check_optimality = conf.compute_sensitivity;
+    opts.sensitivity_chunk_size = conf.sensitivity_chunk_size;
+
+    if ( conf.compute_sensitivity && (conf.sensitivity_file.size() > 0) )
+    {
+        const auto& car_curv_sc_const = car_curv_sc;
+        opts.sensitivity_callback = Sensitivity_file_writer<typename vehicle_t::vehicle_ad_curvilinear>(conf.sensitivity_file, 
+            car_curv_sc_const.get_parameters().get_all_parameters_aliases());
+    }
+
+    // The derivatives of the output variables are only available if they were not streamed
+    const bool store_derivatives = opts.check_optimality && !opts.sensitivity_callback;
+    opts.automatic_scaling = conf.automatic_scaling;
+    opts.quasi_steady_slip = conf.quasi_steady_slip;
+    opts.multilevel_coarsening = conf.multilevel_coarsening;
+    opts.recovery_strategies = conf.recovery_strategies;
+
+    // (5.2.1) Outputs retained. The output variables are evaluated from the solution with the scalar vehicle (most of them 
+    //         are derived quantities, not states or controls, so they cannot be taken from Output_specification::channels), 
+    //         so the solution is always kept. The coordinates and the optimization data are only needed for the xml file 
+    //         and the warm start
+    opts.output.coordinates       = conf.write_xml || conf.save_warm_start;
+    opts.output.optimization_data = conf.write_xml || conf.save_warm_start;
 
     for (auto& integral_constraint : conf.integral_constraints)
     {
@@ -1500,6 +2036,8 @@ void compute_optimal_laptime(vehicle_t& vehicle, Track_by_polynomial& track, con
     }
     
 
+    const auto start = std::chrono::steady_clock::now();
+
     // (5.2.a) Start from steady-state
     if ( !conf.warm_start )
     {
@@ -1533,13 +2071,17 @@ void compute_optimal_laptime(vehicle_t& vehicle, Track_by_polynomial& track, con
                         get_warm_start<vehicle_t>().optimization_data.lambda, opts);
     }
 
+    const std::chrono::duration<scalar> elapsed_time = std::chrono::steady_clock::now() - start;
+
     // (6) Save results -----------------------------------------------------------------------
 
     // (6.1) Save xml file
     if ( conf.write_xml )
         opt_laptime.xml()->save(conf.xml_file_name);
 
-    // (6.2) Save outputs
+    // (6.2) Save outputs. With a sweep result store, they are also its channels
+    std::map<std::string,std::vector<scalar>> sweep_channels = {{"arclength", arclength}};
+
     for (const auto& variable_name : conf.variables_to_save)
     {
         // Check if the variable_name exists in any of the tables
@@ -1591,6 +2133,7 @@ void compute_optimal_laptime(vehicle_t& vehicle, Track_by_polynomial& track, con
             const size_t index = std::distance(vehicle_t::vehicle_ad_curvilinear::Integral_quantities::names.cbegin(),it);
 
             table_scalar.insert({conf.output_variables_prefix + variable_name, opt_laptime.integral_quantities[index].value});
+            sweep_channels[variable_name] = {opt_laptime.integral_quantities[index].value};
 
             is_vector = false;
         }
@@ -1599,7 +2142,8 @@ void compute_optimal_laptime(vehicle_t& vehicle, Track_by_polynomial& track, con
         if ( is_vector ) 
         {
             std::vector<scalar> data(n_points,0.0);
-            std::vector<std::vector<scalar>> ddatadp(car_curv_sc_const.get_parameters().get_number_of_parameters(), std::vector<scalar>(n_points,0.0)); 
+            std::vector<std::vector<scalar>> ddatadp(store_derivatives ? car_curv_sc_const.get_parameters().get_number_of_parameters() : 0, 
+                                                     std::vector<scalar>(n_points,0.0)); 
             for (int i = 0; i < n_points; ++i)
             {
                 car_curv_sc(opt_laptime.q[i], opt_laptime.qa[i], opt_laptime.control_variables.control_array_at_s(car_curv,i,s[i]), s[i]);
@@ -1623,7 +2167,7 @@ void compute_optimal_laptime(vehicle_t& vehicle, Track_by_polynomial& track, con
                 {
                     data[i] = opt_laptime.q[i][vehicle_t::vehicle_scalar_curvilinear::Chassis_type::IU];
     
-                    if ( opts.check_optimality )
+                    if ( store_derivatives )
                     {
                         for (size_t p = 0; p < car_curv_sc_const.get_parameters().get_number_of_parameters(); ++p)
                         {
@@ -1638,7 +2182,7 @@ void compute_optimal_laptime(vehicle_t& vehicle, Track_by_polynomial& track, con
                 {
                     data[i] = opt_laptime.q[i][vehicle_t::vehicle_scalar_curvilinear::Road_type::ITIME];
 
-                    if ( opts.check_optimality )
+                    if ( store_derivatives )
                     {
                         for (size_t p = 0; p < car_curv_sc_const.get_parameters().get_number_of_parameters(); ++p)
                         {
@@ -1823,9 +2367,10 @@ void compute_optimal_laptime(vehicle_t& vehicle, Track_by_polynomial& track, con
     
             // Insert in the vector table
             table_vector.insert({conf.output_variables_prefix + variable_name, data});
+            sweep_channels[variable_name] = data;
 
             // Insert derivatives in the table
-            if ( opts.check_optimality )
+            if ( store_derivatives )
             {
                 for (size_t p = 0; p < car_curv_sc_const.get_parameters().get_number_of_parameters(); ++p)
                     table_vector.insert({conf.output_variables_prefix + "derivatives/" + variable_name + "/" + parameter_aliases[p], ddatadp[p]});
@@ -1836,6 +2381,13 @@ void compute_optimal_laptime(vehicle_t& vehicle, Track_by_polynomial& track, con
     // (6.3) Save warm start for next runs
     if (conf.save_warm_start)
         get_warm_start<vehicle_t>() = opt_laptime;
+
+    // (6.4) Append the run to the sweep result store
+    if ( conf.sweep_result_store.size() > 0 )
+    {
+        table_sweep_result_store.at(conf.sweep_result_store)->add_run({conf.sweep_run_name, conf.sweep_parameters, opt_laptime.success,
+            opt_laptime.iter_count, elapsed_time.count(), opt_laptime.laptime}, sweep_channels);
+    }
 }
 
 
@@ -1843,6 +2395,8 @@ void optimal_laptime(const char* c_vehicle_name, const char* c_track_name, const
 {
  try
  {
+    FASTEST_LAP_TRACE_SCOPE("optimal_laptime");
+
     const std::string vehicle_name(c_vehicle_name);
     const std::string track_name(c_track_name);
     if ( table_kart_6dof.count(vehicle_name) != 0 )
@@ -1900,6 +2454,10 @@ struct Circuit_preprocessor_configuration
 //          xml_file_name: name of the XML file to export the track
 //          output_variables/prefix: prefix used to store the output variables in the table         
 //          insert_table_name: name used to insert the track itself into the table
+//          optimization/multilevel_coarsening: coarsening factors of the meshes solved first to warm start the requested one (e.g. 8, 2)
+//          optimization/remeshing/target_error: refine the mesh until the boundary error is below this value [m]
+//          optimization/remeshing/minimum_ds: smallest element size allowed by the remeshing [m]
+//          optimization/banded_formulation: true/false, use the formulation with banded Jacobian (recommended for large meshes)
     enum Mode { EQUALLY_SPACED, REFINED };
 
     Circuit_preprocessor_configuration(const char* options)
@@ -1974,6 +2532,18 @@ struct Circuit_preprocessor_configuration
                 maximum_kappa = doc.get_element("options/optimization/maximum_kappa").get_value(scalar());
             if ( doc.has_element("options/optimization/maximum_dkappa") )    
                 maximum_dkappa = doc.get_element("options/optimization/maximum_dkappa").get_value(scalar());
+            if ( doc.has_element("options/optimization/multilevel_coarsening") ) 
+            {
+                const auto coarsening = doc.get_element("options/optimization/multilevel_coarsening").get_value(std::vector<scalar>());
+                std::transform(coarsening.cbegin(), coarsening.cend(), std::back_inserter(multilevel_coarsening), 
+                    [](const auto& c) -> auto { return static_cast<size_t>(c); });
+            }
+            if ( doc.has_element("options/optimization/remeshing/target_error") )
+                remeshing_target_error = doc.get_element("options/optimization/remeshing/target_error").get_value(scalar());
+            if ( doc.has_element("options/optimization/remeshing/minimum_ds") )
+                remeshing_minimum_ds = doc.get_element("options/optimization/remeshing/minimum_ds").get_value(scalar());
+            if ( doc.has_element("options/optimization/banded_formulation") )
+                banded_formulation = doc.get_element("options/optimization/banded_formulation").get_value(bool());
         }
 
         if ( doc.has_element("options/print_level") ) print_level = doc.get_element("options/print_level").get_value(scalar());
@@ -2018,6 +2588,10 @@ struct Circuit_preprocessor_configuration
     scalar maximum_dn                = Circuit_preprocessor::Options().maximum_dn;
     scalar maximum_distance_find     = Circuit_preprocessor::Options().maximum_distance_find;
     scalar adaption_aspect_ratio_max = Circuit_preprocessor::Options().adaption_aspect_ratio_max;
+    std::vector<size_t> multilevel_coarsening{};
+    scalar remeshing_target_error    = Circuit_preprocessor::Options().remeshing_target_error;
+    scalar remeshing_minimum_ds      = Circuit_preprocessor::Options().remeshing_minimum_ds;
+    bool banded_formulation          = Circuit_preprocessor::Options().banded_formulation;
     int print_level                  = 0;
 
     // Output options
@@ -2037,6 +2611,8 @@ void circuit_preprocessor(const char* options)
 //        =================================
  try
  {
+    FASTEST_LAP_TRACE_SCOPE("circuit_preprocessor");
+
     Circuit_preprocessor_configuration conf(options);
 
     // Read KML files
@@ -2057,6 +2633,11 @@ void circuit_preprocessor(const char* options)
 
     preprocessor_options.adaption_aspect_ratio_max = conf.adaption_aspect_ratio_max ;
 
+    preprocessor_options.multilevel_coarsening = conf.multilevel_coarsening ;
+    preprocessor_options.remeshing_target_error = conf.remeshing_target_error ;
+    preprocessor_options.remeshing_minimum_ds   = conf.remeshing_minimum_ds ;
+    preprocessor_options.banded_formulation     = conf.banded_formulation ;
+
     preprocessor_options.print_level = conf.print_level ;
 
     // (2) Construct circuit
@@ -39,6 +39,22 @@ extern fastestlapc_API void print_variable(const char* variable_name);
 
 extern fastestlapc_API void print_variable_to_string(char* str_out, const int n_char, const char* variable_name);
 
+// Tracing -------------------------------------------------------------------------------------------------------------
+
+extern fastestlapc_API void start_tracing(const int events_per_thread);
+
+extern fastestlapc_API void stop_tracing();
+
+extern fastestlapc_API void clear_tracing();
+
+extern fastestlapc_API void save_tracing(const char* file_name);
+
+// Sweep result stores -------------------------------------------------------------------------------------------------
+
+extern fastestlapc_API void sweep_result_store_open(const char* store_name, const char* file_name, const int chunk_size);
+
+extern fastestlapc_API void sweep_result_store_close(const char* store_name);
+
 // Factories -----------------------------------------------------------------------------------------------------------
 
 extern fastestlapc_API void create_vehicle_from_xml(const char* vehicle_name, const char* database_file);
@@ -75,6 +91,8 @@ extern fastestlapc_API double vehicle_get_property(const char* vehicle_name, con
 
 extern fastestlapc_API void vehicle_save_as_xml(const char* vehicle_name, const char* file_name);
 
+extern fastestlapc_API void vehicle_get_number_of_variables(int* n_state, int* n_algebraic, int* n_control, const char* vehicle_name);
+
 extern fastestlapc_API int track_download_number_of_points(const char* track_name); // [TEST OK]
 
 extern fastestlapc_API void track_download_data(double* data, const char* track_name, const int n, const char* variable_name_c); // [TEST OK]
@@ -100,6 +118,9 @@ extern fastestlapc_API void propagate_vehicle(double* q, double* qa, double* u,
 
 extern fastestlapc_API void gg_diagram(double* ay, double* ax_max, double* ax_min, const char* vehicle_name, double v, const int n_points);
 
+extern fastestlapc_API void steady_state_batch(double* q, double* qa, double* u, bool* success, const char* vehicle_name, const int n_points, 
+                                               const double* v, const double* ax, const double* ay, const int n_threads);
+
 extern fastestlapc_API void optimal_laptime(const char* c_vehicle, const char* c_track_name, const int n_points, const double* s, const char* options);
 
 extern fastestlapc_API void circuit_preprocessor(const char* options);
@@ -30,6 +30,38 @@ def print_variable(variable_name):
 	print(c_data.value.decode())
 	return;
 
+# Tracing ---------------------------------------------------------------------------
+
+def start_tracing(events_per_thread=65536):
+	c_lib.start_tracing(c.c_int(events_per_thread));
+	return;
+
+def stop_tracing():
+	c_lib.stop_tracing();
+	return;
+
+def clear_tracing():
+	c_lib.clear_tracing();
+	return;
+
+def save_tracing(file_name):
+	c_file_name = c.c_char_p((file_name).encode('utf-8'));
+	c_lib.save_tracing(c_file_name);
+	return;
+
+# Sweep result stores -----------------------------------------------------------------
+
+def sweep_result_store_open(store_name, file_name, chunk_size=4096):
+	c_store_name = c.c_char_p((store_name).encode('utf-8'));
+	c_file_name  = c.c_char_p((file_name).encode('utf-8'));
+	c_lib.sweep_result_store_open(c_store_name, c_file_name, c.c_int(chunk_size));
+	return;
+
+def sweep_result_store_close(store_name):
+	c_store_name = c.c_char_p((store_name).encode('utf-8'));
+	c_lib.sweep_result_store_close(c_store_name);
+	return;
+
 # Factories -------------------------------------------------------------------------
 
 def create_vehicle_from_xml(name,database_file):
@@ -221,6 +253,32 @@ def gg_diagram(vehicle,speed,n_points):
 
 	return ay,ay_minus,ax_max,ax_min;
 
+def steady_state_batch(vehicle, v, ax, ay, n_threads=0):
+	n_points = len(v);
+	c_vehicle = c.c_char_p((vehicle).encode('utf-8'))
+
+	# Get the sizes of the vehicle
+	n_state = c.c_int(); n_algebraic = c.c_int(); n_control = c.c_int();
+	c_lib.vehicle_get_number_of_variables(c.byref(n_state), c.byref(n_algebraic), c.byref(n_control), c_vehicle);
+
+	c_v  = (c.c_double*n_points)(*v);
+	c_ax = (c.c_double*n_points)(*ax);
+	c_ay = (c.c_double*n_points)(*ay);
+
+	c_q       = (c.c_double*(n_points*n_state.value))();
+	c_qa      = (c.c_double*(n_points*n_algebraic.value))();
+	c_u       = (c.c_double*(n_points*n_control.value))();
+	c_success = (c.c_bool*n_points)();
+
+	c_lib.steady_state_batch(c_q, c_qa, c_u, c_success, c_vehicle, c.c_int(n_points), c_v, c_ax, c_ay, c.c_int(n_threads));
+
+	q       = np.reshape(np.array(c_q[:]), (n_points, n_state.value));
+	qa      = np.reshape(np.array(c_qa[:]), (n_points, n_algebraic.value));
+	u       = np.reshape(np.array(c_u[:]), (n_points, n_control.value));
+	success = [bool(c_success[i]) for i in range(n_points)];
+
+	return q, qa, u, success;
+
 def optimal_laptime(vehicle, track, s, options):
 	vehicle = c.c_char_p((vehicle).encode('utf-8'))
 	track   = c.c_char_p((track).encode('utf-8'))
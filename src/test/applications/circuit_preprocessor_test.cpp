@@ -494,6 +494,182 @@ TEST(Circuit_preprocessor_test, catalunya_500)
 }
 
 
+TEST(Circuit_preprocessor_test, catalunya_500_multilevel)
+{
+    #ifndef NDEBUG
+          GTEST_SKIP();
+    #endif
+
+    if ( is_valgrind ) GTEST_SKIP();
+
+    Xml_document coord_left_kml("./database/tracks/catalunya/Catalunya_left.kml", true);
+    Xml_document coord_right_kml("./database/tracks/catalunya/Catalunya_right.kml", true);
+
+    // Same problem as catalunya_500, warm started from meshes with 63 and 250 points
+    Circuit_preprocessor::Options opts;
+    opts.multilevel_coarsening = {8, 2};
+
+    Circuit_preprocessor circuit(coord_left_kml, coord_right_kml, false, opts, 500);
+
+    ASSERT_EQ(circuit.levels.size(), 3);
+    EXPECT_EQ(circuit.levels[0].n_points, 63);
+    EXPECT_EQ(circuit.levels[1].n_points, 250);
+    EXPECT_EQ(circuit.levels[2].n_points, 500);
+
+    Xml_document solution_saved("./database/tracks/catalunya/catalunya_discrete.xml", true);
+
+    const std::vector<scalar> x     = solution_saved.get_element("circuit/data/centerline/x").get_value(std::vector<scalar>());
+    const std::vector<scalar> y     = solution_saved.get_element("circuit/data/centerline/y").get_value(std::vector<scalar>());
+    const std::vector<scalar> theta = solution_saved.get_element("circuit/data/theta").get_value(std::vector<scalar>());
+    const std::vector<scalar> kappa = solution_saved.get_element("circuit/data/kappa").get_value(std::vector<scalar>());
+    const std::vector<scalar> nl    = solution_saved.get_element("circuit/data/nl").get_value(std::vector<scalar>());
+    const std::vector<scalar> nr    = solution_saved.get_element("circuit/data/nr").get_value(std::vector<scalar>());
+
+    ASSERT_EQ(circuit.n_points,500);
+
+    for (size_t i = 0; i < circuit.n_points; ++i)
+    {
+        EXPECT_NEAR(circuit.r_centerline[i].x(), x[i]     , 1.0e-6) << " with i = " << i;
+        EXPECT_NEAR(circuit.r_centerline[i].y(), y[i]     , 1.0e-6) << " with i = " << i;
+        EXPECT_NEAR(circuit.theta[i]           , theta[i] , 1.0e-6) << " with i = " << i;
+        EXPECT_NEAR(circuit.kappa[i]           , kappa[i] , 1.0e-6) << " with i = " << i;
+        EXPECT_NEAR(circuit.nl[i]              , nl[i]    , 1.0e-6) << " with i = " << i;
+        EXPECT_NEAR(circuit.nr[i]              , nr[i]    , 1.0e-6) << " with i = " << i;
+    }
+}
+
+
+TEST(Circuit_preprocessor_test, catalunya_banded_formulation)
+{
+    #ifndef NDEBUG
+          GTEST_SKIP();
+    #endif
+
+    if ( is_valgrind ) GTEST_SKIP();
+
+    Xml_document coord_left_kml("./database/tracks/catalunya/Catalunya_left.kml", true);
+    Xml_document coord_right_kml("./database/tracks/catalunya/Catalunya_right.kml", true);
+
+    Circuit_preprocessor::Options opts_banded;
+    opts_banded.banded_formulation = true;
+
+    // Both formulations have the same optimum. The solve times against the mesh size are measured by
+    // src/benchmark/circuit_preprocessor_banded_benchmark.cpp
+    Circuit_preprocessor classic(coord_left_kml, coord_right_kml, false, {}, 500);
+    Circuit_preprocessor banded(coord_left_kml, coord_right_kml, false, opts_banded, 500);
+
+    ASSERT_EQ(banded.n_points, classic.n_points);
+    EXPECT_NEAR(banded.track_length, classic.track_length, 1.0e-5);
+    EXPECT_NEAR(banded.left_boundary_L2_error, classic.left_boundary_L2_error, 1.0e-5);
+    EXPECT_NEAR(banded.right_boundary_L2_error, classic.right_boundary_L2_error, 1.0e-5);
+
+    for (size_t i = 0; i < classic.n_points; ++i)
+    {
+        EXPECT_NEAR(banded.s[i]                   , classic.s[i]                   , 1.0e-5) << " with i = " << i;
+        EXPECT_NEAR(banded.r_centerline[i].x()    , classic.r_centerline[i].x()    , 1.0e-5) << " with i = " << i;
+        EXPECT_NEAR(banded.r_centerline[i].y()    , classic.r_centerline[i].y()    , 1.0e-5) << " with i = " << i;
+        EXPECT_NEAR(banded.kappa[i]               , classic.kappa[i]               , 1.0e-6) << " with i = " << i;
+        EXPECT_NEAR(banded.nl[i]                  , classic.nl[i]                  , 1.0e-5) << " with i = " << i;
+        EXPECT_NEAR(banded.nr[i]                  , classic.nr[i]                  , 1.0e-5) << " with i = " << i;
+    }
+}
+
+
+TEST(Circuit_preprocessor_test, catalunya_remeshing)
+{
+    #ifndef NDEBUG
+          GTEST_SKIP();
+    #endif
+
+    if ( is_valgrind ) GTEST_SKIP();
+
+    Xml_document coord_left_kml("./database/tracks/catalunya/Catalunya_left.kml", true);
+    Xml_document coord_right_kml("./database/tracks/catalunya/Catalunya_right.kml", true);
+
+    // Coarse mesh only
+    Circuit_preprocessor coarse(coord_left_kml, coord_right_kml, false, {}, 100);
+
+    // Coarse mesh, refined automatically
+    Circuit_preprocessor::Options opts;
+    opts.remeshing_target_error = 0.5;
+
+    Circuit_preprocessor circuit(coord_left_kml, coord_right_kml, false, opts, 100);
+
+    // Every pass adds points
+    ASSERT_GE(circuit.levels.size(), 2);
+    EXPECT_EQ(circuit.levels.front().n_points, 100);
+
+    for (size_t i = 1; i < circuit.levels.size(); ++i)
+        EXPECT_GT(circuit.levels[i].n_points, circuit.levels[i-1].n_points);
+
+    EXPECT_EQ(circuit.n_points, circuit.levels.back().n_points);
+    EXPECT_EQ(circuit.n_elements, circuit.n_points);
+    EXPECT_EQ(circuit.s.size(), circuit.n_points);
+
+    for (size_t i = 1; i < circuit.n_points; ++i)
+        EXPECT_GT(circuit.s[i], circuit.s[i-1]);
+
+    // The refined track fits better the measured boundaries
+    EXPECT_LT(circuit.left_boundary_L2_error, coarse.left_boundary_L2_error);
+    EXPECT_LT(circuit.right_boundary_L2_error, coarse.right_boundary_L2_error);
+}
+
+
+TEST(Circuit_preprocessor_test, catalunya_tuning)
+{
+    #ifndef NDEBUG
+          GTEST_SKIP();
+    #endif
+
+    if ( is_valgrind ) GTEST_SKIP();
+
+    Xml_document coord_left_kml("./database/tracks/catalunya/Catalunya_left.kml", true);
+    Xml_document coord_right_kml("./database/tracks/catalunya/Catalunya_right.kml", true);
+
+    Circuit_preprocessor circuit(coord_left_kml, coord_right_kml, false, {}, 100);
+
+    // Grid of 3 x 2 candidates
+    const auto candidates = Circuit_preprocessor::tuning_grid(circuit.options, {{"eps_k", {1.0e3, 5.0e4, 1.0e6}}, {"eps_n", {1.0e-1, 1.0}}});
+
+    ASSERT_EQ(candidates.size(), 6);
+    EXPECT_DOUBLE_EQ(candidates[3].eps_k, 5.0e4);
+    EXPECT_DOUBLE_EQ(candidates[3].eps_n, 1.0);
+
+    EXPECT_THROW(Circuit_preprocessor::tuning_grid(circuit.options, {{"unknown", {1.0}}}), fastest_lap_exception);
+
+    Circuit_preprocessor::Tuning_options tuning_options;
+    tuning_options.n_threads = 3;
+
+    const auto result = circuit.tune(candidates, tuning_options);
+
+    ASSERT_EQ(result.score.size(), 6);
+    EXPECT_EQ(result.best, std::distance(result.score.cbegin(), std::min_element(result.score.cbegin(), result.score.cend())));
+    EXPECT_TRUE(result.success[result.best]);
+
+    // The circuit contains the best candidate: same result as a sequential run
+    Circuit_preprocessor best(coord_left_kml, coord_right_kml, false, candidates[result.best], 100);
+
+    EXPECT_DOUBLE_EQ(circuit.options.eps_k, candidates[result.best].eps_k);
+    EXPECT_NEAR(circuit.track_length, best.track_length, 1.0e-6);
+    EXPECT_NEAR(circuit.left_boundary_L2_error, best.left_boundary_L2_error, 1.0e-6);
+    EXPECT_NEAR(circuit.right_boundary_L2_error, best.right_boundary_L2_error, 1.0e-6);
+
+    for (size_t i = 0; i < circuit.n_points; ++i)
+        EXPECT_NEAR(circuit.kappa[i], best.kappa[i], 1.0e-7);
+
+    // Random candidates lie within their ranges
+    const auto samples = Circuit_preprocessor::tuning_sample(circuit.options, {{"eps_k", 1.0e3, 1.0e6}}, 10);
+
+    ASSERT_EQ(samples.size(), 10);
+
+    for (const auto& sample : samples)
+    {
+        EXPECT_GE(sample.eps_k, 1.0e3);
+        EXPECT_LE(sample.eps_k, 1.0e6);
+    }
+}
+
+
 TEST(Circuit_preprocessor_test, catalunya_adapted_by_coords)
 {
     #ifndef NDEBUG
@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 #include "lion/math/matrix_extensions.h"
 #include "src/core/applications/optimal_laptime.h"
+#include "src/core/applications/pareto_front.h"
 #include "src/core/vehicles/limebeer2014f1.h"
 #include "lion/thirdparty/include/cppad/cppad.hpp"
 #include "src/core/applications/steady_state.h"
@@ -261,10 +262,11 @@ TEST_F(F1_optimal_laptime_test, Catalunya_variable_parameter)
 }
   
 
-TEST_F(F1_optimal_laptime_test, Catalunya_chicane)
+//! Solve the Catalunya chicane (adapted mesh from i=533 to i=677) starting from the steady state at 70km/h
+static Optimal_laptime<limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p> solve_catalunya_chicane(Xml_document& database, 
+    limebeer2014f1<CppAD::AD<scalar>>::cartesian& car_cartesian, const Optimal_laptime<limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p>::Options& opts,
+    const size_t stride = 1)
 {
-    // The chicane test uses the adapted mesh from i=533 to i=677
-
     Xml_document catalunya_xml("./database/tracks/catalunya/catalunya_adapted.xml",true);
     Circuit_preprocessor catalunya_pproc(catalunya_xml);
     Track_by_polynomial catalunya(catalunya_pproc);
@@ -276,11 +278,12 @@ TEST_F(F1_optimal_laptime_test, Catalunya_chicane)
     const scalar v = 70.0*KMH;
     auto ss = Steady_state(car_cartesian).solve(v,0.0,0.0); 
 
-    // Get arclength: s(i0:i1)
+    // Get arclength: s(i0:stride:i1)
     const size_t i0 = 533;
     const size_t i1 = 677;
-    std::vector<scalar> s(i1-i0+1);
-    std::copy(catalunya_pproc.s.cbegin()+i0,catalunya_pproc.s.cbegin()+i1+1,s.begin());        
+    std::vector<scalar> s;
+    for (size_t i = i0; i <= i1; i += stride)
+        s.push_back(catalunya_pproc.s[i]);
 
     const size_t n = s.size();
 
@@ -320,12 +323,225 @@ TEST_F(F1_optimal_laptime_test, Catalunya_chicane)
             control_variables[i].u.front() = u_start[i];
     }
 
-    Optimal_laptime opt_laptime(s, false, true, car, q0, qa0, control_variables, {});
+    return Optimal_laptime(s, false, true, car, q0, qa0, control_variables, opts);
+}
+
+
+TEST_F(F1_optimal_laptime_test, Catalunya_chicane)
+{
+    // The chicane test uses the adapted mesh from i=533 to i=677
+    auto opt_laptime = solve_catalunya_chicane(database, car_cartesian, {});
     opt_laptime.xml();
 
     Xml_document opt_saved("data/f1_optimal_laptime_catalunya_chicane.xml", true);
 
-    check_optimal_laptime(opt_laptime, opt_saved, n);
+    check_optimal_laptime(opt_laptime, opt_saved, opt_laptime.n_points);
+}
+
+
+TEST_F(F1_optimal_laptime_test, Catalunya_chicane_multilevel)
+{
+    // Same problem as Catalunya_chicane, but the initial guess is constructed from two coarser solutions
+    Optimal_laptime<limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p>::Options opts;
+    opts.multilevel_coarsening = {4, 2};
+
+    auto opt_laptime = solve_catalunya_chicane(database, car_cartesian, opts);
+
+    Xml_document opt_saved("data/f1_optimal_laptime_catalunya_chicane.xml", true);
+
+    check_optimal_laptime(opt_laptime, opt_saved, opt_laptime.n_points);
+}
+
+
+TEST_F(F1_optimal_laptime_test, Catalunya_chicane_automatic_scaling)
+{
+    // Same problem as Catalunya_chicane, solved with the automatic scaling of variables and constraints
+    Optimal_laptime<limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p>::Options opts;
+    opts.automatic_scaling = true;
+
+    auto opt_laptime = solve_catalunya_chicane(database, car_cartesian, opts);
+
+    Xml_document opt_saved("data/f1_optimal_laptime_catalunya_chicane.xml", true);
+
+    check_optimal_laptime(opt_laptime, opt_saved, opt_laptime.n_points);
+}
+
+
+TEST_F(F1_optimal_laptime_test, Catalunya_chicane_recovery)
+{
+    // The original attempt is stopped by the iteration limit. Every restart continues from the last iterate of the
+    // previous one, so the solve advances until one of them converges to the solution of Catalunya_chicane
+    using Optimal_laptime_t = Optimal_laptime<limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p>;
+
+    Optimal_laptime_t::Options opts;
+    opts.maximum_iterations  = 20;
+    opts.recovery_strategies = std::vector<Optimal_laptime_t::Recovery_strategy>(20, Optimal_laptime_t::RESTART_ADAPTIVE_MU);
+    opts.throw_if_fail       = false;
+
+    auto opt_laptime = solve_catalunya_chicane(database, car_cartesian, opts);
+
+    // Every attempt is logged, and the recovery stops at the first success
+    const auto& attempts = opt_laptime.recovery_attempts;
+
+    ASSERT_GE(attempts.size(), 2);
+    ASSERT_LE(attempts.size(), 21);
+    EXPECT_EQ(attempts.front().strategy, "original");
+    EXPECT_FALSE(attempts.front().success);
+    EXPECT_EQ(attempts.front().iter_count, 20);
+
+    for (size_t i = 1; i < attempts.size(); ++i)
+    {
+        EXPECT_EQ(attempts[i].strategy, "restart-adaptive-mu");
+        EXPECT_EQ(attempts[i].success, i == attempts.size() - 1) << ", with i = " << i;
+    }
+
+    EXPECT_TRUE(opt_laptime.success);
+
+    // The recovered solution is the solution of the problem
+    Xml_document opt_saved("data/f1_optimal_laptime_catalunya_chicane.xml", true);
+
+    auto time_saved = opt_saved.get_element("optimal_laptime/time").get_value(std::vector<scalar>());
+    EXPECT_NEAR(opt_laptime.q.back()[limebeer2014f1<scalar>::curvilinear_p::Road_t::ITIME], time_saved.back(), 1.0e-6);
+
+    check_optimal_laptime(opt_laptime, opt_saved, opt_laptime.n_points);
+}
+
+
+TEST_F(F1_optimal_laptime_test, Catalunya_chicane_recovery_attempt_throws)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    // A recovery attempt that throws is logged as failed: the recovery continues, and the options and the initial
+    // guess given by the user are restored
+    using Car_t = limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p;
+    using Optimal_laptime_t = Optimal_laptime<Car_t>;
+
+    Optimal_laptime_t::Options opts;
+    opts.maximum_iterations = 20;
+    opts.throw_if_fail      = false;
+
+    auto opt_laptime = solve_catalunya_chicane(database, car_cartesian, opts);
+
+    ASSERT_FALSE(opt_laptime.success);
+
+    Xml_document catalunya_xml("./database/tracks/catalunya/catalunya_adapted.xml",true);
+    Circuit_preprocessor catalunya_pproc(catalunya_xml);
+    Track_by_polynomial catalunya(catalunya_pproc);
+    
+    Car_t::Road_t road(catalunya);
+    Car_t car(database, road);
+
+    // (1) The coarse mesh attempt throws, since a coarsening factor of 1 is not valid
+    opt_laptime.options.maximum_iterations    = 1;
+    opt_laptime.options.multilevel_coarsening = {1};
+    opt_laptime.options.recovery_strategies   = {Optimal_laptime_t::COARSE_MESH, Optimal_laptime_t::RELAX_TOLERANCES};
+
+    const auto q_initial = opt_laptime.q;
+    const auto control_variables_initial = opt_laptime.control_variables;
+
+    EXPECT_NO_THROW(opt_laptime.compute(car));
+
+    const auto& attempts = opt_laptime.recovery_attempts;
+
+    ASSERT_EQ(attempts.size(), 3);
+    EXPECT_EQ(attempts[0].strategy, "original");
+    EXPECT_EQ(attempts[1].strategy, "coarse-mesh");
+    EXPECT_EQ(attempts[2].strategy, "relax-tolerances");
+
+    EXPECT_FALSE(attempts[1].success);
+    EXPECT_EQ(attempts[1].iter_count, 0);
+    EXPECT_FALSE(opt_laptime.success);
+
+    // (2) The user options are restored
+    EXPECT_EQ(opt_laptime.options.maximum_iterations, 1);
+    EXPECT_EQ(opt_laptime.options.multilevel_coarsening, std::vector<size_t>{1});
+    EXPECT_EQ(opt_laptime.options.recovery_strategies.size(), 2);
+    EXPECT_FALSE(opt_laptime.options.throw_if_fail);
+
+    // (3) Without a successful attempt afterwards, the guess is the initial one: the throwing attempt does not modify it
+    opt_laptime.q                 = q_initial;
+    opt_laptime.control_variables = control_variables_initial;
+    opt_laptime.options.recovery_strategies = {Optimal_laptime_t::COARSE_MESH};
+
+    EXPECT_NO_THROW(opt_laptime.compute(car));
+    ASSERT_EQ(opt_laptime.recovery_attempts.size(), 2);
+    EXPECT_FALSE(opt_laptime.recovery_attempts.back().success);
+
+    for (size_t i = 0; i < opt_laptime.n_points; ++i)
+        for (size_t j = 0; j < Car_t::NSTATE; ++j)
+            EXPECT_DOUBLE_EQ(opt_laptime.q[i][j], q_initial[i][j]) << ", with i = " << i << ", j = " << j;
+
+    // (4) With throw_if_fail, the final error is thrown once the user options are restored
+    opt_laptime.options.throw_if_fail = true;
+    EXPECT_THROW(opt_laptime.compute(car), fastest_lap_exception);
+    EXPECT_TRUE(opt_laptime.options.throw_if_fail);
+    EXPECT_EQ(opt_laptime.options.multilevel_coarsening, std::vector<size_t>{1});
+}
+
+
+TEST_F(F1_optimal_laptime_test, Catalunya_chicane_pareto_front)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    using Optimal_laptime_type = Optimal_laptime<limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p>;
+
+    // Start from the chicane with an inactive bound on the engine energy
+    Optimal_laptime_type::Options opts;
+    opts.integral_quantities = { {"engine-energy", 0.0, 1.0e3} };
+
+    auto start = solve_catalunya_chicane(database, car_cartesian, opts);
+    const scalar energy_0 = start.integral_quantities.front().value;
+
+    Xml_document catalunya_xml("./database/tracks/catalunya/catalunya_adapted.xml",true);
+    Circuit_preprocessor catalunya_pproc(catalunya_xml);
+    Track_by_polynomial catalunya(catalunya_pproc);
+    limebeer2014f1<CppAD::AD<scalar>>::curvilinear<Track_by_polynomial>::Road_t road(catalunya);
+    limebeer2014f1<CppAD::AD<scalar>>::curvilinear<Track_by_polynomial> car(database, road);
+
+    // Sweep the engine energy budget from 90% to 70% of the unconstrained value
+    Pareto_front<limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p>::Options pareto_opts;
+    pareto_opts.integral_quantity       = "engine-energy";
+    pareto_opts.bound_start             = 0.9*energy_0;
+    pareto_opts.bound_end               = 0.7*energy_0;
+    pareto_opts.initial_step            = 0.05*energy_0;
+    pareto_opts.minimum_step            = 0.005*energy_0;
+    pareto_opts.maximum_step            = 0.1*energy_0;
+    pareto_opts.optimal_laptime_options = opts;
+
+    Pareto_front<limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p> pareto(start, car, pareto_opts);
+
+    ASSERT_TRUE(pareto.success);
+    ASSERT_GE(pareto.points.size(), 2);
+    EXPECT_DOUBLE_EQ(pareto.points.front().bound, pareto_opts.bound_start);
+    EXPECT_DOUBLE_EQ(pareto.points.back().bound, pareto_opts.bound_end);
+
+    // Less energy cannot be faster, and the bound is active
+    for (size_t i = 0; i < pareto.points.size(); ++i)
+    {
+        EXPECT_NEAR(pareto.points[i].integral_quantity_value, pareto.points[i].bound, 1.0e-4);
+
+        if ( i > 0 )
+            EXPECT_GE(pareto.points[i].laptime, pareto.points[i-1].laptime - 1.0e-8);
+    }
+
+    // Flat segment: above the unconstrained energy the bound is inactive and the laptime does not change. The slope of 
+    // the front is numerical noise, and the points are accepted through the absolute floor of the slope change
+    auto flat_opts        = pareto_opts;
+    flat_opts.bound_start = 1.3*energy_0;
+    flat_opts.bound_end   = 1.1*energy_0;
+
+    Pareto_front<limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p> pareto_flat(start, car, flat_opts);
+
+    ASSERT_TRUE(pareto_flat.success);
+    ASSERT_GE(pareto_flat.points.size(), 3);
+    EXPECT_EQ(pareto_flat.number_of_rejected_points, 0);
+    EXPECT_DOUBLE_EQ(pareto_flat.points.back().bound, flat_opts.bound_end);
+
+    for (const auto& point : pareto_flat.points)
+    {
+        EXPECT_NEAR(point.laptime, start.laptime, 1.0e-6);
+        EXPECT_NEAR(point.integral_quantity_value, energy_0, 1.0e-4*energy_0);
+    }
 }
 
 
@@ -942,3 +1158,529 @@ TEST_F(F1_optimal_laptime_test, Catalunya_tire_energy_limited)
     for (size_t i = 1; i < 5; ++i)
         EXPECT_TRUE(opt_laptime.integral_quantities[i].value < 0.8 + 1.0e-6);
 }
+
+
+TEST_F(F1_optimal_laptime_test, Catalunya_tape_profile)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    Xml_document catalunya_xml("./database/tracks/catalunya/catalunya_adapted.xml",true);
+    Circuit_preprocessor catalunya_pproc(catalunya_xml);
+    Track_by_polynomial catalunya(catalunya_pproc);
+    
+    limebeer2014f1<CppAD::AD<scalar>>::curvilinear<Track_by_polynomial>::Road_t road(catalunya);
+    limebeer2014f1<CppAD::AD<scalar>>::curvilinear<Track_by_polynomial> car(database, road);
+
+    Xml_document opt_full_lap("data/f1_optimal_laptime_catalunya_adapted.xml", true);
+    Optimal_laptime<limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p> opt_laptime(opt_full_lap);
+
+    const auto reports = opt_laptime.profile_tape(car, {0, 100, 200});
+
+    ASSERT_EQ(reports.size(), 3);
+
+    for (const auto& report : reports)
+    {
+        // All components were tagged
+        for (const std::string name : {"other", "road", "chassis", "axle", "tire", "engine", "integral quantities"})
+            EXPECT_TRUE(report.has_component(name)) << name;
+
+        // The components add up to the complete tape
+        size_t n_operations = 0;
+        size_t n_variables  = 0;
+        for (const auto& component : report.components)
+        {
+            n_operations += component.n_operations;
+            n_variables  += component.n_variables;
+        }
+
+        EXPECT_EQ(n_operations, report.n_operations);
+        EXPECT_EQ(n_variables, report.n_variables);
+
+        // Four tires, two axles
+        EXPECT_GT(report["tire"].n_operations, 0);
+        EXPECT_GT(report["axle"].n_operations, 0);
+        EXPECT_GT(report["road"].n_operations, 0);
+        EXPECT_GT(report.forward_time, 0.0);
+    }
+
+    // Accumulate
+    Tape_profiler::Report total;
+    for (const auto& report : reports)
+        total += report;
+
+    EXPECT_EQ(total["tire"].n_operations, reports[0]["tire"].n_operations + reports[1]["tire"].n_operations + reports[2]["tire"].n_operations);
+    EXPECT_EQ(total.n_operations, reports[0].n_operations + reports[1].n_operations + reports[2].n_operations);
+}
+
+
+TEST_F(F1_optimal_laptime_test, Catalunya_chicane_track_sensitivities)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    using Car_t = limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p;
+
+    Optimal_laptime<Car_t>::Options opts;
+    auto opt_laptime = solve_catalunya_chicane(database, car_cartesian, opts);
+
+    Xml_document catalunya_xml("./database/tracks/catalunya/catalunya_adapted.xml",true);
+    Circuit_preprocessor catalunya_pproc(catalunya_xml);
+    Track_by_polynomial catalunya(catalunya_pproc);
+    
+    Car_t::Road_t road(catalunya);
+    Car_t car(database, road);
+
+    const auto sensitivities = opt_laptime.compute_track_sensitivities(car);
+
+    ASSERT_EQ(sensitivities.dlaptimedwl.size(), opt_laptime.n_points);
+    ASSERT_EQ(sensitivities.dlaptimedwr.size(), opt_laptime.n_points);
+    ASSERT_EQ(sensitivities.dlaptimedkappa.size(), opt_laptime.n_points);
+
+    // A wider track is never slower
+    for (size_t i = 0; i < opt_laptime.n_points; ++i)
+    {
+        EXPECT_LE(sensitivities.dlaptimedwl[i], 1.0e-8) << ", with i = " << i;
+        EXPECT_LE(sensitivities.dlaptimedwr[i], 1.0e-8) << ", with i = " << i;
+    }
+
+    // Compare with finite differences, solving the perturbed problems warm started from the solution
+    auto perturbed_laptime = [&](const Car_t& car_perturbed) -> scalar
+    {
+        Optimal_laptime perturbed(opt_laptime.s, false, true, car_perturbed, opt_laptime.q, opt_laptime.qa, opt_laptime.control_variables, 
+                                  opt_laptime.optimization_data.zl, opt_laptime.optimization_data.zu, opt_laptime.optimization_data.lambda, opts);
+
+        return perturbed.laptime;
+    };
+
+    // (1) Track limits: widen the whole track, the derivative is the sum of the pointwise sensitivities
+    const scalar dw = 1.0e-2;
+    for (size_t side = 0; side < 2; ++side)
+    {
+        Car_t car_plus(car), car_minus(car);
+        car_plus.get_road().set_track_limits_perturbation((side == 0 ? dw : 0.0), (side == 1 ? dw : 0.0));
+        car_minus.get_road().set_track_limits_perturbation((side == 0 ? -dw : 0.0), (side == 1 ? -dw : 0.0));
+
+        const scalar dlaptimedw_fd = (perturbed_laptime(car_plus) - perturbed_laptime(car_minus))/(2.0*dw);
+
+        const auto& dlaptimedw = (side == 0 ? sensitivities.dlaptimedwl : sensitivities.dlaptimedwr);
+        const scalar dlaptimedw_adjoint = std::accumulate(dlaptimedw.cbegin(), dlaptimedw.cend(), 0.0);
+
+        EXPECT_NEAR(dlaptimedw_adjoint, dlaptimedw_fd, 0.05*std::abs(dlaptimedw_fd) + 1.0e-4) << ", with side = " << side;
+    }
+
+    // (2) Curvature at the point with the largest sensitivity
+    const size_t i_max = std::distance(sensitivities.dlaptimedkappa.cbegin(), 
+        std::max_element(sensitivities.dlaptimedkappa.cbegin()+1, sensitivities.dlaptimedkappa.cend()-1, 
+                         [](const auto& a, const auto& b) -> auto { return std::abs(a) < std::abs(b); }));
+
+    const scalar dkappa = 1.0e-5;
+    Car_t car_plus(car), car_minus(car);
+    car_plus.get_road().set_curvature_perturbation({opt_laptime.s[i_max]}, {dkappa});
+    car_minus.get_road().set_curvature_perturbation({opt_laptime.s[i_max]}, {-dkappa});
+
+    const scalar dlaptimedkappa_fd = (perturbed_laptime(car_plus) - perturbed_laptime(car_minus))/(2.0*dkappa);
+
+    EXPECT_GT(std::abs(sensitivities.dlaptimedkappa[i_max]), 0.0);
+    EXPECT_NEAR(sensitivities.dlaptimedkappa[i_max], dlaptimedkappa_fd, 0.05*std::abs(dlaptimedkappa_fd));
+}
+
+
+TEST_F(F1_optimal_laptime_test, Catalunya_chicane_reoptimize_window)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    using Car_t = limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p;
+
+    Optimal_laptime<Car_t>::Options opts;
+    auto opt_laptime = solve_catalunya_chicane(database, car_cartesian, opts);
+
+    Xml_document catalunya_xml("./database/tracks/catalunya/catalunya_adapted.xml",true);
+    Circuit_preprocessor catalunya_pproc(catalunya_xml);
+    Track_by_polynomial catalunya(catalunya_pproc);
+    
+    Car_t::Road_t road(catalunya);
+    Car_t car(database, road);
+
+    const size_t i_start = 40;
+    const size_t i_end   = 80;
+
+    // Integral quantities of a solution, recomputed over all its elements
+    auto check_integral_quantities = [&](const Optimal_laptime<Car_t>& solution, const Car_t& car_solution)
+    {
+        const auto values = solution.integrate_quantities(car_solution, 0, solution.n_points - 1);
+
+        for (size_t k = 0; k < values.size(); ++k)
+            EXPECT_NEAR(solution.integral_quantities[k].value, values[k], 1.0e-8*std::max(1.0, std::abs(values[k])))
+                << ", with quantity = " << solution.integral_quantities[k].name;
+    };
+
+    check_integral_quantities(opt_laptime, car);
+
+    // (1) Without changes, the window reproduces the solution
+    auto opt_laptime_same = opt_laptime;
+    const auto window_same = opt_laptime_same.reoptimize_window(car, i_start, i_end);
+
+    EXPECT_TRUE(window_same.success);
+    EXPECT_EQ(window_same.n_points, i_end - i_start + 1);
+    EXPECT_NEAR(opt_laptime_same.laptime, opt_laptime.laptime, 1.0e-6);
+
+    for (size_t i = 0; i < opt_laptime.n_points; ++i)
+    {
+        EXPECT_NEAR(opt_laptime_same.q[i][Car_t::Chassis_type::IU], opt_laptime.q[i][Car_t::Chassis_type::IU], 1.0e-5) << ", with i = " << i;
+        EXPECT_NEAR(opt_laptime_same.q[i][Car_t::Road_type::IN], opt_laptime.q[i][Car_t::Road_type::IN], 1.0e-5) << ", with i = " << i;
+        EXPECT_NEAR(opt_laptime_same.q[i][Car_t::Road_type::ITIME], opt_laptime.q[i][Car_t::Road_type::ITIME], 1.0e-6) << ", with i = " << i;
+    }
+
+    // (2) With a wider track, the window gets faster and the rest of the lap is only shifted in time
+    Car_t car_wider(car);
+    car_wider.get_road().set_track_limits_perturbation(0.5, 0.5);
+
+    auto opt_laptime_wider = opt_laptime;
+    const auto window_wider = opt_laptime_wider.reoptimize_window(car_wider, i_start, i_end);
+
+    EXPECT_TRUE(window_wider.success);
+    EXPECT_LT(opt_laptime_wider.laptime, opt_laptime.laptime);
+
+    const scalar delta_time = opt_laptime_wider.laptime - opt_laptime.laptime;
+
+    for (size_t i = 0; i < opt_laptime.n_points; ++i)
+    {
+        if ( (i >= i_start) && (i <= i_end) ) 
+            continue;
+
+        EXPECT_EQ(opt_laptime_wider.q[i][Car_t::Chassis_type::IU], opt_laptime.q[i][Car_t::Chassis_type::IU]) << ", with i = " << i;
+        EXPECT_EQ(opt_laptime_wider.q[i][Car_t::Road_type::IN], opt_laptime.q[i][Car_t::Road_type::IN]) << ", with i = " << i;
+        EXPECT_NEAR(opt_laptime_wider.q[i][Car_t::Road_type::ITIME], 
+                    opt_laptime.q[i][Car_t::Road_type::ITIME] + (i > i_end ? delta_time : 0.0), 1.0e-10) << ", with i = " << i;
+    }
+
+    // (2.1) The ends of the window are tied to the lap
+    for (size_t j = 0; j < Car_t::NSTATE; ++j)
+    {
+        if ( j == Car_t::Road_type::ITIME ) 
+            continue;
+
+        EXPECT_NEAR(window_wider.q.front()[j], opt_laptime.q[i_start][j], 1.0e-10) << ", with j = " << j;
+        EXPECT_NEAR(window_wider.q.back()[j], opt_laptime.q[i_end][j], 1.0e-8) << ", with j = " << j;
+    }
+
+    // (2.2) The integral quantities include the contribution of the new window
+    check_integral_quantities(opt_laptime_wider, car_wider);
+
+    // (3) A window that does not converge leaves the lap unchanged
+    auto opt_laptime_failed = opt_laptime;
+    opt_laptime_failed.options.maximum_iterations = 1;
+    opt_laptime_failed.options.throw_if_fail      = false;
+
+    const auto window_failed = opt_laptime_failed.reoptimize_window(car_wider, i_start, i_end);
+
+    EXPECT_FALSE(window_failed.success);
+    EXPECT_TRUE(opt_laptime_failed.success);
+    EXPECT_EQ(opt_laptime_failed.laptime, opt_laptime.laptime);
+    EXPECT_EQ(opt_laptime_failed.q, opt_laptime.q);
+    EXPECT_EQ(opt_laptime_failed.qa, opt_laptime.qa);
+    EXPECT_EQ(opt_laptime_failed.optimization_data.x, opt_laptime.optimization_data.x);
+
+    // (3.1) With throw_if_fail, it throws
+    opt_laptime_failed.options.throw_if_fail = true;
+
+    EXPECT_THROW(opt_laptime_failed.reoptimize_window(car_wider, i_start, i_end), fastest_lap_exception);
+    EXPECT_EQ(opt_laptime_failed.q, opt_laptime.q);
+}
+
+
+TEST_F(F1_optimal_laptime_test, Catalunya_chicane_quasi_steady_slip)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    // The comparison of iterations and laptimes against the dynamic slips for several meshes is in 
+    // src/benchmark/optimal_laptime_quasi_steady_slip_benchmark.cpp
+    using Car_t = limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p;
+
+    Optimal_laptime<Car_t>::Options opts_quasi_steady;
+    opts_quasi_steady.quasi_steady_slip = true;
+
+    const auto opt_laptime = solve_catalunya_chicane(database, car_cartesian, opts_quasi_steady);
+
+    ASSERT_TRUE(opt_laptime.success);
+
+    Xml_document catalunya_xml("./database/tracks/catalunya/catalunya_adapted.xml",true);
+    Circuit_preprocessor catalunya_pproc(catalunya_xml);
+    Track_by_polynomial catalunya(catalunya_pproc);
+    Car_t::Road_t road(catalunya);
+    Car_t car(database, road);
+
+    // (1) The wheels are in equilibrium at every point but the first, which is given
+    const auto is_slip = Car_t::get_slip_states();
+
+    for (size_t i = 1; i < opt_laptime.n_points; ++i)
+    {
+        std::array<CppAD::AD<scalar>,Car_t::NSTATE> q;
+        std::array<CppAD::AD<scalar>,Car_t::NALGEBRAIC> qa;
+        std::array<CppAD::AD<scalar>,Car_t::NCONTROL> u;
+        const auto u_i = opt_laptime.control_variables.control_array_at_s(car, i, opt_laptime.s[i]);
+
+        std::copy(opt_laptime.q[i].cbegin(), opt_laptime.q[i].cend(), q.begin());
+        std::copy(opt_laptime.qa[i].cbegin(), opt_laptime.qa[i].cend(), qa.begin());
+        std::copy(u_i.cbegin(), u_i.cend(), u.begin());
+
+        const auto [dqdt, dqa] = car(q, qa, u, opt_laptime.s[i]);
+
+        for (size_t j = 0; j < Car_t::NSTATE; ++j)
+        {
+            if ( is_slip[j] )
+                EXPECT_NEAR(Value(dqdt[j]), 0.0, 1.0e-7) << ", with i = " << i << ", j = " << j;
+        }
+    }
+
+    // (2) The wheel dynamics are much faster than the vehicle dynamics: the laptime agrees with the dynamic slips
+    Xml_document opt_saved("data/f1_optimal_laptime_catalunya_chicane.xml", true);
+    auto time_saved = opt_saved.get_element("optimal_laptime/time").get_value(std::vector<scalar>());
+
+    EXPECT_NEAR(opt_laptime.q.back()[Car_t::Road_t::ITIME], time_saved.back(), 1.0e-2);
+}
+
+
+TEST_F(F1_optimal_laptime_test, Catalunya_chicane_output_specification)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    using Car_t = limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p;
+
+    // (1) Solve the chicane keeping everything, and keeping only a few channels
+    Optimal_laptime<Car_t>::Options opts_full;
+    Optimal_laptime<Car_t>::Options opts_compact;
+    opts_compact.output.solution          = false;
+    opts_compact.output.coordinates       = false;
+    opts_compact.output.optimization_data = false;
+    opts_compact.output.channels          = {"u", "time", "Fz_fl", "throttle", "brake-bias", "x"};
+
+    auto opt_laptime_full    = solve_catalunya_chicane(database, car_cartesian, opts_full);
+    auto opt_laptime_compact = solve_catalunya_chicane(database, car_cartesian, opts_compact);
+
+    EXPECT_TRUE(opt_laptime_compact.success);
+    EXPECT_DOUBLE_EQ(opt_laptime_compact.laptime, opt_laptime_full.laptime);
+
+    // (2) The discarded buffers are released
+    EXPECT_EQ(opt_laptime_compact.q.size(), 0);
+    EXPECT_EQ(opt_laptime_compact.qa.size(), 0);
+    EXPECT_EQ(opt_laptime_compact.control_variables[Car_t::Chassis_type::ITHROTTLE].u.size(), 0);
+    EXPECT_EQ(opt_laptime_compact.x_coord.size(), 0);
+    EXPECT_EQ(opt_laptime_compact.psi.size(), 0);
+    EXPECT_EQ(opt_laptime_compact.optimization_data.x.size(), 0);
+    EXPECT_EQ(opt_laptime_compact.optimization_data.lambda.size(), 0);
+    EXPECT_EQ(opt_laptime_full.channels.size(), 0);
+
+    EXPECT_THROW(opt_laptime_compact.xml(), fastest_lap_exception);
+
+    // (3) The channels kept match the full solution
+    ASSERT_EQ(opt_laptime_compact.channels.size(), opts_compact.output.channels.size());
+
+    const auto& u        = opt_laptime_compact.channels.at("u");
+    const auto& time     = opt_laptime_compact.channels.at("time");
+    const auto& Fz_fl    = opt_laptime_compact.channels.at("Fz_fl");
+    const auto& throttle = opt_laptime_compact.channels.at("throttle");
+    const auto& x        = opt_laptime_compact.channels.at("x");
+
+    ASSERT_EQ(u.size(), opt_laptime_full.n_points);
+
+    for (size_t i = 0; i < opt_laptime_full.n_points; ++i)
+    {
+        EXPECT_DOUBLE_EQ(u[i], opt_laptime_full.q[i][Car_t::Chassis_type::IU]);
+        EXPECT_DOUBLE_EQ(time[i], opt_laptime_full.q[i][Car_t::Road_type::ITIME]);
+        EXPECT_DOUBLE_EQ(Fz_fl[i], opt_laptime_full.qa[i][Car_t::Chassis_type::IFZFL]);
+        EXPECT_DOUBLE_EQ(throttle[i], opt_laptime_full.control_variables[Car_t::Chassis_type::ITHROTTLE].u[i]);
+        EXPECT_DOUBLE_EQ(x[i], opt_laptime_full.x_coord[i]);
+    }
+
+    // (4) Unknown channels are reported before the optimization is run
+    opts_compact.output.channels = {"not-a-channel"};
+    EXPECT_THROW(solve_catalunya_chicane(database, car_cartesian, opts_compact), fastest_lap_exception);
+
+    // (4.1) Also when reoptimizing a window: the lap is not modified
+    const auto q_full = opt_laptime_full.q;
+    opt_laptime_full.options.output.channels = {"not-a-channel"};
+
+    Xml_document catalunya_xml("./database/tracks/catalunya/catalunya_adapted.xml",true);
+    Circuit_preprocessor catalunya_pproc(catalunya_xml);
+    Track_by_polynomial catalunya(catalunya_pproc);
+    Car_t::Road_t road(catalunya);
+    Car_t car(database, road);
+
+    EXPECT_THROW(opt_laptime_full.reoptimize_window(car, 10, 20), fastest_lap_exception);
+    EXPECT_EQ(opt_laptime_full.q, q_full);
+}
+
+
+#ifdef TEST_LIBFASTESTLAPC
+#include <cstdio>
+#include <sstream>
+#include "src/main/c/fastestlapc.h"
+#include "src/core/foundation/sweep_result_store.h"
+
+TEST_F(F1_optimal_laptime_test, sweep_result_store_c_api)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    // Sweep the mass of the car: every optimal laptime is appended as a run of the store
+    set_print_level(0);
+    create_vehicle_from_xml("f1_sweep_result_store", "./database/vehicles/f1/limebeer-2014-f1.xml");
+    create_track_from_xml("catalunya_sweep_result_store", "./database/tracks/catalunya/catalunya_discrete.xml");
+
+    std::vector<double> s(track_download_number_of_points("catalunya_sweep_result_store"));
+    track_download_data(s.data(), "catalunya_sweep_result_store", s.size(), "arclength");
+
+    sweep_result_store_open("mass_sweep", "f1_optimal_laptime_sweep_result_store.flsweep", 128);
+
+    const std::vector<double> masses = {660.0, 680.0};
+
+    for (size_t i = 0; i < masses.size(); ++i)
+    {
+        vehicle_set_parameter("f1_sweep_result_store", "vehicle/chassis/mass", masses[i]);
+
+        std::ostringstream options;
+        options << "<options>" << std::endl;
+        options << "    <warm_start> " << (i > 0 ? "true" : "false") << " </warm_start>" << std::endl;
+        options << "    <save_warm_start> true </save_warm_start>" << std::endl;
+        options << "    <output_variables>" << std::endl;
+        options << "        <prefix>run" << i << "/</prefix>" << std::endl;
+        options << "        <variables>" << std::endl;
+        options << "            <u/>" << std::endl;
+        options << "            <time/>" << std::endl;
+        options << "            <laptime/>" << std::endl;
+        options << "        </variables>" << std::endl;
+        options << "    </output_variables>" << std::endl;
+        options << "    <sweep_result_store>" << std::endl;
+        options << "        <name> mass_sweep </name>" << std::endl;
+        options << "        <run_name> mass-" << i << " </run_name>" << std::endl;
+        options << "        <parameters>" << std::endl;
+        options << "            <mass> " << masses[i] << " </mass>" << std::endl;
+        options << "        </parameters>" << std::endl;
+        options << "    </sweep_result_store>" << std::endl;
+        options << "</options>" << std::endl;
+
+        optimal_laptime("f1_sweep_result_store", "catalunya_sweep_result_store", s.size(), s.data(), options.str().c_str());
+    }
+
+    sweep_result_store_close("mass_sweep");
+
+    // The store contains the same values as the tables
+    Sweep_result_store::Reader store("f1_optimal_laptime_sweep_result_store.flsweep");
+
+    ASSERT_EQ(store.get_n_runs(), masses.size());
+    EXPECT_EQ(store.get_chunk_size(), 128);
+
+    for (size_t i = 0; i < masses.size(); ++i)
+    {
+        const std::string prefix = "run" + std::to_string(i) + "/";
+        const auto& metadata = store.get_metadata(i);
+
+        EXPECT_EQ(metadata.name, "mass-" + std::to_string(i));
+        EXPECT_EQ(metadata.parameters.at("mass"), masses[i]);
+        EXPECT_TRUE(metadata.success);
+        EXPECT_GT(metadata.iter_count, 0);
+        EXPECT_DOUBLE_EQ(metadata.laptime, download_scalar((prefix + "laptime").c_str()));
+
+        EXPECT_EQ(store.get_channel_names(i), (std::vector<std::string>{"arclength", "time", "u"}));
+        EXPECT_EQ(store.get_channel(i, "arclength"), s);
+
+        for (const std::string variable : {"u", "time"})
+        {
+            std::vector<double> data(download_vector_size((prefix + variable).c_str()));
+            download_vector(data.data(), data.size(), (prefix + variable).c_str());
+
+            EXPECT_EQ(store.get_channel(i, variable), data) << ", with variable = " << variable;
+        }
+    }
+
+    // The heavier car is slower
+    EXPECT_GT(store.get_metadata(1).laptime, store.get_metadata(0).laptime);
+
+    // The store is released once closed
+    EXPECT_THROW(sweep_result_store_close("mass_sweep"), fastest_lap_exception);
+
+    delete_variables_by_prefix("run0/");
+    delete_variables_by_prefix("run1/");
+    delete_variable("f1_sweep_result_store");
+    delete_variable("catalunya_sweep_result_store");
+}
+TEST_F(F1_optimal_laptime_test, sensitivity_file_c_api)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    set_print_level(0);
+    create_vehicle_from_xml("f1_sensitivity_file", "./database/vehicles/f1/limebeer-2014-f1.xml");
+    create_track_from_xml("catalunya_sensitivity_file", "./database/tracks/catalunya/catalunya_discrete.xml");
+    vehicle_declare_new_constant_parameter("f1_sensitivity_file", "vehicle/chassis/mass", "mass", 660.0);
+
+    std::vector<double> s(track_download_number_of_points("catalunya_sensitivity_file"));
+    track_download_data(s.data(), "catalunya_sensitivity_file", s.size(), "arclength");
+
+    auto get_options = [](const std::string& prefix, const bool warm_start, const std::string& sensitivity_file)
+    {
+        std::ostringstream options;
+        options << "<options>" << std::endl;
+        options << "    <warm_start> " << (warm_start ? "true" : "false") << " </warm_start>" << std::endl;
+        options << "    <save_warm_start> true </save_warm_start>" << std::endl;
+        options << "    <compute_sensitivity> true </compute_sensitivity>" << std::endl;
+
+        if ( sensitivity_file.size() > 0 )
+            options << "    <sensitivity_file> " << sensitivity_file << " </sensitivity_file>" << std::endl;
+
+        options << "    <output_variables>" << std::endl;
+        options << "        <prefix>" << prefix << "</prefix>" << std::endl;
+        options << "        <variables>" << std::endl;
+        options << "            <u/>" << std::endl;
+        options << "            <time/>" << std::endl;
+        options << "            <laptime/>" << std::endl;
+        options << "        </variables>" << std::endl;
+        options << "    </output_variables>" << std::endl;
+        options << "</options>" << std::endl;
+
+        return options.str();
+    };
+
+    // (1) Reference: the derivatives are stored in the tables
+    optimal_laptime("f1_sensitivity_file", "catalunya_sensitivity_file", s.size(), s.data(), 
+        get_options("stored/", false, "").c_str());
+
+    // (2) The same problem, warm started, with the derivatives streamed to a sweep result store
+    std::remove("f1_optimal_laptime_sensitivities.flsweep");
+
+    optimal_laptime("f1_sensitivity_file", "catalunya_sensitivity_file", s.size(), s.data(), 
+        get_options("streamed/", true, "f1_optimal_laptime_sensitivities.flsweep").c_str());
+
+    EXPECT_EQ(download_vector_size("streamed/u"), s.size());
+    EXPECT_THROW(download_vector_size("streamed/derivatives/u/mass"), fastest_lap_exception);
+
+    // (3) One run per parameter, with the same values as the tables
+    Sweep_result_store::Reader store("f1_optimal_laptime_sensitivities.flsweep");
+
+    ASSERT_EQ(store.get_n_runs(), 1);
+    EXPECT_EQ(store.get_metadata(0).name, "mass");
+
+    const auto dlaptimedp = store.get_channel(0, "laptime");
+    ASSERT_EQ(dlaptimedp.size(), 1);
+    EXPECT_NEAR(dlaptimedp.front(), download_scalar("stored/derivatives/laptime/mass"), 1.0e-6);
+
+    for (const std::string variable : {"u", "time"})
+    {
+        std::vector<double> data(download_vector_size(("stored/derivatives/" + variable + "/mass").c_str()));
+        download_vector(data.data(), data.size(), ("stored/derivatives/" + variable + "/mass").c_str());
+
+        const auto streamed = store.get_channel(0, variable);
+        ASSERT_EQ(streamed.size(), data.size());
+
+        for (size_t i = 0; i < data.size(); ++i)
+            EXPECT_NEAR(streamed[i], data[i], 1.0e-6*(1.0 + std::abs(data[i]))) << ", with variable = " << variable << ", i = " << i;
+    }
+
+    // (3.1) The full mesh controls are streamed too
+    EXPECT_TRUE(store.has_channel(0, "throttle"));
+    EXPECT_TRUE(store.has_channel(0, "delta"));
+
+    delete_variables_by_prefix("stored/");
+    delete_variables_by_prefix("streamed/");
+    delete_variable("f1_sensitivity_file");
+    delete_variable("catalunya_sensitivity_file");
+}
+#endif
@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+#include "src/core/applications/path_tracking_nmpc.h"
+#include "src/core/vehicles/limebeer2014f1.h"
+#include "lion/thirdparty/include/cppad/cppad.hpp"
+#include "src/core/applications/circuit_preprocessor.h"
+
+extern bool is_valgrind;
+
+class F1_path_tracking_nmpc_test : public ::testing::Test
+{
+ protected:
+    using Car_t = limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p;
+
+    F1_path_tracking_nmpc_test()
+    {
+        // Read the reference: the optimal laptime of the Catalunya chicane
+        Xml_document opt_saved("data/f1_optimal_laptime_catalunya_chicane.xml", true);
+
+        s_ref = opt_saved.get_element("optimal_laptime/arclength").get_value(std::vector<scalar>());
+        const size_t n = s_ref.size();
+
+        auto read = [&](const std::string& name) -> auto { return opt_saved.get_element("optimal_laptime/" + name).get_value(std::vector<scalar>()); };
+
+        const auto kappa_fl = read("steering-kappa-left");
+        const auto kappa_fr = read("steering-kappa-right");
+        const auto kappa_rl = read("powered-kappa-left");
+        const auto kappa_rr = read("powered-kappa-right");
+        const auto u        = read("u");
+        const auto v        = read("v");
+        const auto omega    = read("omega");
+        const auto time     = read("time");
+        const auto n_lat    = read("n");
+        const auto alpha    = read("alpha");
+        const auto Fz_fl    = read("Fz_fl");
+        const auto Fz_fr    = read("Fz_fr");
+        const auto Fz_rl    = read("Fz_rl");
+        const auto Fz_rr    = read("Fz_rr");
+        const auto delta    = read("delta");
+        const auto throttle = read("throttle");
+
+        q_ref  = std::vector<std::array<scalar,Car_t::NSTATE>>(n);
+        qa_ref = std::vector<std::array<scalar,Car_t::NALGEBRAIC>>(n);
+        u_ref  = std::vector<std::array<scalar,Car_t::NCONTROL>>(n, car.get_state_and_control_upper_lower_and_default_values().u_def);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            q_ref[i][limebeer2014f1<scalar>::Front_axle_t::IKAPPA_LEFT]  = kappa_fl[i];
+            q_ref[i][limebeer2014f1<scalar>::Front_axle_t::IKAPPA_RIGHT] = kappa_fr[i];
+            q_ref[i][limebeer2014f1<scalar>::Rear_axle_t::IKAPPA_LEFT]   = kappa_rl[i];
+            q_ref[i][limebeer2014f1<scalar>::Rear_axle_t::IKAPPA_RIGHT]  = kappa_rr[i];
+            q_ref[i][limebeer2014f1<scalar>::Chassis_t::IU]              = u[i];
+            q_ref[i][limebeer2014f1<scalar>::Chassis_t::IV]              = v[i];
+            q_ref[i][limebeer2014f1<scalar>::Chassis_t::IOMEGA]          = omega[i];
+            q_ref[i][Car_t::Road_type::ITIME]                             = time[i];
+            q_ref[i][Car_t::Road_type::IN]                                = n_lat[i];
+            q_ref[i][Car_t::Road_type::IALPHA]                            = alpha[i];
+
+            qa_ref[i][limebeer2014f1<scalar>::Chassis_t::IFZFL] = Fz_fl[i];
+            qa_ref[i][limebeer2014f1<scalar>::Chassis_t::IFZFR] = Fz_fr[i];
+            qa_ref[i][limebeer2014f1<scalar>::Chassis_t::IFZRL] = Fz_rl[i];
+            qa_ref[i][limebeer2014f1<scalar>::Chassis_t::IFZRR] = Fz_rr[i];
+
+            u_ref[i][limebeer2014f1<scalar>::Front_axle_t::ISTEERING] = delta[i];
+            u_ref[i][limebeer2014f1<scalar>::Chassis_t::ITHROTTLE]    = throttle[i];
+        }
+    }
+
+    Xml_document database = {"./database/vehicles/f1/limebeer-2014-f1.xml", true};
+    Xml_document catalunya_xml = {"./database/tracks/catalunya/catalunya_adapted.xml", true};
+    Circuit_preprocessor catalunya_pproc = {catalunya_xml};
+    Track_by_polynomial catalunya = {catalunya_pproc};
+    Car_t::Road_t road = {catalunya};
+    Car_t car = {database, road};
+
+    std::vector<scalar> s_ref;
+    std::vector<std::array<scalar,Car_t::NSTATE>> q_ref;
+    std::vector<std::array<scalar,Car_t::NALGEBRAIC>> qa_ref;
+    std::vector<std::array<scalar,Car_t::NCONTROL>> u_ref;
+};
+
+
+TEST_F(F1_path_tracking_nmpc_test, riccati_and_condensed_agree)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    Path_tracking_nmpc<Car_t>::Options opts;
+    opts.horizon = 10;
+
+    // Start displaced 0.5m from the reference
+    auto q0 = q_ref.front();
+    q0[Car_t::Road_type::IN] += 0.5;
+
+    Path_tracking_nmpc<Car_t> riccati(car, s_ref, false, q_ref, qa_ref, u_ref, opts);
+    const auto u_riccati = riccati.step(0, q0, qa_ref.front(), u_ref.front());
+
+    opts.qp_solver = Path_tracking_nmpc<Car_t>::CONDENSED;
+    Path_tracking_nmpc<Car_t> condensed(car, s_ref, false, q_ref, qa_ref, u_ref, opts);
+    const auto u_condensed = condensed.step(0, q0, qa_ref.front(), u_ref.front());
+
+    for (size_t j = 0; j < Car_t::NCONTROL; ++j)
+        EXPECT_NEAR(u_riccati[j], u_condensed[j], 1.0e-8*(1.0 + std::abs(u_riccati[j])));
+
+    // The controller reacts to the lateral offset
+    EXPECT_GT(std::abs(u_riccati[limebeer2014f1<scalar>::Front_axle_t::ISTEERING] - u_ref[1][limebeer2014f1<scalar>::Front_axle_t::ISTEERING]), 1.0e-6);
+}
+
+
+TEST_F(F1_path_tracking_nmpc_test, Catalunya_chicane_closed_loop)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    Path_tracking_nmpc<Car_t>::Options opts;
+    opts.keep_tapes = false;
+
+    Path_tracking_nmpc<Car_t> nmpc(car, s_ref, false, q_ref, qa_ref, u_ref, opts);
+
+    // Start displaced 0.5m from the reference, and push the car laterally halfway through the chicane
+    auto q0 = q_ref.front();
+    q0[Car_t::Road_type::IN] += 0.5;
+
+    const size_t i_disturbance = s_ref.size()/2;
+    auto disturbance = [&](const size_t i, auto& q, auto&) { if ( i == i_disturbance ) q[Car_t::Road_type::IN] -= 0.3; };
+
+    auto solution = nmpc.simulate(q0, qa_ref.front(), u_ref.front(), 0, s_ref.size()-1, disturbance);
+
+    ASSERT_TRUE(solution.success);
+    ASSERT_EQ(solution.q.size(), s_ref.size());
+
+    // One controller step per simulated element: the controller wall time is measured by path_tracking_nmpc_benchmark
+    EXPECT_EQ(solution.computation_time.size(), s_ref.size()-1);
+
+    // The tapes behind the horizon were released
+    EXPECT_LE(nmpc.get_number_of_tapes(), opts.horizon + 1);
+
+    // The lateral error is recovered at the end of the chicane
+    EXPECT_LT(std::abs(solution.q.back()[Car_t::Road_type::IN] - q_ref.back()[Car_t::Road_type::IN]), 0.1);
+
+    // The elapsed time is close to the reference
+    const scalar reference_time = q_ref.back()[Car_t::Road_type::ITIME] - q_ref.front()[Car_t::Road_type::ITIME];
+    EXPECT_NEAR(solution.simulated_time, reference_time, 0.01*reference_time);
+}
@@ -339,6 +339,89 @@ TEST_F(F1_sensitivity_analysis, maximum_acceleration)
 }
 
 
+TEST_F(F1_sensitivity_analysis, maximum_acceleration_streamed)
+{
+    Xml_document straight_xml("./data/straight.xml",true);
+    Track_by_arcs straight(straight_xml,10.0,false);
+
+    limebeer2014f1<CppAD::AD<scalar>>::curvilinear<Track_by_arcs> car(database, {straight});
+
+    car.add_parameter("vehicle/chassis/mass"                 , "mass" , 660.0);
+    car.add_parameter("vehicle/chassis/aerodynamics/cd"      , "cd"   , 0.9);
+    car.add_parameter("vehicle/chassis/aerodynamics/cl"      , "cl"   , 3.0);
+    car.add_parameter("vehicle/rear-axle/engine/maximum-power", "power", 735.499);
+
+    constexpr const size_t n = 50;
+    auto s = linspace(0.0,straight.get_total_length(),n+1);
+
+    const scalar v = 80.0*KMH;
+    auto ss = Steady_state(car_cartesian).solve(v,0.0,0.0); 
+
+    auto control_variables = Optimal_laptime<decltype(car)>::Control_variables<>{};
+
+    control_variables[decltype(car)::Chassis_type::front_axle_type::ISTEERING] 
+        = Optimal_laptime<decltype(car)>::create_full_mesh(std::vector<scalar>(n+1,ss.u[decltype(car)::Chassis_type::front_axle_type::ISTEERING]), 0.0e0);
+
+    control_variables[decltype(car)::Chassis_type::ITHROTTLE] 
+        = Optimal_laptime<decltype(car)>::create_full_mesh(std::vector<scalar>(n+1,ss.u[decltype(car)::Chassis_type::ITHROTTLE]), 4.0e-7);
+
+    control_variables[decltype(car)::Chassis_type::IBRAKE_BIAS] 
+        = Optimal_laptime<decltype(car)>::create_dont_optimize();
+
+    // (1) Reference: all the parameters at once, stored
+    auto opts = Optimal_laptime<decltype(car)>::Options{};
+    opts.check_optimality = true;
+    Optimal_laptime opt_laptime(s, false, true, car, {n+1,ss.q}, {n+1,ss.qa}, control_variables, opts);
+
+    ASSERT_EQ(opt_laptime.dqdp.size(), 4);
+
+    // (2) Chunks of 3 parameters, streamed to a callback
+    std::vector<size_t> parameters_received;
+    std::vector<typename Optimal_laptime<decltype(car)>::Parameter_sensitivity> sensitivities_received;
+
+    opts.sensitivity_chunk_size = 3;
+    opts.sensitivity_callback = [&](const size_t i, const auto& sensitivity) 
+        { 
+            parameters_received.push_back(i); 
+            sensitivities_received.push_back(sensitivity); 
+        };
+
+    Optimal_laptime opt_laptime_streamed(s, false, true, car, {n+1,ss.q}, {n+1,ss.qa}, control_variables, opts);
+
+    // (2.1) The full tensors are not stored, except the laptime derivatives
+    EXPECT_EQ(opt_laptime_streamed.dqdp.size(), 0);
+    EXPECT_EQ(opt_laptime_streamed.dqadp.size(), 0);
+    EXPECT_EQ(opt_laptime_streamed.dcontrol_variablesdp.size(), 0);
+    EXPECT_EQ(opt_laptime_streamed.dxdp.size(), 0);
+    ASSERT_EQ(opt_laptime_streamed.dlaptimedp.size(), 4);
+
+    // (2.2) Every parameter is received once, in order, with the same derivatives
+    ASSERT_EQ(parameters_received, (std::vector<size_t>{0, 1, 2, 3}));
+
+    for (size_t p = 0; p < 4; ++p)
+    {
+        const auto& sensitivity = sensitivities_received[p];
+
+        EXPECT_NEAR(sensitivity.dlaptimedp, opt_laptime.dlaptimedp[p], 1.0e-10);
+        EXPECT_NEAR(opt_laptime_streamed.dlaptimedp[p], opt_laptime.dlaptimedp[p], 1.0e-10);
+
+        ASSERT_EQ(sensitivity.dqdp.size(), n+1);
+
+        for (size_t i = 0; i < n+1; ++i)
+        {
+            for (size_t j = 0; j < decltype(car)::NSTATE; ++j)
+                EXPECT_NEAR(sensitivity.dqdp[i][j], opt_laptime.dqdp[p][i][j], 1.0e-10) << "p = " << p << ", i = " << i << ", j = " << j;
+
+            for (size_t j = 0; j < decltype(car)::NALGEBRAIC; ++j)
+                EXPECT_NEAR(sensitivity.dqadp[i][j], opt_laptime.dqadp[p][i][j], 1.0e-10) << "p = " << p << ", i = " << i << ", j = " << j;
+
+            EXPECT_NEAR(sensitivity.dcontrol_variablesdp[decltype(car)::Chassis_type::ITHROTTLE].u[i], 
+                        opt_laptime.dcontrol_variablesdp[p][decltype(car)::Chassis_type::ITHROTTLE].u[i], 1.0e-10);
+        }
+    }
+}
+
+
 TEST_F(F1_sensitivity_analysis, Catalunya_discrete)
 {
     if ( is_valgrind ) GTEST_SKIP();
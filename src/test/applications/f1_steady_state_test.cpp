@@ -673,3 +673,117 @@ TEST_F(Steady_state_test_f1, max_lateral_accel_300kmh)
     
     EXPECT_TRUE(solution.solved);
 }
+
+
+#ifdef TEST_LIBFASTESTLAPC
+#include "src/main/c/fastestlapc.h"
+
+TEST_F(Steady_state_test_f1, steady_state_batch_c_api)
+{
+    using vehicle_t = limebeer2014f1<CppAD::AD<scalar>>::cartesian;
+
+    set_print_level(0);
+    create_vehicle_from_xml("f1_steady_state_batch", "./database/vehicles/f1/limebeer-2014-f1.xml");
+
+    int n_state, n_algebraic, n_control;
+    vehicle_get_number_of_variables(&n_state, &n_algebraic, &n_control, "f1_steady_state_batch");
+
+    ASSERT_EQ(n_state, vehicle_t::NSTATE);
+    ASSERT_EQ(n_algebraic, vehicle_t::NALGEBRAIC);
+    ASSERT_EQ(n_control, vehicle_t::NCONTROL);
+
+    // Increasing lateral accelerations at 150km/h. The last point is not achievable
+    const int n = 9;
+    std::vector<double> v(n, 150.0*KMH), ax(n, 0.0), ay(n);
+    for (int i = 0; i < n-1; ++i)
+        ay[i] = 2.0*i;
+
+    ay.back() = 200.0;
+
+    std::vector<double> q(n*n_state), qa(n*n_algebraic), u(n*n_control);
+    bool success[n];
+
+    steady_state_batch(q.data(), qa.data(), u.data(), success, "f1_steady_state_batch", n, v.data(), ax.data(), ay.data(), 3);
+
+    for (int i = 0; i < n-1; ++i)
+    {
+        ASSERT_TRUE(success[i]) << ", with i = " << i;
+
+        // Same solution as a sequential solve
+        auto solution = Steady_state(car).solve(v[i], ax[i], ay[i]);
+
+        for (int j = 0; j < n_state; ++j)
+            EXPECT_NEAR(q[i*n_state+j], solution.q[j], 1.0e-6*(1.0 + std::abs(solution.q[j]))) << ", with i = " << i;
+
+        for (int j = 0; j < n_algebraic; ++j)
+            EXPECT_NEAR(qa[i*n_algebraic+j], solution.qa[j], 1.0e-6*(1.0 + std::abs(solution.qa[j]))) << ", with i = " << i;
+
+        for (int j = 0; j < n_control; ++j)
+            EXPECT_NEAR(u[i*n_control+j], solution.u[j], 1.0e-6*(1.0 + std::abs(solution.u[j]))) << ", with i = " << i;
+    }
+
+    EXPECT_FALSE(success[n-1]);
+    EXPECT_TRUE(std::isnan(q[(n-1)*n_state]));
+
+    delete_variable("f1_steady_state_batch");
+}
+
+
+std::pair<size_t,size_t> get_artefacts_statistics(const std::string& vehicle_name, const std::string& artefact);
+
+TEST_F(Steady_state_test_f1, gg_diagram_c_api_reuse)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    set_print_level(0);
+    create_vehicle_from_xml("f1_gg_diagram_reuse", "./database/vehicles/f1/limebeer-2014-f1.xml");
+
+    const int n = 20;
+    const double v = 150.0*KMH;
+
+    auto compute = [&]() -> std::array<std::vector<double>,3>
+    {
+        std::array<std::vector<double>,3> diagram = {std::vector<double>(n), std::vector<double>(n), std::vector<double>(n)};
+        gg_diagram(diagram[0].data(), diagram[1].data(), diagram[2].data(), "f1_gg_diagram_reuse", v, n);
+        return diagram;
+    };
+
+    // Number of diagrams {computed, reused}
+    auto statistics = [&]() { return get_artefacts_statistics("f1_gg_diagram_reuse", "gg_diagram"); };
+
+    // (1) First computation, and the same diagram again
+    const auto diagram = compute();
+    EXPECT_EQ(statistics(), std::pair<size_t,size_t>(1, 0));
+
+    const auto diagram_again = compute();
+    EXPECT_EQ(statistics(), std::pair<size_t,size_t>(1, 1));
+
+    EXPECT_EQ(diagram_again, diagram);
+
+    // (2) The inertias do not enter the steady state: the diagram is reused
+    vehicle_set_parameter("f1_gg_diagram_reuse", "vehicle/chassis/inertia/Izz", 500.0);
+    const auto diagram_inertia = compute();
+
+    EXPECT_EQ(statistics(), std::pair<size_t,size_t>(1, 2));
+    EXPECT_EQ(diagram_inertia, diagram);
+
+    // (3) The aerodynamics do: the diagram is recomputed
+    vehicle_set_parameter("f1_gg_diagram_reuse", "vehicle/chassis/aerodynamics/cl", 3.5);
+    const auto diagram_cl = compute();
+
+    EXPECT_EQ(statistics(), std::pair<size_t,size_t>(2, 2));
+    EXPECT_GT(diagram_cl[0].back(), diagram[0].back() + 1.0);
+
+    // (4) Back to the original value: recomputed, same diagram
+    vehicle_set_parameter("f1_gg_diagram_reuse", "vehicle/chassis/aerodynamics/cl", 3.0);
+    const auto diagram_back = compute();
+
+    EXPECT_EQ(statistics(), std::pair<size_t,size_t>(3, 2));
+
+    for (size_t k = 0; k < 3; ++k)
+        for (int i = 0; i < n; ++i)
+            EXPECT_NEAR(diagram_back[k][i], diagram[k][i], 1.0e-6) << ", with k = " << k << ", i = " << i;
+
+    delete_variable("f1_gg_diagram_reuse");
+}
+#endif
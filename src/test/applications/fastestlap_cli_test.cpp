@@ -0,0 +1,129 @@
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "src/core/foundation/sweep_result_store.h"
+
+extern bool is_valgrind;
+
+#ifdef FASTESTLAP_EXECUTABLE
+
+//! Read a CSV file written by fastestlap: the header, and the rows
+static std::pair<std::vector<std::string>,std::vector<std::vector<double>>> read_csv(const std::string& file_name)
+{
+    std::ifstream file(file_name);
+    std::string line;
+
+    std::vector<std::string> header;
+    std::vector<std::vector<double>> rows;
+
+    if ( !std::getline(file, line) )
+        return {header, rows};
+
+    std::stringstream s_header(line);
+    for (std::string name; std::getline(s_header, name, ','); )
+        header.push_back(name);
+
+    while ( std::getline(file, line) )
+    {
+        std::stringstream s_row(line);
+        std::vector<double> row;
+
+        for (std::string value; std::getline(s_row, value, ','); )
+            row.push_back(std::stod(value));
+
+        rows.push_back(row);
+    }
+
+    return {header, rows};
+}
+
+
+TEST(Fastestlap_cli_test, optimal_laptime_outputs)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    // (1) Write the job: optimal laptime of catalunya in the mesh of the track, with vector and scalar outputs
+    {
+        std::ofstream options("fastestlap_cli_test_options.xml");
+        options << "<options>" << std::endl;
+        options << "    <print_level> 0 </print_level>" << std::endl;
+        options << "    <output_variables>" << std::endl;
+        options << "        <prefix>run/</prefix>" << std::endl;
+        options << "        <variables>" << std::endl;
+        options << "            <u/>" << std::endl;
+        options << "            <time/>" << std::endl;
+        options << "            <laptime/>" << std::endl;
+        options << "        </variables>" << std::endl;
+        options << "    </output_variables>" << std::endl;
+        options << "</options>" << std::endl;
+
+        std::ofstream job("fastestlap_cli_test_job.xml");
+        job << "<fastest_lap_job>" << std::endl;
+        job << "    <print_level> 0 </print_level>" << std::endl;
+        job << "    <vehicle>" << std::endl;
+        job << "        <name> car </name>" << std::endl;
+        job << "        <database> ./database/vehicles/f1/limebeer-2014-f1.xml </database>" << std::endl;
+        job << "    </vehicle>" << std::endl;
+        job << "    <track>" << std::endl;
+        job << "        <name> catalunya </name>" << std::endl;
+        job << "        <file> ./database/tracks/catalunya/catalunya_discrete.xml </file>" << std::endl;
+        job << "    </track>" << std::endl;
+        job << "    <optimal_laptime>" << std::endl;
+        job << "        <vehicle> car </vehicle>" << std::endl;
+        job << "        <track> catalunya </track>" << std::endl;
+        job << "        <options_file> fastestlap_cli_test_options.xml </options_file>" << std::endl;
+        job << "        <output> fastestlap_cli_test_run.csv </output>" << std::endl;
+        job << "    </optimal_laptime>" << std::endl;
+        job << "    <steady_state_sweep>" << std::endl;
+        job << "        <vehicle> car </vehicle>" << std::endl;
+        job << "        <v> 50.0, 60.0 </v>" << std::endl;
+        job << "        <ax> 0.0 </ax>" << std::endl;
+        job << "        <ay> 0.0 </ay>" << std::endl;
+        job << "        <output> fastestlap_cli_test_steady_state.flsweep </output>" << std::endl;
+        job << "    </steady_state_sweep>" << std::endl;
+        job << "</fastest_lap_job>" << std::endl;
+    }
+
+    std::remove("fastestlap_cli_test_run.csv");
+    std::remove("fastestlap_cli_test_steady_state.flsweep");
+
+    // (2) Run
+    ASSERT_EQ(std::system(FASTESTLAP_EXECUTABLE " fastestlap_cli_test_job.xml"), 0);
+
+    // (3) Check the output file
+    const auto [header, rows] = read_csv("fastestlap_cli_test_run.csv");
+
+    ASSERT_EQ(header, (std::vector<std::string>{"arclength", "u", "time", "laptime"}));
+    ASSERT_EQ(rows.size(), 500);
+
+    const double laptime = rows.front()[3];
+
+    for (const auto& row : rows)
+    {
+        ASSERT_EQ(row.size(), 4);
+        EXPECT_GT(row[1], 0.0);
+        EXPECT_DOUBLE_EQ(row[3], laptime);
+    }
+
+    // (3.1) The laptime is the time of the last point plus the time to close the lap
+    const double track_length = 4634.1501076379418;
+    const double time_last_segment = (track_length - rows.back()[0])/rows.back()[1];
+
+    EXPECT_NEAR(laptime, rows.back()[2] + time_last_segment, 0.05);
+
+    // (4) Binary outputs are sweep result stores, with one run and one channel per column
+    Sweep_result_store::Reader store("fastestlap_cli_test_steady_state.flsweep");
+
+    ASSERT_EQ(store.get_n_runs(), 1);
+    EXPECT_EQ(store.get_metadata(0).name, "steady_state_sweep");
+    EXPECT_EQ(store.get_channel(0, "v"), (std::vector<double>{50.0, 60.0}));
+    EXPECT_EQ(store.get_channel(0, "success"), (std::vector<double>{1.0, 1.0}));
+    EXPECT_TRUE(store.has_channel(0, "q0"));
+    EXPECT_TRUE(store.has_channel(0, "u0"));
+}
+
+#endif
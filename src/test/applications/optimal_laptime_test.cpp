@@ -747,3 +747,60 @@ TEST_F(Optimal_laptime_test, Vendrell)
     for (size_t i = 0; i < n; ++i)
         EXPECT_NEAR(opt_laptime.control_variables[lot2016kart<scalar>::Rear_axle_t::ITORQUE].u[i], torque_saved[i], 5.0e-5);
 }
+
+
+TEST_F(Optimal_laptime_test, control_variables_gather_plan)
+{
+    using Car_t = lot2016kart<scalar>::cartesian;
+    using Optimal_laptime_t = Optimal_laptime<Car_t>;
+    constexpr const size_t ISTEERING = Car_t::Chassis_type::front_axle_type::ISTEERING;
+    constexpr const size_t ITORQUE   = Car_t::Chassis_type::rear_axle_type::ITORQUE;
+
+    // Construct control variables: full mesh steering and hypermesh torque
+    constexpr const size_t n = 20;
+    const auto s = linspace(0.0, 10.0, n+1);
+
+    auto control_variables = Optimal_laptime_t::Control_variables<>{};
+
+    std::vector<scalar> steering(n+1), dsteering(n+1);
+    for (size_t i = 0; i <= n; ++i)
+    {
+        steering[i]  = 0.01*i;
+        dsteering[i] = -0.1*i;
+    }
+
+    control_variables[ISTEERING] = Optimal_laptime_t::create_full_mesh(steering, dsteering, 0.0);
+    control_variables[ITORQUE]   = Optimal_laptime_t::create_hypermesh({0.0, 2.5, 7.5}, {1.0, 2.0, 3.0});
+    control_variables.check();
+
+    // Compute the controls without the gather plan
+    std::vector<std::array<scalar,Car_t::NCONTROL>> u_reference, dudt_reference;
+
+    for (size_t i = 0; i <= n; ++i)
+    {
+        EXPECT_EQ(control_variables.control_array_at_s(car_cartesian_scalar, i, s[i]), 
+                  control_variables.control_array_and_derivative_at_s(car_cartesian_scalar, i, s[i]).first);
+
+        const auto [u, dudt] = control_variables.control_array_and_derivative_at_s(car_cartesian_scalar, i, s[i]);
+        u_reference.push_back(u);
+        dudt_reference.push_back(dudt);
+    }
+
+    // Build the gather plan, and check that the controls are the same
+    control_variables.build_gather_plan(car_cartesian_scalar, s);
+
+    for (size_t i = 0; i <= n; ++i)
+    {
+        EXPECT_EQ(control_variables.control_array_at_s(car_cartesian_scalar, i, s[i]), u_reference[i]) << ", with i = " << i;
+
+        const auto [u, dudt] = control_variables.control_array_and_derivative_at_s(car_cartesian_scalar, i, s[i]);
+        EXPECT_EQ(u, u_reference[i]) << ", with i = " << i;
+        EXPECT_EQ(dudt, dudt_reference[i]) << ", with i = " << i;
+    }
+
+    EXPECT_DOUBLE_EQ(control_variables.control_array_at_s(car_cartesian_scalar, 4, s[4])[ITORQUE], 1.0);
+    EXPECT_DOUBLE_EQ(control_variables.control_array_at_s(car_cartesian_scalar, 20, s[20])[ITORQUE], 3.0);
+
+    // Points outside the mesh of the plan resolve the layout on the fly
+    EXPECT_DOUBLE_EQ(control_variables.control_array_at_s(car_cartesian_scalar, 5, 8.0)[ITORQUE], 3.0);
+}
@@ -0,0 +1,189 @@
+#include "gtest/gtest.h"
+#include "src/core/foundation/parallel.h"
+#include "src/core/applications/optimal_laptime.h"
+#include "src/core/applications/steady_state.h"
+#include "src/core/applications/circuit_preprocessor.h"
+#include "src/core/vehicles/limebeer2014f1.h"
+#include "lion/thirdparty/include/cppad/cppad.hpp"
+
+extern bool is_valgrind;
+
+//! Runs several instances of the solvers concurrently, and checks that the results are bitwise identical
+//! to the sequential runs
+class Parallel_stress_test : public ::testing::Test
+{
+ protected:
+    using Car_t = limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p;
+    using Car_cartesian_t = limebeer2014f1<CppAD::AD<scalar>>::cartesian;
+
+    Parallel_stress_test() { Parallel::initialize(); }
+
+    const size_t n_threads = 4;
+};
+
+
+TEST_F(Parallel_stress_test, steady_state)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    Xml_document database("./database/vehicles/f1/limebeer-2014-f1.xml", true);
+    Car_cartesian_t car(database);
+
+    // (1) Trim points
+    const size_t n = 24;
+    std::vector<scalar> v(n), ay(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        v[i]  = (100.0 + 200.0*(i % 6)/5.0)*KMH;
+        ay[i] = 3.0*(i/6);
+    }
+
+    // (2) Sequential runs
+    std::vector<Steady_state<Car_cartesian_t>::Solution> serial;
+    for (size_t i = 0; i < n; ++i)
+        serial.push_back(Steady_state(car).solve(v[i], 0.0, ay[i]));
+
+    // (3) Parallel runs, each task with its own copy of the vehicle
+    std::vector<Steady_state<Car_cartesian_t>::Solution> parallel(n);
+    std::vector<Car_cartesian_t> cars(n, car);
+
+    Parallel::for_each(n, n_threads, [&](const size_t i) { parallel[i] = Steady_state(cars[i]).solve(v[i], 0.0, ay[i]); });
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        ASSERT_TRUE(serial[i].solved);
+        EXPECT_EQ(parallel[i].solved, serial[i].solved);
+        EXPECT_EQ(parallel[i].q, serial[i].q) << ", with i = " << i;
+        EXPECT_EQ(parallel[i].qa, serial[i].qa) << ", with i = " << i;
+        EXPECT_EQ(parallel[i].u, serial[i].u) << ", with i = " << i;
+    }
+}
+
+
+TEST_F(Parallel_stress_test, circuit_preprocessor)
+{
+    #ifndef NDEBUG
+          GTEST_SKIP();
+    #endif
+
+    if ( is_valgrind ) GTEST_SKIP();
+
+    const std::vector<scalar> eps_k = {1.0e3, 1.0e4, 5.0e4, 1.0e5, 1.0e6, 5.0e6};
+    const size_t n = eps_k.size();
+
+    auto solve = [&](const size_t i) -> Circuit_preprocessor
+    {
+        Xml_document coord_left_kml("./database/tracks/catalunya/Catalunya_left.kml", true);
+        Xml_document coord_right_kml("./database/tracks/catalunya/Catalunya_right.kml", true);
+
+        Circuit_preprocessor::Options opts;
+        opts.eps_k = eps_k[i];
+
+        return Circuit_preprocessor(coord_left_kml, coord_right_kml, false, opts, 100);
+    };
+
+    // (1) Sequential runs
+    std::vector<Circuit_preprocessor> serial;
+    for (size_t i = 0; i < n; ++i)
+        serial.push_back(solve(i));
+
+    // (2) Parallel runs
+    std::vector<Circuit_preprocessor> parallel(n);
+    Parallel::for_each(n, n_threads, [&](const size_t i) { parallel[i] = solve(i); });
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        EXPECT_EQ(parallel[i].track_length, serial[i].track_length) << ", with i = " << i;
+        EXPECT_EQ(parallel[i].s, serial[i].s) << ", with i = " << i;
+        EXPECT_EQ(parallel[i].kappa, serial[i].kappa) << ", with i = " << i;
+        EXPECT_EQ(parallel[i].nl, serial[i].nl) << ", with i = " << i;
+        EXPECT_EQ(parallel[i].nr, serial[i].nr) << ", with i = " << i;
+    }
+}
+
+
+TEST_F(Parallel_stress_test, optimal_laptime)
+{
+    if ( is_valgrind ) GTEST_SKIP();
+
+    Xml_document database("./database/vehicles/f1/limebeer-2014-f1.xml", true);
+    Xml_document catalunya_xml("./database/tracks/catalunya/catalunya_adapted.xml",true);
+    Circuit_preprocessor catalunya_pproc(catalunya_xml);
+    Track_by_polynomial catalunya(catalunya_pproc);
+    Car_t::Road_t road(catalunya);
+    Car_t car(database, road);
+
+    // (1) Initial point: the steady state at 70km/h, and the full lap solution at the start of every window
+    Car_cartesian_t car_cartesian(database);
+    const auto ss = Steady_state(car_cartesian).solve(70.0*KMH, 0.0, 0.0);
+
+    Xml_document opt_full_lap("data/f1_optimal_laptime_catalunya_adapted.xml", true);
+    Optimal_laptime<Car_t> opt_laptime_full_lap(opt_full_lap);
+
+    // (2) Windows of 40 elements around the chicane
+    const std::vector<size_t> i_start = {533, 543, 553, 563};
+    const size_t n = i_start.size();
+
+    auto solve = [&](const size_t k, const Car_t& car_k) -> Optimal_laptime<Car_t>
+    {
+        const size_t i0 = i_start[k];
+        const size_t n_points = 41;
+
+        std::vector<scalar> s(catalunya_pproc.s.cbegin() + i0, catalunya_pproc.s.cbegin() + i0 + n_points);
+
+        std::vector<std::array<scalar,Car_t::NSTATE>> q0(n_points, ss.q);
+        std::vector<std::array<scalar,Car_t::NALGEBRAIC>> qa0(n_points, ss.qa);
+
+        auto control_variables = Optimal_laptime<Car_t>::Control_variables<>{};
+
+        control_variables[Car_t::Chassis_type::front_axle_type::ISTEERING]
+            = Optimal_laptime<Car_t>::create_full_mesh(std::vector<scalar>(n_points,ss.u[Car_t::Chassis_type::front_axle_type::ISTEERING]), 50.0e0);
+
+        control_variables[Car_t::Chassis_type::ITHROTTLE]
+            = Optimal_laptime<Car_t>::create_full_mesh(std::vector<scalar>(n_points,ss.u[Car_t::Chassis_type::ITHROTTLE]), 20.0*8.0e-4);
+
+        control_variables[Car_t::Chassis_type::IBRAKE_BIAS]
+            = Optimal_laptime<Car_t>::create_dont_optimize();
+
+        q0.front()  = opt_laptime_full_lap.q[i0];
+        qa0.front() = opt_laptime_full_lap.qa[i0];
+        const auto u_start = opt_laptime_full_lap.control_variables.control_array_at_s(car_k, i0, s.front());
+
+        for (size_t j = 0; j < Car_t::NCONTROL; ++j)
+        {
+            if ( control_variables[j].optimal_control_type != Optimal_laptime<Car_t>::DONT_OPTIMIZE )
+                control_variables[j].u.front() = u_start[j];
+        }
+
+        return Optimal_laptime(s, false, true, car_k, q0, qa0, control_variables, Optimal_laptime<Car_t>::Options{});
+    };
+
+    // (3) Sequential runs
+    std::vector<Optimal_laptime<Car_t>> serial;
+    for (size_t k = 0; k < n; ++k)
+        serial.push_back(solve(k, car));
+
+    // (4) Parallel runs, each task with its own database, track and vehicle: nothing is shared between the tasks
+    std::vector<std::unique_ptr<Optimal_laptime<Car_t>>> parallel(n);
+
+    Parallel::for_each(n, n_threads, [&](const size_t k) 
+    { 
+        Xml_document database_k("./database/vehicles/f1/limebeer-2014-f1.xml", true);
+        Xml_document catalunya_xml_k("./database/tracks/catalunya/catalunya_adapted.xml",true);
+        Circuit_preprocessor catalunya_pproc_k(catalunya_xml_k);
+        Track_by_polynomial catalunya_k(catalunya_pproc_k);
+        Car_t::Road_t road_k(catalunya_k);
+        Car_t car_k(database_k, road_k);
+
+        parallel[k] = std::make_unique<Optimal_laptime<Car_t>>(solve(k, car_k)); 
+    });
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        ASSERT_TRUE(parallel[k] != nullptr);
+        EXPECT_EQ(parallel[k]->iter_count, serial[k].iter_count) << ", with k = " << k;
+        EXPECT_EQ(parallel[k]->laptime, serial[k].laptime) << ", with k = " << k;
+        EXPECT_EQ(parallel[k]->q, serial[k].q) << ", with k = " << k;
+        EXPECT_EQ(parallel[k]->qa, serial[k].qa) << ", with k = " << k;
+    }
+}
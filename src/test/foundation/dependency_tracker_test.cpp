@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+#include "src/core/foundation/dependency_tracker.h"
+
+static bool is_aerodynamics(const std::string& path) { return path.find("vehicle/chassis/aerodynamics/") == 0; }
+
+
+TEST(Dependency_tracker_test, changes_only_invalidate_their_dependents)
+{
+    Dependency_tracker tracker;
+
+    const size_t id = tracker.get_id();
+    const size_t epoch = tracker.get_epoch();
+
+    EXPECT_TRUE(tracker.is_up_to_date(id, epoch, {}));
+    EXPECT_TRUE(tracker.is_up_to_date(id, epoch, is_aerodynamics));
+
+    tracker.parameter_changed("vehicle/rear-axle/tire/mu-x-max");
+
+    EXPECT_FALSE(tracker.is_up_to_date(id, epoch, {}));
+    EXPECT_TRUE(tracker.is_up_to_date(id, epoch, is_aerodynamics));
+
+    tracker.parameter_changed("vehicle/chassis/aerodynamics/cl");
+
+    EXPECT_FALSE(tracker.is_up_to_date(id, epoch, is_aerodynamics));
+    EXPECT_TRUE(tracker.is_up_to_date(id, tracker.get_epoch(), is_aerodynamics));
+
+    tracker.everything_changed();
+
+    EXPECT_FALSE(tracker.is_up_to_date(id, tracker.get_epoch() - 1, [](const std::string&) { return false; }));
+}
+
+
+TEST(Dependency_tracker_test, copies_have_their_own_history)
+{
+    Dependency_tracker tracker;
+    tracker.parameter_changed("vehicle/chassis/mass");
+
+    Dependency_tracker copy(tracker);
+
+    EXPECT_NE(copy.get_id(), tracker.get_id());
+    EXPECT_EQ(copy.get_epoch(), 0);
+    EXPECT_FALSE(copy.is_up_to_date(tracker.get_id(), tracker.get_epoch(), {}));
+
+    Dependency_tracker assigned;
+    const size_t assigned_id = assigned.get_id();
+    assigned = tracker;
+
+    EXPECT_NE(assigned.get_id(), assigned_id);
+    EXPECT_NE(assigned.get_id(), tracker.get_id());
+}
+
+
+TEST(Dependency_tracker_test, artefact_cache)
+{
+    Dependency_tracker tracker;
+    Artefact_cache<double,double> cache(is_aerodynamics);
+
+    double cl = 3.0;
+    auto compute = [&](const double v) { return [&, v]() { return cl*v*v; }; };
+
+    // (1) Computed once per key
+    EXPECT_DOUBLE_EQ(cache.get(tracker, 10.0, compute(10.0)), 300.0);
+    EXPECT_DOUBLE_EQ(cache.get(tracker, 20.0, compute(20.0)), 1200.0);
+    EXPECT_DOUBLE_EQ(cache.get(tracker, 10.0, compute(10.0)), 300.0);
+
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.get_n_computations(), 2);
+    EXPECT_EQ(cache.get_n_hits(), 1);
+
+    // (2) A parameter it does not depend on: reused
+    tracker.parameter_changed("vehicle/front-tire/mu-x-max");
+
+    EXPECT_DOUBLE_EQ(cache.get(tracker, 10.0, compute(10.0)), 300.0);
+    EXPECT_EQ(cache.get_n_computations(), 2);
+    EXPECT_EQ(cache.size(), 2);
+
+    // (3) A parameter it depends on: all the keys are recomputed
+    cl = 4.0;
+    tracker.parameter_changed("vehicle/chassis/aerodynamics/cl");
+
+    EXPECT_DOUBLE_EQ(cache.get(tracker, 10.0, compute(10.0)), 400.0);
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_DOUBLE_EQ(cache.get(tracker, 20.0, compute(20.0)), 1600.0);
+    EXPECT_EQ(cache.get_n_computations(), 4);
+
+    // (4) A different vehicle never reuses the artefacts
+    Dependency_tracker other(tracker);
+    cl = 5.0;
+
+    EXPECT_DOUBLE_EQ(cache.get(other, 10.0, compute(10.0)), 500.0);
+    EXPECT_EQ(cache.size(), 1);
+
+    // (5) Failed computations are not stored
+    EXPECT_THROW(cache.get(other, 30.0, []() -> double { throw std::runtime_error("failed"); }), std::runtime_error);
+    EXPECT_EQ(cache.size(), 1);
+}
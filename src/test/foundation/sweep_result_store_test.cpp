@@ -0,0 +1,193 @@
+#include "gtest/gtest.h"
+#include "src/core/foundation/sweep_result_store.h"
+#include <cmath>
+#include <thread>
+#include <random>
+#include <cstdio>
+
+class Sweep_result_store_test : public ::testing::Test
+{
+ protected:
+    ~Sweep_result_store_test() { std::remove(file_name.c_str()); }
+
+    const std::string file_name = "sweep_result_store_test.flsweep";
+
+    //! Channels of a fictitious run
+    static std::map<std::string,std::vector<scalar>> get_channels(const size_t i_run, const size_t n)
+    {
+        std::map<std::string,std::vector<scalar>> channels;
+        std::mt19937 generator(i_run);
+        std::uniform_real_distribution<scalar> distribution(-1.0, 1.0);
+
+        channels["u"]          = std::vector<scalar>(n);
+        channels["noise"]      = std::vector<scalar>(n);
+        channels["brake-bias"] = std::vector<scalar>(n, 0.6);
+        channels["empty"]      = {};
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            channels["u"][i]     = 50.0 + 10.0*std::sin(0.01*i) + i_run;
+            channels["noise"][i] = distribution(generator);
+        }
+
+        return channels;
+    }
+};
+
+
+TEST_F(Sweep_result_store_test, compress_and_decompress)
+{
+    std::vector<scalar> values = {0.0, 0.0, 1.0, -1.0, 1.0e-300, 1.0e300, std::nan(""), 3.14159, 3.14159, -0.0};
+
+    const auto compressed = Sweep_result_store::compress(values.data(), values.size());
+    std::vector<scalar> decompressed(values.size());
+    Sweep_result_store::decompress(compressed.data(), compressed.size(), decompressed.data(), values.size());
+
+    for (size_t i = 0; i < values.size(); ++i)
+        EXPECT_EQ(std::memcmp(&values[i], &decompressed[i], sizeof(scalar)), 0) << ", with i = " << i;
+
+    // A constant channel costs half a byte per value, plus its first value
+    std::vector<scalar> constant(1000, 0.6);
+    EXPECT_EQ(Sweep_result_store::compress(constant.data(), constant.size()).size(), 500 + 8);
+
+    // Corrupted data is detected
+    EXPECT_THROW(Sweep_result_store::decompress(compressed.data(), compressed.size() - 1, decompressed.data(), values.size()), fastest_lap_exception);
+}
+
+
+TEST_F(Sweep_result_store_test, write_and_read_from_several_threads)
+{
+    const size_t n_runs = 16;
+    const size_t n_threads = 4;
+    const size_t n = 2500;
+
+    // (1) Write the runs from several workers, in arbitrary order
+    {
+        Sweep_result_store::Writer writer(file_name, 1000);
+
+        std::vector<std::thread> workers;
+        for (size_t i_thread = 0; i_thread < n_threads; ++i_thread)
+        {
+            workers.emplace_back([&, i_thread]() 
+            {
+                for (size_t i_run = i_thread; i_run < n_runs; i_run += n_threads)
+                {
+                    Sweep_result_store::Run_metadata metadata;
+                    metadata.name         = "run_" + std::to_string(i_run);
+                    metadata.parameters   = {{"mass", 700.0 + i_run}, {"power", 500.0e3}};
+                    metadata.success      = (i_run % 5 != 0);
+                    metadata.iter_count   = 10*i_run;
+                    metadata.elapsed_time = 0.5*i_run;
+                    metadata.laptime      = 80.0 + 0.1*i_run;
+
+                    writer.add_run(metadata, get_channels(i_run, n));
+                }
+            });
+        }
+
+        for (auto& worker : workers)
+            worker.join();
+
+        EXPECT_EQ(writer.get_n_runs(), n_runs);
+        writer.close();
+
+        EXPECT_THROW(writer.add_run({}, {}), fastest_lap_exception);
+    }
+
+    // The chunk size is stored in 32 bits
+    EXPECT_THROW(Sweep_result_store::Writer("sweep_result_store_test_chunk_size.flsweep", size_t(std::numeric_limits<uint32_t>::max()) + 1), 
+                 fastest_lap_exception);
+
+    // (2) Read them back
+    Sweep_result_store::Reader reader(file_name);
+
+    ASSERT_EQ(reader.get_n_runs(), n_runs);
+    EXPECT_EQ(reader.get_chunk_size(), 1000);
+
+    std::vector<bool> found(n_runs, false);
+
+    for (size_t i = 0; i < n_runs; ++i)
+    {
+        const auto& metadata = reader.get_metadata(i);
+        const size_t i_run = std::stoi(metadata.name.substr(4));
+
+        found[i_run] = true;
+
+        EXPECT_DOUBLE_EQ(metadata.parameters.at("mass"), 700.0 + i_run);
+        EXPECT_DOUBLE_EQ(metadata.parameters.at("power"), 500.0e3);
+        EXPECT_EQ(metadata.success, (i_run % 5 != 0));
+        EXPECT_EQ(metadata.iter_count, 10*i_run);
+        EXPECT_DOUBLE_EQ(metadata.elapsed_time, 0.5*i_run);
+        EXPECT_DOUBLE_EQ(metadata.laptime, 80.0 + 0.1*i_run);
+
+        EXPECT_EQ(reader.get_channel_names(i), std::vector<std::string>({"brake-bias", "empty", "noise", "u"}));
+        EXPECT_TRUE(reader.has_channel(i, "u"));
+        EXPECT_FALSE(reader.has_channel(i, "v"));
+
+        const auto channels = get_channels(i_run, n);
+
+        for (const auto& [name, values] : channels)
+            EXPECT_EQ(reader.get_channel(i, name), values) << ", with run = " << i_run << ", channel = " << name;
+    }
+
+    EXPECT_EQ(std::count(found.cbegin(), found.cend(), true), n_runs);
+
+    // (3) Errors
+    EXPECT_THROW(reader.get_channel(0, "v"), fastest_lap_exception);
+    EXPECT_THROW(reader.get_metadata(n_runs), fastest_lap_exception);
+}
+
+
+TEST_F(Sweep_result_store_test, compression_ratio)
+{
+    const size_t n = 10000;
+
+    {
+        Sweep_result_store::Writer writer(file_name);
+        auto channels = get_channels(0, n);
+        channels.erase("noise");
+        writer.add_run({}, channels);
+    }
+
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+    const size_t file_size = file.tellg();
+    const size_t raw_size = 2*n*sizeof(scalar);
+
+    EXPECT_LT(file_size, raw_size*3/4);
+
+    // Per channel: the smooth channel saves the bytes of the sign, exponent and leading mantissa bits, the
+    // constant channel costs half a byte per value, and the noise does not compress
+    const auto channels = get_channels(0, n);
+    const size_t raw_channel_size = n*sizeof(scalar);
+
+    EXPECT_LT(Sweep_result_store::compress(channels.at("u").data(), n).size(), raw_channel_size*17/20);
+    EXPECT_EQ(Sweep_result_store::compress(channels.at("brake-bias").data(), n).size(), n/2 + 8);
+    EXPECT_GT(Sweep_result_store::compress(channels.at("noise").data(), n).size(), raw_channel_size*19/20);
+}
+
+
+TEST_F(Sweep_result_store_test, unclosed_store)
+{
+    Sweep_result_store::Writer writer(file_name);
+    writer.add_run({}, get_channels(0, 10));
+
+    EXPECT_THROW(Sweep_result_store::Reader reader(file_name), fastest_lap_exception);
+
+    writer.close();
+
+    Sweep_result_store::Reader reader(file_name);
+    EXPECT_EQ(reader.get_n_runs(), 1);
+}
+
+
+TEST_F(Sweep_result_store_test, not_a_store)
+{
+    EXPECT_THROW(Sweep_result_store::Reader reader("does_not_exist.flsweep"), fastest_lap_exception);
+
+    {
+        std::ofstream file(file_name);
+        file << "<optimal_laptime/>" << std::endl;
+    }
+
+    EXPECT_THROW(Sweep_result_store::Reader reader(file_name), fastest_lap_exception);
+}
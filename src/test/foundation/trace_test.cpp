@@ -0,0 +1,121 @@
+#include "gtest/gtest.h"
+#include "src/core/foundation/trace.h"
+#include <thread>
+#include <algorithm>
+
+class Trace_test : public ::testing::Test
+{
+ protected:
+    Trace_test() { Trace::disable(); Trace::clear(); }
+
+    ~Trace_test() { Trace::disable(); Trace::clear(); }
+
+    static size_t count(const std::string& str, const std::string& pattern)
+    {
+        size_t n = 0;
+        for (size_t pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + pattern.size()))
+            ++n;
+
+        return n;
+    }
+};
+
+
+TEST_F(Trace_test, disabled_records_nothing)
+{
+    {
+        FASTEST_LAP_TRACE_SCOPE("disabled");
+    }
+
+    EXPECT_EQ(Trace::size(), 0);
+    EXPECT_EQ(Trace::json().find("\"disabled\""), std::string::npos);
+}
+
+
+TEST_F(Trace_test, begin_and_end_events)
+{
+    Trace::enable();
+
+    {
+        FASTEST_LAP_TRACE_SCOPE("outer");
+        {
+            FASTEST_LAP_TRACE_SCOPE("inner \"quoted\"");
+        }
+    }
+
+    Trace::disable();
+
+    EXPECT_EQ(Trace::size(), 4);
+
+    const std::string json = Trace::json();
+
+    EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0);
+    EXPECT_EQ(count(json, "\"name\":\"outer\""), 2);
+    EXPECT_EQ(count(json, "\"name\":\"inner \\\"quoted\\\"\""), 2);
+    EXPECT_EQ(count(json, "\"ph\":\"B\""), 2);
+    EXPECT_EQ(count(json, "\"ph\":\"E\""), 2);
+
+    // Events are nested: outer begins first and ends last
+    const size_t outer_begin = json.find("\"name\":\"outer\"");
+    const size_t outer_end   = json.rfind("\"name\":\"outer\"");
+    const size_t inner_begin = json.find("\"name\":\"inner");
+    const size_t inner_end   = json.rfind("\"name\":\"inner");
+
+    EXPECT_LT(outer_begin, inner_begin);
+    EXPECT_LT(inner_begin, inner_end);
+    EXPECT_LT(inner_end, outer_end);
+}
+
+
+TEST_F(Trace_test, ring_buffer_keeps_the_newest_events)
+{
+    Trace::enable(10);
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        FASTEST_LAP_TRACE_SCOPE((i < 95 ? "old" : "new"));
+    }
+
+    Trace::disable();
+
+    EXPECT_EQ(Trace::size(), 10);
+
+    const std::string json = Trace::json();
+    EXPECT_EQ(count(json, "\"name\":\"new\""), 10);
+    EXPECT_EQ(count(json, "\"name\":\"old\""), 0);
+
+    // Restore the default capacity
+    Trace::clear();
+    Trace::enable();
+    Trace::disable();
+}
+
+
+TEST_F(Trace_test, several_threads)
+{
+    Trace::enable();
+
+    const size_t n_threads = 4;
+    const size_t n_events_per_thread = 50;
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < n_threads; ++i)
+        threads.emplace_back([&]()
+        {
+            for (size_t j = 0; j < n_events_per_thread; ++j)
+            {
+                FASTEST_LAP_TRACE_SCOPE("task");
+            }
+        });
+
+    for (auto& thread : threads)
+        thread.join();
+
+    Trace::disable();
+
+    EXPECT_EQ(Trace::size(), 2*n_threads*n_events_per_thread);
+
+    const std::string json = Trace::json();
+    EXPECT_EQ(count(json, "\"name\":\"task\""), 2*n_threads*n_events_per_thread);
+    EXPECT_GE(count(json, "\"name\":\"thread_name\""), 2);
+}
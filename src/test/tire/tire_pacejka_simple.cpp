@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "src/core/tire/tire_pacejka.h"
+#include "lion/thirdparty/include/cppad/cppad.hpp"
 
 class Tire_pacejka_simple_test : public ::testing::Test
 {
@@ -105,3 +106,66 @@ TEST_F(Tire_pacejka_simple_test, update)
     EXPECT_DOUBLE_EQ(tire.get_force()[1],Fy_computed);
     EXPECT_DOUBLE_EQ(tire.get_force()[2], -5555.0);
 }
+
+
+TEST_F(Tire_pacejka_simple_test, combined_forces)
+{
+    const std::vector<scalar> kappa_values = {-0.08, -0.01, 0.0, 0.02, 0.12};
+    const std::vector<scalar> lambda_values = {-0.1, 0.0, 0.03, 0.2};
+    const std::vector<scalar> Fz_values = {500.0, 3000.0, 7000.0};
+
+    // (1) Simple model
+    for (const scalar kappa : kappa_values)
+        for (const scalar lambda : lambda_values)
+            for (const scalar Fz : Fz_values)
+            {
+                const auto [Fx, Fy] = tire.get_model().force_combined_magic(kappa, lambda, Fz);
+
+                EXPECT_EQ(Fx, tire.get_model().force_combined_longitudinal_magic(kappa, lambda, Fz));
+                EXPECT_EQ(Fy, tire.get_model().force_combined_lateral_magic(kappa, lambda, Fz));
+            }
+
+    // (2) Standard model
+    Xml_document kart_database("./database/vehicles/kart/roberto-lot-kart-2016.xml", true);
+    Tire_pacejka_std<scalar,0,0> kart_tire("tire-test", kart_database, "vehicle/rear-tire/");
+
+    for (const scalar kappa : kappa_values)
+        for (const scalar lambda : lambda_values)
+            for (const scalar Fz : Fz_values)
+            {
+                const auto [Fx, Fy] = kart_tire.get_model().force_combined_magic(kappa, lambda, Fz);
+
+                EXPECT_EQ(Fx, kart_tire.get_model().force_combined_longitudinal_magic(kappa, lambda, Fz));
+                EXPECT_EQ(Fy, kart_tire.get_model().force_combined_lateral_magic(kappa, lambda, Fz));
+            }
+}
+
+
+TEST_F(Tire_pacejka_simple_test, combined_forces_tape_size)
+{
+    // The fused evaluation records the load interpolated peaks and the normalized slips only once
+    Tire_pacejka_simple<CppAD::AD<scalar>,0,0> tire_ad("tire-test", database, "vehicle/front-tire/");
+    const auto& model = tire_ad.get_model();
+
+    auto tape_size = [](const auto& forces) -> size_t
+    {
+        std::vector<CppAD::AD<scalar>> x = {0.05, 0.03, 4000.0};
+        CppAD::Independent(x);
+
+        const auto [Fx, Fy] = forces(x[0], x[1], x[2]);
+
+        std::vector<CppAD::AD<scalar>> y = {Fx, Fy};
+        CppAD::ADFun<scalar> tape(x, y);
+
+        return tape.size_op();
+    };
+
+    const size_t n_fused = tape_size([&](const auto& kappa, const auto& lambda, const auto& Fz) 
+        { return model.force_combined_magic(kappa, lambda, Fz); });
+
+    const size_t n_separate = tape_size([&](const auto& kappa, const auto& lambda, const auto& Fz) 
+        { return std::make_pair(model.force_combined_longitudinal_magic(kappa, lambda, Fz), 
+                                model.force_combined_lateral_magic(kappa, lambda, Fz)); });
+
+    EXPECT_LT(n_fused, n_separate);
+}
@@ -4,7 +4,9 @@
 #include "lion/thirdparty/include/cppad/cppad.hpp"
 #include "src/core/applications/steady_state.h"
 #include "lion/propagators/crank_nicolson.h"
+#include "src/core/applications/crank_nicolson_propagator.h"
 #include <unordered_map>
+#include <map>
 #include "src/main/c/fastestlapc.h"
 
 // Define convenient aliases
@@ -760,3 +762,192 @@ TEST_F(limebeer2014f1_test,propagation_crank_nicolson_corner_exit)
     for (size_t i = 0; i < 4; ++i)
         EXPECT_NEAR(qa[i],qa_next[i],1.0e-10) << ", with i = " << i;
 }
+
+
+TEST_F(limebeer2014f1_test,propagation_crank_nicolson_jacobian_modes)
+{
+    Xml_document catalunya_xml("./database/tracks/catalunya/catalunya_discrete.xml",true);
+    Track_by_polynomial catalunya(catalunya_xml);
+
+    using Car_t        = limebeer2014f1<CppAD::AD<scalar>>::curvilinear_p;
+    using Propagator_t = Crank_nicolson_propagator<Car_t>;
+
+    Car_t::Road_t road(catalunya);
+    Car_t car(database, road);
+
+    // Get the results from a saved simulation
+    Xml_document opt_saved("data/f1_optimal_laptime_catalunya_discrete.xml", true);
+
+    auto arclength_saved = opt_saved.get_element("optimal_laptime/arclength").get_value(std::vector<scalar>());
+    std::vector<std::vector<scalar>> q_saved, qa_saved;
+
+    for (const std::string name : {"steering-kappa-left", "steering-kappa-right", "powered-kappa-left", "powered-kappa-right", 
+                                   "u", "v", "omega", "time", "n", "alpha"})
+        q_saved.push_back(opt_saved.get_element("optimal_laptime/" + name).get_value(std::vector<scalar>()));
+
+    for (const std::string name : {"Fz_fl", "Fz_fr", "Fz_rl", "Fz_rr"})
+        qa_saved.push_back(opt_saved.get_element("optimal_laptime/" + name).get_value(std::vector<scalar>()));
+
+    auto delta_saved    = opt_saved.get_element("optimal_laptime/delta").get_value(std::vector<scalar>());
+    auto throttle_saved = opt_saved.get_element("optimal_laptime/throttle").get_value(std::vector<scalar>());
+
+    auto get_controls = [&](const size_t i)
+    {
+        auto u = car.get_state_and_control_upper_lower_and_default_values().u_def;
+        u[Car_t::Chassis_type::front_axle_type::ISTEERING] = delta_saved[i];
+        u[Car_t::Chassis_type::ITHROTTLE] = throttle_saved[i];
+        return u;
+    };
+
+    // Take the steps from i = 101 to i = 200, starting every step from the saved solution, with all the Jacobian modes
+    const size_t i_start = 101;
+    const size_t i_end   = 200;
+
+    const std::vector<std::pair<std::string,Propagator_t::Jacobian_mode>> modes = { {"newton", Propagator_t::NEWTON}, 
+        {"frozen", Propagator_t::FROZEN}, {"reuse", Propagator_t::REUSE}, {"broyden", Propagator_t::BROYDEN} };
+
+    std::map<std::string,Propagator_t::Statistics> statistics;
+
+    for (const auto& [mode_name, mode] : modes)
+    {
+        Propagator_t::Options options;
+        options.jacobian_mode = mode;
+        options.max_iter      = 30;
+
+        Propagator_t propagator(options);
+
+        for (size_t i_step = i_start; i_step < i_end; ++i_step)
+        {
+            std::array<scalar,Car_t::NSTATE> q;
+            std::array<scalar,Car_t::NALGEBRAIC> qa;
+
+            for (size_t i = 0; i < Car_t::NSTATE; ++i)
+                q[i] = q_saved[i][i_step];
+
+            for (size_t i = 0; i < Car_t::NALGEBRAIC; ++i)
+                qa[i] = qa_saved[i][i_step];
+
+            propagator.take_step(car, get_controls(i_step), get_controls(i_step+1), q, qa, arclength_saved[i_step], 
+                arclength_saved[i_step+1] - arclength_saved[i_step]);
+
+            for (size_t i = 0; i < Car_t::NSTATE; ++i)
+                EXPECT_NEAR(q[i], q_saved[i][i_step+1], 1.0e-8) << ", with i = " << i << ", step = " << i_step << ", mode = " << mode_name;
+
+            for (size_t i = 0; i < Car_t::NALGEBRAIC; ++i)
+                EXPECT_NEAR(qa[i], qa_saved[i][i_step+1], 1.0e-8) << ", with i = " << i << ", step = " << i_step << ", mode = " << mode_name;
+        }
+
+        statistics[mode_name] = propagator.get_statistics();
+    }
+
+    // Newton computes the Jacobian on every iteration, frozen at least once per step. Reuse and Broyden keep it across steps
+    EXPECT_EQ(statistics["newton"].n_jacobian_evaluations, statistics["newton"].n_iterations);
+    EXPECT_GE(statistics["frozen"].n_jacobian_evaluations, i_end - i_start);
+    EXPECT_LT(statistics["frozen"].n_jacobian_evaluations, statistics["newton"].n_jacobian_evaluations);
+    EXPECT_LT(statistics["reuse"].n_jacobian_evaluations, statistics["frozen"].n_jacobian_evaluations);
+    EXPECT_LT(statistics["broyden"].n_jacobian_evaluations, statistics["frozen"].n_jacobian_evaluations);
+}
+
+
+#ifdef TEST_LIBFASTESTLAPC
+std::pair<size_t,size_t> get_artefacts_statistics(const std::string& vehicle_name, const std::string& artefact);
+
+TEST_F(limebeer2014f1_test,propagate_vehicle_c_api_jacobian_modes)
+{
+    set_print_level(0);
+    create_vehicle_from_xml("vehicle_propagation", "./database/vehicles/f1/limebeer-2014-f1.xml");
+    create_track_from_xml("track_propagation", "./database/tracks/catalunya/catalunya_discrete.xml");
+
+    auto& car = get_table_f1_3dof().at("vehicle_propagation").get_curvilinear_scalar_car();
+    using Car_t = std::decay_t<decltype(car)>;
+
+    // Get the results from a saved simulation
+    Xml_document opt_saved("data/f1_optimal_laptime_catalunya_discrete.xml", true);
+
+    auto arclength_saved = opt_saved.get_element("optimal_laptime/arclength").get_value(std::vector<scalar>());
+    std::vector<std::vector<scalar>> q_saved, qa_saved;
+
+    for (const std::string name : {"steering-kappa-left", "steering-kappa-right", "powered-kappa-left", "powered-kappa-right", 
+                                   "u", "v", "omega", "time", "n", "alpha"})
+        q_saved.push_back(opt_saved.get_element("optimal_laptime/" + name).get_value(std::vector<scalar>()));
+
+    for (const std::string name : {"Fz_fl", "Fz_fr", "Fz_rl", "Fz_rr"})
+        qa_saved.push_back(opt_saved.get_element("optimal_laptime/" + name).get_value(std::vector<scalar>()));
+
+    auto delta_saved    = opt_saved.get_element("optimal_laptime/delta").get_value(std::vector<scalar>());
+    auto throttle_saved = opt_saved.get_element("optimal_laptime/throttle").get_value(std::vector<scalar>());
+
+    auto get_controls = [&](const size_t i)
+    {
+        auto u = car.get_state_and_control_upper_lower_and_default_values().u_def;
+        u[Car_t::Chassis_type::front_axle_type::ISTEERING] = delta_saved[i];
+        u[Car_t::Chassis_type::ITHROTTLE] = throttle_saved[i];
+        return u;
+    };
+
+    // Take the steps from i = 101 to i = 150, starting every step from the saved solution
+    const size_t i_start = 101;
+    const size_t i_end   = 150;
+
+    auto propagate = [&](const std::string& options)
+    {
+        for (size_t i_step = i_start; i_step < i_end; ++i_step)
+        {
+            std::array<double,Car_t::NSTATE> q;
+            std::array<double,Car_t::NALGEBRAIC> qa;
+
+            for (size_t i = 0; i < Car_t::NSTATE; ++i)
+                q[i] = q_saved[i][i_step];
+
+            for (size_t i = 0; i < Car_t::NALGEBRAIC; ++i)
+                qa[i] = qa_saved[i][i_step];
+
+            auto u      = get_controls(i_step);
+            auto u_next = get_controls(i_step+1);
+
+            propagate_vehicle(q.data(), qa.data(), u.data(), "vehicle_propagation", "track_propagation", arclength_saved[i_step], 
+                arclength_saved[i_step+1] - arclength_saved[i_step], u_next.data(), true, options.c_str());
+
+            for (size_t i = 0; i < Car_t::NSTATE; ++i)
+                EXPECT_NEAR(q[i], q_saved[i][i_step+1], 1.0e-8) << ", with i = " << i << ", step = " << i_step << ", options = " << options;
+
+            for (size_t i = 0; i < Car_t::NALGEBRAIC; ++i)
+                EXPECT_NEAR(qa[i], qa_saved[i][i_step+1], 1.0e-8) << ", with i = " << i << ", step = " << i_step << ", options = " << options;
+        }
+    };
+
+    const size_t n_steps = i_end - i_start;
+
+    // (1) Reuse: the propagator is created in the first step, and kept by the vehicle for the next ones
+    propagate("<options><max_iter>30</max_iter><jacobian_mode>reuse</jacobian_mode><maximum_jacobian_age>10</maximum_jacobian_age></options>");
+
+    EXPECT_EQ(get_artefacts_statistics("vehicle_propagation", "propagator_curvilinear"), std::pair<size_t,size_t>(1, n_steps - 1));
+    EXPECT_EQ(get_artefacts_statistics("vehicle_propagation", "propagator_cartesian"), std::pair<size_t,size_t>(0, 0));
+
+    // (2) Broyden: same propagator, with its new options
+    propagate("<options><max_iter>30</max_iter><jacobian_mode>broyden</jacobian_mode></options>");
+
+    EXPECT_EQ(get_artefacts_statistics("vehicle_propagation", "propagator_curvilinear"), std::pair<size_t,size_t>(1, 2*n_steps - 1));
+
+    // (3) A change of a parameter discards the propagator
+    vehicle_set_parameter("vehicle_propagation", "vehicle/chassis/mass", 660.0);
+    propagate("<options><max_iter>30</max_iter><jacobian_mode>frozen</jacobian_mode></options>");
+
+    EXPECT_EQ(get_artefacts_statistics("vehicle_propagation", "propagator_curvilinear"), std::pair<size_t,size_t>(2, 3*n_steps - 2));
+
+    // (4) Wrong options
+    std::array<double,Car_t::NSTATE> q{};
+    std::array<double,Car_t::NALGEBRAIC> qa{};
+    auto u = get_controls(i_start);
+
+    EXPECT_THROW(propagate_vehicle(q.data(), qa.data(), u.data(), "vehicle_propagation", "track_propagation", 0.0, 1.0, u.data(), true, 
+        "<options><jacobian_mode>reuse</jacobian_mode><maximum_jacobian_age>-1</maximum_jacobian_age></options>"), fastest_lap_exception);
+
+    EXPECT_THROW(propagate_vehicle(q.data(), qa.data(), u.data(), "vehicle_propagation", "track_propagation", 0.0, 1.0, u.data(), true, 
+        "<options><jacobian_mode>chord</jacobian_mode></options>"), fastest_lap_exception);
+
+    delete_variable("vehicle_propagation");
+    delete_variable("track_propagation");
+}
+
+#endif